@@ -63,6 +63,8 @@
 #include "DownloadContext.h"
 #include "wallclock.h"
 #include "NameResolver.h"
+#include "NameResolveJob.h"
+#include "DiskWriteJob.h"
 #include "uri.h"
 #include "FileEntry.h"
 #include "error_code.h"
@@ -111,6 +113,12 @@ AbstractCommand::~AbstractCommand() {
 #ifdef ENABLE_ASYNC_DNS
   disableNameResolverCheck(asyncNameResolver_);
 #endif // ENABLE_ASYNC_DNS
+  if(nameResolveJob_) {
+    nameResolveJob_->setCommand(0);
+  }
+  if(diskWriteJob_) {
+    diskWriteJob_->setCommand(0);
+  }
   requestGroup_->decreaseNumCommand();
   requestGroup_->decreaseStreamCommand();
   if(incNumConnection_) {
@@ -118,6 +126,11 @@ AbstractCommand::~AbstractCommand() {
   }
 }
 
+void AbstractCommand::setDiskWriteJob(const SharedHandle<DiskWriteJob>& job)
+{
+  diskWriteJob_ = job;
+}
+
 void AbstractCommand::useFasterRequest
 (const SharedHandle<Request>& fasterRequest)
 {
@@ -207,8 +220,10 @@ bool AbstractCommand::execute() {
 #ifdef ENABLE_ASYNC_DNS
        (nameResolverCheck_ && nameResolveFinished()) ||
 #endif // ENABLE_ASYNC_DNS
+       (nameResolveJob_ && nameResolveJob_->isDone()) ||
+       (diskWriteJob_ && diskWriteJob_->isDone()) ||
        (!checkSocketIsReadable_ && !checkSocketIsWritable_ &&
-        !nameResolverCheck_)) {
+        !nameResolverCheck_ && !diskWriteJob_)) {
       checkPoint_ = global::wallclock();
       if(getPieceStorage()) {
         if(!req_ || req_->getMaxPipelinedRequest() == 1 ||
@@ -751,7 +766,24 @@ std::string AbstractCommand::resolveHostname
       }
     } else
 #endif // ENABLE_ASYNC_DNS
-      {
+      if(e_->getThreadPool()) {
+        if(!nameResolveJob_) {
+          nameResolveJob_.reset
+            (new NameResolveJob(hostname,
+                                e_->getOption()->getAsBool(PREF_DISABLE_IPV6)?
+                                AF_INET : AF_UNSPEC));
+          e_->submitJob(nameResolveJob_, this);
+        }
+        if(!nameResolveJob_->isDone()) {
+          return A2STR::NIL;
+        }
+        SharedHandle<NameResolveJob> job;
+        job.swap(nameResolveJob_);
+        if(!job->getError().empty()) {
+          throw DL_ABORT_EX2(job->getError(), job->getErrorCode());
+        }
+        addrs = job->getResolvedAddresses();
+      } else {
         NameResolver res;
         res.setSocktype(SOCK_STREAM);
         if(e_->getOption()->getAsBool(PREF_DISABLE_IPV6)) {
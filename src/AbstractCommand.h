@@ -57,6 +57,8 @@ class Segment;
 class SocketCore;
 class Option;
 class SocketRecvBuffer;
+class NameResolveJob;
+class DiskWriteJob;
 #ifdef ENABLE_ASYNC_DNS
 class AsyncNameResolver;
 #endif // ENABLE_ASYNC_DNS
@@ -78,6 +80,14 @@ private:
   SharedHandle<AsyncNameResolver> asyncNameResolver_;
 #endif // ENABLE_ASYNC_DNS
 
+  // Used instead of synchronous name resolution if DownloadEngine
+  // has ThreadPool.
+  SharedHandle<NameResolveJob> nameResolveJob_;
+
+  // While this is set, the command is executed only after the job is
+  // done.
+  SharedHandle<DiskWriteJob> diskWriteJob_;
+
   bool checkSocketIsReadable_;
   bool checkSocketIsWritable_;
   SharedHandle<SocketCore> readCheckTarget_;
@@ -229,6 +239,15 @@ protected:
   }
 
   void checkSocketRecvBuffer();
+
+  // Makes this command wait for job, which must be submitted with
+  // this command. Passing null stops waiting.
+  void setDiskWriteJob(const SharedHandle<DiskWriteJob>& job);
+
+  const SharedHandle<DiskWriteJob>& getDiskWriteJob() const
+  {
+    return diskWriteJob_;
+  }
 public:
   AbstractCommand
   (cuid_t cuid, const SharedHandle<Request>& req,
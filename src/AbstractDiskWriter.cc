@@ -35,6 +35,10 @@
 #include "AbstractDiskWriter.h"
 
 #include <unistd.h>
+#ifdef HAVE_PWRITEV
+# include <sys/uio.h>
+# include <climits>
+#endif // HAVE_PWRITEV
 
 #include <cerrno>
 #include <cstring>
@@ -124,12 +128,22 @@ void AbstractDiskWriter::createFile(int addFlags)
   }  
 }
 
-ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data, size_t len)
+ssize_t AbstractDiskWriter::writeDataInternal
+(const unsigned char* data, size_t len, off_t offset)
 {
+#ifndef HAVE_PWRITE
+  seek(offset);
+#endif // !HAVE_PWRITE
   ssize_t writtenLength = 0;
   while((size_t)writtenLength < len) {
     ssize_t ret = 0;
-    while((ret = write(fd_, data+writtenLength, len-writtenLength)) == -1 && errno == EINTR);
+#ifdef HAVE_PWRITE
+    while((ret = pwrite(fd_, data+writtenLength, len-writtenLength,
+                        offset+writtenLength)) == -1 && errno == EINTR);
+#else // !HAVE_PWRITE
+    while((ret = write(fd_, data+writtenLength, len-writtenLength)) == -1 &&
+          errno == EINTR);
+#endif // !HAVE_PWRITE
     if(ret == -1) {
       return -1;
     }
@@ -138,10 +152,16 @@ ssize_t AbstractDiskWriter::writeDataInternal(const unsigned char* data, size_t
   return writtenLength;
 }
 
-ssize_t AbstractDiskWriter::readDataInternal(unsigned char* data, size_t len)
+ssize_t AbstractDiskWriter::readDataInternal
+(unsigned char* data, size_t len, off_t offset)
 {
   ssize_t ret = 0;
+#ifdef HAVE_PREAD
+  while((ret = pread(fd_, data, len, offset)) == -1 && errno == EINTR);
+#else // !HAVE_PREAD
+  seek(offset);
   while((ret = read(fd_, data, len)) == -1 && errno == EINTR);
+#endif // !HAVE_PREAD
   return ret;
 }
 
@@ -156,36 +176,82 @@ void AbstractDiskWriter::seek(off_t offset)
   }
 }
 
+void AbstractDiskWriter::throwWriteError(int errNum)
+{
+  // If errno is ENOSPC(not enough space in device), throw
+  // DownloadFailureException and abort download instantly.
+  if(errNum == ENOSPC) {
+    throw DOWNLOAD_FAILURE_EXCEPTION3
+      (errNum,
+       fmt(EX_FILE_WRITE,
+           filename_.c_str(),
+           util::safeStrerror(errNum).c_str()),
+       error_code::NOT_ENOUGH_DISK_SPACE);
+  } else {
+    throw DL_ABORT_EX3
+      (errNum,
+       fmt(EX_FILE_WRITE,
+           filename_.c_str(),
+           util::safeStrerror(errNum).c_str()),
+       error_code::FILE_IO_ERROR);
+  }
+}
+
 void AbstractDiskWriter::writeData(const unsigned char* data, size_t len, off_t offset)
 {
-  seek(offset);
-  if(writeDataInternal(data, len) < 0) {
-    int errNum = errno;
-    // If errno is ENOSPC(not enough space in device), throw
-    // DownloadFailureException and abort download instantly.
-    if(errNum == ENOSPC) {
-      throw DOWNLOAD_FAILURE_EXCEPTION3
-        (errNum,
-         fmt(EX_FILE_WRITE,
-             filename_.c_str(),
-             util::safeStrerror(errNum).c_str()),
-         error_code::NOT_ENOUGH_DISK_SPACE);
-    } else {
-      throw DL_ABORT_EX3
-        (errNum,
-         fmt(EX_FILE_WRITE,
-             filename_.c_str(),
-             util::safeStrerror(errNum).c_str()),
-         error_code::FILE_IO_ERROR);
+  if(writeDataInternal(data, len, offset) < 0) {
+    throwWriteError(errno);
+  }
+}
+
+void AbstractDiskWriter::writeDataVector
+(const std::vector<DataBuffer>& bufs, off_t offset)
+{
+#ifdef HAVE_PWRITEV
+  std::vector<struct iovec> iov;
+  iov.reserve(std::min(bufs.size(), static_cast<size_t>(IOV_MAX)));
+  std::vector<DataBuffer>::const_iterator first = bufs.begin();
+  while(first != bufs.end()) {
+    iov.clear();
+    std::vector<DataBuffer>::const_iterator last = first;
+    for(; last != bufs.end() && iov.size() < static_cast<size_t>(IOV_MAX);
+        ++last) {
+      struct iovec v;
+      v.iov_base = const_cast<unsigned char*>((*last).data);
+      v.iov_len = (*last).length;
+      iov.push_back(v);
+    }
+    // Retry from the first buffer which is not completely written
+    // when pwritev() writes partially.
+    size_t i = 0;
+    while(i < iov.size()) {
+      ssize_t ret;
+      while((ret = pwritev(fd_, &iov[i], iov.size()-i, offset)) == -1 &&
+            errno == EINTR);
+      if(ret == -1) {
+        throwWriteError(errno);
+      }
+      offset += ret;
+      for(; i < iov.size() && static_cast<size_t>(ret) >= iov[i].iov_len;
+          ++i) {
+        ret -= iov[i].iov_len;
+      }
+      if(i < iov.size()) {
+        iov[i].iov_base = reinterpret_cast<unsigned char*>(iov[i].iov_base)+ret;
+        iov[i].iov_len -= ret;
+      }
     }
+    first = last;
   }
+#else // !HAVE_PWRITEV
+  DiskWriter::writeDataVector(bufs, offset);
+#endif // !HAVE_PWRITEV
 }
 
 ssize_t AbstractDiskWriter::readData(unsigned char* data, size_t len, off_t offset)
 {
   ssize_t ret;
-  seek(offset);
-  if((ret = readDataInternal(data, len)) < 0) {
+  if((ret = readDataInternal(data, len, offset)) < 0) {
     int errNum = errno;
     throw DL_ABORT_EX3
       (errNum,
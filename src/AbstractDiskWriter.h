@@ -47,12 +47,26 @@ private:
 
   bool readOnly_;
 
-  ssize_t writeDataInternal(const unsigned char* data, size_t len);
-  ssize_t readDataInternal(unsigned char* data, size_t len);
+  ssize_t writeDataInternal(const unsigned char* data, size_t len,
+                            off_t offset);
+  ssize_t readDataInternal(unsigned char* data, size_t len, off_t offset);
 
   void seek(off_t offset);
+
+  // Throws exception for write error errNum.
+  void throwWriteError(int errNum);
 protected:
   void createFile(int addFlags = 0);
+
+  const std::string& getFilename() const
+  {
+    return filename_;
+  }
+
+  bool isReadOnly() const
+  {
+    return readOnly_;
+  }
 public:
   AbstractDiskWriter(const std::string& filename);
   virtual ~AbstractDiskWriter();
@@ -65,6 +79,9 @@ public:
 
   virtual void writeData(const unsigned char* data, size_t len, off_t offset);
 
+  virtual void writeDataVector(const std::vector<DataBuffer>& bufs,
+                               off_t offset);
+
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
 
   virtual void truncate(uint64_t length);
@@ -77,6 +94,22 @@ public:
   virtual void enableReadOnly();
 
   virtual void disableReadOnly();
+
+  virtual int getFd() const
+  {
+    return fd_;
+  }
+
+  // With pread()/pwrite(), I/O does not depend on the file offset,
+  // which is shared by threads.
+  virtual bool isThreadSafe() const
+  {
+#if defined HAVE_PREAD && defined HAVE_PWRITE
+    return true;
+#else // !(HAVE_PREAD && HAVE_PWRITE)
+    return false;
+#endif // !(HAVE_PREAD && HAVE_PWRITE)
+  }
 };
 
 } // namespace aria2
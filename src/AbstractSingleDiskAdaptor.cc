@@ -74,6 +74,12 @@ void AbstractSingleDiskAdaptor::writeData
   diskWriter_->writeData(data, len, offset);
 }
 
+void AbstractSingleDiskAdaptor::writeDataVector
+(const std::vector<DataBuffer>& bufs, off_t offset)
+{
+  diskWriter_->writeDataVector(bufs, offset);
+}
+
 ssize_t AbstractSingleDiskAdaptor::readData
 (unsigned char* data, size_t len, off_t offset)
 {
@@ -126,6 +132,19 @@ void AbstractSingleDiskAdaptor::disableReadOnly()
   readOnly_ = false;
 }
 
+bool AbstractSingleDiskAdaptor::isThreadSafe() const
+{
+  return diskWriter_ && diskWriter_->isThreadSafe();
+}
+
+int AbstractSingleDiskAdaptor::getFd
+(off_t offset, size_t len, off_t& fileOffset, size_t& fileLength)
+{
+  fileOffset = offset;
+  fileLength = len;
+  return diskWriter_->getFd();
+}
+
 void AbstractSingleDiskAdaptor::cutTrailingGarbage()
 {
   if(File(getFilePath()).size() > totalLength_) {
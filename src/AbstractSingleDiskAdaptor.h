@@ -63,6 +63,9 @@ public:
   virtual void writeData(const unsigned char* data, size_t len,
                          off_t offset);
 
+  virtual void writeDataVector(const std::vector<DataBuffer>& bufs,
+                               off_t offset);
+
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
 
   virtual bool fileExists();
@@ -80,6 +83,11 @@ public:
   virtual void disableReadOnly();
     
   virtual bool isReadOnlyEnabled() const { return readOnly_; }
+
+  virtual bool isThreadSafe() const;
+
+  virtual int getFd(off_t offset, size_t len,
+                    off_t& fileOffset, size_t& fileLength);
   
   virtual void cutTrailingGarbage();
 
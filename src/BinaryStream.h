@@ -39,16 +39,40 @@
 
 #include <unistd.h>
 
+#include <vector>
+
 #include "SharedHandle.h"
 
 namespace aria2 {
 
+// Buffer passed to BinaryStream::writeDataVector().
+struct DataBuffer {
+  const unsigned char* data;
+  size_t length;
+
+  DataBuffer(const unsigned char* data, size_t length)
+    : data(data), length(length) {}
+};
+
 class BinaryStream {
 public:
   virtual ~BinaryStream() {}
   
   virtual void writeData(const unsigned char* data, size_t len, off_t offset) = 0;
 
+  // Writes bufs in order to the contiguous region starting at
+  // offset. The default implementation calls writeData() for each
+  // buffer.
+  virtual void writeDataVector(const std::vector<DataBuffer>& bufs,
+                               off_t offset)
+  {
+    for(std::vector<DataBuffer>::const_iterator i = bufs.begin(),
+          eoi = bufs.end(); i != eoi; ++i) {
+      writeData((*i).data, (*i).length, offset);
+      offset += (*i).length;
+    }
+  }
+
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset) = 0;
 
   // Truncates a file to given length. The default implementation does
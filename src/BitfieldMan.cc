@@ -152,18 +152,9 @@ bool BitfieldMan::hasMissingPiece
   if(bitfieldLength_ != length) {
     return false;
   }
-  bool retval = false;
-  for(size_t i = 0; i < bitfieldLength_; ++i) {
-    unsigned char temp = peerBitfield[i] & ~bitfield_[i];
-    if(filterEnabled_) {
-      temp &= filterBitfield_[i];
-    }
-    if(temp&0xffu) {
-      retval = true;
-      break;
-    }
-  }
-  return retval;
+  return bitfield::andNot(0, peerBitfield,
+                          filterEnabled_ ? filterBitfield_ : 0,
+                          bitfield_, 0, blocks_);
 }
 
 bool BitfieldMan::getFirstMissingUnusedIndex(size_t& index) const
@@ -202,30 +193,6 @@ bool BitfieldMan::getFirstMissingIndex(size_t& index) const
   }
 }
 
-namespace {
-template<typename Array>
-size_t getStartIndex(size_t index, const Array& bitfield, size_t blocks) {
-  while(index < blocks && bitfield::test(bitfield, blocks, index)) {
-    ++index;
-  }
-  if(blocks <= index) {
-    return blocks;
-  } else {
-    return index;
-  }
-}
-} // namespace
-
-namespace {
-template<typename Array>
-size_t getEndIndex(size_t index, const Array& bitfield, size_t blocks) {
-  while(index < blocks && !bitfield::test(bitfield, blocks, index)) {
-    ++index;
-  }
-  return index;
-}
-} // namespace
-
 namespace {
 template<typename Array>
 bool getSparseMissingUnusedIndex
@@ -241,12 +208,12 @@ bool getSparseMissingUnusedIndex
   size_t nextIndex = 0;
   while(nextIndex < blocks) {
     currentRange.startIndex =
-      getStartIndex(nextIndex, bitfield, blocks);
+      bitfield::getNextUnsetBitIndex(bitfield, blocks, nextIndex);
     if(currentRange.startIndex == blocks) {
       break;
     }
     currentRange.endIndex =
-      getEndIndex(currentRange.startIndex, bitfield, blocks);
+      bitfield::getNextSetBitIndex(bitfield, blocks, currentRange.startIndex);
 
     if(currentRange.startIndex > 0) {
       if(bitfield::test(useBitfield, blocks, currentRange.startIndex-1)) {
@@ -382,38 +349,29 @@ bool getInorderMissingUnusedIndex
  size_t blockLength_,
  size_t blocks)
 {
-  // We always return first piece if it is available.
-  if(!bitfield::test(bitfield, blocks, 0) &&
-     !bitfield::test(useBitfield, blocks, 0)) {
-    index = 0;
-    return true;
-  }
-  for(size_t i = 1; i < blocks;) {
-    if(!bitfield::test(bitfield, blocks, i) &&
-       !bitfield::test(useBitfield, blocks, i)) {
-      // If previous piece has already been retrieved, we can download
-      // from this index.
-      if(!bitfield::test(useBitfield, blocks, i-1) &&
-         bitfield::test(bitfield, blocks, i-1)) {
-        index = i;
-        return true;
-      }
-      // Check free space of minSplitSize.
-      size_t j;
-      for(j = i; j < blocks; ++j) {
-        if(bitfield::test(bitfield, blocks, j) ||
-           bitfield::test(useBitfield, blocks, j)) {
-          break;
-        }
-        if((j-i+1)*blockLength_ >= minSplitSize) {
-          index = j;
-          return true;
-        }
-      }
-      i = j+1;
-    } else {
-      ++i;
+  // The number of free blocks needed to hold minSplitSize bytes.
+  size_t minBlocks = std::max(static_cast<size_t>(1),
+                              (minSplitSize+blockLength_-1)/blockLength_);
+  // bitfield includes useBitfield, so unset bits are free blocks.
+  for(size_t i = bitfield::getNextUnsetBitIndex(bitfield, blocks, 0);
+      i < blocks;) {
+    // We always return first piece if it is available. If previous
+    // piece has already been retrieved, we can download from this
+    // index.
+    if(i == 0 || !bitfield::test(useBitfield, blocks, i-1)) {
+      index = i;
+      return true;
+    }
+    // Check free space of minSplitSize.
+    size_t end = bitfield::getNextSetBitIndex(bitfield, blocks, i);
+    if(end-i >= minBlocks) {
+      index = i+minBlocks-1;
+      return true;
+    }
+    if(end == blocks) {
+      break;
     }
+    i = bitfield::getNextUnsetBitIndex(bitfield, blocks, end);
   }
   return false;
 }
@@ -439,32 +397,12 @@ bool BitfieldMan::getInorderMissingUnusedIndex
   }
 }
 
-namespace {
-template<typename Array>
-bool copyBitfield(unsigned char* dst, const Array& src, size_t blocks)
-{
-  unsigned char bits = 0;
-  size_t len = (blocks+7)/8;
-  for(size_t i = 0; i < len-1; ++i) {
-    dst[i] = src[i];
-    bits |= dst[i];
-  }
-  dst[len-1] = src[len-1]&bitfield::lastByteMask(blocks);
-  bits |= dst[len-1];
-  return bits != 0;
-}
-} // namespace
-
 bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len)
   const
 {
   assert(len == bitfieldLength_);
-  if(filterEnabled_) {
-    return copyBitfield
-      (misbitfield, ~array(bitfield_)&array(filterBitfield_), blocks_);
-  } else {
-    return copyBitfield(misbitfield, ~array(bitfield_), blocks_);
-  }
+  return bitfield::andNot(misbitfield, filterEnabled_ ? filterBitfield_ : 0, 0,
+                          bitfield_, 0, blocks_);
 }
 
 bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len,
@@ -475,16 +413,17 @@ bool BitfieldMan::getAllMissingIndexes(unsigned char* misbitfield, size_t len,
   if(bitfieldLength_ != peerBitfieldLength) {
     return false;
   }
-  if(filterEnabled_) {
-    return copyBitfield
-      (misbitfield,
-       ~array(bitfield_)&array(peerBitfield)&array(filterBitfield_),
-       blocks_);
-  } else {
-    return copyBitfield
-      (misbitfield, ~array(bitfield_)&array(peerBitfield),
-       blocks_);
-  }
+  return bitfield::andNot(misbitfield, peerBitfield,
+                          filterEnabled_ ? filterBitfield_ : 0,
+                          bitfield_, 0, blocks_);
+}
+
+bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
+                                             size_t len) const
+{
+  assert(len == bitfieldLength_);
+  return bitfield::andNot(misbitfield, filterEnabled_ ? filterBitfield_ : 0, 0,
+                          bitfield_, useBitfield_, blocks_);
 }
 
 bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
@@ -496,18 +435,9 @@ bool BitfieldMan::getAllMissingUnusedIndexes(unsigned char* misbitfield,
   if(bitfieldLength_ != peerBitfieldLength) {
     return false;
   }
-  if(filterEnabled_) {
-    return copyBitfield
-      (misbitfield,
-       ~array(bitfield_)&~array(useBitfield_)&array(peerBitfield)&
-       array(filterBitfield_),
-       blocks_);
-  } else {
-    return copyBitfield
-      (misbitfield,
-       ~array(bitfield_)&~array(useBitfield_)&array(peerBitfield),
-       blocks_);
-  }
+  return bitfield::andNot(misbitfield, peerBitfield,
+                          filterEnabled_ ? filterBitfield_ : 0,
+                          bitfield_, useBitfield_, blocks_);
 }
 
 size_t BitfieldMan::countMissingBlock() const {
@@ -516,13 +446,8 @@ size_t BitfieldMan::countMissingBlock() const {
 
 size_t BitfieldMan::countMissingBlockNow() const {
   if(filterEnabled_) {
-    array_ptr<unsigned char> temp(new unsigned char[bitfieldLength_]);
-    for(size_t i = 0; i < bitfieldLength_; ++i) {
-      temp[i] = bitfield_[i]&filterBitfield_[i];
-    }
-    size_t count =  bitfield::countSetBit(filterBitfield_, blocks_)-
-      bitfield::countSetBit(temp, blocks_);
-    return count;
+    return bitfield::countSetBit(filterBitfield_, blocks_)-
+      bitfield::countSetBitAnd(bitfield_, filterBitfield_, blocks_);
   } else {
     return blocks_-bitfield::countSetBit(bitfield_, blocks_);
   }
@@ -569,12 +494,7 @@ bool BitfieldMan::unsetBit(size_t index) {
 
 bool BitfieldMan::isFilteredAllBitSet() const {
   if(filterEnabled_) {
-    for(size_t i = 0; i < bitfieldLength_; ++i) {
-      if((bitfield_[i]&filterBitfield_[i]) != filterBitfield_[i]) {
-        return false;
-      }
-    }
-    return true;
+    return !bitfield::andNot(0, filterBitfield_, 0, bitfield_, 0, blocks_);
   } else {
     return isAllBitSet();
   }
@@ -619,6 +539,11 @@ bool BitfieldMan::isUseBitSet(size_t index) const
   return bitfield::test(useBitfield_, blocks_, index);
 }
 
+bool BitfieldMan::isFilteredBit(size_t index) const
+{
+  return !filterEnabled_ || bitfield::test(filterBitfield_, blocks_, index);
+}
+
 void BitfieldMan::setBitfield(const unsigned char* bitfield, size_t bitfieldLength) {
   if(bitfieldLength_ != bitfieldLength) {
     return;
@@ -633,10 +558,19 @@ void BitfieldMan::clearAllBit() {
   updateCache();
 }
 
-void BitfieldMan::setAllBit() {
-  for(size_t i = 0; i < blocks_; ++i) {
-    setBitInternal(bitfield_, i, true);
+namespace {
+void setAllBitInternal(unsigned char* bitfield, size_t length, size_t blocks)
+{
+  if(length == 0) {
+    return;
   }
+  memset(bitfield, 0xff, length-1);
+  bitfield[length-1] = bitfield::lastByteMask(blocks);
+}
+} // namespace
+
+void BitfieldMan::setAllBit() {
+  setAllBitInternal(bitfield_, bitfieldLength_, blocks_);
   updateCache();
 }
 
@@ -646,9 +580,7 @@ void BitfieldMan::clearAllUseBit() {
 }
 
 void BitfieldMan::setAllUseBit() {
-  for(size_t i = 0; i < blocks_; ++i) {
-    setBitInternal(useBitfield_, i, true);
-  }
+  setAllBitInternal(useBitfield_, bitfieldLength_, blocks_);
 }
 
 bool BitfieldMan::setFilterBit(size_t index) {
@@ -742,33 +674,26 @@ uint64_t BitfieldMan::getFilteredTotalLengthNow() const {
 }
 
 uint64_t BitfieldMan::getCompletedLength(bool useFilter) const {
-  unsigned char* temp;
-  if(useFilter) {
-    temp = new unsigned char[bitfieldLength_];
-    for(size_t i = 0; i < bitfieldLength_; ++i) {
-      temp[i] = bitfield_[i];
-      if(filterEnabled_) {
-        temp[i] &= filterBitfield_[i];
-      }
-    }
+  size_t completedBlocks;
+  bool lastBlockCompleted;
+  if(useFilter && filterEnabled_) {
+    completedBlocks =
+      bitfield::countSetBitAnd(bitfield_, filterBitfield_, blocks_);
+    lastBlockCompleted = completedBlocks > 0 &&
+      bitfield::test(bitfield_, blocks_, blocks_-1) &&
+      bitfield::test(filterBitfield_, blocks_, blocks_-1);
   } else {
-    temp = bitfield_;
+    completedBlocks = bitfield::countSetBit(bitfield_, blocks_);
+    lastBlockCompleted = completedBlocks > 0 &&
+      bitfield::test(bitfield_, blocks_, blocks_-1);
   }
-  size_t completedBlocks = bitfield::countSetBit(temp, blocks_);
-  uint64_t completedLength = 0;
   if(completedBlocks == 0) {
-    completedLength = 0;
+    return 0;
+  } else if(lastBlockCompleted) {
+    return ((uint64_t)completedBlocks-1)*blockLength_+getLastBlockLength();
   } else {
-    if(bitfield::test(temp, blocks_, blocks_-1)) {
-      completedLength = ((uint64_t)completedBlocks-1)*blockLength_+getLastBlockLength();
-    } else {
-      completedLength = ((uint64_t)completedBlocks)*blockLength_;
-    }
+    return ((uint64_t)completedBlocks)*blockLength_;
   }
-  if(useFilter) {
-    delete [] temp;
-  }
-  return completedLength;
 }
 
 uint64_t BitfieldMan::getCompletedLengthNow() const {
@@ -801,7 +726,7 @@ bool BitfieldMan::isBitRangeSet(size_t startIndex, size_t endIndex) const
 void BitfieldMan::unsetBitRange(size_t startIndex, size_t endIndex)
 {
   for(size_t i = startIndex; i <= endIndex; ++i) {
-    unsetBit(i);
+    setBitInternal(bitfield_, i, false);
   }
   updateCache();
 }
@@ -809,7 +734,7 @@ void BitfieldMan::unsetBitRange(size_t startIndex, size_t endIndex)
 void BitfieldMan::setBitRange(size_t startIndex, size_t endIndex)
 {
   for(size_t i = startIndex; i <= endIndex; ++i) {
-    setBit(i);
+    setBitInternal(bitfield_, i, true);
   }
   updateCache();
 }
@@ -176,6 +176,9 @@ public:
   bool getAllMissingIndexes(unsigned char* misbitfield, size_t mislen,
                             const unsigned char* bitfield, size_t len) const;
   // affected by filter
+  bool getAllMissingUnusedIndexes(unsigned char* misbitfield, size_t mislen)
+    const;
+  // affected by filter
   bool getAllMissingUnusedIndexes(unsigned char* misbitfield, size_t mislen,
                                   const unsigned char* bitfield,
                                   size_t len) const;
@@ -193,6 +196,8 @@ public:
 
   bool isBitSet(size_t index) const;
   bool isUseBitSet(size_t index) const;
+  // Returns true if filter is disabled or index-th filter bit is set.
+  bool isFilteredBit(size_t index) const;
 
   // affected by filter
   bool isFilteredAllBitSet() const;
@@ -298,6 +303,11 @@ public:
   {
     return filterBitfield_;
   }
+
+  const unsigned char* getUseBitfield() const
+  {
+    return useBitfield_;
+  }
 };
 
 } // namespace aria2
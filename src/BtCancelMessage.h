@@ -36,6 +36,7 @@
 #define D_BT_CANCEL_MESSAGE_H
 
 #include "RangeBtMessage.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
@@ -43,7 +44,8 @@ class BtCancelMessage;
 
 typedef SharedHandle<BtCancelMessage> BtCancelMessageHandle;
 
-class BtCancelMessage : public RangeBtMessage {
+class BtCancelMessage : public RangeBtMessage,
+                        public PooledObject<BtCancelMessage> {
 public:
   BtCancelMessage(size_t index = 0, uint32_t begin = 0, size_t length = 0);
 
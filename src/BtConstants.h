@@ -56,7 +56,23 @@ typedef std::map<std::string, uint8_t> Extensions;
 #define OUTSTANDING_REQUEST_STEP 6
 
 // Upper Bound of the number of outstanding request
-#define UB_MAX_OUTSTANDING_REQUEST 256
+#define UB_MAX_OUTSTANDING_REQUEST 1024
+
+// The number of outstanding requests a peer is assumed to accept if
+// it does not tell reqq in extended handshake.
+#define DEFAULT_PEER_REQQ 250
+
+// The number of requests from a peer which aria2 queues. It is told
+// to peers as reqq in extended handshake, and requests beyond it are
+// rejected.
+#define MAX_INCOMING_REQUEST 250
+
+// Choking algorithms unchoke more peers than the regular upload slots
+// while the n-th additional peer gets more than n times this many
+// bytes per second, up to MAX_EXTRA_UPLOAD_SLOTS peers.
+#define UPLOAD_SLOT_SPEED_STEP (2*1024)
+
+#define MAX_EXTRA_UPLOAD_SLOTS 4
 
 #define METADATA_PIECE_SIZE (16*1024)
 
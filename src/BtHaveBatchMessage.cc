@@ -0,0 +1,78 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "BtHaveBatchMessage.h"
+#include "BtHaveMessage.h"
+#include "util.h"
+#include "a2functional.h"
+#include "bittorrent_helper.h"
+
+namespace aria2 {
+
+const std::string BtHaveBatchMessage::NAME("have batch");
+
+namespace {
+// The length of one HAVE message.
+const size_t HAVE_MESSAGE_LENGTH = 9;
+} // namespace
+
+BtHaveBatchMessage::BtHaveBatchMessage(const std::vector<size_t>& indexes)
+  : SimpleBtMessage(BtHaveMessage::ID, NAME),
+    indexes_(indexes)
+{}
+
+unsigned char* BtHaveBatchMessage::createMessage()
+{
+  unsigned char* msg = new unsigned char[getMessageLength()];
+  unsigned char* p = msg;
+  for(std::vector<size_t>::const_iterator i = indexes_.begin(),
+        eoi = indexes_.end(); i != eoi; ++i, p += HAVE_MESSAGE_LENGTH) {
+    bittorrent::createPeerMessageString(p, HAVE_MESSAGE_LENGTH, 5,
+                                        BtHaveMessage::ID);
+    bittorrent::setIntParam(&p[5], *i);
+  }
+  return msg;
+}
+
+size_t BtHaveBatchMessage::getMessageLength()
+{
+  return HAVE_MESSAGE_LENGTH*indexes_.size();
+}
+
+std::string BtHaveBatchMessage::toString() const
+{
+  return strconcat(NAME, " count=", util::uitos(indexes_.size()));
+}
+
+} // namespace aria2
@@ -37,6 +37,7 @@
 #include "PieceStorage.h"
 #include "message.h"
 #include "DlAbortEx.h"
+#include "SuperSeeder.h"
 
 namespace aria2 {
 
@@ -57,6 +58,10 @@ void BtHaveMessage::doReceivedAction()
   }
   getPeer()->updateBitfield(getIndex(), 1);
   getPieceStorage()->addPieceStats(getIndex());
+  SharedHandle<SuperSeeder> superSeeder = getPieceStorage()->getSuperSeeder();
+  if(superSeeder) {
+    superSeeder->updatePeerHave(getCuid(), getIndex());
+  }
   if(getPeer()->isSeeder() && getPieceStorage()->downloadFinished()) {
     throw DL_ABORT_EX(MSG_GOOD_BYE_SEEDER);
   }
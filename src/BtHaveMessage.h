@@ -36,6 +36,7 @@
 #define D_BT_HAVE_MESSAGE_H
 
 #include "IndexBtMessage.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
@@ -43,7 +44,8 @@ class BtHaveMessage;
 
 typedef SharedHandle<BtHaveMessage> BtHaveMessageHandle;
 
-class BtHaveMessage : public IndexBtMessage {
+class BtHaveMessage : public IndexBtMessage,
+                      public PooledObject<BtHaveMessage> {
 public:
   BtHaveMessage(size_t index = 0);
 
@@ -36,6 +36,7 @@
 #define D_BT_KEEP_ALIVE_MESSAGE_H
 
 #include "SimpleBtMessage.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
@@ -43,7 +44,8 @@ class BtKeepAliveMessage;
 
 typedef SharedHandle<BtKeepAliveMessage> BtKeepAliveMessageHandle;
 
-class BtKeepAliveMessage : public SimpleBtMessage {
+class BtKeepAliveMessage : public SimpleBtMessage,
+                           public PooledObject<BtKeepAliveMessage> {
 private:
   static const size_t MESSAGE_LENGTH = 4;
 public:
@@ -37,6 +37,7 @@
 #include <algorithm>
 
 #include "Peer.h"
+#include "BtConstants.h"
 #include "Logger.h"
 #include "LogFactory.h"
 #include "SimpleRandomizer.h"
@@ -53,7 +54,8 @@ BtLeecherStateChoke::BtLeecherStateChoke()
 BtLeecherStateChoke::~BtLeecherStateChoke() {}
 
 BtLeecherStateChoke::PeerEntry::PeerEntry(const SharedHandle<Peer>& peer):
-  peer_(peer), downloadSpeed_(peer->calculateDownloadSpeed()),
+  peer_(peer), downloadSpeed_(peer->calculateDownloadRate()),
+  uploadSpeed_(peer->calculateUploadRate()),
   // peer must be interested to us and sent block in the last 30 seconds
   regularUnchoker_
   (peer->peerInterested() &&
@@ -62,6 +64,7 @@ BtLeecherStateChoke::PeerEntry::PeerEntry(const SharedHandle<Peer>& peer):
 BtLeecherStateChoke::PeerEntry::PeerEntry(const PeerEntry& c)
   : peer_(c.peer_),
     downloadSpeed_(c.downloadSpeed_),
+    uploadSpeed_(c.uploadSpeed_),
     regularUnchoker_(c.regularUnchoker_)
 {}
 
@@ -70,6 +73,7 @@ void BtLeecherStateChoke::PeerEntry::swap(PeerEntry& c)
   using std::swap;
   swap(peer_, c.peer_);
   swap(downloadSpeed_, c.downloadSpeed_);
+  swap(uploadSpeed_, c.uploadSpeed_);
   swap(regularUnchoker_, c.regularUnchoker_);
 }
 
@@ -79,6 +83,7 @@ BtLeecherStateChoke::PeerEntry& BtLeecherStateChoke::PeerEntry::operator=
   if(this != &c) {
     peer_ = c.peer_;
     downloadSpeed_ = c.downloadSpeed_;
+    uploadSpeed_ = c.uploadSpeed_;
     regularUnchoker_ = c.regularUnchoker_;
   }
   return *this;
@@ -96,6 +101,16 @@ unsigned int BtLeecherStateChoke::PeerEntry::getDownloadSpeed() const
   return downloadSpeed_;
 }
 
+unsigned int BtLeecherStateChoke::PeerEntry::getUploadSpeed() const
+{
+  return uploadSpeed_;
+}
+
+bool BtLeecherStateChoke::PeerEntry::isInterested() const
+{
+  return peer_->peerInterested();
+}
+
 bool BtLeecherStateChoke::PeerEntry::isRegularUnchoker() const
 {
   return regularUnchoker_;
@@ -186,6 +201,26 @@ void BtLeecherStateChoke::regularUnchoke(std::vector<PeerEntry>& peerEntries)
       (*peerIter).disableOptUnchoking();
     }
   }
+  // More slots are added while the peers take more than a threshold
+  // which grows with each slot. Once the upload bandwidth is used up,
+  // the upload speed of each peer drops below the threshold.
+  std::vector<PeerEntry>::iterator interested =
+    std::partition(peerIter, peerEntries.end(),
+                   std::mem_fun_ref(&PeerEntry::isInterested));
+  std::sort(peerIter, interested, UploadSpeedGreater());
+  for(unsigned int threshold = UPLOAD_SLOT_SPEED_STEP;
+      peerIter != interested && (*peerIter).getUploadSpeed() > threshold &&
+        threshold <= UPLOAD_SLOT_SPEED_STEP*MAX_EXTRA_UPLOAD_SLOTS;
+      ++peerIter, threshold += UPLOAD_SLOT_SPEED_STEP) {
+    (*peerIter).disableChokingRequired();
+    A2_LOG_INFO(fmt("RU(extra): %s, ulspd=%u",
+                    (*peerIter).getPeer()->getIPAddress().c_str(),
+                    (*peerIter).getUploadSpeed()));
+    if((*peerIter).getPeer()->optUnchoking()) {
+      fastOptUnchoker = true;
+      (*peerIter).disableOptUnchoking();
+    }
+  }
   if(fastOptUnchoker) {
     std::random_shuffle(peerIter, peerEntries.end(),
                         *(SimpleRandomizer::getInstance().get()));
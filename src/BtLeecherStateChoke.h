@@ -56,6 +56,7 @@ private:
   private:
     SharedHandle<Peer> peer_;
     unsigned int downloadSpeed_;
+    unsigned int uploadSpeed_;
     bool regularUnchoker_;
   public:
     PeerEntry(const SharedHandle<Peer>& peer);
@@ -72,6 +73,10 @@ private:
 
     unsigned int getDownloadSpeed() const;
 
+    unsigned int getUploadSpeed() const;
+
+    bool isInterested() const;
+
     bool isRegularUnchoker() const;
 
     bool isSnubbing() const;
@@ -89,6 +94,14 @@ private:
 
   void regularUnchoke(std::vector<PeerEntry>& peerEntries);
 
+  class UploadSpeedGreater {
+  public:
+    bool operator()(const PeerEntry& lhs, const PeerEntry& rhs) const
+    {
+      return lhs.getUploadSpeed() > rhs.getUploadSpeed();
+    }
+  };
+
   class PeerFilter {
   private:
     bool amChoking_;
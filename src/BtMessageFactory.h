@@ -36,6 +36,9 @@
 #define D_BT_MESSAGE_FACTORY_H
 
 #include "common.h"
+
+#include <vector>
+
 #include "SharedHandle.h"
 
 namespace aria2 {
@@ -70,6 +73,10 @@ public:
 
   virtual SharedHandle<BtMessage> createHaveMessage(size_t index) = 0;
 
+  // Creates a message which sends HAVE messages for indexes at once.
+  virtual SharedHandle<BtMessage> createHaveBatchMessage
+  (const std::vector<size_t>& indexes) = 0;
+
   virtual SharedHandle<BtMessage> createChokeMessage() = 0;
 
   virtual SharedHandle<BtMessage> createUnchokeMessage() = 0;
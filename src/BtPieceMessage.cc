@@ -55,6 +55,8 @@
 #include "PeerConnection.h"
 #include "fmt.h"
 #include "DownloadContext.h"
+#include "DiskWriteJob.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -67,23 +69,42 @@ BtPieceMessage::BtPieceMessage
     begin_(begin),
     blockLength_(blockLength),
     block_(0),
-    rawData_(0)
+    rawData_(0),
+    blockFreeList_(0)
 {
   setUploading(true);
 }
 
 BtPieceMessage::~BtPieceMessage()
 {
+  releaseBlock();
+}
+
+void BtPieceMessage::releaseBlock()
+{
+  if(blockFreeList_) {
+    blockFreeList_->deallocate(block_);
+    blockFreeList_ = 0;
+  }
   delete [] rawData_;
+  rawData_ = 0;
+  block_ = 0;
 }
 
 void BtPieceMessage::setRawMessage(unsigned char* data)
 {
-  delete [] rawData_;
+  releaseBlock();
   rawData_ = data;
   block_ = data+9;
 }
 
+void BtPieceMessage::setBlock(unsigned char* block, FreeList* freeList)
+{
+  releaseBlock();
+  block_ = block;
+  blockFreeList_ = freeList;
+}
+
 BtPieceMessageHandle BtPieceMessage::create
 (const unsigned char* data, size_t dataLength)
 {
@@ -105,6 +126,13 @@ void BtPieceMessage::doReceivedAction()
     (index_, begin_, blockLength_);
   getPeer()->updateDownloadLength(blockLength_);
   if(!RequestSlot::isNull(slot)) {
+    // Bytes received after the request was sent, excluding this
+    // block.
+    uint64_t received = getPeer()->getSessionDownloadLength();
+    uint64_t sent = slot.getSessionDownloadLength()+blockLength_;
+    getPeer()->updateRtt
+      (slot.getDispatchedTime().differenceInMillis(global::wallclock()),
+       received > sent ? received-sent : 0);
     getPeer()->snubbing(false);
     SharedHandle<Piece> piece = getPieceStorage()->getPiece(index_);
     off_t offset = (off_t)index_*downloadContext_->getPieceLength()+begin_;
@@ -119,13 +147,24 @@ void BtPieceMessage::doReceivedAction()
       A2_LOG_DEBUG("Already have this block.");
       return;
     }
-    getPieceStorage()->getDiskAdaptor()->writeData
-      (block_, blockLength_, offset);
+    // The block may be freed by the write cache below.
+    piece->updateHash(begin_, block_, blockLength_);
+    if(piece->getWrDiskCacheEntry()) {
+      if(blockFreeList_) {
+        piece->updateWrCache(block_, blockLength_, offset, blockFreeList_);
+        block_ = 0;
+        blockFreeList_ = 0;
+      } else {
+        piece->updateWrCache(block_, blockLength_, offset);
+      }
+    } else {
+      getPieceStorage()->getDiskAdaptor()->writeData
+        (block_, blockLength_, offset);
+    }
     piece->completeBlock(slot.getBlockIndex());
     A2_LOG_DEBUG(fmt(MSG_PIECE_BITFIELD, getCuid(),
                      util::toHex(piece->getBitfield(),
                                  piece->getBitfieldLength()).c_str()));
-    piece->updateHash(begin_, block_, blockLength_);
     getBtMessageDispatcher()->removeOutstandingRequest(slot);
     if(piece->pieceComplete()) {
       if(checkPieceHash(piece)) {
@@ -195,18 +234,26 @@ void BtPieceMessage::send()
 
 void BtPieceMessage::pushPieceData(off_t offset, size_t length) const
 {
-  assert(length <= 16*1024);
-  unsigned char* buf = new unsigned char[length];
+  assert(length <= MAX_BLOCK_LENGTH);
+  if(getPeerConnection()->pushFileData
+     (getPieceStorage()->getDiskAdaptor(), offset, length)) {
+    return;
+  }
+  // The buffer is returned to the free list by SocketBuffer after it
+  // is sent.
+  FreeList& freeList = bittorrent::getBlockBufferList();
+  unsigned char* buf = static_cast<unsigned char*>(freeList.allocate());
   ssize_t r;
   try {
     r = getPieceStorage()->getDiskAdaptor()->readData(buf, length, offset);
   } catch(RecoverableException& e) {
-    delete [] buf;
+    freeList.deallocate(buf);
     throw;
   }
   if(r == static_cast<ssize_t>(length)) {
-    getPeerConnection()->pushBytes(buf, length);
+    getPeerConnection()->pushBytes(buf, length, &freeList);
   } else {
+    freeList.deallocate(buf);
     throw DL_ABORT_EX(EX_DATA_READ);
   }
 }
@@ -224,6 +271,12 @@ bool BtPieceMessage::checkPieceHash(const SharedHandle<Piece>& piece)
                      static_cast<unsigned long>(piece->getIndex())));
     return
       piece->getDigest() == downloadContext_->getPieceHash(piece->getIndex());
+  } else if(piece->getWrDiskCacheEntry()) {
+    // Use cached data and read the rest from the disk.
+    return piece->getDigestWithWrCache
+      (downloadContext_->getPieceLength(),
+       getPieceStorage()->getDiskAdaptor())
+      == downloadContext_->getPieceHash(piece->getIndex());
   } else {
     off_t offset = (off_t)piece->getIndex()*downloadContext_->getPieceLength();
     return message_digest::staticSHA1Digest
@@ -237,6 +290,11 @@ void BtPieceMessage::onNewPiece(const SharedHandle<Piece>& piece)
   A2_LOG_INFO(fmt(MSG_GOT_NEW_PIECE,
                   getCuid(),
                   static_cast<unsigned long>(piece->getIndex())));
+  if(piece->getWrDiskCacheEntry() &&
+     piece->flushWrCacheAsync(0, getPieceStorage(), piece, getCuid())) {
+    // The piece is completed when its data are written.
+    return;
+  }
   getPieceStorage()->completePiece(piece);
   getPieceStorage()->advertisePiece(getCuid(), piece->getIndex());
 }
@@ -259,13 +317,13 @@ void BtPieceMessage::erasePieceOnDisk(const SharedHandle<Piece>& piece)
   memset(buf, 0, BUFSIZE);
   off_t offset = (off_t)piece->getIndex()*downloadContext_->getPieceLength();
   div_t res = div(piece->getLength(), BUFSIZE);
-  for(int i = 0; i < res.quot; ++i) {
-    getPieceStorage()->getDiskAdaptor()->writeData(buf, BUFSIZE, offset);
-    offset += BUFSIZE;
-  }
+  // All buffers point to the same zero-filled buf, so that the whole
+  // piece is erased with one vectored write.
+  std::vector<DataBuffer> bufs(res.quot, DataBuffer(buf, BUFSIZE));
   if(res.rem > 0) {
-    getPieceStorage()->getDiskAdaptor()->writeData(buf, res.rem, offset);
+    bufs.push_back(DataBuffer(buf, res.rem));
   }
+  getPieceStorage()->getDiskAdaptor()->writeDataVector(bufs, offset);
 }
 
 void BtPieceMessage::onChokingEvent(const BtChokingEvent& event)
@@ -36,6 +36,7 @@
 #define D_BT_PIECE_MESSAGE_H
 
 #include "AbstractBtMessage.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
@@ -45,13 +46,17 @@ class DownloadContext;
 
 typedef SharedHandle<BtPieceMessage> BtPieceMessageHandle;
 
-class BtPieceMessage : public AbstractBtMessage {
+class BtPieceMessage : public AbstractBtMessage,
+                       public PooledObject<BtPieceMessage> {
 private:
   size_t index_;
   uint32_t begin_;
   uint32_t blockLength_;
   unsigned char* block_;
   unsigned char* rawData_;
+  // If not null, block_ was allocated by this free list and is owned
+  // by this object.
+  FreeList* blockFreeList_;
   SharedHandle<DownloadContext> downloadContext_;
 
   static size_t MESSAGE_HEADER_LENGTH;
@@ -65,6 +70,9 @@ private:
   void erasePieceOnDisk(const SharedHandle<Piece>& piece);
 
   void pushPieceData(off_t offset, size_t length) const;
+
+  // Frees the received block.
+  void releaseBlock();
 public:
   BtPieceMessage(size_t index = 0, uint32_t begin = 0, size_t blockLength = 0);
 
@@ -91,6 +99,12 @@ public:
   // Member block is pointed to block starting position in data.
   void setRawMessage(unsigned char* data);
 
+  // Stores block, which was allocated by freeList. After this
+  // function call, this object has ownership of block. When the
+  // block is written through the write cache, it is handed to the
+  // cache without copying it.
+  void setBlock(unsigned char* block, FreeList* freeList);
+
   void setBlockLength(size_t blockLength) { blockLength_ = blockLength; }
 
   void setDownloadContext(const SharedHandle<DownloadContext>& downloadContext);
@@ -38,6 +38,8 @@
 #include "PieceStorage.h"
 #include "BtMessageDispatcher.h"
 #include "BtMessageFactory.h"
+#include "SuperSeeder.h"
+#include "BtConstants.h"
 
 namespace aria2 {
 
@@ -59,7 +61,13 @@ void BtRequestMessage::doReceivedAction()
   if(isMetadataGetMode()) {
     return;
   }
+  SharedHandle<SuperSeeder> superSeeder = getPieceStorage()->getSuperSeeder();
+  // Requests beyond reqq we advertised are not queued, so that a peer
+  // cannot make us hold an unbounded amount of pending upload.
   if(getPieceStorage()->hasPiece(getIndex()) &&
+     getBtMessageDispatcher()->countOutstandingUpload() <
+     MAX_INCOMING_REQUEST &&
+     (!superSeeder || superSeeder->canUpload(getCuid(), getIndex())) &&
      (!getPeer()->amChoking() ||
       (getPeer()->amChoking() &&
        getPeer()->isInAmAllowedIndexSet(getIndex())))) {
@@ -81,6 +89,7 @@ void BtRequestMessage::onQueued()
 {
   RequestSlot requestSlot(getIndex(), getBegin(), getLength(), blockIndex_,
                           getPieceStorage()->getPiece(getIndex()));
+  requestSlot.setSessionDownloadLength(getPeer()->getSessionDownloadLength());
   getBtMessageDispatcher()->addOutstandingRequest(requestSlot);
 }
 
@@ -36,6 +36,7 @@
 #define D_BT_REQUEST_MESSAGE_H
 
 #include "RangeBtMessage.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
@@ -43,7 +44,8 @@ class BtRequestMessage;
 
 typedef SharedHandle<BtRequestMessage> BtRequestMessageHandle;
 
-class BtRequestMessage : public RangeBtMessage {
+class BtRequestMessage : public RangeBtMessage,
+                         public PooledObject<BtRequestMessage> {
 private:
   size_t blockIndex_;
 public:
@@ -37,6 +37,7 @@
 #include <algorithm>
 
 #include "Peer.h"
+#include "BtConstants.h"
 #include "Logger.h"
 #include "LogFactory.h"
 #include "SimpleRandomizer.h"
@@ -58,7 +59,7 @@ BtSeederStateChoke::PeerEntry::PeerEntry
   outstandingUpload_(peer->countOutstandingUpload()),
   lastAmUnchoking_(peer->getLastAmUnchoking()),
   recentUnchoking_(lastAmUnchoking_.difference(global::wallclock()) < TIME_FRAME),
-  uploadSpeed_(peer->calculateUploadSpeed())
+  uploadSpeed_(peer->calculateUploadRate())
 {}
 
 BtSeederStateChoke::PeerEntry::PeerEntry(const PeerEntry& c)
@@ -138,6 +139,19 @@ void BtSeederStateChoke::unchoke
                     (*r).getPeer()->getIPAddress().c_str(),
                     (*r).getUploadSpeed()));
   }
+  // More slots are added while the peers take more than a threshold
+  // which grows with each slot. Once the upload bandwidth is used up,
+  // the upload speed of each peer drops below the threshold.
+  std::sort(r, peers.end(), UploadSpeedGreater());
+  for(unsigned int threshold = UPLOAD_SLOT_SPEED_STEP;
+      r != peers.end() && (*r).getUploadSpeed() > threshold &&
+        threshold <= UPLOAD_SLOT_SPEED_STEP*MAX_EXTRA_UPLOAD_SLOTS;
+      ++r, threshold += UPLOAD_SLOT_SPEED_STEP) {
+    (*r).getPeer()->chokingRequired(false);
+    A2_LOG_INFO(fmt("RU(extra): %s, ulspd=%u",
+                    (*r).getPeer()->getIPAddress().c_str(),
+                    (*r).getUploadSpeed()));
+  }
 
   if(round_ < 2) {
     std::for_each(peers.begin(), peers.end(),
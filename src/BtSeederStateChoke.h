@@ -89,6 +89,14 @@ private:
     }
   };
 
+  class UploadSpeedGreater {
+  public:
+    bool operator()(const PeerEntry& lhs, const PeerEntry& rhs) const
+    {
+      return lhs.getUploadSpeed() > rhs.getUploadSpeed();
+    }
+  };
+
   class NotInterestedPeer {
   public:
     bool operator()(const PeerEntry& peerEntry) const;
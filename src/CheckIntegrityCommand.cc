@@ -53,19 +53,26 @@ CheckIntegrityCommand::CheckIntegrityCommand
  const SharedHandle<CheckIntegrityEntry>& entry):
   RealtimeCommand(cuid, requestGroup, e),
   entry_(entry)
-{}
+{
+  if(e->getThreadPool() && !requestGroup->inMemoryDownload()) {
+    entry_->enableAsyncValidation(e, this);
+  }
+}
 
-CheckIntegrityCommand::~CheckIntegrityCommand() {}
+CheckIntegrityCommand::~CheckIntegrityCommand()
+{
+  entry_->disableAsyncValidation();
+}
 
 bool CheckIntegrityCommand::executeInternal()
 {
   if(getRequestGroup()->isHaltRequested()) {
-    getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
+    getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry(entry_);
     return true;
   }
   entry_->validateChunk();
   if(entry_->finished()) {
-    getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
+    getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry(entry_);
     // Enable control file saving here. See also
     // RequestGroup::processCheckIntegrityEntry() to know why this is
     // needed.
@@ -92,6 +99,10 @@ bool CheckIntegrityCommand::executeInternal()
     getDownloadEngine()->setNoWait(true);
     return true;
   } else {
+    if(entry_->isWaitingJob()) {
+      // Sleep until a hashing job is done.
+      setStatusInactive();
+    }
     getDownloadEngine()->addCommand(this);
     return false;
   }
@@ -99,7 +110,7 @@ bool CheckIntegrityCommand::executeInternal()
 
 bool CheckIntegrityCommand::handleException(Exception& e)
 {
-  getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry();
+  getDownloadEngine()->getCheckIntegrityMan()->dropPickedEntry(entry_);
   A2_LOG_ERROR_EX(fmt(MSG_FILE_VALIDATION_FAILURE,
                    getCuid()),
                   e);
@@ -79,6 +79,26 @@ bool CheckIntegrityEntry::finished()
   return validator_->finished();
 }
 
+void CheckIntegrityEntry::enableAsyncValidation
+(DownloadEngine* e, Command* command)
+{
+  if(validator_) {
+    validator_->enableAsyncValidation(e, command);
+  }
+}
+
+void CheckIntegrityEntry::disableAsyncValidation()
+{
+  if(validator_) {
+    validator_->disableAsyncValidation();
+  }
+}
+
+bool CheckIntegrityEntry::isWaitingJob() const
+{
+  return validator_ && validator_->isWaitingJob();
+}
+
 void CheckIntegrityEntry::cutTrailingGarbage()
 {
   getRequestGroup()->getPieceStorage()->getDiskAdaptor()->cutTrailingGarbage();
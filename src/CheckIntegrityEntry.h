@@ -69,6 +69,16 @@ public:
 
   virtual bool finished();
 
+  // Lets the validator hash data in the worker threads of e if it
+  // supports it. command is woken up whenever a job is done.
+  void enableAsyncValidation(DownloadEngine* e, Command* command);
+
+  void disableAsyncValidation();
+
+  // Returns true if validateChunk() has nothing to do until a job
+  // running in a worker thread is done.
+  bool isWaitingJob() const;
+
   virtual bool isValidationReady() = 0;
 
   virtual void initValidator() = 0;
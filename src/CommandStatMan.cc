@@ -0,0 +1,124 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "CommandStatMan.h"
+
+#ifdef HAVE_CXXABI_H
+# include <cxxabi.h>
+#endif // HAVE_CXXABI_H
+
+#include <cstdlib>
+#include <algorithm>
+
+#include "Command.h"
+
+namespace aria2 {
+
+CommandStat::CommandStat()
+  : count_(0),
+    totalTime_(0),
+    maxTime_(0)
+{
+  std::fill(&histogram_[0], &histogram_[NUM_BUCKETS], 0);
+}
+
+void CommandStat::update(int64_t micros)
+{
+  if(micros < 0) {
+    micros = 0;
+  }
+  ++count_;
+  totalTime_ += micros;
+  maxTime_ = std::max(maxTime_, static_cast<uint64_t>(micros));
+  ++histogram_[getBucketIndex(micros)];
+}
+
+size_t CommandStat::getBucketIndex(int64_t micros)
+{
+  size_t i = 0;
+  for(micros >>= 1; micros > 0 && i < NUM_BUCKETS-1; micros >>= 1) {
+    ++i;
+  }
+  return i;
+}
+
+void CommandStatMan::update(const Command* command, int64_t micros)
+{
+  stats_[&typeid(*command)].update(micros);
+}
+
+namespace {
+struct NameLess {
+  bool operator()(const std::pair<std::string, CommandStat>& lhs,
+                  const std::pair<std::string, CommandStat>& rhs) const
+  {
+    return lhs.first < rhs.first;
+  }
+};
+} // namespace
+
+void CommandStatMan::getStats
+(std::vector<std::pair<std::string, CommandStat> >& stats) const
+{
+  size_t first = stats.size();
+  for(std::map<const std::type_info*, CommandStat, TypeInfoLess>::
+        const_iterator i = stats_.begin(), eoi = stats_.end(); i != eoi; ++i) {
+    stats.push_back(std::make_pair(getClassName(*(*i).first), (*i).second));
+  }
+  std::sort(stats.begin()+first, stats.end(), NameLess());
+}
+
+std::string CommandStatMan::getClassName(const std::type_info& type)
+{
+  std::string name;
+#ifdef HAVE_CXXABI_H
+  int status;
+  char* demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+  if(demangled) {
+    name = demangled;
+    free(demangled);
+  } else {
+    name = type.name();
+  }
+#else // !HAVE_CXXABI_H
+  name = type.name();
+#endif // !HAVE_CXXABI_H
+  std::string::size_type p = name.rfind("::");
+  if(p != std::string::npos) {
+    name.erase(0, p+2);
+  }
+  return name;
+}
+
+} // namespace aria2
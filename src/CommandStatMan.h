@@ -0,0 +1,129 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_COMMAND_STAT_MAN_H
+#define D_COMMAND_STAT_MAN_H
+
+#include "common.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <typeinfo>
+
+namespace aria2 {
+
+class Command;
+
+// Call count and execution time of Command::execute() for one
+// concrete Command class.
+class CommandStat {
+public:
+  // Bucket 0 counts executions which took less than 2 microseconds.
+  // Bucket i (0 < i < NUM_BUCKETS-1) counts executions which took
+  // [2^i, 2^(i+1)) microseconds. The last bucket counts all slower
+  // ones.
+  static const size_t NUM_BUCKETS = 24;
+private:
+  uint64_t count_;
+
+  // In microseconds.
+  uint64_t totalTime_;
+
+  // In microseconds.
+  uint64_t maxTime_;
+
+  uint64_t histogram_[NUM_BUCKETS];
+public:
+  CommandStat();
+
+  void update(int64_t micros);
+
+  uint64_t getCount() const
+  {
+    return count_;
+  }
+
+  uint64_t getTotalTime() const
+  {
+    return totalTime_;
+  }
+
+  uint64_t getMaxTime() const
+  {
+    return maxTime_;
+  }
+
+  uint64_t getBucket(size_t i) const
+  {
+    return histogram_[i];
+  }
+
+  static size_t getBucketIndex(int64_t micros);
+};
+
+// Collects CommandStat for each concrete Command class. Command
+// classes are distinguished by RTTI, so no change is required in
+// Command subclasses.
+class CommandStatMan {
+private:
+  struct TypeInfoLess {
+    bool operator()(const std::type_info* lhs,
+                    const std::type_info* rhs) const
+    {
+      return lhs->before(*rhs);
+    }
+  };
+
+  std::map<const std::type_info*, CommandStat, TypeInfoLess> stats_;
+public:
+  void update(const Command* command, int64_t micros);
+
+  // Appends pairs of class name and its CommandStat to stats, sorted
+  // by class name.
+  void getStats
+  (std::vector<std::pair<std::string, CommandStat> >& stats) const;
+
+  void clear()
+  {
+    stats_.clear();
+  }
+
+  // Returns class name of type without namespace.
+  static std::string getClassName(const std::type_info& type);
+};
+
+} // namespace aria2
+
+#endif // D_COMMAND_STAT_MAN_H
@@ -339,9 +339,11 @@ ConsoleStatCalc::calculateStat(const DownloadEngine* e)
   }
 #ifdef ENABLE_MESSAGE_DIGEST
   {
-    SharedHandle<CheckIntegrityEntry> entry =
-      e->getCheckIntegrityMan()->getPickedEntry();
-    if(entry) {
+    const std::deque<SharedHandle<CheckIntegrityEntry> >& entries =
+      e->getCheckIntegrityMan()->getPickedEntries();
+    for(std::deque<SharedHandle<CheckIntegrityEntry> >::const_iterator i =
+          entries.begin(), eoi = entries.end(); i != eoi; ++i) {
+      const SharedHandle<CheckIntegrityEntry>& entry = *i;
       o << " "
         << "[Checksum:"
         << "#" << entry->getRequestGroup()->getGID() << " "
@@ -358,11 +360,11 @@ ConsoleStatCalc::calculateStat(const DownloadEngine* e)
       }
       o << "%)"
         << "]";
-      if(e->getCheckIntegrityMan()->hasNext()) {
-        o << "("
-          << e->getCheckIntegrityMan()->countEntryInQueue()
-          << "waiting...)";
-      }
+    }
+    if(!entries.empty() && e->getCheckIntegrityMan()->hasNext()) {
+      o << "("
+        << e->getCheckIntegrityMan()->countEntryInQueue()
+        << "waiting...)";
     }
   }
 #endif // ENABLE_MESSAGE_DIGEST
@@ -0,0 +1,217 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DeadlinePieceSelector.h"
+
+#include <algorithm>
+
+#include "BitfieldMan.h"
+#include "bitfield.h"
+#include "wallclock.h"
+
+namespace aria2 {
+
+namespace {
+// Pieces played within this time are selected by deadline.
+const int64_t LOOKAHEAD_MILLIS = 30*1000;
+// Pieces due within this time are downloaded by two connections.
+const int64_t DUPLICATE_DEADLINE_MILLIS = 3*1000;
+// A connection is fast if it is at least 1/FAST_RATIO as fast as the
+// fastest one.  A slow connection only gets pieces due after
+// FAST_RATIO times its expected download time.
+const unsigned int FAST_RATIO = 2;
+// The fastest speed is forgotten after this many seconds.
+const time_t FASTEST_SPEED_TIMEOUT = 10;
+} // namespace
+
+DeadlinePieceSelector::DeadlinePieceSelector(const BitfieldMan* bitfieldMan)
+  : bitfieldMan_(bitfieldMan),
+    position_(0),
+    bitrate_(0),
+    positionTimer_(global::wallclock()),
+    fastestSpeed_(0),
+    fastestSpeedTimer_(global::wallclock())
+{}
+
+void DeadlinePieceSelector::setPlayback
+(uint64_t position, unsigned int bitrate)
+{
+  position_ = std::min(position, bitfieldMan_->getTotalLength());
+  bitrate_ = bitrate;
+  positionTimer_ = global::wallclock();
+}
+
+uint64_t DeadlinePieceSelector::getPlaybackPosition() const
+{
+  int64_t elapsed =
+    std::max(static_cast<int64_t>(0),
+             positionTimer_.differenceInMillis(global::wallclock()));
+  return std::min(position_+static_cast<uint64_t>(elapsed)*bitrate_/1000,
+                  bitfieldMan_->getTotalLength());
+}
+
+int64_t DeadlinePieceSelector::getDeadline(size_t index) const
+{
+  uint64_t offset = static_cast<uint64_t>(index)*
+    bitfieldMan_->getBlockLength();
+  uint64_t position = getPlaybackPosition();
+  if(offset <= position || bitrate_ == 0) {
+    return 0;
+  }
+  return (offset-position)*1000/bitrate_;
+}
+
+size_t DeadlinePieceSelector::getLastWindowIndex(uint64_t position) const
+{
+  uint64_t end = position+static_cast<uint64_t>(bitrate_)*
+    LOOKAHEAD_MILLIS/1000;
+  return std::min(static_cast<uint64_t>(bitfieldMan_->countBlock()-1),
+                  end/bitfieldMan_->getBlockLength());
+}
+
+void DeadlinePieceSelector::updateFastestSpeed(unsigned int speed)
+{
+  if(speed == 0) {
+    return;
+  }
+  if(fastestSpeed_ <= speed ||
+     fastestSpeedTimer_.difference(global::wallclock()) >=
+     FASTEST_SPEED_TIMEOUT) {
+    fastestSpeed_ = speed;
+    fastestSpeedTimer_ = global::wallclock();
+  }
+}
+
+bool DeadlinePieceSelector::isFastConnection(unsigned int speed) const
+{
+  // A connection whose speed is not known yet is not regarded as
+  // fast unless no speed is known at all.
+  return fastestSpeed_ == 0 ||
+    (speed > 0 && static_cast<uint64_t>(speed)*FAST_RATIO >= fastestSpeed_);
+}
+
+bool DeadlinePieceSelector::canMeetDeadline
+(size_t index, unsigned int speed) const
+{
+  int64_t deadline = getDeadline(index);
+  if(speed == 0) {
+    return deadline >= LOOKAHEAD_MILLIS/2;
+  }
+  int64_t downloadTime =
+    static_cast<int64_t>(bitfieldMan_->getBlockLength(index))*1000/speed;
+  return deadline >= downloadTime*FAST_RATIO;
+}
+
+bool DeadlinePieceSelector::select
+(size_t& index, const unsigned char* bitfield, size_t nbits,
+ unsigned int speed)
+{
+  updateFastestSpeed(speed);
+  if(nbits == 0 || bitrate_ == 0) {
+    return false;
+  }
+  uint64_t position = getPlaybackPosition();
+  size_t last = std::min(nbits-1, getLastWindowIndex(position));
+  bool fast = isFastConnection(speed);
+  for(size_t i = bitfield::getNextSetBitIndex
+        (bitfield, nbits, position/bitfieldMan_->getBlockLength());
+      i <= last; i = bitfield::getNextSetBitIndex(bitfield, nbits, i+1)) {
+    if(fast || canMeetDeadline(i, speed)) {
+      index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DeadlinePieceSelector::selectDuplicate
+(size_t& index, const unsigned char* bitfield, size_t nbits,
+ unsigned int speed)
+{
+  updateFastestSpeed(speed);
+  if(nbits == 0 || bitrate_ == 0 || speed == 0 || !isFastConnection(speed)) {
+    return false;
+  }
+  size_t i = bitfield::getNextSetBitIndex
+    (bitfield, nbits, getPlaybackPosition()/bitfieldMan_->getBlockLength());
+  if(i < nbits && getDeadline(i) < DUPLICATE_DEADLINE_MILLIS) {
+    index = i;
+    return true;
+  }
+  return false;
+}
+
+bool DeadlinePieceSelector::hasEarlierPiece(size_t index) const
+{
+  size_t blocks = bitfieldMan_->countBlock();
+  if(blocks == 0 || bitrate_ == 0) {
+    return false;
+  }
+  uint64_t position = getPlaybackPosition();
+  size_t first = position/bitfieldMan_->getBlockLength();
+  size_t last = std::min(index, getLastWindowIndex(position)+1);
+  if(last <= first) {
+    return false;
+  }
+  // Only the window is tested, so that this function, which is called
+  // for each segment, does not build the whole missing bitfield.
+  const unsigned char* have = bitfieldMan_->getBitfield();
+  const unsigned char* use = bitfieldMan_->getUseBitfield();
+  const unsigned char* filter = bitfieldMan_->isFilterEnabled() ?
+    bitfieldMan_->getFilterBitfield() : 0;
+  for(size_t i = first; i < last; ++i) {
+    if(!bitfield::test(have, blocks, i) && !bitfield::test(use, blocks, i) &&
+       (!filter || bitfield::test(filter, blocks, i))) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t DeadlinePieceSelector::getBufferedAhead() const
+{
+  size_t blocks = bitfieldMan_->countBlock();
+  uint64_t position = getPlaybackPosition();
+  size_t first = position/bitfieldMan_->getBlockLength();
+  if(blocks <= first) {
+    return 0;
+  }
+  size_t missing =
+    bitfield::getNextUnsetBitIndex(bitfieldMan_->getBitfield(), blocks, first);
+  uint64_t end = missing == blocks ? bitfieldMan_->getTotalLength() :
+    static_cast<uint64_t>(missing)*bitfieldMan_->getBlockLength();
+  return end > position ? end-position : 0;
+}
+
+} // namespace aria2
@@ -0,0 +1,123 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DEADLINE_PIECE_SELECTOR_H
+#define D_DEADLINE_PIECE_SELECTOR_H
+
+#include "common.h"
+
+#include <cstdlib>
+
+#include "TimerA2.h"
+
+namespace aria2 {
+
+class BitfieldMan;
+
+// Selects pieces by the time a media player needs them. The player
+// plays the download from the given position at bitrate bytes per
+// second. Only the pieces in the lookahead window after the playback
+// position are selected here. The rest are left to PieceSelector and
+// StreamPieceSelector.
+class DeadlinePieceSelector {
+private:
+  const BitfieldMan* bitfieldMan_;
+  // Playback position in bytes at positionTimer_.
+  uint64_t position_;
+  // Playback rate in bytes per second.
+  unsigned int bitrate_;
+  Timer positionTimer_;
+  // The fastest download speed of the connections seen recently.
+  unsigned int fastestSpeed_;
+  Timer fastestSpeedTimer_;
+
+  void updateFastestSpeed(unsigned int speed);
+
+  bool isFastConnection(unsigned int speed) const;
+
+  // Returns true if a connection downloading at speed bytes per
+  // second is likely to get index-th piece before its deadline.
+  bool canMeetDeadline(size_t index, unsigned int speed) const;
+
+  // Returns the index of the last piece in the lookahead window.
+  size_t getLastWindowIndex(uint64_t position) const;
+public:
+  DeadlinePieceSelector(const BitfieldMan* bitfieldMan);
+
+  void setPlayback(uint64_t position, unsigned int bitrate);
+
+  // Returns the playback position estimated from the position and
+  // bitrate given by setPlayback() and the time since then.
+  uint64_t getPlaybackPosition() const;
+
+  unsigned int getBitrate() const
+  {
+    return bitrate_;
+  }
+
+  // Returns the time in milliseconds until index-th piece is
+  // played. Returns 0 if the piece is being played or has been
+  // played.
+  int64_t getDeadline(size_t index) const;
+
+  // Stores in index the piece with the earliest deadline among the
+  // set bits in bitfield, in the lookahead window. The connection
+  // downloads at speed bytes per second; 0 means unknown. Pieces due
+  // soon are given only to connections close to the fastest one, so
+  // a slow connection gets a piece far enough ahead. Returns true if
+  // a piece is selected.
+  bool select(size_t& index, const unsigned char* bitfield, size_t nbits,
+              unsigned int speed);
+
+  // Stores in index the earliest piece among the set bits in bitfield
+  // if it is due within a few seconds and the connection is fast.
+  // bitfield should hold the pieces other connections are
+  // downloading. The piece is then downloaded twice and the faster
+  // download wins. Returns true if a piece is selected.
+  bool selectDuplicate(size_t& index, const unsigned char* bitfield,
+                       size_t nbits, unsigned int speed);
+
+  // Returns true if a missing piece nobody is downloading is in the
+  // lookahead window and due before index-th piece. A connection
+  // about to continue to index-th piece should select again instead.
+  bool hasEarlierPiece(size_t index) const;
+
+  // Returns the number of bytes downloaded contiguously from the
+  // playback position.
+  uint64_t getBufferedAhead() const;
+};
+
+} // namespace aria2
+
+#endif // D_DEADLINE_PIECE_SELECTOR_H
@@ -73,6 +73,7 @@
 #include "UTMetadataRequestFactory.h"
 #include "UTMetadataRequestTracker.h"
 #include "wallclock.h"
+#include "SuperSeeder.h"
 
 namespace aria2 {
 
@@ -84,7 +85,7 @@ DefaultBtInteractive::DefaultBtInteractive
     metadataGetMode_(false),
     localNode_(0),
     allowedFastSetSize_(10),
-    haveTimer_(global::wallclock()),
+    haveCursor_(0),
     keepAliveTimer_(global::wallclock()),
     floodingTimer_(global::wallclock()),
     inactiveTimer_(global::wallclock()),
@@ -98,7 +99,12 @@ DefaultBtInteractive::DefaultBtInteractive
     requestGroupMan_(0)
 {}
 
-DefaultBtInteractive::~DefaultBtInteractive() {}
+DefaultBtInteractive::~DefaultBtInteractive()
+{
+  if(superSeeder_) {
+    superSeeder_->removePeer(cuid_);
+  }
+}
 
 void DefaultBtInteractive::initiateHandshake() {
   SharedHandle<BtMessage> message =
@@ -159,8 +165,14 @@ BtMessageHandle DefaultBtInteractive::receiveAndSendHandshake() {
 }
 
 void DefaultBtInteractive::doPostHandshakeProcessing() {
-  // Set time 0 to haveTimer to cache http/ftp download piece completion
-  haveTimer_.reset(0);
+  // The pieces advertised before are in the bitfield sent below.
+  haveCursor_ = pieceStorage_->getAdvertisedPieceCursor();
+  if(!metadataGetMode_ && pieceStorage_->allDownloadFinished()) {
+    superSeeder_ = pieceStorage_->getSuperSeeder();
+    if(superSeeder_) {
+      superSeeder_->addPeer(cuid_);
+    }
+  }
   keepAliveTimer_ = global::wallclock();
   floodingTimer_ = global::wallclock();
   pexTimer_.reset(0);
@@ -191,6 +203,7 @@ void DefaultBtInteractive::addHandshakeExtendedMessageToQueue()
   HandshakeExtensionMessageHandle m(new HandshakeExtensionMessage());
   m->setClientVersion(CLIENT_ARIA2);
   m->setTCPPort(tcpPort_);
+  m->setReqq(MAX_INCOMING_REQUEST);
   m->setExtensions(extensionMessageRegistry_->getExtensions());
   SharedHandle<TorrentAttribute> attrs =
     bittorrent::getTorrentAttrs(downloadContext_);
@@ -202,6 +215,13 @@ void DefaultBtInteractive::addHandshakeExtendedMessageToQueue()
 }
 
 void DefaultBtInteractive::addBitfieldMessageToQueue() {
+  if(superSeeder_) {
+    // Pieces are shown one by one in checkHave().
+    if(peer_->isFastExtensionEnabled()) {
+      dispatcher_->addMessageToQueue(messageFactory_->createHaveNoneMessage());
+    }
+    return;
+  }
   if(peer_->isFastExtensionEnabled()) {
     if(pieceStorage_->allDownloadFinished()) {
       dispatcher_->addMessageToQueue(messageFactory_->createHaveAllMessage());
@@ -218,7 +238,7 @@ void DefaultBtInteractive::addBitfieldMessageToQueue() {
 }
 
 void DefaultBtInteractive::addAllowedFastMessageToQueue() {
-  if(peer_->isFastExtensionEnabled()) {
+  if(peer_->isFastExtensionEnabled() && !superSeeder_) {
     std::vector<size_t> fastSet;
     bittorrent::computeFastSet(fastSet, peer_->getIPAddress(),
                                downloadContext_->getNumPieces(),
@@ -245,21 +265,32 @@ void DefaultBtInteractive::decideChoking() {
 }
 
 void DefaultBtInteractive::checkHave() {
+  if(superSeeder_) {
+    // We are seeding, so no new piece is advertised.
+    size_t index;
+    if(superSeeder_->getNextPiece(index, cuid_, peer_->getBitfield(),
+                                  downloadContext_->getNumPieces())) {
+      dispatcher_->addMessageToQueue(messageFactory_->createHaveMessage(index));
+    }
+    return;
+  }
   std::vector<size_t> indexes;
-  pieceStorage_->getAdvertisedPieceIndexes(indexes, cuid_, haveTimer_);
-  haveTimer_ = global::wallclock();
-  if(indexes.size() >= 20) {
+  // HAVE message is 9 bytes long. BITFIELD message is 5 bytes plus
+  // bitfield.
+  if(!pieceStorage_->getAdvertisedPieceIndexes(indexes, cuid_, haveCursor_) ||
+     indexes.size()*9 > 5+pieceStorage_->getBitfieldLength()) {
     if(peer_->isFastExtensionEnabled() &&
        pieceStorage_->allDownloadFinished()) {
       dispatcher_->addMessageToQueue(messageFactory_->createHaveAllMessage());
     } else {
       dispatcher_->addMessageToQueue(messageFactory_->createBitfieldMessage());
     }
-  } else {
-    for(std::vector<size_t>::const_iterator itr = indexes.begin(),
-          eoi = indexes.end(); itr != eoi; ++itr) {
-      dispatcher_->addMessageToQueue(messageFactory_->createHaveMessage(*itr));
-    }
+  } else if(indexes.size() == 1) {
+    dispatcher_->addMessageToQueue
+      (messageFactory_->createHaveMessage(indexes.front()));
+  } else if(!indexes.empty()) {
+    dispatcher_->addMessageToQueue
+      (messageFactory_->createHaveBatchMessage(indexes));
   }
 }
 
@@ -312,16 +343,51 @@ size_t DefaultBtInteractive::receiveMessages() {
       break;
     }
   }
-  if(!pieceStorage_->isEndGame() &&
-     countOldOutstandingRequest >= maxOutstandingRequest_ &&
-     dispatcher_->countOutstandingRequest()*2 <= maxOutstandingRequest_){
-    maxOutstandingRequest_ =
-      std::min((size_t)UB_MAX_OUTSTANDING_REQUEST,
-               maxOutstandingRequest_+OUTSTANDING_REQUEST_STEP);
+  if(!pieceStorage_->isEndGame()) {
+    updateMaxOutstandingRequest(countOldOutstandingRequest);
   }
   return msgcount;
 }
 
+namespace {
+// Added to the RTT when computing the number of requests to keep in
+// flight. Covers the time requests wait in the local send queue and
+// in the peer.
+const int64_t REQUEST_QUEUE_MARGIN_MILLIS = 100;
+} // namespace
+
+void DefaultBtInteractive::updateMaxOutstandingRequest
+(size_t countOldOutstandingRequest)
+{
+  size_t n = maxOutstandingRequest_;
+  // If more than half of the requests were answered at once, the
+  // peer can serve more than we ask.
+  bool drained = countOldOutstandingRequest >= maxOutstandingRequest_ &&
+    dispatcher_->countOutstandingRequest()*2 <= maxOutstandingRequest_;
+  if(drained) {
+    n += OUTSTANDING_REQUEST_STEP;
+  }
+  int64_t rtt = peer_->getRtt();
+  if(rtt >= 0) {
+    // Twice the bandwidth-delay product. The download speed is
+    // limited by the number of requests in flight, so this doubles
+    // it each RTT while the pipe is not full.
+    uint64_t bdp = static_cast<uint64_t>(peer_->calculateDownloadSpeed())*
+      (rtt*2+REQUEST_QUEUE_MARGIN_MILLIS)/1000/MAX_BLOCK_LENGTH;
+    bdp = std::min(bdp, static_cast<uint64_t>(UB_MAX_OUTSTANDING_REQUEST));
+    n = drained ? std::max(n, static_cast<size_t>(bdp)) : bdp;
+  }
+  size_t reqq = peer_->getReqq();
+  if(reqq == 0) {
+    reqq = DEFAULT_PEER_REQQ;
+  }
+  maxOutstandingRequest_ =
+    std::max(static_cast<size_t>(DEFAULT_MAX_OUTSTANDING_REQUEST),
+             std::min(n, std::min(reqq,
+                                  static_cast<size_t>
+                                  (UB_MAX_OUTSTANDING_REQUEST))));
+}
+
 void DefaultBtInteractive::decideInterest() {
   if(pieceStorage_->hasMissingPiece(peer_)) {
     if(!peer_->amInterested()) {
@@ -386,6 +452,7 @@ void DefaultBtInteractive::addRequests() {
   if(pieceStorage_->isEndGame()) {
     maxOutstandingRequest_ = 2;
   }
+  peer_->setRequestQueueSize(maxOutstandingRequest_);
   fillPiece(maxOutstandingRequest_);
   size_t reqNumToCreate =
     maxOutstandingRequest_ <= dispatcher_->countOutstandingRequest() ?
@@ -61,6 +61,7 @@ class DHTNode;
 class RequestGroupMan;
 class UTMetadataRequestFactory;
 class UTMetadataRequestTracker;
+class SuperSeeder;
 
 class FloodingStat {
 private:
@@ -126,7 +127,10 @@ private:
   DHTNode* localNode_;
 
   size_t allowedFastSetSize_;
-  Timer haveTimer_;
+  // The sequence number of the next advertised piece to send HAVE.
+  uint64_t haveCursor_;
+  // Not null if this peer is super-seeded.
+  SharedHandle<SuperSeeder> superSeeder_;
   Timer keepAliveTimer_;
   Timer floodingTimer_;
   FloodingStat floodingStat_;
@@ -155,6 +159,9 @@ private:
   void sendKeepAlive();
   void decideInterest();
   void fillPiece(size_t maxMissingBlock);
+  // Sets maxOutstandingRequest_ to keep the bandwidth-delay product
+  // of the peer in flight.
+  void updateMaxOutstandingRequest(size_t countOldOutstandingRequest);
   void addRequests();
   void detectMessageFlooding();
   void checkActiveInteraction();
@@ -41,6 +41,7 @@
 #include "BtInterestedMessage.h"
 #include "BtNotInterestedMessage.h"
 #include "BtHaveMessage.h"
+#include "BtHaveBatchMessage.h"
 #include "BtBitfieldMessage.h"
 #include "BtBitfieldMessageValidator.h"
 #include "RangeBtMessageValidator.h"
@@ -355,6 +356,15 @@ DefaultBtMessageFactory::createHaveMessage(size_t index)
   return msg;
 }
 
+BtMessageHandle
+DefaultBtMessageFactory::createHaveBatchMessage
+(const std::vector<size_t>& indexes)
+{
+  SharedHandle<BtHaveBatchMessage> msg(new BtHaveBatchMessage(indexes));
+  setCommonProperty(msg);
+  return msg;
+}
+
 BtMessageHandle
 DefaultBtMessageFactory::createChokeMessage()
 {
@@ -109,6 +109,9 @@ public:
 
   virtual SharedHandle<BtMessage> createHaveMessage(size_t index);
 
+  virtual SharedHandle<BtMessage> createHaveBatchMessage
+  (const std::vector<size_t>& indexes);
+
   virtual SharedHandle<BtMessage> createChokeMessage();
 
   virtual SharedHandle<BtMessage> createUnchokeMessage();
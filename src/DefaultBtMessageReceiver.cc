@@ -126,7 +126,12 @@ BtMessageHandle DefaultBtMessageReceiver::receiveMessage() {
   if(msg->getId() == BtPieceMessage::ID) {
     SharedHandle<BtPieceMessage> piecemsg =
       static_pointer_cast<BtPieceMessage>(msg);
-    piecemsg->setRawMessage(peerConnection_->detachBuffer());
+    unsigned char* block = peerConnection_->detachBlock();
+    if(block) {
+      piecemsg->setBlock(block, peerConnection_->getBlockFreeList());
+    } else {
+      piecemsg->setRawMessage(peerConnection_->detachBuffer());
+    }
   }
   return msg;
 }
@@ -55,6 +55,8 @@
 #include "array_fun.h"
 #include "DownloadContext.h"
 #include "BufferedFile.h"
+#include "FileEntry.h"
+#include "TimeA2.h"
 #ifdef ENABLE_BITTORRENT
 # include "PeerStorage.h"
 # include "BtRuntime.h"
@@ -129,11 +131,13 @@ void DefaultBtProgressInfoFile::save()
     // extension: 32 bits
     // If this is BitTorrent download, then 0x00000001
     // Otherwise, 0x00000000
+    // 0x00000002 is set if file stats follow in-flight pieces.
     char extension[4];
     memset(extension, 0, sizeof(extension));
     if(torrentDownload) {
       extension[3] = 1;
     }
+    extension[3] |= 2;
     WRITE_CHECK(fp, extension, sizeof(extension));
     if(torrentDownload) {
 #ifdef ENABLE_BITTORRENT
@@ -190,6 +194,7 @@ void DefaultBtProgressInfoFile::save()
       WRITE_CHECK(fp, &bitfieldLengthNL, sizeof(bitfieldLengthNL));
       WRITE_CHECK(fp, (*itr)->getBitfield(), (*itr)->getBitfieldLength());
     }
+    saveFileStats(fp);
     if(fp.close() == EOF) {
       throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_WRITE, filename_.c_str()));
     }
@@ -200,6 +205,38 @@ void DefaultBtProgressInfoFile::save()
   }
 }
 
+void DefaultBtProgressInfoFile::saveFileStats(BufferedFile& fp)
+{
+  const std::vector<SharedHandle<FileEntry> >& fileEntries =
+    dctx_->getFileEntries();
+  // the number of files: 32 bits
+  uint32_t numFilesNL = htonl(fileEntries.size());
+  WRITE_CHECK(fp, &numFilesNL, sizeof(numFilesNL));
+  time_t now = Time().getTime();
+  for(std::vector<SharedHandle<FileEntry> >::const_iterator i =
+        fileEntries.begin(), eoi = fileEntries.end(); i != eoi; ++i) {
+    File f((*i)->getPath());
+    uint64_t size = 0;
+    uint64_t mtime = 0;
+    if(f.isFile()) {
+      size = f.size();
+      time_t t = f.getModifiedTime().getTime();
+      // Modification time has a resolution of 1 second. If the file
+      // was modified in this second, it may be modified again without
+      // changing it. 0 means the file must be checked.
+      if(t < now) {
+        mtime = t;
+      }
+    }
+    // file size: 64 bits
+    uint64_t sizeNL = hton64(size);
+    WRITE_CHECK(fp, &sizeNL, sizeof(sizeNL));
+    // modification time: 64 bits
+    uint64_t mtimeNL = hton64(mtime);
+    WRITE_CHECK(fp, &mtimeNL, sizeof(mtimeNL));
+  }
+}
+
 #define READ_CHECK(fp, ptr, count)                                      \
   if(fp.read((ptr), (count)) != (count)) {                              \
     throw DL_ABORT_EX(fmt(EX_SEGMENT_FILE_READ, filename_.c_str()));    \
@@ -229,6 +266,12 @@ void DefaultBtProgressInfoFile::load()
   }
   unsigned char extension[4];
   READ_CHECK(fp, extension, sizeof(extension));
+  const std::vector<SharedHandle<FileEntry> >& fileEntries =
+    dctx_->getFileEntries();
+  for(std::vector<SharedHandle<FileEntry> >::const_iterator i =
+        fileEntries.begin(), eoi = fileEntries.end(); i != eoi; ++i) {
+    (*i)->setUnchanged(false);
+  }
   bool infoHashCheckEnabled = false;
   if(extension[3]&1 && isTorrentDownload()) {
     infoHashCheckEnabled = true;
@@ -363,6 +406,9 @@ void DefaultBtProgressInfoFile::load()
       inFlightPieces.push_back(piece);
     }
     pieceStorage_->addInFlightPiece(inFlightPieces);
+    if(extension[3]&2 && option_->getAsBool(PREF_FAST_RESUME)) {
+      loadFileStats(fp);
+    }
   } else {
     uint32_t numInFlightPiece;
     READ_CHECK(fp, &numInFlightPiece, sizeof(numInFlightPiece));
@@ -386,6 +432,45 @@ void DefaultBtProgressInfoFile::load()
   A2_LOG_INFO(MSG_LOADED_SEGMENT_FILE);
 }
 
+void DefaultBtProgressInfoFile::loadFileStats(BufferedFile& fp)
+{
+  const std::vector<SharedHandle<FileEntry> >& fileEntries =
+    dctx_->getFileEntries();
+  uint32_t numFiles;
+  READ_CHECK(fp, &numFiles, sizeof(numFiles));
+  numFiles = ntohl(numFiles);
+  if(numFiles != fileEntries.size()) {
+    A2_LOG_INFO(fmt("The number of files in the control file does not match."
+                    " expected: %lu, actual: %u",
+                    static_cast<unsigned long>(fileEntries.size()),
+                    numFiles));
+    return;
+  }
+  size_t numUnchanged = 0;
+  for(std::vector<SharedHandle<FileEntry> >::const_iterator i =
+        fileEntries.begin(), eoi = fileEntries.end(); i != eoi; ++i) {
+    uint64_t size;
+    READ_CHECK(fp, &size, sizeof(size));
+    size = ntoh64(size);
+    uint64_t mtime;
+    READ_CHECK(fp, &mtime, sizeof(mtime));
+    mtime = ntoh64(mtime);
+    if(mtime == 0) {
+      continue;
+    }
+    File f((*i)->getPath());
+    if(f.isFile() && f.size() == size &&
+       static_cast<uint64_t>(f.getModifiedTime().getTime()) == mtime) {
+      (*i)->setUnchanged(true);
+      ++numUnchanged;
+    }
+  }
+  A2_LOG_INFO(fmt("%lu of %lu files have not changed since the control file"
+                  " was saved.",
+                  static_cast<unsigned long>(numUnchanged),
+                  static_cast<unsigned long>(fileEntries.size())));
+}
+
 void DefaultBtProgressInfoFile::removeFile()
 {
   if(exists()) {
@@ -44,6 +44,7 @@ class PieceStorage;
 class PeerStorage;
 class BtRuntime;
 class Option;
+class BufferedFile;
 
 class DefaultBtProgressInfoFile : public BtProgressInfoFile {
 private:
@@ -58,6 +59,13 @@ private:
 
   bool isTorrentDownload();
 
+  // Writes the size and modification time of each file.
+  void saveFileStats(BufferedFile& fp);
+
+  // Reads the records written by saveFileStats() and marks the files
+  // which have not changed since then.
+  void loadFileStats(BufferedFile& fp);
+
   static const std::string V0000;
   static const std::string V0001;
 public:
@@ -182,6 +182,13 @@ void DefaultBtRequestFactory::createRequestMessages
           (messageFactory_->createRequestMessage(piece, *i));
       }
       blockIndexes.clear();
+    } else if(piece->countUser() > 1) {
+      // The piece is downloaded from several peers at once to meet
+      // its deadline. See DeadlinePieceSelector.
+      size_t n = requests.size();
+      createRequestMessagesForMissingBlock(requests, piece,
+                                           requests.size()+getnum);
+      getnum -= requests.size()-n;
     }
   }
 }
@@ -191,40 +198,46 @@ void DefaultBtRequestFactory::createRequestMessagesOnEndGame
 {
   for(std::deque<SharedHandle<Piece> >::iterator itr = pieces_.begin(),
         eoi = pieces_.end(); itr != eoi && requests.size() < max; ++itr) {
-    SharedHandle<Piece>& piece = *itr;
-    const size_t mislen = piece->getBitfieldLength();
-    array_ptr<unsigned char> misbitfield(new unsigned char[mislen]);
+    createRequestMessagesForMissingBlock(requests, *itr, max);
+  }
+}
 
-    piece->getAllMissingBlockIndexes(misbitfield, mislen);
+void DefaultBtRequestFactory::createRequestMessagesForMissingBlock
+(std::vector<SharedHandle<BtMessage> >& requests,
+ const SharedHandle<Piece>& piece, size_t max)
+{
+  const size_t mislen = piece->getBitfieldLength();
+  array_ptr<unsigned char> misbitfield(new unsigned char[mislen]);
+
+  piece->getAllMissingBlockIndexes(misbitfield, mislen);
 
-    std::vector<size_t> missingBlockIndexes;
-    size_t blockIndex = 0;
-    for(size_t i = 0; i < mislen; ++i) {
-      unsigned char bits = misbitfield[i];
-      unsigned char mask = 128;
-      for(size_t bi = 0; bi < 8; ++bi, mask >>= 1, ++blockIndex) {
-        if(bits & mask) {
-          missingBlockIndexes.push_back(blockIndex);
-        }
+  std::vector<size_t> missingBlockIndexes;
+  size_t blockIndex = 0;
+  for(size_t i = 0; i < mislen; ++i) {
+    unsigned char bits = misbitfield[i];
+    unsigned char mask = 128;
+    for(size_t bi = 0; bi < 8; ++bi, mask >>= 1, ++blockIndex) {
+      if(bits & mask) {
+        missingBlockIndexes.push_back(blockIndex);
       }
     }
-    std::random_shuffle(missingBlockIndexes.begin(), missingBlockIndexes.end(),
-                        *(SimpleRandomizer::getInstance().get()));
-    for(std::vector<size_t>::const_iterator bitr = missingBlockIndexes.begin(),
-          eoi2 = missingBlockIndexes.end();
-        bitr != eoi2 && requests.size() < max; ++bitr) {
-      const size_t& blockIndex = *bitr;
-      if(!dispatcher_->isOutstandingRequest(piece->getIndex(),
-                                           blockIndex)) {
-        A2_LOG_DEBUG
-          (fmt("Creating RequestMessage index=%lu, begin=%u,"
-               " blockIndex=%lu",
-               static_cast<unsigned long>(piece->getIndex()),
-               static_cast<unsigned int>(blockIndex*piece->getBlockLength()),
-               static_cast<unsigned long>(blockIndex)));
-        requests.push_back(messageFactory_->createRequestMessage
-                           (piece, blockIndex));
-      }
+  }
+  std::random_shuffle(missingBlockIndexes.begin(), missingBlockIndexes.end(),
+                      *(SimpleRandomizer::getInstance().get()));
+  for(std::vector<size_t>::const_iterator bitr = missingBlockIndexes.begin(),
+        eoi = missingBlockIndexes.end();
+      bitr != eoi && requests.size() < max; ++bitr) {
+    const size_t& blockIndex = *bitr;
+    if(!dispatcher_->isOutstandingRequest(piece->getIndex(),
+                                         blockIndex)) {
+      A2_LOG_DEBUG
+        (fmt("Creating RequestMessage index=%lu, begin=%u,"
+             " blockIndex=%lu",
+             static_cast<unsigned long>(piece->getIndex()),
+             static_cast<unsigned int>(blockIndex*piece->getBlockLength()),
+             static_cast<unsigned long>(blockIndex)));
+      requests.push_back(messageFactory_->createRequestMessage
+                         (piece, blockIndex));
     }
   }
 }
@@ -57,6 +57,13 @@ private:
   BtMessageFactory* messageFactory_;
   std::deque<SharedHandle<Piece> > pieces_;
   cuid_t cuid_;
+
+  // Creates requests for the missing blocks of piece which are not
+  // requested to this peer yet, even if they are requested to other
+  // peers.
+  void createRequestMessagesForMissingBlock
+  (std::vector<SharedHandle<BtMessage> >& requests,
+   const SharedHandle<Piece>& piece, size_t max);
 public:
   DefaultBtRequestFactory();
 
@@ -40,6 +40,7 @@
 #include "DownloadContext.h"
 #include "Piece.h"
 #include "Peer.h"
+#include "PeerSessionResource.h"
 #include "LogFactory.h"
 #include "Logger.h"
 #include "prefs.h"
@@ -51,6 +52,7 @@
 #include "DefaultDiskWriterFactory.h"
 #include "FileEntry.h"
 #include "DlAbortEx.h"
+#include "RecoverableException.h"
 #include "util.h"
 #include "a2functional.h"
 #include "Option.h"
@@ -59,12 +61,20 @@
 #include "DefaultStreamPieceSelector.h"
 #include "InorderStreamPieceSelector.h"
 #include "GeomStreamPieceSelector.h"
+#include "DeadlinePieceSelector.h"
 #include "array_fun.h"
 #include "PieceStatMan.h"
 #include "wallclock.h"
 #include "bitfield.h"
+#include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "OpenedFileCache.h"
+#ifdef HAVE_MMAP
+# include "MmapDiskWriterFactory.h"
+#endif // HAVE_MMAP
 #ifdef ENABLE_BITTORRENT
 # include "bittorrent_helper.h"
+# include "SuperSeeder.h"
 #endif // ENABLE_BITTORRENT
 
 namespace aria2 {
@@ -78,9 +88,16 @@ DefaultPieceStorage::DefaultPieceStorage
    endGame_(false),
    endGamePieceNum_(END_GAME_PIECE_NUM),
    option_(option),
+   haveSeq_(0),
    pieceStatMan_(new PieceStatMan(downloadContext->getNumPieces(), true)),
-   pieceSelector_(new RarestPieceSelector(pieceStatMan_))
+   pieceSelector_(new RarestPieceSelector(pieceStatMan_)),
+   wrDiskCache_(0),
+   pieceChangeBase_(1)
 {
+  // A peer which missed more HAVEs than this is sent the bitfield
+  // instead, which is smaller than that many HAVE messages.
+  haves_.resize(std::max(static_cast<size_t>(64),
+                         bitfieldMan_->getBitfieldLength()));
   const std::string& pieceSelectorOpt =
     option_->get(PREF_STREAM_PIECE_SELECTOR);
   if(pieceSelectorOpt.empty() || pieceSelectorOpt == A2_V_DEFAULT) {
@@ -90,6 +107,29 @@ DefaultPieceStorage::DefaultPieceStorage
   } else if(pieceSelectorOpt == A2_V_GEOM) {
     streamPieceSelector_.reset(new GeomStreamPieceSelector(bitfieldMan_, 1.5));
   }
+#ifdef ENABLE_BITTORRENT
+  if(option_->getAsBool(PREF_BT_SUPER_SEEDING)) {
+    superSeeder_.reset(new SuperSeeder(pieceStatMan_));
+  }
+#endif // ENABLE_BITTORRENT
+#ifdef HAVE_MMAP
+  if(option_->get(PREF_FILE_IO) == V_MMAP) {
+    // A store into a hole of a mapped sparse file raises SIGBUS when
+    // the disk is full. Files which are not going to be preallocated
+    // are not mapped. MmapDiskWriter also checks that the file has no
+    // hole left, for example, from an earlier run without allocation.
+    const std::string& allocation = option_->get(PREF_FILE_ALLOCATION);
+    if((allocation == V_PREALLOC || allocation == V_FALLOC) &&
+       static_cast<uint64_t>
+       (option_->getAsLLInt(PREF_NO_FILE_ALLOCATION_LIMIT)) <=
+       downloadContext->getTotalLength()) {
+      diskWriterFactory_.reset(new MmapDiskWriterFactory());
+    } else {
+      A2_LOG_INFO("--file-io=mmap is ignored because the file is not"
+                  " preallocated. Using read/write instead.");
+    }
+  }
+#endif // HAVE_MMAP
 }
 
 DefaultPieceStorage::~DefaultPieceStorage()
@@ -101,6 +141,7 @@ SharedHandle<Piece> DefaultPieceStorage::checkOutPiece
 (size_t index, cuid_t cuid)
 {
   bitfieldMan_->setUseBit(index);
+  recordPieceChange(index);
 
   SharedHandle<Piece> piece = findUsedPiece(index);
   if(!piece) {
@@ -113,6 +154,9 @@ SharedHandle<Piece> DefaultPieceStorage::checkOutPiece
 
     addUsedPiece(piece);
   }
+  if(wrDiskCache_ && !piece->getWrDiskCacheEntry()) {
+    piece->initWrCache(wrDiskCache_, diskAdaptor_);
+  }
   piece->addUser(cuid);
   return piece;
 }
@@ -211,52 +255,183 @@ void DefaultPieceStorage::getMissingPiece
     if(!r) {
       return;
     }
-    while(misBlock < minMissingBlocks) {
+    selectMissingPiece(pieces, minMissingBlocks, misbitfield, cuid);
+  }
+}
+
+void DefaultPieceStorage::selectMissingPiece
+(std::vector<SharedHandle<Piece> >& pieces,
+ size_t minMissingBlocks,
+ unsigned char* candidates,
+ cuid_t cuid)
+{
+  size_t blocks = bitfieldMan_->countBlock();
+  size_t misBlock = 0;
+  while(misBlock < minMissingBlocks) {
+    size_t index;
+    if(pieceSelector_->select(index, candidates, blocks)) {
+      pieces.push_back(checkOutPiece(index, cuid));
+      bitfield::flipBit(candidates, blocks, index);
+      misBlock += pieces.back()->countMissingBlock();
+    } else {
+      break;
+    }
+  }
+}
+
+size_t DefaultPieceStorage::selectDeadlinePiece
+(std::vector<SharedHandle<Piece> >& pieces,
+ size_t minMissingBlocks,
+ const SharedHandle<Peer>& peer,
+ unsigned char* candidates,
+ cuid_t cuid)
+{
+  const size_t blocks = bitfieldMan_->countBlock();
+  const unsigned int speed = peer->calculateDownloadRate();
+  size_t misBlock = 0;
+  if(peer->getBitfieldLength() == bitfieldMan_->getBitfieldLength()) {
+    // Pieces other connections are downloading which this peer has.
+    array_ptr<unsigned char> inFlight
+      (new unsigned char[bitfieldMan_->getBitfieldLength()]);
+    if(bitfield::andNot(inFlight, bitfieldMan_->getUseBitfield(),
+                        peer->getBitfield(), bitfieldMan_->getBitfield(), 0,
+                        blocks)) {
       size_t index;
-      if(pieceSelector_->select(index, misbitfield, blocks)) {
-        pieces.push_back(checkOutPiece(index, cuid));
-        bitfield::flipBit(misbitfield, blocks, index);
-        misBlock += pieces.back()->countMissingBlock();
-      } else {
-        break;
+      while(deadlinePieceSelector_->selectDuplicate
+            (index, inFlight, blocks, speed)) {
+        bitfield::flipBit(inFlight, blocks, index);
+        SharedHandle<Piece> piece = findUsedPiece(index);
+        // We don't share piece downloaded via HTTP/FTP
+        if(piece && !piece->usedBy(cuid) && !piece->getUsedBySegment()) {
+          pieces.push_back(checkOutPiece(index, cuid));
+          misBlock += piece->countMissingBlock();
+          break;
+        }
       }
     }
   }
+  while(misBlock < minMissingBlocks) {
+    size_t index;
+    if(deadlinePieceSelector_->select(index, candidates, blocks, speed)) {
+      pieces.push_back(checkOutPiece(index, cuid));
+      bitfield::flipBit(candidates, blocks, index);
+      misBlock += pieces.back()->countMissingBlock();
+    } else {
+      break;
+    }
+  }
+  return misBlock;
+}
+
+bool DefaultPieceStorage::isCandidatePiece
+(const SharedHandle<Peer>& peer, size_t index)
+{
+  return index < bitfieldMan_->countBlock() &&
+    peer->hasPiece(index) &&
+    !bitfieldMan_->isBitSet(index) &&
+    !bitfieldMan_->isUseBitSet(index) &&
+    bitfieldMan_->isFilteredBit(index);
 }
 
 namespace {
-void unsetExcludedIndexes(BitfieldMan& bitfield,
-                          const std::vector<size_t>& excludedIndexes)
+void setCandidateBit(std::vector<unsigned char>& bitfield, size_t index,
+                     bool on)
 {
-  std::for_each(excludedIndexes.begin(), excludedIndexes.end(),
-                std::bind1st(std::mem_fun(&BitfieldMan::unsetBit), &bitfield));
+  unsigned char mask = 128 >> (index%8);
+  if(on) {
+    bitfield[index/8] |= mask;
+  } else {
+    bitfield[index/8] &= ~mask;
+  }
 }
 } // namespace
 
+unsigned char* DefaultPieceStorage::updateCandidatePieces
+(const SharedHandle<Peer>& peer)
+{
+  CandidatePieces& candidates = peer->getCandidatePieces();
+  const size_t len = bitfieldMan_->getBitfieldLength();
+  if(candidates.seq < pieceChangeBase_ ||
+     candidates.bitfield.size() != len ||
+     peer->getBitfieldLength() != len) {
+    candidates.bitfield.assign(len, 0);
+    if(len) {
+      bitfieldMan_->getAllMissingUnusedIndexes
+        (&candidates.bitfield[0], len,
+         peer->getBitfield(), peer->getBitfieldLength());
+    }
+  } else {
+    for(std::deque<size_t>::const_iterator i =
+          pieceChanges_.begin()+(candidates.seq-pieceChangeBase_),
+          eoi = pieceChanges_.end(); i != eoi; ++i) {
+      setCandidateBit(candidates.bitfield, *i, isCandidatePiece(peer, *i));
+    }
+    for(std::vector<size_t>::const_iterator i = candidates.haves.begin(),
+          eoi = candidates.haves.end(); i != eoi; ++i) {
+      if(isCandidatePiece(peer, *i)) {
+        setCandidateBit(candidates.bitfield, *i, true);
+      }
+    }
+  }
+  candidates.haves.clear();
+  candidates.seq = pieceChangeBase_+pieceChanges_.size();
+  return len ? &candidates.bitfield[0] : 0;
+}
+
 void DefaultPieceStorage::createFastIndexBitfield
-(BitfieldMan& bitfield, const SharedHandle<Peer>& peer)
+(unsigned char* bitfield, const SharedHandle<Peer>& peer)
 {
+  const size_t len = bitfieldMan_->getBitfieldLength();
+  memset(bitfield, 0, len);
   for(std::vector<size_t>::const_iterator itr =
         peer->getPeerAllowedIndexSet().begin(),
         eoi = peer->getPeerAllowedIndexSet().end(); itr != eoi; ++itr) {
-    if(!bitfieldMan_->isBitSet(*itr) && peer->hasPiece(*itr)) {
-      bitfield.setBit(*itr);
+    if(*itr < bitfieldMan_->countBlock() &&
+       !bitfieldMan_->isBitSet(*itr) && peer->hasPiece(*itr)) {
+      bitfield[*itr/8] |= 128 >> (*itr%8);
     }
   }
 }
 
+namespace {
+void unsetExcludedIndexes(unsigned char* bitfield, size_t nbits,
+                          const std::vector<size_t>& excludedIndexes)
+{
+  for(std::vector<size_t>::const_iterator i = excludedIndexes.begin(),
+        eoi = excludedIndexes.end(); i != eoi; ++i) {
+    if(*i < nbits) {
+      bitfield[*i/8] &= ~(128 >> (*i%8));
+    }
+  }
+}
+} // namespace
+
 void DefaultPieceStorage::getMissingPiece
 (std::vector<SharedHandle<Piece> >& pieces,
  size_t minMissingBlocks,
  const SharedHandle<Peer>& peer,
  cuid_t cuid)
 {
-  getMissingPiece(pieces, minMissingBlocks,
-                  peer->getBitfield(), peer->getBitfieldLength(),
-                  cuid);
+  if(isEndGame()) {
+    getMissingPiece(pieces, minMissingBlocks,
+                    peer->getBitfield(), peer->getBitfieldLength(),
+                    cuid);
+  } else {
+    unsigned char* candidates = updateCandidatePieces(peer);
+    if(candidates) {
+      size_t misBlock = 0;
+      if(deadlinePieceSelector_) {
+        misBlock = selectDeadlinePiece(pieces, minMissingBlocks, peer,
+                                       candidates, cuid);
+      }
+      if(misBlock < minMissingBlocks) {
+        selectMissingPiece(pieces, minMissingBlocks-misBlock, candidates,
+                           cuid);
+      }
+    }
+  }
 }
 
-
 void DefaultPieceStorage::getMissingPiece
 (std::vector<SharedHandle<Piece> >& pieces,
  size_t minMissingBlocks,
@@ -264,13 +439,11 @@ void DefaultPieceStorage::getMissingPiece
  const std::vector<size_t>& excludedIndexes,
  cuid_t cuid)
 {
-  BitfieldMan tempBitfield(bitfieldMan_->getBlockLength(),
-                           bitfieldMan_->getTotalLength());
-  tempBitfield.setBitfield(peer->getBitfield(), peer->getBitfieldLength());
-  unsetExcludedIndexes(tempBitfield, excludedIndexes);
-  getMissingPiece(pieces, minMissingBlocks,
-                  tempBitfield.getBitfield(), tempBitfield.getBitfieldLength(),
-                  cuid);
+  const size_t len = peer->getBitfieldLength();
+  array_ptr<unsigned char> tempBitfield(new unsigned char[len]);
+  memcpy(tempBitfield, peer->getBitfield(), len);
+  unsetExcludedIndexes(tempBitfield, len*8, excludedIndexes);
+  getMissingPiece(pieces, minMissingBlocks, tempBitfield, len, cuid);
 }
 
 void DefaultPieceStorage::getMissingFastPiece
@@ -280,13 +453,20 @@ void DefaultPieceStorage::getMissingFastPiece
  cuid_t cuid)
 {
   if(peer->isFastExtensionEnabled() && peer->countPeerAllowedIndexSet() > 0) {
-    BitfieldMan tempBitfield(bitfieldMan_->getBlockLength(),
-                             bitfieldMan_->getTotalLength());
+    const size_t len = bitfieldMan_->getBitfieldLength();
+    array_ptr<unsigned char> tempBitfield(new unsigned char[len]);
     createFastIndexBitfield(tempBitfield, peer);
-    getMissingPiece(pieces, minMissingBlocks,
-                    tempBitfield.getBitfield(),
-                    tempBitfield.getBitfieldLength(),
-                    cuid);
+    if(isEndGame()) {
+      getMissingPiece(pieces, minMissingBlocks, tempBitfield, len, cuid);
+    } else {
+      const unsigned char* candidates = updateCandidatePieces(peer);
+      if(!candidates) {
+        return;
+      }
+      bitfield::andNot(tempBitfield, tempBitfield, candidates, 0, 0,
+                       bitfieldMan_->countBlock());
+      selectMissingPiece(pieces, minMissingBlocks, tempBitfield, cuid);
+    }
   }
 }
 
@@ -298,14 +478,12 @@ void DefaultPieceStorage::getMissingFastPiece
  cuid_t cuid)
 {
   if(peer->isFastExtensionEnabled() && peer->countPeerAllowedIndexSet() > 0) {
-    BitfieldMan tempBitfield(bitfieldMan_->getBlockLength(),
-                             bitfieldMan_->getTotalLength());
+    const size_t len = bitfieldMan_->getBitfieldLength();
+    array_ptr<unsigned char> tempBitfield(new unsigned char[len]);
     createFastIndexBitfield(tempBitfield, peer);
-    unsetExcludedIndexes(tempBitfield, excludedIndexes);
-    getMissingPiece(pieces, minMissingBlocks,
-                    tempBitfield.getBitfield(),
-                    tempBitfield.getBitfieldLength(),
-                    cuid);
+    unsetExcludedIndexes(tempBitfield, bitfieldMan_->countBlock(),
+                         excludedIndexes);
+    getMissingPiece(pieces, minMissingBlocks, tempBitfield, len, cuid);
   }
 }
 
@@ -364,6 +542,11 @@ SharedHandle<Piece> DefaultPieceStorage::getMissingFastPiece
   }
 }
 
+SharedHandle<SuperSeeder> DefaultPieceStorage::getSuperSeeder()
+{
+  return superSeeder_;
+}
+
 #endif // ENABLE_BITTORRENT
 
 bool DefaultPieceStorage::hasMissingUnusedPiece()
@@ -387,6 +570,33 @@ SharedHandle<Piece> DefaultPieceStorage::getMissingPiece
   }
 }
 
+SharedHandle<Piece> DefaultPieceStorage::getMissingPiece
+(size_t minSplitSize,
+ const unsigned char* ignoreBitfield,
+ size_t length,
+ cuid_t cuid,
+ unsigned int speed)
+{
+  const size_t len = bitfieldMan_->getBitfieldLength();
+  // If ignoreBitfield cannot be applied, leave the selection to the
+  // regular path so that the excluded pieces are never returned.
+  if(deadlinePieceSelector_ && (!ignoreBitfield || length == len)) {
+    const size_t blocks = bitfieldMan_->countBlock();
+    array_ptr<unsigned char> candidates(new unsigned char[len]);
+    if(bitfieldMan_->getAllMissingUnusedIndexes(candidates, len)) {
+      if(ignoreBitfield) {
+        bitfield::andNot(candidates, candidates, 0, ignoreBitfield, 0,
+                         blocks);
+      }
+      size_t index;
+      if(deadlinePieceSelector_->select(index, candidates, blocks, speed)) {
+        return checkOutPiece(index, cuid);
+      }
+    }
+  }
+  return getMissingPiece(minSplitSize, ignoreBitfield, length, cuid);
+}
+
 SharedHandle<Piece> DefaultPieceStorage::getMissingPiece
 (size_t index,
  cuid_t cuid)
@@ -403,6 +613,18 @@ void DefaultPieceStorage::deleteUsedPiece(const SharedHandle<Piece>& piece)
   if(!piece) {
     return;
   }
+  // Write cached data before the piece is forgotten. This may wait
+  // for asynchronous writes, which may change usedPieces_, so do this
+  // first. This runs while a command is aborted, so a write error
+  // must not escape from here.
+  try {
+    piece->flushWrCache();
+  } catch(RecoverableException& e) {
+    A2_LOG_ERROR_EX(fmt("Failed to write cached data of piece#%lu",
+                        static_cast<unsigned long>(piece->getIndex())), e);
+    piece->getWrDiskCacheEntry()->setWriteError(true);
+  }
+  piece->releaseWrCache();
   std::deque<SharedHandle<Piece> >::iterator i = 
     std::lower_bound(usedPieces_.begin(), usedPieces_.end(), piece,
                      DerefLess<SharedHandle<Piece> >());
@@ -461,6 +683,7 @@ void DefaultPieceStorage::completePiece(const SharedHandle<Piece>& piece)
   }
   bitfieldMan_->setBit(piece->getIndex());
   bitfieldMan_->unsetUseBit(piece->getIndex());
+  recordPieceChange(piece->getIndex());
   addPieceStats(piece->getIndex());
   if(downloadFinished()) {
     downloadContext_->resetDownloadStopTime();
@@ -500,9 +723,12 @@ void DefaultPieceStorage::cancelPiece
   piece->removeUser(cuid);
   if(!piece->getUsed()) {
     bitfieldMan_->unsetUseBit(piece->getIndex());
+    recordPieceChange(piece->getIndex());
   }
   if(!isEndGame()) {
-    if(piece->getCompletedLength() == 0) {
+    // The piece may still be downloaded by other connections if it
+    // was requested twice by deadlinePieceSelector_.
+    if(!piece->getUsed() && piece->getCompletedLength() == 0) {
       deleteUsedPiece(piece);
     }
   }
@@ -576,12 +802,14 @@ void DefaultPieceStorage::setupFileFilter()
     }
   }
   bitfieldMan_->enableFilter();
+  resetPieceChanges();
 }
 
 // not unittested
 void DefaultPieceStorage::clearFileFilter()
 {
   bitfieldMan_->clearFilter();
+  resetPieceChanges();
 }
 
 // not unittested
@@ -619,8 +847,12 @@ void DefaultPieceStorage::initStorage()
     multiDiskAdaptor->setFileEntries(downloadContext_->getFileEntries().begin(),
                                      downloadContext_->getFileEntries().end());
     multiDiskAdaptor->setPieceLength(downloadContext_->getPieceLength());
-    multiDiskAdaptor->setMaxOpenFiles
-      (option_->getAsInt(PREF_BT_MAX_OPEN_FILES));
+    if(openedFileCache_) {
+      multiDiskAdaptor->setOpenedFileCache(openedFileCache_);
+    } else {
+      multiDiskAdaptor->setMaxOpenFiles
+        (option_->getAsInt(PREF_BT_MAX_OPEN_FILES));
+    }
     diskAdaptor_ = multiDiskAdaptor;
   }
   if(option_->get(PREF_FILE_ALLOCATION) == V_FALLOC) {
@@ -632,6 +864,7 @@ void DefaultPieceStorage::setBitfield(const unsigned char* bitfield,
                                       size_t bitfieldLength)
 {
   bitfieldMan_->setBitfield(bitfield, bitfieldLength);
+  resetPieceChanges();
   addPieceStats(bitfield, bitfieldLength);
 }
 
@@ -656,64 +889,42 @@ size_t DefaultPieceStorage::getPieceLength(size_t index)
 
 void DefaultPieceStorage::advertisePiece(cuid_t cuid, size_t index)
 {
-  HaveEntry entry(cuid, index, global::wallclock());
-  haves_.push_front(entry);
+  haves_[haveSeq_%haves_.size()] = HaveEntry(cuid, index);
+  ++haveSeq_;
 }
 
-void
+bool
 DefaultPieceStorage::getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
                                                cuid_t myCuid,
-                                               const Timer& lastCheckTime)
+                                               uint64_t& cursor)
 {
-  for(std::deque<HaveEntry>::const_iterator itr = haves_.begin(),
-        eoi = haves_.end(); itr != eoi; ++itr) {
-    const HaveEntry& have = *itr;
-    if(have.getCuid() == myCuid) {
-      continue;
-    }
-    if(lastCheckTime > have.getRegisteredTime()) {
-      break;
-    }
-    indexes.push_back(have.getIndex());
+  if(cursor+haves_.size() < haveSeq_) {
+    cursor = haveSeq_;
+    return false;
   }
-}
-
-namespace {
-class FindElapsedHave
-{
-private:
-  time_t elapsed;
-public:
-  FindElapsedHave(time_t elapsed):elapsed(elapsed) {}
-
-  bool operator()(const HaveEntry& have) {
-    if(have.getRegisteredTime().difference(global::wallclock()) >= elapsed) {
-      return true;
-    } else {
-      return false;
+  for(; cursor < haveSeq_; ++cursor) {
+    const HaveEntry& have = haves_[cursor%haves_.size()];
+    if(have.getCuid() != myCuid) {
+      indexes.push_back(have.getIndex());
     }
   }
-};
-} // namespace
+  return true;
+}
 
-void DefaultPieceStorage::removeAdvertisedPiece(time_t elapsed)
+uint64_t DefaultPieceStorage::getAdvertisedPieceCursor()
 {
-  std::deque<HaveEntry>::iterator itr =
-    std::find_if(haves_.begin(), haves_.end(), FindElapsedHave(elapsed));
-  if(itr != haves_.end()) {
-    A2_LOG_DEBUG(fmt(MSG_REMOVED_HAVE_ENTRY,
-                     static_cast<unsigned long>(haves_.end()-itr)));
-    haves_.erase(itr, haves_.end());
-  }
+  return haveSeq_;
 }
 
 void DefaultPieceStorage::markAllPiecesDone()
 {
   bitfieldMan_->setAllBit();
+  resetPieceChanges();
 }
 
 void DefaultPieceStorage::markPiecesDone(uint64_t length)
 {
+  resetPieceChanges();
   if(length == bitfieldMan_->getTotalLength()) {
     bitfieldMan_->setAllBit();
   } else if(length == 0) {
@@ -748,6 +959,25 @@ void DefaultPieceStorage::markPiecesDone(uint64_t length)
 void DefaultPieceStorage::markPieceMissing(size_t index)
 {
   bitfieldMan_->unsetBit(index);
+  recordPieceChange(index);
+}
+
+void DefaultPieceStorage::recordPieceChange(size_t index)
+{
+  pieceChanges_.push_back(index);
+  // Beyond this, rebuilding CandidatePieces is cheaper than replaying
+  // the log.
+  if(pieceChanges_.size() >
+     std::max(static_cast<size_t>(64), bitfieldMan_->getBitfieldLength())) {
+    pieceChanges_.pop_front();
+    ++pieceChangeBase_;
+  }
+}
+
+void DefaultPieceStorage::resetPieceChanges()
+{
+  pieceChangeBase_ += pieceChanges_.size()+1;
+  pieceChanges_.clear();
 }
 
 void DefaultPieceStorage::addInFlightPiece
@@ -775,6 +1005,12 @@ void DefaultPieceStorage::setDiskWriterFactory
   diskWriterFactory_ = diskWriterFactory;
 }
 
+void DefaultPieceStorage::setOpenedFileCache
+(const SharedHandle<OpenedFileCache>& openedFileCache)
+{
+  openedFileCache_ = openedFileCache;
+}
+
 void DefaultPieceStorage::addPieceStats(const unsigned char* bitfield,
                                         size_t bitfieldLength)
 {
@@ -815,4 +1051,45 @@ void DefaultPieceStorage::onDownloadIncomplete()
   streamPieceSelector_->onBitfieldInit();
 }
 
+void DefaultPieceStorage::flushWrDiskCacheEntry()
+{
+  if(!wrDiskCache_) {
+    return;
+  }
+  // Finishing asynchronous writes may complete pieces, so wait for
+  // them before iterating usedPieces_.
+  wrDiskCache_->waitAsyncWrite(diskAdaptor_);
+  for(std::deque<SharedHandle<Piece> >::const_iterator i = usedPieces_.begin(),
+        eoi = usedPieces_.end(); i != eoi; ++i) {
+    (*i)->flushWrCache();
+  }
+}
+
+void DefaultPieceStorage::releaseWrDiskCacheEntry()
+{
+  if(!wrDiskCache_) {
+    return;
+  }
+  wrDiskCache_->waitAsyncWrite(diskAdaptor_);
+  for(std::deque<SharedHandle<Piece> >::const_iterator i = usedPieces_.begin(),
+        eoi = usedPieces_.end(); i != eoi; ++i) {
+    (*i)->flushWrCache();
+    (*i)->releaseWrCache();
+  }
+}
+
+void DefaultPieceStorage::setPlayback(uint64_t position, unsigned int bitrate)
+{
+  if(!deadlinePieceSelector_) {
+    deadlinePieceSelector_.reset(new DeadlinePieceSelector(bitfieldMan_));
+  }
+  deadlinePieceSelector_->setPlayback(position, bitrate);
+}
+
+SharedHandle<DeadlinePieceSelector>
+DefaultPieceStorage::getDeadlinePieceSelector()
+{
+  return deadlinePieceSelector_;
+}
+
 } // namespace aria2
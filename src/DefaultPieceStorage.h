@@ -49,6 +49,12 @@ class FileEntry;
 class PieceStatMan;
 class PieceSelector;
 class StreamPieceSelector;
+class DeadlinePieceSelector;
+#ifdef ENABLE_BITTORRENT
+class SuperSeeder;
+#endif // ENABLE_BITTORRENT
+class WrDiskCache;
+class OpenedFileCache;
 
 #define END_GAME_PIECE_NUM 20
 
@@ -56,18 +62,14 @@ class HaveEntry {
 private:
   cuid_t cuid_;
   size_t index_;
-  Timer registeredTime_;
 public:
-  HaveEntry(cuid_t cuid, size_t index, const Timer& registeredTime):
+  HaveEntry(cuid_t cuid = 0, size_t index = 0):
     cuid_(cuid),
-    index_(index),
-    registeredTime_(registeredTime) {}
+    index_(index) {}
 
   cuid_t getCuid() const { return cuid_; }
 
   size_t getIndex() const { return index_; }
-
-  const Timer& getRegisteredTime() const { return registeredTime_; }
 };
 
 class DefaultPieceStorage : public PieceStorage {
@@ -81,12 +83,40 @@ private:
   bool endGame_;
   size_t endGamePieceNum_;
   const Option* option_;
-  std::deque<HaveEntry> haves_;
+  // Ring buffer of advertised pieces. The piece with sequence number
+  // seq is stored in haves_[seq%haves_.size()] until haveSeq_ reaches
+  // seq+haves_.size().
+  std::vector<HaveEntry> haves_;
+  // The sequence number the next advertised piece gets.
+  uint64_t haveSeq_;
 
   SharedHandle<PieceStatMan> pieceStatMan_;
 
   SharedHandle<PieceSelector> pieceSelector_;
   SharedHandle<StreamPieceSelector> streamPieceSelector_;
+  // Created by setPlayback().
+  SharedHandle<DeadlinePieceSelector> deadlinePieceSelector_;
+#ifdef ENABLE_BITTORRENT
+  // Created if --bt-super-seeding is enabled.
+  SharedHandle<SuperSeeder> superSeeder_;
+#endif // ENABLE_BITTORRENT
+
+  WrDiskCache* wrDiskCache_;
+
+  SharedHandle<OpenedFileCache> openedFileCache_;
+
+  // Indexes of the pieces whose downloaded or checked out state has
+  // changed, oldest first. Peer's CandidatePieces are brought up to
+  // date by replaying this log.
+  std::deque<size_t> pieceChanges_;
+  // Position of the front of pieceChanges_ in the log. Positions
+  // before this are no longer available.
+  uint64_t pieceChangeBase_;
+
+  void recordPieceChange(size_t index);
+  // Invalidates all peer's CandidatePieces. Call this after changing
+  // many pieces at once.
+  void resetPieceChanges();
 #ifdef ENABLE_BITTORRENT
   void getMissingPiece
   (std::vector<SharedHandle<Piece> >& pieces,
@@ -95,7 +125,33 @@ private:
    size_t length,
    cuid_t cuid);
 
-  void createFastIndexBitfield(BitfieldMan& bitfield,
+  // Checks out pieces chosen by pieceSelector_ from candidates until
+  // minMissingBlocks blocks are collected. The chosen pieces are
+  // cleared from candidates.
+  void selectMissingPiece
+  (std::vector<SharedHandle<Piece> >& pieces,
+   size_t minMissingBlocks,
+   unsigned char* candidates,
+   cuid_t cuid);
+
+  // Checks out pieces chosen by deadlinePieceSelector_ from
+  // candidates, and possibly one piece another connection is
+  // downloading if it is about to miss its deadline. Returns the
+  // number of missing blocks in the checked out pieces.
+  size_t selectDeadlinePiece
+  (std::vector<SharedHandle<Piece> >& pieces,
+   size_t minMissingBlocks,
+   const SharedHandle<Peer>& peer,
+   unsigned char* candidates,
+   cuid_t cuid);
+
+  bool isCandidatePiece(const SharedHandle<Peer>& peer, size_t index);
+
+  // Brings peer's CandidatePieces up to date and returns its
+  // bitfield.
+  unsigned char* updateCandidatePieces(const SharedHandle<Peer>& peer);
+
+  void createFastIndexBitfield(unsigned char* bitfield,
                                const SharedHandle<Peer>& peer);
 #endif // ENABLE_BITTORRENT
 
@@ -165,6 +221,8 @@ public:
    const std::vector<size_t>& excludedIndexes,
    cuid_t cuid);
 
+  virtual SharedHandle<SuperSeeder> getSuperSeeder();
+
 #endif // ENABLE_BITTORRENT
 
   virtual bool hasMissingUnusedPiece();
@@ -175,6 +233,13 @@ public:
    size_t length,
    cuid_t cuid);
 
+  virtual SharedHandle<Piece> getMissingPiece
+  (size_t minSplitSize,
+   const unsigned char* ignoreBitfield,
+   size_t length,
+   cuid_t cuid,
+   unsigned int speed);
+
   virtual SharedHandle<Piece> getMissingPiece(size_t index, cuid_t cuid);
 
   virtual SharedHandle<Piece> getPiece(size_t index);
@@ -238,11 +303,11 @@ public:
 
   virtual void advertisePiece(cuid_t cuid, size_t index);
 
-  virtual void
+  virtual bool
   getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
-                            cuid_t myCuid, const Timer& lastCheckTime);
+                            cuid_t myCuid, uint64_t& cursor);
 
-  virtual void removeAdvertisedPiece(time_t elapsed);
+  virtual uint64_t getAdvertisedPieceCursor();
 
   virtual void markAllPiecesDone();
 
@@ -274,6 +339,14 @@ public:
 
   virtual void onDownloadIncomplete();
 
+  virtual void flushWrDiskCacheEntry();
+
+  virtual void releaseWrDiskCacheEntry();
+
+  virtual void setPlayback(uint64_t position, unsigned int bitrate);
+
+  virtual SharedHandle<DeadlinePieceSelector> getDeadlinePieceSelector();
+
   /**
    * This method is made private for test purpose only.
    */
@@ -296,6 +369,24 @@ public:
   {
     return pieceSelector_;
   }
+
+  // If wrDiskCache is not 0, the data of in-flight pieces are cached
+  // in it before written to the disk.
+  void setWrDiskCache(WrDiskCache* wrDiskCache)
+  {
+    wrDiskCache_ = wrDiskCache;
+  }
+
+  WrDiskCache* getWrDiskCache() const
+  {
+    return wrDiskCache_;
+  }
+
+  // If openedFileCache is set, it limits the number of files opened
+  // by a multi-file download instead of --bt-max-open-files of this
+  // download.
+  void setOpenedFileCache
+  (const SharedHandle<OpenedFileCache>& openedFileCache);
 };
 
 typedef SharedHandle<DefaultPieceStorage> DefaultPieceStorageHandle;
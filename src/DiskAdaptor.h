@@ -87,6 +87,23 @@ public:
 
   virtual bool isReadOnlyEnabled() const { return false; }
 
+  // Returns true if writeData(), writeDataVector() and readData() can
+  // be called from several threads at the same time while the files
+  // are open.
+  virtual bool isThreadSafe() const { return false; }
+
+  // Returns file descriptor of the file which contains the data at
+  // offset, opening the file if necessary.  The offset of the data in
+  // that file is stored in fileOffset and the number of bytes of the
+  // data in that file, which is at most len, is stored in fileLength.
+  // The returned descriptor is only valid until the next call to this
+  // object.  Returns -1 if no file descriptor is available.
+  virtual int getFd(off_t offset, size_t len,
+                    off_t& fileOffset, size_t& fileLength)
+  {
+    return -1;
+  }
+
   // Assumed each file length is stored in fileEntries or DiskAdaptor knows it.
   // If each actual file's length is larger than that, truncate file to that
   // length.
@@ -0,0 +1,113 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "DiskWriteJob.h"
+#include "WrDiskCache.h"
+#include "DiskAdaptor.h"
+#include "Piece.h"
+#include "PieceStorage.h"
+#include "Exception.h"
+#include "LogFactory.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+DiskWriteJob::DiskWriteJob(WrDiskCacheEntry* entry)
+  : entry_(entry),
+    diskAdaptor_(entry->getDiskAdaptor()),
+    size_(entry->getSize()),
+    cuid_(0),
+    handled_(false)
+{
+  entry_->swapDataSet(dataSet_);
+}
+
+DiskWriteJob::~DiskWriteJob()
+{
+  WrDiskCacheEntry::deleteDataCells(dataSet_);
+}
+
+void DiskWriteJob::execute()
+{
+  try {
+    WrDiskCacheEntry::writeDataCells(diskAdaptor_, dataSet_);
+  } catch(Exception& e) {
+    error_ = e.what();
+    if(error_.empty()) {
+      error_ = "unknown error";
+    }
+  }
+}
+
+void DiskWriteJob::onDone()
+{
+  if(handled_) {
+    return;
+  }
+  handled_ = true;
+  WrDiskCache* cache = entry_->getCache();
+  cache->onWriteDone(this);
+  if(!error_.empty()) {
+    A2_LOG_ERROR(fmt("Writing cached data failed: %s", error_.c_str()));
+    entry_->setWriteError(true);
+  }
+  if(pieceStorage_) {
+    // The older writes of this piece may still be running in other
+    // worker threads.
+    if(entry_->getPendingWrite() > 0) {
+      cache->waitAsyncWrite(entry_);
+    }
+    if(entry_->getWriteError()) {
+      piece_->clearAllBlock();
+#ifdef ENABLE_MESSAGE_DIGEST
+      piece_->destroyHashContext();
+#endif // ENABLE_MESSAGE_DIGEST
+    } else {
+      pieceStorage_->completePiece(piece_);
+      pieceStorage_->advertisePiece(cuid_, piece_->getIndex());
+    }
+  }
+}
+
+void DiskWriteJob::setPieceCompletion
+(const SharedHandle<PieceStorage>& pieceStorage,
+ const SharedHandle<Piece>& piece,
+ cuid_t cuid)
+{
+  pieceStorage_ = pieceStorage;
+  piece_ = piece;
+  cuid_ = cuid;
+}
+
+} // namespace aria2
@@ -0,0 +1,107 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_DISK_WRITE_JOB_H
+#define D_DISK_WRITE_JOB_H
+
+#include "ThreadJob.h"
+
+#include <string>
+
+#include "SharedHandle.h"
+#include "WrDiskCacheEntry.h"
+#include "Command.h"
+
+namespace aria2 {
+
+class DiskAdaptor;
+class Piece;
+class PieceStorage;
+
+// Writes the data taken from WrDiskCacheEntry in a worker thread.
+// The data are taken in the constructor, so that the entry can cache
+// new data while this job is running.
+class DiskWriteJob:public ThreadJob {
+private:
+  WrDiskCacheEntry* entry_;
+  SharedHandle<DiskAdaptor> diskAdaptor_;
+  WrDiskCacheEntry::DataCellSet dataSet_;
+  size_t size_;
+  // Written in the worker thread. Empty if the write succeeded.
+  std::string error_;
+  // If pieceStorage_ is not null, piece_ is completed in it after the
+  // data are written.
+  SharedHandle<PieceStorage> pieceStorage_;
+  SharedHandle<Piece> piece_;
+  cuid_t cuid_;
+  bool handled_;
+public:
+  DiskWriteJob(WrDiskCacheEntry* entry);
+
+  virtual ~DiskWriteJob();
+
+  virtual void execute();
+
+  // Updates entry and completes the piece if requested. This
+  // function is idempotent because WrDiskCache may call it before
+  // DownloadEngine does.
+  virtual void onDone();
+
+  // Marks piece completed in pieceStorage and advertises it as if it
+  // was done by cuid after the data are successfully written. If
+  // writing fails, all blocks of piece are cleared so that it is
+  // downloaded again.
+  void setPieceCompletion(const SharedHandle<PieceStorage>& pieceStorage,
+                          const SharedHandle<Piece>& piece,
+                          cuid_t cuid);
+
+  WrDiskCacheEntry* getEntry() const
+  {
+    return entry_;
+  }
+
+  size_t getSize() const
+  {
+    return size_;
+  }
+
+  const std::string& getError() const
+  {
+    return error_;
+  }
+};
+
+} // namespace aria2
+
+#endif // D_DISK_WRITE_JOB_H
@@ -79,6 +79,15 @@ public:
   // opens file in read/write mode. This is an optional
   // functionality. The default implementation is do noting.
   virtual void disableReadOnly() {}
+
+  // Returns true if writeData(), writeDataVector() and readData() can
+  // be called from several threads at the same time while the file
+  // is open.
+  virtual bool isThreadSafe() const { return false; }
+
+  // Returns file descriptor of the opened file, or -1 if the file is
+  // not opened or this object is not backed by a file.
+  virtual int getFd() const { return -1; }
 };
 
 typedef SharedHandle<DiskWriter> DiskWriterHandle;
@@ -34,6 +34,7 @@
 /* copyright --> */
 #include "DownloadCommand.h"
 
+#include <cerrno>
 #include <cassert>
 
 #include "Request.h"
@@ -60,8 +61,12 @@
 #include "RequestGroupMan.h"
 #include "wallclock.h"
 #include "SinkStreamFilter.h"
+#include "Piece.h"
+#include "DiskWriteJob.h"
+#include "WrDiskCacheEntry.h"
 #include "FileEntry.h"
 #include "SocketRecvBuffer.h"
+#include "DeadlinePieceSelector.h"
 #ifdef ENABLE_MESSAGE_DIGEST
 # include "MessageDigest.h"
 # include "message_digest_helper.h"
@@ -69,6 +74,9 @@
 #ifdef ENABLE_BITTORRENT
 # include "bittorrent_helper.h"
 #endif // ENABLE_BITTORRENT
+#ifdef HAVE_SPLICE
+# include "SplicePipe.h"
+#endif // HAVE_SPLICE
 
 namespace aria2 {
 
@@ -108,6 +116,17 @@ DownloadCommand::DownloadCommand
   streamFilter_.reset(new SinkStreamFilter(pieceHashValidationEnabled_));
   streamFilter_->init();
   sinkFilterOnly_ = true;
+#ifdef HAVE_SPLICE
+  if(getOption()->getAsBool(PREF_ENABLE_SPLICE) && !s->isSecure() &&
+     !pieceHashValidationEnabled_) {
+    splicePipe_.reset(new SplicePipe());
+    if(!splicePipe_->good()) {
+      A2_LOG_INFO(fmt("CUID#%lld - Failed to create pipe for splice: %s",
+                      getCuid(), util::safeStrerror(errno).c_str()));
+      splicePipe_.reset();
+    }
+  }
+#endif // HAVE_SPLICE
   checkSocketRecvBuffer();
 }
 
@@ -117,6 +136,22 @@ DownloadCommand::~DownloadCommand() {
 }
 
 bool DownloadCommand::executeInternal() {
+  if(getDiskWriteJob()) {
+    SharedHandle<DiskWriteJob> job = getDiskWriteJob();
+    if(!job->isDone()) {
+      getDownloadEngine()->addCommand(this);
+      return false;
+    }
+    setDiskWriteJob(SharedHandle<DiskWriteJob>());
+    SharedHandle<Segment> segment = getSegments().front();
+    if(!job->getError().empty() || job->getEntry()->getWriteError()) {
+      segment->clear();
+      getSegmentMan()->cancelSegment(getCuid());
+      throw DL_RETRY_EX(fmt("Writing cached data failed: %s",
+                            job->getError().c_str()));
+    }
+    return completeSegmentPart(segment);
+  }
   if(getDownloadEngine()->getRequestGroupMan()->doesOverallDownloadSpeedExceed()
      || getRequestGroup()->doesDownloadSpeedExceed()) {
     getDownloadEngine()->addCommand(this);
@@ -129,51 +164,44 @@ bool DownloadCommand::executeInternal() {
     getPieceStorage()->getDiskAdaptor();
   SharedHandle<Segment> segment = getSegments().front();
   bool eof = false;
-  if(getSocketRecvBuffer()->bufferEmpty()) {
-    // Only read from socket when buffer is empty.  Imagine that When
-    // segment length is *short* and we are using HTTP pilelining.  We
-    // issued 2 requests in pipeline. When reading first response
-    // header, we may read its response body and 2nd response header
-    // and 2nd response body in buffer if they are small enough to fit
-    // in buffer. And then server may sends EOF.  In this case, we
-    // read data from socket here, we will get EOF and leaves 2nd
-    // response unprocessed.  To prevent this, we don't read from
-    // socket when buffer is not empty.
-    eof = getSocketRecvBuffer()->recv() == 0 &&
-      !getSocket()->wantRead() && !getSocket()->wantWrite();
-  }
-  if(!eof) {
-    size_t bufSize;
-    if(sinkFilterOnly_) {
-      if(segment->getLength() > 0) {
-        if(static_cast<uint64_t>(segment->getPosition()+segment->getLength()) <=
-           static_cast<uint64_t>(getFileEntry()->getLastOffset())) {
-          bufSize = std::min(segment->getLength()-segment->getWrittenLength(),
-                             getSocketRecvBuffer()->getBufferLength());
-        } else {
-          bufSize =
-            std::min
-            (static_cast<size_t>
-             (getFileEntry()->getLastOffset()-segment->getPositionToWrite()),
-             getSocketRecvBuffer()->getBufferLength());
-        }
+  bool spliced = false;
+#ifdef HAVE_SPLICE
+  spliced = spliceSegmentData(segment, diskAdaptor, eof);
+#endif // HAVE_SPLICE
+  if(!spliced) {
+    if(getSocketRecvBuffer()->bufferEmpty()) {
+      // Only read from socket when buffer is empty.  Imagine that When
+      // segment length is *short* and we are using HTTP pilelining.  We
+      // issued 2 requests in pipeline. When reading first response
+      // header, we may read its response body and 2nd response header
+      // and 2nd response body in buffer if they are small enough to fit
+      // in buffer. And then server may sends EOF.  In this case, we
+      // read data from socket here, we will get EOF and leaves 2nd
+      // response unprocessed.  To prevent this, we don't read from
+      // socket when buffer is not empty.
+      eof = getSocketRecvBuffer()->recv() == 0 &&
+        !getSocket()->wantRead() && !getSocket()->wantWrite();
+    }
+    if(!eof) {
+      size_t bufSize;
+      if(sinkFilterOnly_) {
+        bufSize = calculateSinkLength(segment,
+                                      getSocketRecvBuffer()->getBufferLength());
+        streamFilter_->transform(diskAdaptor, segment,
+                                 getSocketRecvBuffer()->getBuffer(), bufSize);
       } else {
-        bufSize = getSocketRecvBuffer()->getBufferLength();
+        // It is possible that segment is completed but we have some bytes
+        // of stream to read. For example, chunked encoding has "0"+CRLF
+        // after data. After we read data(at this moment segment is
+        // completed), we need another 3bytes(or more if it has trailers).
+        streamFilter_->transform(diskAdaptor, segment,
+                                 getSocketRecvBuffer()->getBuffer(),
+                                 getSocketRecvBuffer()->getBufferLength());
+        bufSize = streamFilter_->getBytesProcessed();
       }
-      streamFilter_->transform(diskAdaptor, segment,
-                               getSocketRecvBuffer()->getBuffer(), bufSize);
-    } else {
-      // It is possible that segment is completed but we have some bytes
-      // of stream to read. For example, chunked encoding has "0"+CRLF
-      // after data. After we read data(at this moment segment is
-      // completed), we need another 3bytes(or more if it has trailers).
-      streamFilter_->transform(diskAdaptor, segment,
-                               getSocketRecvBuffer()->getBuffer(),
-                               getSocketRecvBuffer()->getBufferLength());
-      bufSize = streamFilter_->getBytesProcessed();
+      getSocketRecvBuffer()->shiftBuffer(bufSize);
+      peerStat_->updateDownloadLength(bufSize);
     }
-    getSocketRecvBuffer()->shiftBuffer(bufSize);
-    peerStat_->updateDownloadLength(bufSize);
   }
   getSegmentMan()->updateDownloadSpeedFor(peerStat_);
   bool segmentPartComplete = false;
@@ -210,62 +238,159 @@ bool DownloadCommand::executeInternal() {
   }
 
   if(segmentPartComplete) {
-    if(segment->complete() || segment->getLength() == 0) {
-      // If segment->getLength() == 0, the server doesn't provide
-      // content length, but the client detected that download
-      // completed.
-      A2_LOG_INFO(fmt(MSG_SEGMENT_DOWNLOAD_COMPLETED,
-                      getCuid()));
+    // Write the data of this segment held in the disk cache in one
+    // go. If a worker thread does it, continue when it is done.
+    SharedHandle<Piece> piece = segment->getPiece();
+    if(piece && piece->getWrDiskCacheEntry()) {
+      SharedHandle<DiskWriteJob> job =
+        piece->flushWrCacheAsync(this, SharedHandle<PieceStorage>(),
+                                 piece, getCuid());
+      if(job) {
+        setDiskWriteJob(job);
+        disableReadCheckSocket();
+        disableWriteCheckSocket();
+        getDownloadEngine()->addCommand(this);
+        return false;
+      }
+      // The data may have been lost by a failed write when they were
+      // evicted from the cache.
+      if(piece->getWrDiskCacheEntry()->getWriteError()) {
+        segment->clear();
+        getSegmentMan()->cancelSegment(getCuid());
+        throw DL_RETRY_EX("Writing cached data failed");
+      }
+    }
+    return completeSegmentPart(segment);
+  } else {
+    checkLowestDownloadSpeed();
+    setWriteCheckSocketIf(getSocket(), getSocket()->wantWrite());
+    checkSocketRecvBuffer();
+    getDownloadEngine()->addCommand(this);
+    return false;
+  }
+}
+
+size_t DownloadCommand::calculateSinkLength
+(const SharedHandle<Segment>& segment, size_t maxLength) const
+{
+  if(segment->getLength() > 0) {
+    if(static_cast<uint64_t>(segment->getPosition()+segment->getLength()) <=
+       static_cast<uint64_t>(getFileEntry()->getLastOffset())) {
+      return std::min(segment->getLength()-segment->getWrittenLength(),
+                      maxLength);
+    } else {
+      return std::min
+        (static_cast<size_t>
+         (getFileEntry()->getLastOffset()-segment->getPositionToWrite()),
+         maxLength);
+    }
+  } else {
+    return maxLength;
+  }
+}
+
+#ifdef HAVE_SPLICE
+bool DownloadCommand::spliceSegmentData
+(const SharedHandle<Segment>& segment,
+ const SharedHandle<DiskAdaptor>& diskAdaptor,
+ bool& eof)
+{
+  // The data already in the receive buffer and the data transformed
+  // by the filters other than SinkStreamFilter must go through the
+  // ordinary path.
+  if(!splicePipe_ || !sinkFilterOnly_ ||
+     !getSocketRecvBuffer()->bufferEmpty()) {
+    return false;
+  }
+  size_t len = calculateSinkLength(segment, SplicePipe::CAPACITY);
+  if(len == 0) {
+    return false;
+  }
+  // The data of this piece held in the disk cache must be written
+  // first. Otherwise they overwrite the data spliced to the file
+  // later.
+  SharedHandle<Piece> piece = segment->getPiece();
+  if(piece && piece->getWrDiskCacheEntry() &&
+     (piece->getWrDiskCacheEntry()->getSize() > 0 ||
+      piece->getWrDiskCacheEntry()->getPendingWrite() > 0)) {
+    piece->flushWrCache();
+  }
+  off_t fileOffset;
+  size_t fileLength;
+  int fd = diskAdaptor->getFd(segment->getPositionToWrite(), len,
+                              fileOffset, fileLength);
+  if(fd == -1) {
+    return false;
+  }
+  ssize_t n = splicePipe_->recv(getSocket(), fileLength);
+  if(n == 0) {
+    eof = !getSocket()->wantRead() && !getSocket()->wantWrite();
+    return true;
+  }
+  splicePipe_->writeTo(fd, fileOffset, getFileEntry()->getPath());
+  segment->updateWrittenLength(n);
+  peerStat_->updateDownloadLength(n);
+  return true;
+}
+#endif // HAVE_SPLICE
+
+bool DownloadCommand::completeSegmentPart
+(const SharedHandle<Segment>& segment)
+{
+  if(segment->getPiece()) {
+    // Flushes the rest if asynchronous write was not used and waits
+    // for the older asynchronous writes, if any.
+    segment->getPiece()->flushWrCache();
+  }
+  if(segment->complete() || segment->getLength() == 0) {
+    // If segment->getLength() == 0, the server doesn't provide
+    // content length, but the client detected that download
+    // completed.
+    A2_LOG_INFO(fmt(MSG_SEGMENT_DOWNLOAD_COMPLETED,
+                    getCuid()));
 #ifdef ENABLE_MESSAGE_DIGEST
 
-      {
-        const std::string& expectedPieceHash =
-          getDownloadContext()->getPieceHash(segment->getIndex());
-        if(pieceHashValidationEnabled_ && !expectedPieceHash.empty()) {
-          if(
+    {
+      const std::string& expectedPieceHash =
+        getDownloadContext()->getPieceHash(segment->getIndex());
+      if(pieceHashValidationEnabled_ && !expectedPieceHash.empty()) {
+        if(
 #ifdef ENABLE_BITTORRENT
-             (!getPieceStorage()->isEndGame() ||
-              !getDownloadContext()->hasAttribute(bittorrent::BITTORRENT)) &&
+           (!getPieceStorage()->isEndGame() ||
+            !getDownloadContext()->hasAttribute(bittorrent::BITTORRENT)) &&
 #endif // ENABLE_BITTORRENT
-             segment->isHashCalculated()) {
-            A2_LOG_DEBUG(fmt("Hash is available! index=%lu",
-                             static_cast<unsigned long>(segment->getIndex())));
-            validatePieceHash
-              (segment, expectedPieceHash, segment->getDigest());
-          } else {
-            messageDigest_->reset();
-            validatePieceHash
-              (segment, expectedPieceHash,
-               message_digest::digest
-               (messageDigest_,
-                getPieceStorage()->getDiskAdaptor(),
-                segment->getPosition(),
-                segment->getLength()));
-          }
+           segment->isHashCalculated()) {
+          A2_LOG_DEBUG(fmt("Hash is available! index=%lu",
+                           static_cast<unsigned long>(segment->getIndex())));
+          validatePieceHash
+            (segment, expectedPieceHash, segment->getDigest());
         } else {
-          getSegmentMan()->completeSegment(getCuid(), segment);
+          messageDigest_->reset();
+          validatePieceHash
+            (segment, expectedPieceHash,
+             message_digest::digest
+             (messageDigest_,
+              getPieceStorage()->getDiskAdaptor(),
+              segment->getPosition(),
+              segment->getLength()));
         }
+      } else {
+        getSegmentMan()->completeSegment(getCuid(), segment);
       }
+    }
 
 #else // !ENABLE_MESSAGE_DIGEST
-      getSegmentMan()->completeSegment(getCuid(), segment);
+    getSegmentMan()->completeSegment(getCuid(), segment);
 #endif // !ENABLE_MESSAGE_DIGEST
-    } else {
-      // If segment is not canceled here, in the next pipelining
-      // request, aria2 requests bad range
-      // [FileEntry->getLastOffset(), FileEntry->getLastOffset())
-      getSegmentMan()->cancelSegment(getCuid(), segment);
-    }
-    checkLowestDownloadSpeed();
-    // this unit is going to download another segment.
-    return prepareForNextSegment();
   } else {
-    checkLowestDownloadSpeed();
-    setWriteCheckSocketIf(getSocket(), getSocket()->wantWrite());
-    checkSocketRecvBuffer();
-    getDownloadEngine()->addCommand(this);
-    return false;
+    // If segment is not canceled here, in the next pipelining
+    // request, aria2 requests bad range
+    // [FileEntry->getLastOffset(), FileEntry->getLastOffset())
+    getSegmentMan()->cancelSegment(getCuid(), segment);
   }
+  checkLowestDownloadSpeed();
+  // this unit is going to download another segment.
+  return prepareForNextSegment();
 }
 
 void DownloadCommand::checkLowestDownloadSpeed() const
@@ -325,6 +450,13 @@ bool DownloadCommand::prepareForNextSegment() {
          (tempSegment->getPosition()+tempSegment->getLength())) {
         return prepareForRetry(0);
       }
+      SharedHandle<DeadlinePieceSelector> deadlinePieceSelector =
+        getPieceStorage()->getDeadlinePieceSelector();
+      if(deadlinePieceSelector &&
+         deadlinePieceSelector->hasEarlierPiece(tempSegment->getIndex()+1)) {
+        // Let the next request go to the piece needed for playback.
+        return prepareForRetry(0);
+      }
       SharedHandle<Segment> nextSegment = getSegmentMan()->getSegmentWithIndex
         (getCuid(), tempSegment->getIndex()+1);
       if(!nextSegment) {
@@ -46,6 +46,10 @@ class StreamFilter;
 #ifdef ENABLE_MESSAGE_DIGEST
 class MessageDigest;
 #endif // ENABLE_MESSAGE_DIGEST
+#ifdef HAVE_SPLICE
+class SplicePipe;
+class DiskAdaptor;
+#endif // HAVE_SPLICE
 
 class DownloadCommand : public AbstractCommand {
 private:
@@ -67,9 +71,29 @@ private:
 
   void checkLowestDownloadSpeed() const;
 
+  // Called when the data of segment are all received, possibly after
+  // waiting for the cached data to be written.
+  bool completeSegmentPart(const SharedHandle<Segment>& segment);
+
+  // Returns the number of bytes, at most maxLength, which can be
+  // written to segment without going beyond the end of the file.
+  size_t calculateSinkLength
+  (const SharedHandle<Segment>& segment, size_t maxLength) const;
+
   SharedHandle<StreamFilter> streamFilter_;
 
   bool sinkFilterOnly_;
+
+#ifdef HAVE_SPLICE
+  SharedHandle<SplicePipe> splicePipe_;
+
+  // Moves the data received from the socket to the file directly
+  // using splice(2).  Returns false if the data cannot be handled in
+  // this way.  eof is set to true if EOF is reached.
+  bool spliceSegmentData(const SharedHandle<Segment>& segment,
+                         const SharedHandle<DiskAdaptor>& diskAdaptor,
+                         bool& eof);
+#endif // HAVE_SPLICE
 protected:
   virtual bool executeInternal();
 
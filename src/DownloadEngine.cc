@@ -66,6 +66,9 @@
 #include "DownloadContext.h"
 #include "fmt.h"
 #include "wallclock.h"
+#include "ThreadPool.h"
+#include "ThreadJob.h"
+#include "CommandStatMan.h"
 #ifdef ENABLE_BITTORRENT
 # include "BtRegistry.h"
 #endif // ENABLE_BITTORRENT
@@ -95,7 +98,8 @@ DownloadEngine::DownloadEngine(const SharedHandle<EventPoll>& eventPoll)
 #ifdef HAVE_ARES_ADDR_NODE
     asyncDNSServers_(0),
 #endif // HAVE_ARES_ADDR_NODE
-    dnsCache_(new DNSCache())
+    dnsCache_(new DNSCache()),
+    readyQueueEnabled_(false)
 {
   unsigned char sessionId[20];
   util::generateRandomKey(sessionId);
@@ -103,7 +107,11 @@ DownloadEngine::DownloadEngine(const SharedHandle<EventPoll>& eventPoll)
 }
 
 DownloadEngine::~DownloadEngine() {
+  eventPoll_->setReadyCommands(0);
   cleanQueue();
+  // Join worker threads before jobs they may touch are released.
+  threadPool_.reset();
+  runningJobs_.clear();
 #ifdef HAVE_ARES_ADDR_NODE
   setAsyncDNSServers(0);
 #endif // HAVE_ARES_ADDR_NODE
@@ -112,11 +120,25 @@ DownloadEngine::~DownloadEngine() {
 void DownloadEngine::cleanQueue() {
   std::for_each(commands_.begin(), commands_.end(), Deleter());
   commands_.clear();
+  std::for_each(idleCommands_.begin(), idleCommands_.end(), Deleter());
+  idleCommands_.clear();
+  readyCommands_.clear();
+  for(std::multimap<Timer, Command*>::const_iterator i =
+        timerCommands_.begin(), eoi = timerCommands_.end(); i != eoi; ++i) {
+    delete (*i).second;
+  }
+  timerCommands_.clear();
 }
 
 namespace {
+// If idleCommands is not 0, Commands which do not match statusFilter
+// are moved to idleCommands instead of being pushed back to
+// commands. If stats is not 0, execution time of each Command is
+// recorded to it.
 void executeCommand(std::deque<Command*>& commands,
-                    Command::STATUS statusFilter)
+                    Command::STATUS statusFilter,
+                    std::set<Command*>* idleCommands,
+                    CommandStatMan* stats)
 {
   size_t max = commands.size();
   for(size_t i = 0; i < max; ++i) {
@@ -124,10 +146,20 @@ void executeCommand(std::deque<Command*>& commands,
     commands.pop_front();
     if(com->statusMatch(statusFilter)) {
       com->transitStatus();
-      if(com->execute()) {
+      bool done;
+      if(stats) {
+        Timer start;
+        done = com->execute();
+        stats->update(com, Timer().getTimeInMicros()-start.getTimeInMicros());
+      } else {
+        done = com->execute();
+      }
+      if(done) {
         delete com;
         com = 0;
       }
+    } else if(idleCommands) {
+      idleCommands->insert(com);
     } else {
       commands.push_back(com);
     }
@@ -142,34 +174,149 @@ void DownloadEngine::run()
 {
   Timer cp;
   cp.reset(0);
-  while(!commands_.empty() || !routineCommands_.empty()) {
+  while(!commands_.empty() || !idleCommands_.empty() ||
+        !timerCommands_.empty() || !routineCommands_.empty()) {
     global::wallclock().reset();
     calculateStatistics();
+    wakeTimerCommands();
+    std::set<Command*>* idleCommands =
+      readyQueueEnabled_ ? &idleCommands_ : 0;
     if(cp.differenceInMillis(global::wallclock())+A2_DELTA_MILLIS >=
        refreshInterval_) {
       refreshInterval_ = DEFAULT_REFRESH_INTERVAL;
       cp = global::wallclock();
-      executeCommand(commands_, Command::STATUS_ALL);
+      // Idle Commands must be executed here to check their timeout.
+      commands_.insert(commands_.end(),
+                       idleCommands_.begin(), idleCommands_.end());
+      idleCommands_.clear();
+      executeCommand(commands_, Command::STATUS_ALL, idleCommands,
+                     commandStatMan_.get());
     } else {
-      executeCommand(commands_, Command::STATUS_ACTIVE);
+      executeCommand(commands_, Command::STATUS_ACTIVE, idleCommands,
+                     commandStatMan_.get());
     }
-    executeCommand(routineCommands_, Command::STATUS_ALL);
+    executeCommand(routineCommands_, Command::STATUS_ALL, 0,
+                   commandStatMan_.get());
     afterEachIteration();
-    if(!commands_.empty()) {
+    if(!commands_.empty() || !idleCommands_.empty() ||
+       !timerCommands_.empty()) {
       waitData();
+      activateReadyCommands();
     }
     noWait_ = false;
   }
   onEndOfRun();
 }
 
+void DownloadEngine::activateReadyCommands()
+{
+  for(std::deque<Command*>::const_iterator i = readyCommands_.begin(),
+        eoi = readyCommands_.end(); i != eoi; ++i) {
+    // Command may be notified more than once or may be already in
+    // commands_. Only move it if it is still idle.
+    if(idleCommands_.erase(*i)) {
+      commands_.push_back(*i);
+    }
+  }
+  readyCommands_.clear();
+}
+
+void DownloadEngine::wakeTimerCommands()
+{
+  bool wakeAll = haltRequested_ || requestGroupMan_->downloadFinished();
+  std::multimap<Timer, Command*>::iterator i = timerCommands_.begin();
+  for(std::multimap<Timer, Command*>::iterator eoi = timerCommands_.end();
+      i != eoi && (wakeAll || !(global::wallclock() < (*i).first)); ++i) {
+    (*i).second->setStatusActive();
+    commands_.push_back((*i).second);
+  }
+  timerCommands_.erase(timerCommands_.begin(), i);
+}
+
+void DownloadEngine::wakeCommand(Command* command)
+{
+  command->setStatusActive();
+  if(idleCommands_.erase(command)) {
+    commands_.push_back(command);
+  }
+  setNoWait(true);
+}
+
+void DownloadEngine::setThreadPool(const SharedHandle<ThreadPool>& threadPool)
+{
+  threadPool_ = threadPool;
+}
+
+void DownloadEngine::setCommandStatMan
+(const SharedHandle<CommandStatMan>& commandStatMan)
+{
+  commandStatMan_ = commandStatMan;
+}
+
+void DownloadEngine::submitJob
+(const SharedHandle<ThreadJob>& job, Command* command)
+{
+  job->setCommand(command);
+  job->setDone(false);
+  runningJobs_[job.get()] = job;
+  threadPool_->submit(job.get());
+}
+
+void DownloadEngine::dispatchDoneJobs()
+{
+  std::vector<ThreadJob*> jobs;
+  threadPool_->getDoneJobs(jobs);
+  // Mark all jobs done first because onDone() may wait for other
+  // jobs.
+  for(std::vector<ThreadJob*>::const_iterator i = jobs.begin(),
+        eoi = jobs.end(); i != eoi; ++i) {
+    (*i)->setDone(true);
+  }
+  for(std::vector<ThreadJob*>::const_iterator i = jobs.begin(),
+        eoi = jobs.end(); i != eoi; ++i) {
+    (*i)->onDone();
+    if((*i)->getCommand()) {
+      wakeCommand((*i)->getCommand());
+    }
+    runningJobs_.erase(*i);
+  }
+}
+
+void DownloadEngine::waitJob(ThreadJob* job)
+{
+  threadPool_->wait(job);
+  dispatchDoneJobs();
+}
+
+bool DownloadEngine::addThreadPoolCheck(Command* command)
+{
+  return eventPoll_->addEvents(threadPool_->getWakeFd(), command,
+                               EventPoll::EVENT_READ);
+}
+
+bool DownloadEngine::deleteThreadPoolCheck(Command* command)
+{
+  return eventPoll_->deleteEvents(threadPool_->getWakeFd(), command,
+                                  EventPoll::EVENT_READ);
+}
+
 void DownloadEngine::waitData()
 {
   struct timeval tv;
   if(noWait_) {
     tv.tv_sec = tv.tv_usec = 0;
   } else {
-    lldiv_t qr = lldiv(refreshInterval_*1000, 1000000);
+    int64_t timeout = refreshInterval_;
+    if(!timerCommands_.empty()) {
+      // Wake up in time for the nearest deadline. The wait is rounded
+      // up to whole milliseconds, otherwise a deadline less than 1ms
+      // away gives 0 timeout and the loop spins until it passes.
+      int64_t micros = (*timerCommands_.begin()).first.getTimeInMicros()-
+        global::wallclock().getTimeInMicros();
+      timeout = std::min(timeout,
+                         std::max(static_cast<int64_t>(1), (micros+999)/1000));
+    }
+    lldiv_t qr = lldiv(timeout*1000, 1000000);
     tv.tv_sec = qr.quot;
     tv.tv_usec = qr.rem;
   }
@@ -273,6 +420,12 @@ void DownloadEngine::setNoWait(bool b)
   noWait_ = b;
 }
 
+void DownloadEngine::enableReadyQueue()
+{
+  readyQueueEnabled_ = true;
+  eventPoll_->setReadyCommands(&readyCommands_);
+}
+
 void DownloadEngine::addRoutineCommand(Command* command)
 {
   routineCommands_.push_back(command);
@@ -539,12 +692,28 @@ void DownloadEngine::setRefreshInterval(int64_t interval)
 
 void DownloadEngine::addCommand(const std::vector<Command*>& commands)
 {
-  commands_.insert(commands_.end(), commands.begin(), commands.end());
+  if(readyQueueEnabled_) {
+    for(std::vector<Command*>::const_iterator i = commands.begin(),
+          eoi = commands.end(); i != eoi; ++i) {
+      addCommand(*i);
+    }
+  } else {
+    commands_.insert(commands_.end(), commands.begin(), commands.end());
+  }
 }
 
 void DownloadEngine::addCommand(Command* command)
 {
-  commands_.push_back(command);
+  if(readyQueueEnabled_ && !command->statusMatch(Command::STATUS_ACTIVE)) {
+    idleCommands_.insert(command);
+  } else {
+    commands_.push_back(command);
+  }
+}
+
+void DownloadEngine::addTimerCommand(Command* command, const Timer& deadline)
+{
+  timerCommands_.insert(std::make_pair(deadline, command));
 }
 
 void DownloadEngine::setRequestGroupMan
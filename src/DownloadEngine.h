@@ -40,6 +40,7 @@
 #include <string>
 #include <deque>
 #include <map>
+#include <set>
 #include <vector>
 
 #include "SharedHandle.h"
@@ -65,6 +66,9 @@ class AuthConfigFactory;
 class Request;
 class EventPoll;
 class Command;
+class ThreadPool;
+class ThreadJob;
+class CommandStatMan;
 #ifdef ENABLE_BITTORRENT
 class BtRegistry;
 #endif // ENABLE_BITTORRENT
@@ -151,6 +155,16 @@ private:
   void onEndOfRun();
 
   void afterEachIteration();
+
+  // Moves Commands notified by EventPoll from idleCommands_ to
+  // commands_.
+  void activateReadyCommands();
+
+  // Moves Commands whose deadline has come from timerCommands_ to
+  // commands_. If all downloads finished or halt is requested, all
+  // Commands in timerCommands_ are moved regardless of deadline so
+  // that they can exit.
+  void wakeTimerCommands();
   
   void poolSocket(const std::string& key, const SocketPoolEntry& entry);
 
@@ -158,6 +172,30 @@ private:
   findSocketPoolEntry(const std::string& key);
 
   std::deque<Command*> commands_;
+
+  // True if ready queue dispatching is enabled. In this mode,
+  // commands_ only holds Commands ready to be executed and Commands
+  // waiting for events are kept in idleCommands_ until EventPoll
+  // reports them or refresh interval elapses.
+  bool readyQueueEnabled_;
+
+  std::set<Command*> idleCommands_;
+
+  // Commands activated by EventPoll in the last poll.
+  std::deque<Command*> readyCommands_;
+
+  // Commands sleeping until their deadline, sorted by deadline.
+  std::multimap<Timer, Command*> timerCommands_;
+
+  SharedHandle<ThreadPool> threadPool_;
+
+  // Execution statistics of Commands. Null unless enabled.
+  SharedHandle<CommandStatMan> commandStatMan_;
+
+  // Jobs submitted to threadPool_ and not dispatched yet. Worker
+  // threads only see raw pointers, so references are held here.
+  std::map<ThreadJob*, SharedHandle<ThreadJob> > runningJobs_;
+
   SharedHandle<RequestGroupMan> requestGroupMan_;
   SharedHandle<FileAllocationMan> fileAllocationMan_;
   SharedHandle<CheckIntegrityMan> checkIntegrityMan_;
@@ -192,6 +230,50 @@ public:
 
   void addCommand(Command* command);
 
+  // Adds command which sleeps until deadline. It is not executed
+  // until deadline comes, all downloads finished or halt is
+  // requested. The poll timeout is shortened so that command is
+  // executed on time.
+  void addTimerCommand(Command* command, const Timer& deadline);
+
+  // Wakes up command which is waiting for something other than
+  // EventPoll, for example, ThreadJob.
+  void wakeCommand(Command* command);
+
+  void setThreadPool(const SharedHandle<ThreadPool>& threadPool);
+
+  void setCommandStatMan(const SharedHandle<CommandStatMan>& commandStatMan);
+
+  const SharedHandle<CommandStatMan>& getCommandStatMan() const
+  {
+    return commandStatMan_;
+  }
+
+  const SharedHandle<ThreadPool>& getThreadPool() const
+  {
+    return threadPool_;
+  }
+
+  // Submits job to ThreadPool. When job is done, command is woken
+  // up. ThreadPool must be set before calling this function.
+  void submitJob(const SharedHandle<ThreadJob>& job, Command* command);
+
+  // Marks jobs finished by ThreadPool done and wakes up their Commands.
+  void dispatchDoneJobs();
+
+  // Blocks until job is done and then calls dispatchDoneJobs(). job
+  // must be submitted by submitJob() and must not be done.
+  void waitJob(ThreadJob* job);
+
+  bool hasRunningJobs() const
+  {
+    return !runningJobs_.empty();
+  }
+
+  bool addThreadPoolCheck(Command* command);
+
+  bool deleteThreadPoolCheck(Command* command);
+
   const SharedHandle<RequestGroupMan>& getRequestGroupMan() const
   {
     return requestGroupMan_;
@@ -236,6 +318,15 @@ public:
 
   void setNoWait(bool b);
 
+  // Enables ready queue dispatching. This must be called before any
+  // Command is added.
+  void enableReadyQueue();
+
+  bool isReadyQueueEnabled() const
+  {
+    return readyQueueEnabled_;
+  }
+
   void addRoutineCommand(Command* command);
 
   void poolSocket(const std::string& ipaddr, uint16_t port,
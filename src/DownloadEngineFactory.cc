@@ -50,7 +50,6 @@
 #include "FillRequestGroupCommand.h"
 #include "FileAllocationDispatcherCommand.h"
 #include "AutoSaveCommand.h"
-#include "HaveEraseCommand.h"
 #include "TimedHaltCommand.h"
 #include "DownloadResult.h"
 #include "ServerStatMan.h"
@@ -60,6 +59,9 @@
 #ifdef HAVE_EPOLL
 # include "EpollEventPoll.h"
 #endif // HAVE_EPOLL
+#ifdef HAVE_IO_URING
+# include "IoUringEventPoll.h"
+#endif // HAVE_IO_URING
 #ifdef HAVE_PORT_ASSOCIATE
 # include "PortEventPoll.h"
 #endif // HAVE_PORT_ASSOCIATE
@@ -73,6 +75,12 @@
 #include "DlAbortEx.h"
 #include "FileAllocationEntry.h"
 #include "HttpListenCommand.h"
+#include "ThreadPool.h"
+#include "JobDispatchCommand.h"
+#include "WrDiskCache.h"
+#include "CommandStatMan.h"
+#include "LogFactory.h"
+#include "Logger.h"
 
 namespace aria2 {
 
@@ -97,6 +105,17 @@ DownloadEngineFactory::newDownloadEngine
     }
   } else
 #endif // HAVE_EPLL
+#ifdef HAVE_IO_URING
+  if(pollMethod == V_IO_URING) {
+    SharedHandle<IoUringEventPoll> up(new IoUringEventPoll());
+    if(up->good()) {
+      eventPoll = up;
+    } else {
+      throw DL_ABORT_EX("Initializing IoUringEventPoll failed."
+                        " Try --event-poll=select");
+    }
+  } else
+#endif // HAVE_IO_URING
 #ifdef HAVE_KQUEUE
     if(pollMethod == V_KQUEUE) {
       SharedHandle<KqueueEventPoll> kp(new KqueueEventPoll());
@@ -131,6 +150,12 @@ DownloadEngineFactory::newDownloadEngine
           }
   DownloadEngineHandle e(new DownloadEngine(eventPoll));
   e->setOption(op);
+  if(op->getAsBool(PREF_ENABLE_READY_QUEUE)) {
+    e->enableReadyQueue();
+  }
+  if(op->getAsBool(PREF_ENABLE_ENGINE_STATS)) {
+    e->setCommandStatMan(SharedHandle<CommandStatMan>(new CommandStatMan()));
+  }
 
   RequestGroupManHandle
     requestGroupMan(new RequestGroupMan(requestGroups, MAX_CONCURRENT_DOWNLOADS,
@@ -155,7 +180,31 @@ DownloadEngineFactory::newDownloadEngine
       (new AutoSaveCommand(e->newCUID(), e.get(),
                            op->getAsInt(PREF_AUTO_SAVE_INTERVAL)));
   }
-  e->addRoutineCommand(new HaveEraseCommand(e->newCUID(), e.get(), 10));
+  if(op->getAsInt(PREF_WORKER_THREADS) > 0) {
+#ifdef HAVE_PTHREAD
+    SharedHandle<ThreadPool> threadPool
+      (new ThreadPool(op->getAsInt(PREF_WORKER_THREADS)));
+    if(threadPool->good()) {
+      e->setThreadPool(threadPool);
+      e->addCommand(new JobDispatchCommand(e->newCUID(), e.get()));
+      if(requestGroupMan->getWrDiskCache()) {
+        // Write the disk cache in worker threads.
+        requestGroupMan->getWrDiskCache()->setDownloadEngine(e.get());
+      }
+#ifdef ENABLE_MESSAGE_DIGEST
+      // Hash pieces in worker threads and check as many downloads
+      // as worker threads at the same time.
+      e->getCheckIntegrityMan()->setMaxPickedEntries
+        (threadPool->getNumThreads());
+#endif // ENABLE_MESSAGE_DIGEST
+    } else {
+      throw DL_ABORT_EX("Starting worker threads failed.");
+    }
+#else // !HAVE_PTHREAD
+    A2_LOG_WARN("--worker-threads is not supported on this platform."
+                " The option is ignored.");
+#endif // !HAVE_PTHREAD
+  }
   {
     time_t stopSec = op->getAsInt(PREF_STOP);
     if(stopSec > 0) {
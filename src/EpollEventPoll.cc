@@ -121,7 +121,7 @@ void EpollEventPoll::poll(const struct timeval& tv)
   if(res > 0) {
     for(int i = 0; i < res; ++i) {
       KSocketEntry* p = reinterpret_cast<KSocketEntry*>(epEvents_[i].data.ptr);
-      p->processEvents(epEvents_[i].events);
+      p->processEvents(epEvents_[i].events, getReadyCommands());
     }
   } else if(res == -1) {
     int errNum = errno;
@@ -55,7 +55,10 @@ class Event {
 public:
   virtual ~Event() {}
 
-  virtual void processEvents(int events) = 0;
+  // Processes events. If readyCommands is not 0, Commands activated
+  // by events are appended to it.
+  virtual void processEvents
+  (int events, std::deque<Command*>* readyCommands) = 0;
 
   virtual int getEvents() const = 0;
 
@@ -104,11 +107,15 @@ public:
     return events_;
   }
 
-  virtual void processEvents(int events)
+  virtual void processEvents
+  (int events, std::deque<Command*>* readyCommands)
   {
     if((events_&events) ||
        ((EventPoll::IEV_ERROR|EventPoll::IEV_HUP)&events)) {
       command_->setStatusActive();
+      if(readyCommands) {
+        readyCommands->push_back(command_);
+      }
     }
     if(EventPoll::IEV_READ&events) {
       command_->readEventReceived();
@@ -159,7 +166,8 @@ public:
     return events_;
   }
 
-  virtual void processEvents(int events)
+  virtual void processEvents
+  (int events, std::deque<Command*>* readyCommands)
   {
     ares_socket_t readfd;
     ares_socket_t writefd;
@@ -177,6 +185,9 @@ public:
     }
     resolver_->process(readfd, writefd);
     command_->setStatusActive();
+    if(readyCommands) {
+      readyCommands->push_back(command_);
+    }
   }
 
   virtual void addSelf(const SharedHandle<SocketEntry>& socketEntry) const
@@ -288,17 +299,17 @@ public:
 #endif // !ENABLE_ASYNC_DNS)
   }
     
-  void processEvents(int events)
+  void processEvents(int events, std::deque<Command*>* readyCommands)
   {
-    std::for_each(commandEvents_.begin(), commandEvents_.end(),
-                  std::bind2nd(std::mem_fun_ref
-                               (&CommandEvent::processEvents),
-                               events));
+    for(typename std::deque<CommandEvent>::iterator i =
+          commandEvents_.begin(), eoi = commandEvents_.end(); i != eoi; ++i) {
+      (*i).processEvents(events, readyCommands);
+    }
 #ifdef ENABLE_ASYNC_DNS
-    std::for_each(adnsEvents_.begin(), adnsEvents_.end(),
-                  std::bind2nd(std::mem_fun_ref
-                               (&ADNSEvent::processEvents),
-                               events));
+    for(typename std::deque<ADNSEvent>::iterator i =
+          adnsEvents_.begin(), eoi = adnsEvents_.end(); i != eoi; ++i) {
+      (*i).processEvents(events, readyCommands);
+    }
 #endif // ENABLE_ASYNC_DNS
   }
 };
@@ -36,6 +36,9 @@
 #define D_EVENT_POLL_H
 
 #include "common.h"
+
+#include <deque>
+
 #include "SharedHandle.h"
 #include "a2time.h"
 #include "a2netcompat.h"
@@ -47,7 +50,13 @@ class Command;
 class AsyncNameResolver;
 
 class EventPoll {
-
+private:
+  std::deque<Command*>* readyCommands_;
+protected:
+  std::deque<Command*>* getReadyCommands() const
+  {
+    return readyCommands_;
+  }
 public:
   enum EventType {
     EVENT_READ = 1,
@@ -56,8 +65,17 @@ public:
     EVENT_HUP = 1 << 3,
   };
 
+  EventPoll():readyCommands_(0) {}
+
   virtual ~EventPoll() {}
 
+  // Commands activated by events in poll() are appended to
+  // readyCommands. If readyCommands is 0, they are not recorded.
+  void setReadyCommands(std::deque<Command*>* readyCommands)
+  {
+    readyCommands_ = readyCommands;
+  }
+
   virtual void poll(const struct timeval& tv) = 0;
 
   virtual bool addEvents(sock_t socket, Command* command, EventType events) = 0;
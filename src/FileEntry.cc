@@ -63,7 +63,8 @@ FileEntry::FileEntry
     requested_(true),
     uniqueProtocol_(false),
     maxConnectionPerServer_(1),
-    lastFasterReplace_(0)
+    lastFasterReplace_(0),
+    unchanged_(false)
 {}
 
 FileEntry::FileEntry()
@@ -71,7 +72,8 @@ FileEntry::FileEntry()
    offset_(0),
    requested_(false),
    uniqueProtocol_(false),
-   maxConnectionPerServer_(1)
+   maxConnectionPerServer_(1),
+   unchanged_(false)
 {}
 
 FileEntry::~FileEntry() {}
@@ -74,6 +74,9 @@ private:
   size_t maxConnectionPerServer_;
   std::string originalName_;
   Timer lastFasterReplace_;
+  // True if the size and modification time of the file match the ones
+  // recorded in the control file.
+  bool unchanged_;
 
   void storePool(const SharedHandle<Request>& request);
 public:
@@ -254,6 +257,16 @@ public:
   {
     return uniqueProtocol_;
   }
+
+  void setUnchanged(bool f)
+  {
+    unchanged_ = f;
+  }
+
+  bool isUnchanged() const
+  {
+    return unchanged_;
+  }
 };
 
 // Returns the first FileEntry which isRequested() method returns
@@ -0,0 +1,84 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "FreeList.h"
+
+#include <algorithm>
+
+namespace aria2 {
+
+FreeList::FreeList(size_t chunkSize, size_t maxFree)
+  : chunkSize_(std::max(chunkSize, sizeof(Node))),
+    maxFree_(maxFree),
+    head_(0),
+    numFree_(0)
+{}
+
+FreeList::~FreeList()
+{
+  while(head_) {
+    Node* next = head_->next;
+    ::operator delete(head_);
+    head_ = next;
+  }
+}
+
+void* FreeList::allocate()
+{
+  if(head_) {
+    Node* node = head_;
+    head_ = node->next;
+    --numFree_;
+    return node;
+  } else {
+    return ::operator new(chunkSize_);
+  }
+}
+
+void FreeList::deallocate(void* p)
+{
+  if(!p) {
+    return;
+  }
+  if(numFree_ < maxFree_) {
+    Node* node = static_cast<Node*>(p);
+    node->next = head_;
+    head_ = node;
+    ++numFree_;
+  } else {
+    ::operator delete(p);
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,125 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_FREE_LIST_H
+#define D_FREE_LIST_H
+
+#include "common.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace aria2 {
+
+// Keeps memory chunks of fixed size which were freed, and hands them
+// out again on the next allocation, so that objects created and
+// destroyed at high rate do not go through the general purpose
+// allocator each time. At most maxFree chunks are kept. This class
+// is not thread-safe: allocate() and deallocate() must be called in
+// the same thread.
+class FreeList {
+private:
+  struct Node {
+    Node* next;
+  };
+
+  size_t chunkSize_;
+  size_t maxFree_;
+  Node* head_;
+  size_t numFree_;
+
+  // Don't allow copying
+  FreeList(const FreeList&);
+  FreeList& operator=(const FreeList&);
+public:
+  FreeList(size_t chunkSize, size_t maxFree);
+
+  ~FreeList();
+
+  // Returns a chunk of chunkSize bytes. The returned memory must be
+  // freed by deallocate() of this object.
+  void* allocate();
+
+  // Frees p, which was returned by allocate(). p may be 0.
+  void deallocate(void* p);
+
+  size_t getChunkSize() const
+  {
+    return chunkSize_;
+  }
+
+  // Returns the number of chunks kept for reuse.
+  size_t countFree() const
+  {
+    return numFree_;
+  }
+};
+
+// Base class which makes instances of T allocated from FreeList. Use
+// it as class T:public Base, public PooledObject<T>. Objects of
+// classes derived from T are allocated by the global operator new
+// because of their different size. The free list is shared by all
+// instances of T and is never destroyed, so T must be created and
+// destroyed only in the main thread.
+template<typename T, size_t MaxFree = 1024>
+class PooledObject {
+private:
+  static FreeList& freeList()
+  {
+    static FreeList* freeList = new FreeList(sizeof(T), MaxFree);
+    return *freeList;
+  }
+public:
+  static void* operator new(size_t size)
+  {
+    if(size == sizeof(T)) {
+      return freeList().allocate();
+    } else {
+      return ::operator new(size);
+    }
+  }
+
+  static void operator delete(void* p, size_t size)
+  {
+    if(size == sizeof(T)) {
+      freeList().deallocate(p);
+    } else {
+      ::operator delete(p);
+    }
+  }
+};
+
+} // namespace aria2
+
+#endif // D_FREE_LIST_H
@@ -33,6 +33,9 @@
  */
 /* copyright --> */
 #include "HandshakeExtensionMessage.h"
+
+#include <algorithm>
+
 #include "Peer.h"
 #include "util.h"
 #include "DlAbortEx.h"
@@ -53,7 +56,8 @@ const std::string HandshakeExtensionMessage::EXTENSION_NAME = "handshake";
 
 HandshakeExtensionMessage::HandshakeExtensionMessage()
   : tcpPort_(0),
-    metadataSize_(0)
+    metadataSize_(0),
+    reqq_(0)
 {}
 
 HandshakeExtensionMessage::~HandshakeExtensionMessage() {}
@@ -77,6 +81,9 @@ std::string HandshakeExtensionMessage::getPayload()
   if(metadataSize_) {
     dict.put("metadata_size", Integer::g(metadataSize_));
   }
+  if(reqq_) {
+    dict.put("reqq", Integer::g(reqq_));
+  }
   return bencode2::encode(&dict);
 }
 
@@ -92,6 +99,9 @@ std::string HandshakeExtensionMessage::toString() const
   if(metadataSize_) {
     strappend(s, ", metadataSize=", util::uitos(metadataSize_));
   }
+  if(reqq_) {
+    strappend(s, ", reqq=", util::uitos(reqq_));
+  }
   for(std::map<std::string, uint8_t>::const_iterator itr = extensions_.begin(),
         eoi = extensions_.end(); itr != eoi; ++itr) {
     const std::map<std::string, uint8_t>::value_type& vt = *itr;
@@ -106,6 +116,9 @@ void HandshakeExtensionMessage::doReceivedAction()
     peer_->setPort(tcpPort_);
     peer_->setIncomingPeer(false);
   }
+  if(reqq_) {
+    peer_->setReqq(reqq_);
+  }
   for(std::map<std::string, uint8_t>::const_iterator itr = extensions_.begin(),
         eoi = extensions_.end(); itr != eoi; ++itr) {
     const std::map<std::string, uint8_t>::value_type& vt = *itr;
@@ -202,6 +215,12 @@ HandshakeExtensionMessage::create(const unsigned char* data, size_t length)
   if(metadataSize && metadataSize->i() <= 1024*1024) {
     msg->metadataSize_ = metadataSize->i();
   }
+  const Integer* reqq = downcast<Integer>(dict->get("reqq"));
+  if(reqq && reqq->i() > 0) {
+    msg->reqq_ = std::min(reqq->i(),
+                          static_cast<Integer::ValueType>
+                          (UB_MAX_OUTSTANDING_REQUEST));
+  }
   return msg;
 }
 
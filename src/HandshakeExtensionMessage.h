@@ -54,6 +54,10 @@ private:
 
   size_t metadataSize_;
 
+  // The number of outstanding requests the sender accepts. 0 means
+  // not given.
+  size_t reqq_;
+
   std::map<std::string, uint8_t> extensions_;
 
   SharedHandle<DownloadContext> dctx_;
@@ -112,6 +116,16 @@ public:
     metadataSize_ = size;
   }
 
+  size_t getReqq() const
+  {
+    return reqq_;
+  }
+
+  void setReqq(size_t reqq)
+  {
+    reqq_ = reqq;
+  }
+
   void setDownloadContext(const SharedHandle<DownloadContext>& dctx)
   {
     dctx_ = dctx;
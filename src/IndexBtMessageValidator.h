@@ -36,12 +36,14 @@
 #define D_INDEX_BT_VALIDATOR_H
 
 #include "BtMessageValidator.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
 class IndexBtMessage;
 
-class IndexBtMessageValidator : public BtMessageValidator {
+class IndexBtMessageValidator : public BtMessageValidator,
+                                public PooledObject<IndexBtMessageValidator> {
 private:
   const IndexBtMessage* message_;
   size_t numPiece_;
@@ -0,0 +1,603 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "IoUringEventPoll.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <endian.h>
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <numeric>
+
+#include "Command.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "a2functional.h"
+#include "fmt.h"
+#include "a2time.h"
+
+namespace aria2 {
+
+namespace {
+int ioUringSetup(unsigned entries, struct io_uring_params* p)
+{
+  return syscall(__NR_io_uring_setup, entries, p);
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags)
+{
+  return syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags,
+                 0, 0);
+}
+
+// user_data of IORING_OP_TIMEOUT and IORING_OP_POLL_REMOVE
+// requests. Their completions are not ready events. Poll requests
+// never use these values because their sequence number is never 0.
+const uint64_t TIMEOUT_USER_DATA = 0;
+const uint64_t REMOVE_USER_DATA = 1;
+
+// user_data of poll request is sequence number in upper 32 bits and
+// socket in lower 32 bits, so that completion of the request can be
+// matched against the current KSocketEntry of the socket.
+uint64_t makePollId(uint32_t seq, sock_t socket)
+{
+  return (static_cast<uint64_t>(seq) << 32) | static_cast<uint32_t>(socket);
+}
+
+sock_t getPollSocket(uint64_t pollId)
+{
+  return static_cast<sock_t>(pollId & 0xffffffffu);
+}
+
+int64_t getMonotonicMicros()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec*1000000LL+ts.tv_nsec/1000;
+}
+} // namespace
+
+IoUringEventPoll::KSocketEntry::KSocketEntry(sock_t s):
+  SocketEntry<KCommandEvent, KADNSEvent>(s),
+  pollId_(0),
+  pollEvents_(0) {}
+
+int accumulateEvent(int events, const IoUringEventPoll::KEvent& event)
+{
+  return events|event.getEvents();
+}
+
+int IoUringEventPoll::KSocketEntry::getEvents()
+{
+#ifdef ENABLE_ASYNC_DNS
+
+  return
+    std::accumulate(adnsEvents_.begin(),
+                    adnsEvents_.end(),
+                    std::accumulate(commandEvents_.begin(),
+                                    commandEvents_.end(), 0, accumulateEvent),
+                    accumulateEvent);
+
+#else // !ENABLE_ASYNC_DNS
+
+  return
+    std::accumulate(commandEvents_.begin(), commandEvents_.end(), 0,
+                    accumulateEvent);
+
+#endif // !ENABLE_ASYNC_DNS
+}
+
+IoUringEventPoll::IoUringEventPoll()
+  : ringfd_(-1),
+    sqRing_(0),
+    sqRingSize_(0),
+    cqRing_(0),
+    cqRingSize_(0),
+    sqes_(0),
+    sqesSize_(0),
+    toSubmit_(0),
+    pollSeq_(0)
+{
+  if(!initRing()) {
+    cleanupRing();
+  }
+}
+
+IoUringEventPoll::~IoUringEventPoll()
+{
+  cleanupRing();
+}
+
+bool IoUringEventPoll::initRing()
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  // Poll requests stay in flight for all watched sockets, so make
+  // completion queue larger than the default.
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = IO_URING_ENTRIES*8;
+  ringfd_ = ioUringSetup(IO_URING_ENTRIES, &params);
+  if(ringfd_ == -1 && errno == EINVAL) {
+    memset(&params, 0, sizeof(params));
+    ringfd_ = ioUringSetup(IO_URING_ENTRIES, &params);
+  }
+  if(ringfd_ == -1) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("io_uring_setup failed: %s",
+                    util::safeStrerror(errNum).c_str()));
+    return false;
+  }
+  sqRingSize_ = params.sq_off.array+params.sq_entries*sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes+
+    params.cq_entries*sizeof(struct io_uring_cqe);
+  if(params.features&IORING_FEAT_SINGLE_MMAP) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  void* p = mmap(0, sqRingSize_, PROT_READ|PROT_WRITE,
+                 MAP_SHARED|MAP_POPULATE, ringfd_, IORING_OFF_SQ_RING);
+  if(p == MAP_FAILED) {
+    return false;
+  }
+  sqRing_ = reinterpret_cast<unsigned char*>(p);
+  if(params.features&IORING_FEAT_SINGLE_MMAP) {
+    cqRing_ = sqRing_;
+  } else {
+    p = mmap(0, cqRingSize_, PROT_READ|PROT_WRITE,
+             MAP_SHARED|MAP_POPULATE, ringfd_, IORING_OFF_CQ_RING);
+    if(p == MAP_FAILED) {
+      return false;
+    }
+    cqRing_ = reinterpret_cast<unsigned char*>(p);
+  }
+  sqesSize_ = params.sq_entries*sizeof(struct io_uring_sqe);
+  p = mmap(0, sqesSize_, PROT_READ|PROT_WRITE,
+           MAP_SHARED|MAP_POPULATE, ringfd_, IORING_OFF_SQES);
+  if(p == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = reinterpret_cast<struct io_uring_sqe*>(p);
+
+  sqHead_ = reinterpret_cast<unsigned*>(sqRing_+params.sq_off.head);
+  sqTail_ = reinterpret_cast<unsigned*>(sqRing_+params.sq_off.tail);
+  sqRingMask_ =
+    *reinterpret_cast<unsigned*>(sqRing_+params.sq_off.ring_mask);
+  sqRingEntries_ =
+    *reinterpret_cast<unsigned*>(sqRing_+params.sq_off.ring_entries);
+  sqArray_ = reinterpret_cast<unsigned*>(sqRing_+params.sq_off.array);
+
+  cqHead_ = reinterpret_cast<unsigned*>(cqRing_+params.cq_off.head);
+  cqTail_ = reinterpret_cast<unsigned*>(cqRing_+params.cq_off.tail);
+  cqRingMask_ =
+    *reinterpret_cast<unsigned*>(cqRing_+params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<struct io_uring_cqe*>(cqRing_+params.cq_off.cqes);
+  return true;
+}
+
+void IoUringEventPoll::cleanupRing()
+{
+  if(sqes_) {
+    munmap(sqes_, sqesSize_);
+    sqes_ = 0;
+  }
+  if(cqRing_ && cqRing_ != sqRing_) {
+    munmap(cqRing_, cqRingSize_);
+  }
+  cqRing_ = 0;
+  if(sqRing_) {
+    munmap(sqRing_, sqRingSize_);
+    sqRing_ = 0;
+  }
+  if(ringfd_ != -1) {
+    int r;
+    while((r = close(ringfd_)) == -1 && errno == EINTR);
+    int errNum = errno;
+    if(r == -1) {
+      A2_LOG_ERROR(fmt("Error occurred while closing io_uring file descriptor"
+                       " %d: %s",
+                       ringfd_,
+                       util::safeStrerror(errNum).c_str()));
+    }
+    ringfd_ = -1;
+  }
+}
+
+bool IoUringEventPoll::good() const
+{
+  return ringfd_ != -1 && sqes_;
+}
+
+struct io_uring_sqe* IoUringEventPoll::getSqe()
+{
+  unsigned tail = *sqTail_;
+  if(tail-__atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqRingEntries_) {
+    // The kernel consumes SQEs only if io_uring_enter(2) succeeds.
+    // It may fail with EBUSY or EAGAIN, and then the slot still holds
+    // an SQE which is not submitted yet.
+    submit(0);
+    if(tail-__atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqRingEntries_) {
+      A2_LOG_INFO("io_uring submission queue is full");
+      return 0;
+    }
+  }
+  unsigned index = tail&sqRingMask_;
+  struct io_uring_sqe* sqe = &sqes_[index];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sqArray_[index] = index;
+  return sqe;
+}
+
+namespace {
+void setPollEvents(struct io_uring_sqe* sqe, int events)
+{
+#if __BYTE_ORDER == __BIG_ENDIAN
+  // Kernel reads poll32_events with half words swapped on big endian
+  // hosts.
+  uint32_t e = events;
+  sqe->poll32_events = (e << 16) | (e >> 16);
+#else // __BYTE_ORDER != __BIG_ENDIAN
+  sqe->poll32_events = events;
+#endif // __BYTE_ORDER != __BIG_ENDIAN
+}
+} // namespace
+
+int IoUringEventPoll::submit(unsigned minComplete)
+{
+  __atomic_store_n(sqTail_, *sqTail_, __ATOMIC_RELEASE);
+  unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  int r;
+  while((r = ioUringEnter(ringfd_, toSubmit_, minComplete, flags)) == -1 &&
+        errno == EINTR);
+  if(r == -1) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("io_uring_enter error: %s",
+                    util::safeStrerror(errNum).c_str()));
+  } else if(static_cast<unsigned>(r) >= toSubmit_) {
+    toSubmit_ = 0;
+  } else {
+    toSubmit_ -= r;
+  }
+  return r;
+}
+
+bool IoUringEventPoll::cancelPoll
+(const SharedHandle<KSocketEntry>& socketEntry)
+{
+  if(socketEntry->getPollId() == 0) {
+    return true;
+  }
+  struct io_uring_sqe* sqe = getSqe();
+  if(!sqe) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = socketEntry->getPollId();
+  sqe->user_data = REMOVE_USER_DATA;
+  __atomic_store_n(sqTail_, *sqTail_+1, __ATOMIC_RELEASE);
+  ++toSubmit_;
+  socketEntry->setPoll(0, 0);
+  return true;
+}
+
+bool IoUringEventPoll::updatePoll
+(const SharedHandle<KSocketEntry>& socketEntry)
+{
+  int events = socketEntry->getEvents();
+  if(socketEntry->getPollId() != 0) {
+    if(socketEntry->getPollEvents() == events) {
+      return true;
+    }
+    if(!cancelPoll(socketEntry)) {
+      return false;
+    }
+  }
+  if(events == 0) {
+    return true;
+  }
+  struct io_uring_sqe* sqe = getSqe();
+  if(!sqe) {
+    return false;
+  }
+  if(++pollSeq_ == 0) {
+    ++pollSeq_;
+  }
+  uint64_t pollId = makePollId(pollSeq_, socketEntry->getSocket());
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = socketEntry->getSocket();
+  setPollEvents(sqe, events);
+  sqe->user_data = pollId;
+  __atomic_store_n(sqTail_, *sqTail_+1, __ATOMIC_RELEASE);
+  ++toSubmit_;
+  socketEntry->setPoll(pollId, events);
+  return true;
+}
+
+void IoUringEventPoll::rearmPendingEntries()
+{
+  std::vector<SharedHandle<KSocketEntry> > entries;
+  entries.swap(rearmEntries_);
+  for(std::vector<SharedHandle<KSocketEntry> >::const_iterator i =
+        entries.begin(), eoi = entries.end(); i != eoi; ++i) {
+    if(!updatePoll(*i)) {
+      rearmEntries_.push_back(*i);
+    }
+  }
+}
+
+size_t IoUringEventPoll::processCompletions()
+{
+  // Entries fired are re-armed after all completions are processed
+  // because poll requests are one-shot.
+  std::vector<SharedHandle<KSocketEntry> > fired;
+  unsigned head = *cqHead_;
+  unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  SharedHandle<KSocketEntry> se(new KSocketEntry(0));
+  for(; head != tail; ++head) {
+    const struct io_uring_cqe& cqe = cqes_[head&cqRingMask_];
+    if(cqe.user_data == TIMEOUT_USER_DATA ||
+       cqe.user_data == REMOVE_USER_DATA) {
+      continue;
+    }
+    se->setSocket(getPollSocket(cqe.user_data));
+    std::deque<SharedHandle<KSocketEntry> >::iterator itr =
+      std::lower_bound(socketEntries_.begin(), socketEntries_.end(), se,
+                       DerefLess<SharedHandle<KSocketEntry> >());
+    if(itr == socketEntries_.end() || !(*(*itr) == *se) ||
+       (*itr)->getPollId() != cqe.user_data) {
+      // Completion of canceled or stale request.
+      continue;
+    }
+    (*itr)->setPoll(0, 0);
+    if(cqe.res < 0) {
+      A2_LOG_DEBUG(fmt("Poll request for socket %d failed: %s",
+                       (*itr)->getSocket(),
+                       util::safeStrerror(-cqe.res).c_str()));
+      continue;
+    }
+    (*itr)->processEvents(cqe.res, getReadyCommands());
+    fired.push_back(*itr);
+  }
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+  for(std::vector<SharedHandle<KSocketEntry> >::const_iterator i =
+        fired.begin(), eoi = fired.end(); i != eoi; ++i) {
+    if(!updatePoll(*i)) {
+      rearmEntries_.push_back(*i);
+    }
+  }
+  return fired.size();
+}
+
+void IoUringEventPoll::poll(const struct timeval& tv)
+{
+  if(!rearmEntries_.empty()) {
+    rearmPendingEntries();
+  }
+  int64_t remaining = tv.tv_sec*1000000LL+tv.tv_usec;
+  const int64_t deadline = getMonotonicMicros()+remaining;
+  for(;;) {
+    struct io_uring_sqe* sqe = 0;
+    if(remaining > 0) {
+      sqe = getSqe();
+    }
+    if(!sqe) {
+      if(toSubmit_ > 0) {
+        submit(0);
+      }
+    } else {
+      // IORING_OP_TIMEOUT with off = 1 completes when another request
+      // completes or when timeout expires, whichever comes first.
+      timeout_.tv_sec = remaining/1000000;
+      timeout_.tv_nsec = (remaining%1000000)*1000;
+      sqe->opcode = IORING_OP_TIMEOUT;
+      sqe->fd = -1;
+      sqe->addr = reinterpret_cast<uint64_t>(&timeout_);
+      sqe->len = 1;
+      sqe->off = 1;
+      sqe->user_data = TIMEOUT_USER_DATA;
+      __atomic_store_n(sqTail_, *sqTail_+1, __ATOMIC_RELEASE);
+      ++toSubmit_;
+      submit(1);
+    }
+    if(processCompletions() > 0 || !sqe) {
+      break;
+    }
+    // The completion of IORING_OP_POLL_REMOVE or of a canceled poll
+    // request also ends the timeout. Keep waiting for the rest of it.
+    remaining = deadline-getMonotonicMicros();
+  }
+#ifdef ENABLE_ASYNC_DNS
+  // It turns out that we have to call ares_process_fd before ares's
+  // own timeout and ares may create new sockets or closes socket in
+  // their API. So we call ares_process_fd for all ares_channel and
+  // re-register their sockets.
+  for(std::deque<SharedHandle<KAsyncNameResolverEntry> >::iterator i =
+        nameResolverEntries_.begin(), eoi = nameResolverEntries_.end();
+      i != eoi; ++i) {
+    (*i)->processTimeout();
+    (*i)->removeSocketEvents(this);
+    (*i)->addSocketEvents(this);
+  }
+#endif // ENABLE_ASYNC_DNS
+}
+
+namespace {
+int translateEvents(EventPoll::EventType events)
+{
+  int newEvents = 0;
+  if(EventPoll::EVENT_READ&events) {
+    newEvents |= IoUringEventPoll::IEV_READ;
+  }
+  if(EventPoll::EVENT_WRITE&events) {
+    newEvents |= IoUringEventPoll::IEV_WRITE;
+  }
+  if(EventPoll::EVENT_ERROR&events) {
+    newEvents |= IoUringEventPoll::IEV_ERROR;
+  }
+  if(EventPoll::EVENT_HUP&events) {
+    newEvents |= IoUringEventPoll::IEV_HUP;
+  }
+  return newEvents;
+}
+} // namespace
+
+bool IoUringEventPoll::addEvents(sock_t socket,
+                                 const IoUringEventPoll::KEvent& event)
+{
+  SharedHandle<KSocketEntry> socketEntry(new KSocketEntry(socket));
+  std::deque<SharedHandle<KSocketEntry> >::iterator i =
+    std::lower_bound(socketEntries_.begin(), socketEntries_.end(), socketEntry,
+                     DerefLess<SharedHandle<KSocketEntry> >());
+  if(i == socketEntries_.end() || !(*(*i) == *socketEntry)) {
+    i = socketEntries_.insert(i, socketEntry);
+  }
+  event.addSelf(*i);
+  if(!updatePoll(*i)) {
+    A2_LOG_DEBUG(fmt("Failed to add socket event %d", socket));
+    event.removeSelf(*i);
+    if((*i)->eventEmpty()) {
+      socketEntries_.erase(i);
+    } else {
+      // The poll request for the other events may have been canceled.
+      rearmEntries_.push_back(*i);
+    }
+    return false;
+  }
+  return true;
+}
+
+bool IoUringEventPoll::addEvents(sock_t socket, Command* command,
+                                 EventPoll::EventType events)
+{
+  int pollEvents = translateEvents(events);
+  return addEvents(socket, KCommandEvent(command, pollEvents));
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::addEvents(sock_t socket, Command* command, int events,
+                                 const SharedHandle<AsyncNameResolver>& rs)
+{
+  return addEvents(socket, KADNSEvent(rs, command, socket, events));
+}
+#endif // ENABLE_ASYNC_DNS
+
+bool IoUringEventPoll::deleteEvents(sock_t socket,
+                                    const IoUringEventPoll::KEvent& event)
+{
+  SharedHandle<KSocketEntry> socketEntry(new KSocketEntry(socket));
+  std::deque<SharedHandle<KSocketEntry> >::iterator i =
+    std::lower_bound(socketEntries_.begin(), socketEntries_.end(), socketEntry,
+                     DerefLess<SharedHandle<KSocketEntry> >());
+  if(i != socketEntries_.end() && *(*i) == *socketEntry) {
+    event.removeSelf(*i);
+    bool r;
+    if((*i)->eventEmpty()) {
+      // If cancelPoll() fails, the poll request stays in the kernel,
+      // but its completion is ignored as stale.
+      r = cancelPoll(*i);
+      socketEntries_.erase(i);
+    } else {
+      r = updatePoll(*i);
+      if(!r) {
+        // Re-armed in poll() with the remaining events.
+        rearmEntries_.push_back(*i);
+      }
+    }
+    if(!r) {
+      A2_LOG_DEBUG(fmt("Failed to delete socket event %d", socket));
+    }
+    return r;
+  } else {
+    A2_LOG_DEBUG(fmt("Socket %d is not found in SocketEntries.", socket));
+    return false;
+  }
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::deleteEvents(sock_t socket, Command* command,
+                                    const SharedHandle<AsyncNameResolver>& rs)
+{
+  return deleteEvents(socket, KADNSEvent(rs, command, socket, 0));
+}
+#endif // ENABLE_ASYNC_DNS
+
+bool IoUringEventPoll::deleteEvents(sock_t socket, Command* command,
+                                    EventPoll::EventType events)
+{
+  int pollEvents = translateEvents(events);
+  return deleteEvents(socket, KCommandEvent(command, pollEvents));
+}
+
+#ifdef ENABLE_ASYNC_DNS
+bool IoUringEventPoll::addNameResolver
+(const SharedHandle<AsyncNameResolver>& resolver, Command* command)
+{
+  SharedHandle<KAsyncNameResolverEntry> entry
+    (new KAsyncNameResolverEntry(resolver, command));
+  std::deque<SharedHandle<KAsyncNameResolverEntry> >::iterator itr =
+    std::find_if(nameResolverEntries_.begin(), nameResolverEntries_.end(),
+                 derefEqual(entry));
+  if(itr == nameResolverEntries_.end()) {
+    nameResolverEntries_.push_back(entry);
+    entry->addSocketEvents(this);
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool IoUringEventPoll::deleteNameResolver
+(const SharedHandle<AsyncNameResolver>& resolver, Command* command)
+{
+  SharedHandle<KAsyncNameResolverEntry> entry
+    (new KAsyncNameResolverEntry(resolver, command));
+  std::deque<SharedHandle<KAsyncNameResolverEntry> >::iterator itr =
+    std::find_if(nameResolverEntries_.begin(), nameResolverEntries_.end(),
+                 derefEqual(entry));
+  if(itr == nameResolverEntries_.end()) {
+    return false;
+  } else {
+    (*itr)->removeSocketEvents(this);
+    nameResolverEntries_.erase(itr);
+    return true;
+  }
+}
+#endif // ENABLE_ASYNC_DNS
+
+} // namespace aria2
@@ -0,0 +1,205 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_IO_URING_EVENT_POLL_H
+#define D_IO_URING_EVENT_POLL_H
+
+#include "EventPoll.h"
+
+#include <poll.h>
+#include <linux/io_uring.h>
+
+#include <deque>
+#include <vector>
+
+#include "Event.h"
+#ifdef ENABLE_ASYNC_DNS
+# include "AsyncNameResolver.h"
+#endif // ENABLE_ASYNC_DNS
+
+namespace aria2 {
+
+// EventPoll implementation using Linux io_uring. Socket readiness is
+// watched by one-shot IORING_OP_POLL_ADD requests. Requests queued by
+// addEvents() and deleteEvents() are not submitted immediately: they
+// are submitted in a batch with a single io_uring_enter(2) call in
+// poll().
+class IoUringEventPoll : public EventPoll {
+private:
+  class KSocketEntry;
+
+  typedef Event<KSocketEntry> KEvent;
+  typedef CommandEvent<KSocketEntry, IoUringEventPoll> KCommandEvent;
+  typedef ADNSEvent<KSocketEntry, IoUringEventPoll> KADNSEvent;
+  typedef AsyncNameResolverEntry<IoUringEventPoll> KAsyncNameResolverEntry;
+  friend class AsyncNameResolverEntry<IoUringEventPoll>;
+
+  class KSocketEntry:
+    public SocketEntry<KCommandEvent, KADNSEvent> {
+  private:
+    // user_data of the poll request in flight for this socket. 0
+    // means no request is in flight.
+    uint64_t pollId_;
+    // Events watched by the poll request in flight.
+    int pollEvents_;
+  public:
+    KSocketEntry(sock_t socket);
+
+    int getEvents();
+
+    uint64_t getPollId() const
+    {
+      return pollId_;
+    }
+
+    int getPollEvents() const
+    {
+      return pollEvents_;
+    }
+
+    void setPoll(uint64_t pollId, int pollEvents)
+    {
+      pollId_ = pollId;
+      pollEvents_ = pollEvents;
+    }
+  };
+
+  friend int accumulateEvent(int events, const KEvent& event);
+
+private:
+  std::deque<SharedHandle<KSocketEntry> > socketEntries_;
+#ifdef ENABLE_ASYNC_DNS
+  std::deque<SharedHandle<KAsyncNameResolverEntry> > nameResolverEntries_;
+#endif // ENABLE_ASYNC_DNS
+
+  int ringfd_;
+
+  unsigned char* sqRing_;
+  size_t sqRingSize_;
+  unsigned char* cqRing_;
+  size_t cqRingSize_;
+  struct io_uring_sqe* sqes_;
+  size_t sqesSize_;
+
+  unsigned* sqHead_;
+  unsigned* sqTail_;
+  unsigned sqRingMask_;
+  unsigned sqRingEntries_;
+  unsigned* sqArray_;
+
+  unsigned* cqHead_;
+  unsigned* cqTail_;
+  unsigned cqRingMask_;
+  struct io_uring_cqe* cqes_;
+
+  // The number of SQEs queued but not submitted yet.
+  unsigned toSubmit_;
+
+  // Used to generate user_data of poll requests.
+  uint32_t pollSeq_;
+
+  // Entries fired but not re-armed because no SQE was available.
+  std::vector<SharedHandle<KSocketEntry> > rearmEntries_;
+
+  struct __kernel_timespec timeout_;
+
+  static const unsigned IO_URING_ENTRIES = 1024;
+
+  bool initRing();
+
+  void cleanupRing();
+
+  // Returns next SQE to fill. If submission queue is full, queued
+  // SQEs are submitted first. Returns 0 if the submission queue is
+  // still full after that.
+  struct io_uring_sqe* getSqe();
+
+  // Submits queued SQEs. If minComplete is greater than 0, waits for
+  // that number of completions.
+  int submit(unsigned minComplete);
+
+  // Submits poll request for socketEntry if its events are changed.
+  // Returns false if no SQE is available.
+  bool updatePoll(const SharedHandle<KSocketEntry>& socketEntry);
+
+  bool cancelPoll(const SharedHandle<KSocketEntry>& socketEntry);
+
+  // Calls updatePoll() for the entries in rearmEntries_ again.
+  void rearmPendingEntries();
+
+  // Processes the completion queue and returns the number of sockets
+  // which got ready events.
+  size_t processCompletions();
+
+  bool addEvents(sock_t socket, const KEvent& event);
+
+  bool deleteEvents(sock_t socket, const KEvent& event);
+
+  bool addEvents(sock_t socket, Command* command, int events,
+                 const SharedHandle<AsyncNameResolver>& rs);
+
+  bool deleteEvents(sock_t socket, Command* command,
+                    const SharedHandle<AsyncNameResolver>& rs);
+
+public:
+  IoUringEventPoll();
+
+  bool good() const;
+
+  virtual ~IoUringEventPoll();
+
+  virtual void poll(const struct timeval& tv);
+
+  virtual bool addEvents(sock_t socket,
+                         Command* command, EventPoll::EventType events);
+
+  virtual bool deleteEvents(sock_t socket,
+                            Command* command, EventPoll::EventType events);
+#ifdef ENABLE_ASYNC_DNS
+
+  virtual bool addNameResolver(const SharedHandle<AsyncNameResolver>& resolver,
+                               Command* command);
+  virtual bool deleteNameResolver
+  (const SharedHandle<AsyncNameResolver>& resolver, Command* command);
+#endif // ENABLE_ASYNC_DNS
+
+  static const int IEV_READ = POLLIN;
+  static const int IEV_WRITE = POLLOUT;
+  static const int IEV_ERROR = POLLERR;
+  static const int IEV_HUP = POLLHUP;
+};
+
+} // namespace aria2
+
+#endif // D_IO_URING_EVENT_POLL_H
@@ -36,6 +36,7 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
 
 #include "util.h"
 #include "message.h"
@@ -50,9 +51,19 @@
 #include "MessageDigest.h"
 #include "fmt.h"
 #include "DlAbortEx.h"
+#include "DownloadEngine.h"
+#include "ThreadPool.h"
+#include "PieceHashJob.h"
+#include "array_fun.h"
 
 namespace aria2 {
 
+namespace {
+// The amount of data read by a PieceHashJob, unless a piece is larger
+// than this.
+const size_t JOB_LENGTH = 4*1024*1024;
+} // namespace
+
 IteratableChunkChecksumValidator::IteratableChunkChecksumValidator
 (const SharedHandle<DownloadContext>& dctx,
  const PieceStorageHandle& pieceStorage)
@@ -60,48 +71,142 @@ IteratableChunkChecksumValidator::IteratableChunkChecksumValidator
     pieceStorage_(pieceStorage),
     bitfield_(new BitfieldMan(dctx_->getPieceLength(),
                               dctx_->getTotalLength())),
-    currentIndex_(0)
+    currentIndex_(0),
+    numValidated_(0),
+    e_(0),
+    command_(0)
 {}
 
-IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator() {}
+IteratableChunkChecksumValidator::~IteratableChunkChecksumValidator()
+{
+  disableAsyncValidation();
+}
 
 
 void IteratableChunkChecksumValidator::validateChunk()
 {
   if(!finished()) {
-    std::string actualChecksum;
-    try {
-      actualChecksum = calculateActualChecksum();
-      if(actualChecksum == dctx_->getPieceHashes()[currentIndex_]) {
-        bitfield_->setBit(currentIndex_);
-      } else {
-        A2_LOG_INFO
-          (fmt(EX_INVALID_CHUNK_CHECKSUM,
-               static_cast<unsigned long>(currentIndex_),
-               util::itos(getCurrentOffset(), true).c_str(),
-               util::toHex(dctx_->getPieceHashes()[currentIndex_]).c_str(),
-               util::toHex(actualChecksum).c_str()));
-        bitfield_->unsetBit(currentIndex_);
+    if(e_) {
+      validateChunkAsync();
+    } else {
+      skipUnchangedPieces();
+      if(currentIndex_ < dctx_->getNumPieces()) {
+        std::string actualChecksum;
+        try {
+          actualChecksum = calculateActualChecksum();
+          updateBitfield(currentIndex_, actualChecksum);
+        } catch(RecoverableException& ex) {
+          A2_LOG_DEBUG_EX(fmt("Caught exception while validating piece"
+                              " index=%lu. Some part of file may be missing."
+                              " Continue operation.",
+                              static_cast<unsigned long>(currentIndex_)),
+                          ex);
+          bitfield_->unsetBit(currentIndex_);
+        }
+        ++currentIndex_;
+        ++numValidated_;
       }
-    } catch(RecoverableException& ex) {
-      A2_LOG_DEBUG_EX(fmt("Caught exception while validating piece index=%lu."
-                          " Some part of file may be missing."
-                          " Continue operation.",
-                          static_cast<unsigned long>(currentIndex_)),
-                      ex);
-      bitfield_->unsetBit(currentIndex_);
     }
-
-    ++currentIndex_;
     if(finished()) {
       pieceStorage_->setBitfield(bitfield_->getBitfield(), bitfield_->getBitfieldLength());
     }
   }
 }
 
+void IteratableChunkChecksumValidator::updateBitfield
+(size_t index, const std::string& actualChecksum)
+{
+  if(actualChecksum == dctx_->getPieceHashes()[index]) {
+    bitfield_->setBit(index);
+  } else {
+    A2_LOG_INFO
+      (fmt(EX_INVALID_CHUNK_CHECKSUM,
+           static_cast<unsigned long>(index),
+           util::itos((off_t)index*dctx_->getPieceLength(), true).c_str(),
+           util::toHex(dctx_->getPieceHashes()[index]).c_str(),
+           util::toHex(actualChecksum).c_str()));
+    bitfield_->unsetBit(index);
+  }
+}
+
+void IteratableChunkChecksumValidator::validateChunkAsync()
+{
+  for(std::deque<SharedHandle<PieceHashJob> >::iterator i = jobs_.begin();
+      i != jobs_.end();) {
+    if(!(*i)->isDone()) {
+      ++i;
+      continue;
+    }
+    const SharedHandle<PieceHashJob>& job = *i;
+    for(size_t index = job->getIndex(),
+          last = job->getIndex()+job->getNumPieces(); index < last; ++index) {
+      if(job->getDigest(index).empty()) {
+        A2_LOG_DEBUG(fmt("Caught exception while validating piece index=%lu."
+                         " Some part of file may be missing."
+                         " Continue operation. cause: %s",
+                         static_cast<unsigned long>(index),
+                         job->getError(index).c_str()));
+        bitfield_->unsetBit(index);
+      } else {
+        updateBitfield(index, job->getDigest(index));
+      }
+      ++numValidated_;
+    }
+    i = jobs_.erase(i);
+  }
+  submitJobs();
+}
+
+void IteratableChunkChecksumValidator::submitJobs()
+{
+  // Keep a few more jobs than worker threads so that threads don't
+  // idle while the results are processed.
+  size_t maxJobs = e_->getThreadPool()->getNumThreads()*2;
+  size_t piecesPerJob =
+    std::max(static_cast<size_t>(1), JOB_LENGTH/dctx_->getPieceLength());
+  size_t numPieces = dctx_->getNumPieces();
+  while(jobs_.size() < maxJobs) {
+    skipUnchangedPieces();
+    if(currentIndex_ >= numPieces) {
+      break;
+    }
+    size_t n = 1;
+    while(n < piecesPerJob && currentIndex_+n < numPieces &&
+          !isUnchangedPiece(currentIndex_+n)) {
+      ++n;
+    }
+    SharedHandle<PieceHashJob> job
+      (new PieceHashJob(dctx_, dctx_->getFileEntries(), currentIndex_, n));
+    e_->submitJob(job, command_);
+    jobs_.push_back(job);
+    currentIndex_ += n;
+  }
+}
+
+void IteratableChunkChecksumValidator::enableAsyncValidation
+(DownloadEngine* e, Command* command)
+{
+  e_ = e;
+  command_ = command;
+}
+
+void IteratableChunkChecksumValidator::disableAsyncValidation()
+{
+  for(std::deque<SharedHandle<PieceHashJob> >::const_iterator i =
+        jobs_.begin(), eoi = jobs_.end(); i != eoi; ++i) {
+    (*i)->setCommand(0);
+  }
+  command_ = 0;
+}
+
+bool IteratableChunkChecksumValidator::isWaitingJob() const
+{
+  return e_ && !jobs_.empty();
+}
+
 std::string IteratableChunkChecksumValidator::calculateActualChecksum()
 {
-  off_t offset = getCurrentOffset();
+  off_t offset = (off_t)currentIndex_*dctx_->getPieceLength();
   size_t length;
   // When validating last piece
   if(currentIndex_+1 == dctx_->getNumPieces()) {
@@ -117,16 +222,78 @@ void IteratableChunkChecksumValidator::init()
   ctx_ = MessageDigest::create(dctx_->getPieceHashType());
   bitfield_->clearAllBit();
   currentIndex_ = 0;
+  numValidated_ = 0;
+  initUnchangedPieces();
+}
+
+void IteratableChunkChecksumValidator::initUnchangedPieces()
+{
+  unchangedPieces_.clear();
+  const std::vector<SharedHandle<FileEntry> >& fileEntries =
+    dctx_->getFileEntries();
+  bool found = false;
+  for(std::vector<SharedHandle<FileEntry> >::const_iterator i =
+        fileEntries.begin(), eoi = fileEntries.end(); i != eoi; ++i) {
+    if((*i)->isUnchanged()) {
+      found = true;
+      break;
+    }
+  }
+  if(!found) {
+    return;
+  }
+  size_t numPieces = dctx_->getNumPieces();
+  size_t pieceLength = dctx_->getPieceLength();
+  unchangedPieces_.assign(numPieces, true);
+  for(std::vector<SharedHandle<FileEntry> >::const_iterator i =
+        fileEntries.begin(), eoi = fileEntries.end(); i != eoi; ++i) {
+    if(!(*i)->isUnchanged() && (*i)->getLength() > 0) {
+      size_t first = (*i)->getOffset()/pieceLength;
+      size_t last = ((*i)->getLastOffset()-1)/pieceLength;
+      std::fill(unchangedPieces_.begin()+first,
+                unchangedPieces_.begin()+last+1, false);
+    }
+    // The state only applies to the first check after loading the
+    // control file.
+    (*i)->setUnchanged(false);
+  }
+  // Take the state of unchanged pieces from the control file loaded
+  // into PieceStorage.
+  std::vector<unsigned char> bits
+    (pieceStorage_->getBitfield(),
+     pieceStorage_->getBitfield()+pieceStorage_->getBitfieldLength());
+  size_t numUnchanged = 0;
+  for(size_t index = 0; index < numPieces; ++index) {
+    if(unchangedPieces_[index]) {
+      ++numUnchanged;
+    } else {
+      bits[index/8] &= ~(128 >> (index%8));
+    }
+  }
+  bitfield_->setBitfield(&bits[0], bits.size());
+  A2_LOG_INFO(fmt("Skipping hash check of %lu unchanged pieces out of %lu.",
+                  static_cast<unsigned long>(numUnchanged),
+                  static_cast<unsigned long>(numPieces)));
+}
+
+void IteratableChunkChecksumValidator::skipUnchangedPieces()
+{
+  size_t numPieces = dctx_->getNumPieces();
+  while(currentIndex_ < numPieces && isUnchangedPiece(currentIndex_)) {
+    ++currentIndex_;
+    ++numValidated_;
+  }
 }
 
 std::string IteratableChunkChecksumValidator::digest(off_t offset, size_t length)
 {
-  unsigned char buf[4096];
+  array_ptr<unsigned char> buf(new unsigned char[PieceHashJob::BUFSIZE]);
   ctx_->reset();
   off_t max = offset+length;
   while(offset < max) {
     size_t r = pieceStorage_->getDiskAdaptor()->readData
-      (buf, std::min(static_cast<off_t>(sizeof(buf)), max-offset), offset);
+      (buf, std::min(static_cast<off_t>(PieceHashJob::BUFSIZE), max-offset),
+       offset);
     if(r == 0) {
       throw DL_ABORT_EX
         (fmt(EX_FILE_READ, dctx_->getBasePath().c_str(),
@@ -140,7 +307,7 @@ std::string IteratableChunkChecksumValidator::digest(off_t offset, size_t length
 
 bool IteratableChunkChecksumValidator::finished() const
 {
-  if(currentIndex_ >= dctx_->getNumPieces()) {
+  if(currentIndex_ >= dctx_->getNumPieces() && jobs_.empty()) {
     return true;
   } else {
     return false;
@@ -149,7 +316,7 @@ bool IteratableChunkChecksumValidator::finished() const
 
 off_t IteratableChunkChecksumValidator::getCurrentOffset() const
 {
-  return (off_t)currentIndex_*dctx_->getPieceLength();
+  return (off_t)numValidated_*dctx_->getPieceLength();
 }
 
 uint64_t IteratableChunkChecksumValidator::getTotalLength() const
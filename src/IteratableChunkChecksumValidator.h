@@ -38,6 +38,8 @@
 #include "IteratableValidator.h"
 
 #include <string>
+#include <deque>
+#include <vector>
 
 namespace aria2 {
 
@@ -45,6 +47,7 @@ class DownloadContext;
 class PieceStorage;
 class BitfieldMan;
 class MessageDigest;
+class PieceHashJob;
 
 class IteratableChunkChecksumValidator:public IteratableValidator
 {
@@ -52,13 +55,41 @@ private:
   SharedHandle<DownloadContext> dctx_;
   SharedHandle<PieceStorage> pieceStorage_;
   SharedHandle<BitfieldMan> bitfield_;
+  // The index of the piece validated or, if asynchronous validation
+  // is enabled, submitted next.
   size_t currentIndex_;
+  // The number of pieces whose validation has finished.
+  size_t numValidated_;
   SharedHandle<MessageDigest> ctx_;
 
+  DownloadEngine* e_;
+  Command* command_;
+  std::deque<SharedHandle<PieceHashJob> > jobs_;
+  // If not empty, true for the pieces which lie only in files
+  // unchanged since the control file was saved. Their state is taken
+  // from PieceStorage without hashing them.
+  std::vector<bool> unchangedPieces_;
+
   std::string calculateActualChecksum();
 
   std::string digest(off_t offset, size_t length);
 
+  void updateBitfield(size_t index, const std::string& actualChecksum);
+
+  void validateChunkAsync();
+
+  void submitJobs();
+
+  void initUnchangedPieces();
+
+  bool isUnchangedPiece(size_t index) const
+  {
+    return !unchangedPieces_.empty() && unchangedPieces_[index];
+  }
+
+  // Advances currentIndex_ past the unchanged pieces.
+  void skipUnchangedPieces();
+
 public:
   IteratableChunkChecksumValidator(const SharedHandle<DownloadContext>& dctx,
                                    const SharedHandle<PieceStorage>& pieceStorage);
@@ -74,6 +105,12 @@ public:
   virtual off_t getCurrentOffset() const;
 
   virtual uint64_t getTotalLength() const;
+
+  virtual void enableAsyncValidation(DownloadEngine* e, Command* command);
+
+  virtual void disableAsyncValidation();
+
+  virtual bool isWaitingJob() const;
 };
 
 typedef SharedHandle<IteratableChunkChecksumValidator> IteratableChunkChecksumValidatorHandle;
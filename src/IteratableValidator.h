@@ -41,6 +41,9 @@
 
 namespace aria2 {
 
+class DownloadEngine;
+class Command;
+
 /**
  * This class provides the interface to validate files.
  *
@@ -63,6 +66,19 @@ public:
   virtual off_t getCurrentOffset() const = 0;
 
   virtual uint64_t getTotalLength() const = 0;
+
+  // Lets validateChunk() process the data in the worker threads of e.
+  // command is woken up whenever a job is done.  Validators which
+  // don't support it ignore this call.
+  virtual void enableAsyncValidation(DownloadEngine* e, Command* command) {}
+
+  // Detaches the running jobs from the command given to
+  // enableAsyncValidation().
+  virtual void disableAsyncValidation() {}
+
+  // Returns true if validateChunk() cannot proceed until one of the
+  // running jobs is done.
+  virtual bool isWaitingJob() const { return false; }
 };
 
 typedef SharedHandle<IteratableValidator> IteratableValidatorHandle;
@@ -2,7 +2,7 @@
 /*
  * aria2 - The high speed download utility
  *
- * Copyright (C) 2006 Tatsuhiro Tsujikawa
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -32,39 +32,33 @@
  * files in the program, then also delete it here.
  */
 /* copyright --> */
-#include "HaveEraseCommand.h"
+#include "JobDispatchCommand.h"
 #include "DownloadEngine.h"
 #include "RequestGroupMan.h"
-#include "PieceStorage.h"
-#include "RequestGroup.h"
 
 namespace aria2 {
 
-HaveEraseCommand::HaveEraseCommand(cuid_t cuid, DownloadEngine* e, time_t interval)
-  :TimeBasedCommand(cuid, e, interval, true) {}
-
-HaveEraseCommand::~HaveEraseCommand() {}
+JobDispatchCommand::JobDispatchCommand(cuid_t cuid, DownloadEngine* e)
+  : Command(cuid),
+    e_(e)
+{
+  e_->addThreadPoolCheck(this);
+}
 
-void HaveEraseCommand::preProcess()
+JobDispatchCommand::~JobDispatchCommand()
 {
-  if(getDownloadEngine()->getRequestGroupMan()->downloadFinished() ||
-     getDownloadEngine()->isHaltRequested()) {
-    enableExit();
-  }
+  e_->deleteThreadPoolCheck(this);
 }
 
-void HaveEraseCommand::process()
+bool JobDispatchCommand::execute()
 {
-  size_t numLoop =
-    getDownloadEngine()->getRequestGroupMan()->countRequestGroup();
-  for(size_t i = 0; i < numLoop; ++i) {
-    PieceStorageHandle ps =
-      getDownloadEngine()->getRequestGroupMan()->getRequestGroup(i)->
-      getPieceStorage();
-    if(ps) {
-      ps->removeAdvertisedPiece(5);
-    }
+  e_->dispatchDoneJobs();
+  if((e_->isHaltRequested() || e_->getRequestGroupMan()->downloadFinished()) &&
+     !e_->hasRunningJobs()) {
+    return true;
   }
+  e_->addCommand(this);
+  return false;
 }
 
 } // namespace aria2
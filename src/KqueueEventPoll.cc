@@ -131,7 +131,7 @@ void KqueueEventPoll::poll(const struct timeval& tv)
       } else if(filter == EVFILT_WRITE) {
         events = KqueueEventPoll::IEV_WRITE;
       }
-      p->processEvents(events);
+      p->processEvents(events, getReadyCommands());
     }
   } else if(res == -1) {
     int errNum = errno;
@@ -34,6 +34,7 @@
 /* copyright --> */
 #include "MessageDigest.h"
 #include "MessageDigestImpl.h"
+#include "SimdMessageDigestImpl.h"
 #include "util.h"
 #include "array_fun.h"
 
@@ -68,14 +69,20 @@ MessageDigest::~MessageDigest()
 SharedHandle<MessageDigest> MessageDigest::sha1()
 {
   SharedHandle<MessageDigest> md(new MessageDigest());
-  md->pImpl_ = MessageDigestImpl::sha1();
+  md->simdImpl_ = SimdMessageDigestImpl::create("sha-1");
+  if(!md->simdImpl_) {
+    md->pImpl_ = MessageDigestImpl::sha1();
+  }
   return md;
 }
 
 SharedHandle<MessageDigest> MessageDigest::create(const std::string& hashType)
 {
   SharedHandle<MessageDigest> md(new MessageDigest());
-  md->pImpl_ = MessageDigestImpl::create(hashType);
+  md->simdImpl_ = SimdMessageDigestImpl::create(hashType);
+  if(!md->simdImpl_) {
+    md->pImpl_ = MessageDigestImpl::create(hashType);
+  }
   return md;
 }
 
@@ -154,29 +161,44 @@ std::string MessageDigest::getCanonicalHashType(const std::string& hashType)
 
 size_t MessageDigest::getDigestLength() const
 {
+  if(simdImpl_) {
+    return simdImpl_->getDigestLength();
+  }
   return pImpl_->getDigestLength();
 }
 
 void MessageDigest::reset()
 {
-  pImpl_->reset();
+  if(simdImpl_) {
+    simdImpl_->reset();
+  } else {
+    pImpl_->reset();
+  }
 }
 
 void MessageDigest::update(const void* data, size_t length)
 {
-  pImpl_->update(data, length);
+  if(simdImpl_) {
+    simdImpl_->update(data, length);
+  } else {
+    pImpl_->update(data, length);
+  }
 }
 
 void MessageDigest::digest(unsigned char* md)
 {
-  pImpl_->digest(md);
+  if(simdImpl_) {
+    simdImpl_->digest(md);
+  } else {
+    pImpl_->digest(md);
+  }
 }
 
 std::string MessageDigest::digest()
 {
-  size_t length = pImpl_->getDigestLength();
+  size_t length = getDigestLength();
   array_ptr<unsigned char> buf(new unsigned char[length]);
-  pImpl_->digest(buf);
+  digest(buf);
   std::string hd(&buf[0], &buf[length]);
   return hd;
 }
@@ -44,11 +44,16 @@
 namespace aria2 {
 
 class MessageDigestImpl;
+class SimdMessageDigestImpl;
 
 class MessageDigest {
 private:
   SharedHandle<MessageDigestImpl> pImpl_;
 
+  // Used instead of pImpl_ if the built-in implementation for the
+  // hash type is available on this CPU.
+  SharedHandle<SimdMessageDigestImpl> simdImpl_;
+
   MessageDigest();
 
   // We don't implement copy ctor.
@@ -0,0 +1,249 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "MmapDiskWriter.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#ifdef __linux__
+# include <sys/vfs.h>
+#endif // __linux__
+
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+
+#include "a2io.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "fmt.h"
+#include "util.h"
+
+namespace aria2 {
+
+namespace {
+// The mapping is extended only when the file has grown by at least
+// this many bytes since it was mapped. Accesses to the smaller tail
+// use read/write system calls.
+const uint64_t MIN_REMAP_GROWTH = 16*1024*1024;
+} // namespace
+
+MmapDiskWriter::MmapDiskWriter(const std::string& filename)
+  : DefaultDiskWriter(filename),
+    mapaddr_(0),
+    maplen_(0),
+    filesize_(0),
+    filesizeKnown_(false),
+    enableMmap_(true)
+{}
+
+MmapDiskWriter::~MmapDiskWriter()
+{
+  unmap();
+}
+
+void MmapDiskWriter::unmap()
+{
+  if(mapaddr_) {
+    munmap(mapaddr_, maplen_);
+    mapaddr_ = 0;
+    maplen_ = 0;
+  }
+}
+
+uint64_t MmapDiskWriter::getFileSize()
+{
+  if(!filesizeKnown_) {
+    filesize_ = size();
+    filesizeKnown_ = true;
+  }
+  return filesize_;
+}
+
+namespace {
+#ifdef __linux__
+// Magic numbers of copy-on-write file systems, which allocate new
+// blocks on each write even to a preallocated file.
+const long BTRFS_MAGIC = 0x9123683eL;
+const long ZFS_MAGIC = 0x2fc12fc1L;
+#endif // __linux__
+} // namespace
+
+bool MmapDiskWriter::isWritableWithoutAllocation()
+{
+  a2_struct_stat st;
+  if(a2fstat(getFd(), &st) != 0 ||
+     static_cast<uint64_t>(st.st_blocks)*512 <
+     static_cast<uint64_t>(st.st_size)) {
+    return false;
+  }
+#ifdef __linux__
+  struct statfs fs;
+  if(fstatfs(getFd(), &fs) != 0 ||
+     static_cast<long>(fs.f_type) == BTRFS_MAGIC ||
+     static_cast<long>(fs.f_type) == ZFS_MAGIC) {
+    return false;
+  }
+#endif // __linux__
+  return true;
+}
+
+bool MmapDiskWriter::ensureMmap(uint64_t end)
+{
+  if(mapaddr_ && end <= maplen_) {
+    return true;
+  }
+  if(!enableMmap_ || getFd() == -1) {
+    return false;
+  }
+  uint64_t filesize = getFileSize();
+  if(filesize == 0 || end > filesize) {
+    return false;
+  }
+  if(mapaddr_ && filesize-maplen_ < MIN_REMAP_GROWTH) {
+    return false;
+  }
+  if(filesize > std::numeric_limits<size_t>::max()) {
+    unmap();
+    enableMmap_ = false;
+    return false;
+  }
+  unmap();
+  // A store into a hole of the mapping raises SIGBUS instead of
+  // returning an error when the disk is full. Only map the file for
+  // writing if every block of it is already allocated.
+  if(!isReadOnly() && !isWritableWithoutAllocation()) {
+    A2_LOG_INFO(fmt("%s is not fully allocated or is on a copy-on-write"
+                    " file system, using read/write instead of mmap",
+                    getFilename().c_str()));
+    enableMmap_ = false;
+    return false;
+  }
+  int prot = isReadOnly() ? PROT_READ : PROT_READ|PROT_WRITE;
+  void* p = mmap(0, filesize, prot, MAP_SHARED, getFd(), 0);
+  if(p == MAP_FAILED) {
+    int errNum = errno;
+    A2_LOG_INFO(fmt("mmap failed for %s, using read/write instead: %s",
+                    getFilename().c_str(),
+                    util::safeStrerror(errNum).c_str()));
+    enableMmap_ = false;
+    return false;
+  }
+  mapaddr_ = reinterpret_cast<unsigned char*>(p);
+  maplen_ = filesize;
+  return true;
+}
+
+void MmapDiskWriter::closeFile()
+{
+  unmap();
+  filesizeKnown_ = false;
+  enableMmap_ = true;
+  DefaultDiskWriter::closeFile();
+}
+
+void MmapDiskWriter::updateFileSize(uint64_t end)
+{
+  if(filesizeKnown_ && end > filesize_) {
+    filesize_ = end;
+  }
+}
+
+void MmapDiskWriter::writeData
+(const unsigned char* data, size_t len, off_t offset)
+{
+  if(ensureMmap(offset+len)) {
+    memcpy(mapaddr_+offset, data, len);
+  } else {
+    DefaultDiskWriter::writeData(data, len, offset);
+    updateFileSize(offset+len);
+  }
+}
+
+void MmapDiskWriter::writeDataVector
+(const std::vector<DataBuffer>& bufs, off_t offset)
+{
+  uint64_t len = 0;
+  for(std::vector<DataBuffer>::const_iterator i = bufs.begin(),
+        eoi = bufs.end(); i != eoi; ++i) {
+    len += (*i).length;
+  }
+  if(ensureMmap(offset+len)) {
+    unsigned char* p = mapaddr_+offset;
+    for(std::vector<DataBuffer>::const_iterator i = bufs.begin(),
+          eoi = bufs.end(); i != eoi; ++i) {
+      memcpy(p, (*i).data, (*i).length);
+      p += (*i).length;
+    }
+  } else {
+    DefaultDiskWriter::writeDataVector(bufs, offset);
+    updateFileSize(offset+len);
+  }
+}
+
+ssize_t MmapDiskWriter::readData
+(unsigned char* data, size_t len, off_t offset)
+{
+  // Read stops at the end of the file, so only the region inside the
+  // file has to be mapped.
+  uint64_t filesize = getFd() == -1 ? 0 : getFileSize();
+  if(static_cast<uint64_t>(offset) < filesize &&
+     ensureMmap(std::min(static_cast<uint64_t>(offset+len), filesize))) {
+    len = std::min(static_cast<uint64_t>(len), maplen_-offset);
+    memcpy(data, mapaddr_+offset, len);
+    return len;
+  } else {
+    return DefaultDiskWriter::readData(data, len, offset);
+  }
+}
+
+void MmapDiskWriter::truncate(uint64_t length)
+{
+  unmap();
+  filesizeKnown_ = false;
+  DefaultDiskWriter::truncate(length);
+}
+
+void MmapDiskWriter::allocate(off_t offset, uint64_t length)
+{
+  unmap();
+  filesizeKnown_ = false;
+  // The file may have no hole after this.
+  enableMmap_ = true;
+  DefaultDiskWriter::allocate(offset, length);
+}
+
+} // namespace aria2
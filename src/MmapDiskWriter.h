@@ -0,0 +1,105 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_MMAP_DISK_WRITER_H
+#define D_MMAP_DISK_WRITER_H
+
+#include "DefaultDiskWriter.h"
+
+namespace aria2 {
+
+// DiskWriter which accesses file through memory mapping.  The whole
+// file is mapped when data inside the current file size is accessed
+// for the first time.  Writes beyond the end of the file are done by
+// pwrite().  When the file has grown enough, the next access inside
+// the file maps it again with the new size.  A store into a hole of a
+// sparse file raises SIGBUS if the disk is full, so the file is only
+// mapped for writing if all of its blocks are allocated and it is not
+// on a copy-on-write file system.  Otherwise read/write system calls
+// are used.
+class MmapDiskWriter:public DefaultDiskWriter {
+private:
+  unsigned char* mapaddr_;
+  uint64_t maplen_;
+  // The file size cached to avoid fstat() on each access. It is
+  // valid only if filesizeKnown_ is true.
+  uint64_t filesize_;
+  bool filesizeKnown_;
+  // false if mapping failed or was given up.
+  bool enableMmap_;
+
+  // Maps the whole file if the region ending at end is inside the
+  // file.  Returns true if the region is mapped.
+  bool ensureMmap(uint64_t end);
+
+  uint64_t getFileSize();
+
+  // Returns true if a store into the mapped file never needs to
+  // allocate a disk block.
+  bool isWritableWithoutAllocation();
+
+  // Updates the cached file size after the file is written up to
+  // end by pwrite().
+  void updateFileSize(uint64_t end);
+
+  void unmap();
+public:
+  MmapDiskWriter(const std::string& filename);
+
+  virtual ~MmapDiskWriter();
+
+  virtual void closeFile();
+
+  virtual void writeData(const unsigned char* data, size_t len, off_t offset);
+
+  virtual void writeDataVector(const std::vector<DataBuffer>& bufs,
+                               off_t offset);
+
+  virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
+
+  virtual void truncate(uint64_t length);
+
+  virtual void allocate(off_t offset, uint64_t length);
+
+  // The mapping is created and removed on demand, which is not
+  // synchronized.
+  virtual bool isThreadSafe() const
+  {
+    return false;
+  }
+};
+
+} // namespace aria2
+
+#endif // D_MMAP_DISK_WRITER_H
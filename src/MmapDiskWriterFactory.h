@@ -2,7 +2,7 @@
 /*
  * aria2 - The high speed download utility
  *
- * Copyright (C) 2006 Tatsuhiro Tsujikawa
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
  *
  * This program is free software; you can redistribute it and/or modify
  * it under the terms of the GNU General Public License as published by
@@ -32,25 +32,21 @@
  * files in the program, then also delete it here.
  */
 /* copyright --> */
-#ifndef D_HAVE_ERASE_COMMAND_H
-#define D_HAVE_ERASE_COMMAND_H
+#ifndef D_MMAP_DISK_WRITER_FACTORY_H
+#define D_MMAP_DISK_WRITER_FACTORY_H
 
-#include "TimeBasedCommand.h"
+#include "DiskWriterFactory.h"
 
 namespace aria2 {
 
-class HaveEraseCommand : public TimeBasedCommand
+class DiskWriter;
+
+class MmapDiskWriterFactory:public DiskWriterFactory
 {
 public:
-  HaveEraseCommand(cuid_t cuid, DownloadEngine* e, time_t interval);
-
-  virtual ~HaveEraseCommand();
-
-  virtual void preProcess();
-
-  virtual void process();
+  virtual SharedHandle<DiskWriter> newDiskWriter(const std::string& filename);
 };
 
 } // namespace aria2
 
-#endif // D_HAVE_ERASE_COMMAND_H
+#endif // D_MMAP_DISK_WRITER_FACTORY_H
@@ -49,7 +49,7 @@
 #include "fmt.h"
 #include "Logger.h"
 #include "LogFactory.h"
-#include "SimpleRandomizer.h"
+#include "OpenedFileCache.h"
 
 namespace aria2 {
 
@@ -118,11 +118,15 @@ bool DiskWriterEntry::operator<(const DiskWriterEntry& entry) const
 
 MultiDiskAdaptor::MultiDiskAdaptor()
   : pieceLength_(0),
-    maxOpenFiles_(DEFAULT_MAX_OPEN_FILES),
+    openedFileCache_(new OpenedFileCache
+                     (OpenedFileCache::DEFAULT_MAX_OPEN_FILES)),
     readOnly_(false)
 {}
 
-MultiDiskAdaptor::~MultiDiskAdaptor() {}
+MultiDiskAdaptor::~MultiDiskAdaptor()
+{
+  closeDiskWriterEntries();
+}
 
 namespace {
 SharedHandle<DiskWriterEntry> createDiskWriterEntry
@@ -137,6 +141,7 @@ SharedHandle<DiskWriterEntry> createDiskWriterEntry
 
 void MultiDiskAdaptor::resetDiskWriterEntries()
 {
+  closeDiskWriterEntries();
   diskWriterEntries_.clear();
 
   if(getFileEntries().empty()) {
@@ -238,28 +243,15 @@ void MultiDiskAdaptor::resetDiskWriterEntries()
 void MultiDiskAdaptor::openIfNot
 (const SharedHandle<DiskWriterEntry>& entry, void (DiskWriterEntry::*open)())
 {
-  if(!entry->isOpen()) {
-    //     A2_LOG_DEBUG(fmt("DiskWriterEntry: Cache MISS. offset=%s",
-    //            util::itos(entry->getFileEntry()->getOffset()).c_str()));
- 
-    size_t numOpened = openedDiskWriterEntries_.size();
-    (entry.get()->*open)();
-    if(numOpened >= maxOpenFiles_) {
-      // Cache is full. 
-      // Choose one DiskWriterEntry randomly and close it.
-      size_t index =
-        SimpleRandomizer::getInstance()->getRandomNumber(numOpened);
-      std::vector<SharedHandle<DiskWriterEntry> >::iterator i =
-        openedDiskWriterEntries_.begin();
-      std::advance(i, index);
-      (*i)->closeFile();
-      (*i) = entry;
-    } else {
-      openedDiskWriterEntries_.push_back(entry);
-    } 
+  if(entry->isOpen() && openedFileCache_->contains(entry.get())) {
+    openedFileCache_->hit(entry.get());
   } else {
-    //     A2_LOG_DEBUG(fmt("DiskWriterEntry: Cache HIT. offset=%s",
-    //            util::itos(entry->getFileEntry()->getOffset()).c_str()));
+    if(!entry->isOpen()) {
+      (entry.get()->*open)();
+    }
+    if(entry->isOpen()) {
+      openedFileCache_->add(entry.get());
+    }
   }
 }
 
@@ -298,8 +290,16 @@ void MultiDiskAdaptor::openExistingFile()
 
 void MultiDiskAdaptor::closeFile()
 {
-  std::for_each(diskWriterEntries_.begin(), diskWriterEntries_.end(),
-                mem_fun_sh(&DiskWriterEntry::closeFile));
+  closeDiskWriterEntries();
+}
+
+void MultiDiskAdaptor::closeDiskWriterEntries()
+{
+  for(DiskWriterEntries::const_iterator i = diskWriterEntries_.begin(),
+        eoi = diskWriterEntries_.end(); i != eoi; ++i) {
+    openedFileCache_->remove((*i).get());
+    (*i)->closeFile();
+  }
 }
 
 namespace {
@@ -423,6 +423,22 @@ ssize_t MultiDiskAdaptor::readData
   return totalReadLength;
 }
 
+int MultiDiskAdaptor::getFd
+(off_t offset, size_t len, off_t& fileOffset, size_t& fileLength)
+{
+  DiskWriterEntries::const_iterator i =
+    findFirstDiskWriterEntry(diskWriterEntries_, offset);
+  fileOffset = offset-(*i)->getFileEntry()->getOffset();
+  fileLength = calculateLength(*i, fileOffset, len);
+
+  openIfNot(*i, &DiskWriterEntry::openFile);
+
+  if(!(*i)->isOpen()) {
+    throwOnDiskWriterNotOpened(*i, offset);
+  }
+  return (*i)->getDiskWriter()->getFd();
+}
+
 bool MultiDiskAdaptor::fileExists()
 {
   return std::find_if(getFileEntries().begin(), getFileEntries().end(),
@@ -472,7 +488,15 @@ void MultiDiskAdaptor::cutTrailingGarbage()
 
 void MultiDiskAdaptor::setMaxOpenFiles(size_t maxOpenFiles)
 {
-  maxOpenFiles_ = maxOpenFiles;
+  closeDiskWriterEntries();
+  openedFileCache_.reset(new OpenedFileCache(maxOpenFiles));
+}
+
+void MultiDiskAdaptor::setOpenedFileCache
+(const SharedHandle<OpenedFileCache>& openedFileCache)
+{
+  closeDiskWriterEntries();
+  openedFileCache_ = openedFileCache;
 }
 
 size_t MultiDiskAdaptor::utime(const Time& actime, const Time& modtime)
@@ -42,6 +42,7 @@ namespace aria2 {
 class MultiFileAllocationIterator;
 class FileEntry;
 class DiskWriter;
+class OpenedFileCache;
 
 class DiskWriterEntry {
 private:
@@ -107,18 +108,17 @@ private:
   size_t pieceLength_;
   DiskWriterEntries diskWriterEntries_;
 
-  std::vector<SharedHandle<DiskWriterEntry> > openedDiskWriterEntries_;
-
-  size_t maxOpenFiles_;
+  SharedHandle<OpenedFileCache> openedFileCache_;
 
   bool readOnly_;
 
   void resetDiskWriterEntries();
 
+  // Closes all files and removes them from openedFileCache_.
+  void closeDiskWriterEntries();
+
   void openIfNot(const SharedHandle<DiskWriterEntry>& entry,
                  void (DiskWriterEntry::*f)());
- 
-  static const size_t DEFAULT_MAX_OPEN_FILES = 100;
 
 public:
   MultiDiskAdaptor();
@@ -137,6 +137,9 @@ public:
 
   virtual ssize_t readData(unsigned char* data, size_t len, off_t offset);
 
+  virtual int getFd(off_t offset, size_t len,
+                    off_t& fileOffset, size_t& fileLength);
+
   virtual bool fileExists();
 
   virtual uint64_t size();
@@ -160,8 +163,22 @@ public:
 
   virtual void cutTrailingGarbage();
 
+  // Uses the private cache of opened files whose limit is
+  // maxOpenFiles.  This function must be called before any file is
+  // opened.
   void setMaxOpenFiles(size_t maxOpenFiles);
 
+  // Uses openedFileCache, which may be shared by other
+  // MultiDiskAdaptors, to limit the number of opened files.  This
+  // function must be called before any file is opened.
+  void setOpenedFileCache
+  (const SharedHandle<OpenedFileCache>& openedFileCache);
+
+  const SharedHandle<OpenedFileCache>& getOpenedFileCache() const
+  {
+    return openedFileCache_;
+  }
+
   virtual size_t utime(const Time& actime, const Time& modtime);
 
   const std::vector<SharedHandle<DiskWriterEntry> >&
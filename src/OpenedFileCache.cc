@@ -0,0 +1,107 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "OpenedFileCache.h"
+
+#include <cassert>
+
+#include "MultiDiskAdaptor.h"
+#include "LogFactory.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+OpenedFileCache::OpenedFileCache(size_t maxOpenFiles)
+  : maxOpenFiles_(maxOpenFiles),
+    hits_(0),
+    misses_(0)
+{}
+
+OpenedFileCache::~OpenedFileCache()
+{
+  // Downloads normally remove their files before this object is
+  // destroyed. Close the rest so that no file is left open.
+  for(std::list<DiskWriterEntry*>::const_iterator i = entries_.begin(),
+        eoi = entries_.end(); i != eoi; ++i) {
+    (*i)->closeFile();
+  }
+}
+
+void OpenedFileCache::hit(DiskWriterEntry* entry)
+{
+  std::map<DiskWriterEntry*, std::list<DiskWriterEntry*>::iterator>::iterator
+    i = index_.find(entry);
+  assert(i != index_.end());
+  ++hits_;
+  entries_.splice(entries_.begin(), entries_, (*i).second);
+}
+
+void OpenedFileCache::add(DiskWriterEntry* entry)
+{
+  assert(!contains(entry));
+  ++misses_;
+  entries_.push_front(entry);
+  index_[entry] = entries_.begin();
+  ensureLimit();
+}
+
+void OpenedFileCache::remove(DiskWriterEntry* entry)
+{
+  std::map<DiskWriterEntry*, std::list<DiskWriterEntry*>::iterator>::iterator
+    i = index_.find(entry);
+  if(i != index_.end()) {
+    entries_.erase((*i).second);
+    index_.erase(i);
+  }
+}
+
+void OpenedFileCache::setMaxOpenFiles(size_t maxOpenFiles)
+{
+  maxOpenFiles_ = maxOpenFiles;
+  ensureLimit();
+}
+
+void OpenedFileCache::ensureLimit()
+{
+  while(index_.size() > maxOpenFiles_) {
+    DiskWriterEntry* entry = entries_.back();
+    entries_.pop_back();
+    index_.erase(entry);
+    A2_LOG_DEBUG(fmt("Closing least recently used file %s",
+                     entry->getFilePath().c_str()));
+    entry->closeFile();
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,114 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_OPENED_FILE_CACHE_H
+#define D_OPENED_FILE_CACHE_H
+
+#include "common.h"
+
+#include <sys/types.h>
+
+#include <list>
+#include <map>
+
+namespace aria2 {
+
+class DiskWriterEntry;
+
+// Keeps track of files opened by MultiDiskAdaptor in least recently
+// used order.  When the number of opened files exceeds the limit,
+// the least recently used files are closed.  A single instance is
+// shared by all downloads so that the limit applies to aria2 as a
+// whole.
+class OpenedFileCache {
+private:
+  size_t maxOpenFiles_;
+  // Most recently used entry comes first.
+  std::list<DiskWriterEntry*> entries_;
+  std::map<DiskWriterEntry*, std::list<DiskWriterEntry*>::iterator> index_;
+  uint64_t hits_;
+  uint64_t misses_;
+
+  // Closes least recently used files until the number of opened
+  // files does not exceed maxOpenFiles_.
+  void ensureLimit();
+public:
+  static const size_t DEFAULT_MAX_OPEN_FILES = 100;
+
+  OpenedFileCache(size_t maxOpenFiles);
+  ~OpenedFileCache();
+
+  // Makes entry, which is already opened and added, the most recently
+  // used one.
+  void hit(DiskWriterEntry* entry);
+  // Adds entry, which has just been opened, as the most recently used
+  // one and closes least recently used files if the limit is
+  // exceeded.
+  void add(DiskWriterEntry* entry);
+  // Removes entry. The caller is responsible to close it.
+  void remove(DiskWriterEntry* entry);
+
+  bool contains(DiskWriterEntry* entry) const
+  {
+    return index_.count(entry);
+  }
+
+  void setMaxOpenFiles(size_t maxOpenFiles);
+
+  size_t getMaxOpenFiles() const
+  {
+    return maxOpenFiles_;
+  }
+
+  size_t countOpenFile() const
+  {
+    return index_.size();
+  }
+
+  // The number of times an already opened file was used.
+  uint64_t getHits() const
+  {
+    return hits_;
+  }
+
+  // The number of times a file had to be opened.
+  uint64_t getMisses() const
+  {
+    return misses_;
+  }
+};
+
+} // namespace aria2
+
+#endif // D_OPENED_FILE_CACHE_H
@@ -229,6 +229,18 @@ unsigned int Peer::calculateDownloadSpeed()
   return res_->getPeerStat().calculateDownloadSpeed();
 }
 
+unsigned int Peer::calculateUploadRate()
+{
+  assert(res_);
+  return res_->calculateUploadRate();
+}
+
+unsigned int Peer::calculateDownloadRate()
+{
+  assert(res_);
+  return res_->calculateDownloadRate();
+}
+
 uint64_t Peer::getSessionUploadLength() const
 {
   assert(res_);
@@ -260,6 +272,12 @@ size_t Peer::getBitfieldLength() const
   return res_->getBitfieldLength();
 }
 
+CandidatePieces& Peer::getCandidatePieces()
+{
+  assert(res_);
+  return res_->getCandidatePieces();
+}
+
 bool Peer::shouldBeChoking() const {
   assert(res_);
   return res_->shouldBeChoking();
@@ -417,4 +435,46 @@ size_t Peer::countOutstandingUpload() const
   return res_->countOutstandingUpload();
 }
 
+size_t Peer::countOutstandingRequest() const
+{
+  assert(res_);
+  return res_->countOutstandingRequest();
+}
+
+void Peer::setReqq(size_t reqq)
+{
+  assert(res_);
+  res_->reqq(reqq);
+}
+
+size_t Peer::getReqq() const
+{
+  assert(res_);
+  return res_->reqq();
+}
+
+void Peer::setRequestQueueSize(size_t size)
+{
+  assert(res_);
+  res_->requestQueueSize(size);
+}
+
+size_t Peer::getRequestQueueSize() const
+{
+  assert(res_);
+  return res_->requestQueueSize();
+}
+
+void Peer::updateRtt(int64_t latency, uint64_t aheadLength)
+{
+  assert(res_);
+  res_->updateRtt(latency, aheadLength);
+}
+
+int64_t Peer::getRtt() const
+{
+  assert(res_);
+  return res_->getRtt();
+}
+
 } // namespace aria2
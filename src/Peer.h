@@ -53,6 +53,7 @@ namespace aria2 {
 
 class PeerSessionResource;
 class BtMessageDispatcher;
+struct CandidatePieces;
 
 class Peer {
 private:
@@ -231,6 +232,13 @@ public:
    */
   unsigned int calculateDownloadSpeed();
 
+  // Same as calculateUploadSpeed() and calculateDownloadSpeed(), but
+  // returns the exponentially weighted moving average, which changes
+  // smoothly. Use these to rank peers.
+  unsigned int calculateUploadRate();
+
+  unsigned int calculateDownloadRate();
+
   /**
    * Returns the number of bytes uploaded to the remote host.
    */
@@ -247,6 +255,10 @@ public:
 
   size_t getBitfieldLength() const;
 
+  // Pieces this peer has and localhost can request. Maintained by
+  // DefaultPieceStorage.
+  CandidatePieces& getCandidatePieces();
+
   void setAllBitfield();
 
   /**
@@ -325,6 +337,25 @@ public:
   void setBtMessageDispatcher(BtMessageDispatcher* dpt);
 
   size_t countOutstandingUpload() const;
+
+  size_t countOutstandingRequest() const;
+
+  // The number of outstanding requests this peer accepts, told by
+  // reqq in extended handshake. 0 means unknown.
+  void setReqq(size_t reqq);
+
+  size_t getReqq() const;
+
+  // The number of outstanding requests localhost keeps to this peer.
+  void setRequestQueueSize(size_t size);
+
+  size_t getRequestQueueSize() const;
+
+  void updateRtt(int64_t latency, uint64_t aheadLength);
+
+  // Returns the request round trip time in milliseconds, or -1 if it
+  // is not measured yet.
+  int64_t getRtt() const;
 };
 
 template<typename InputIterator>
@@ -43,12 +43,14 @@
 #include "LogFactory.h"
 #include "Logger.h"
 #include "BtHandshakeMessage.h"
+#include "BtPieceMessage.h"
 #include "Socket.h"
 #include "a2netcompat.h"
 #include "ARC4Encryptor.h"
 #include "fmt.h"
 #include "util.h"
 #include "Peer.h"
+#include "DiskAdaptor.h"
 
 namespace aria2 {
 
@@ -57,10 +59,14 @@ PeerConnection::PeerConnection
   : cuid_(cuid),
     peer_(peer),
     socket_(socket),
-    resbuf_(new unsigned char[MAX_PAYLOAD_LEN]),
+    resbuf_(new unsigned char[DEFAULT_RESBUF_LEN]),
+    resbufCapacity_(DEFAULT_RESBUF_LEN),
     resbufLength_(0),
     currentPayloadLength_(0),
     lenbufLength_(0),
+    blockFreeList_(0),
+    block_(0),
+    blockLength_(0),
     socketBuffer_(socket),
     encryptionEnabled_(false),
     prevPeek_(false)
@@ -69,6 +75,9 @@ PeerConnection::PeerConnection
 PeerConnection::~PeerConnection()
 {
   delete [] resbuf_;
+  if(block_) {
+    blockFreeList_->deallocate(block_);
+  }
 }
 
 void PeerConnection::pushBytes(unsigned char* data, size_t len)
@@ -79,27 +88,50 @@ void PeerConnection::pushBytes(unsigned char* data, size_t len)
   socketBuffer_.pushBytes(data, len);
 }
 
+void PeerConnection::pushBytes
+(unsigned char* data, size_t len, FreeList* freeList)
+{
+  if(encryptionEnabled_) {
+    encryptor_->encrypt(len, data, data);
+  }
+  socketBuffer_.pushBytes(data, len, freeList);
+}
+
+bool PeerConnection::pushFileData
+(const SharedHandle<DiskAdaptor>& diskAdaptor, off_t offset, size_t len)
+{
+#ifdef HAVE_SENDFILE
+  if(encryptionEnabled_ || socket_->isSecure()) {
+    return false;
+  }
+  off_t fileOffset;
+  size_t fileLength;
+  if(diskAdaptor->getFd(offset, len, fileOffset, fileLength) == -1) {
+    return false;
+  }
+  socketBuffer_.pushFile(diskAdaptor, offset, len);
+  return true;
+#else // !HAVE_SENDFILE
+  return false;
+#endif // !HAVE_SENDFILE
+}
+
+namespace {
+// The length of the payload of PIECE message before the block.
+const size_t PIECE_HEADER_LENGTH = 9;
+// The block of PIECE message is read into a separate buffer if it is
+// at least this long. Shorter messages are read with one read call.
+const size_t MIN_BLOCK_RECEIVE_LENGTH = 1024;
+} // namespace
+
 bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength) {
   if(resbufLength_ == 0 && 4 > lenbufLength_) {
-    // read payload size, 32bit unsigned integer
-    size_t remaining = 4-lenbufLength_;
-    size_t temp = remaining;
-    readData(lenbuf_+lenbufLength_, remaining, encryptionEnabled_);
-    if(remaining == 0) {
-      if(socket_->wantRead() || socket_->wantWrite()) {
-        return false;
-      }
-      // we got EOF
-      A2_LOG_DEBUG(fmt("CUID#%lld - In PeerConnection::receiveMessage(),"
-                       " remain=%lu",
-                       cuid_,
-                       static_cast<unsigned long>(temp)));
-      peer_->setDisconnectedGracefully(true);
-      throw DL_ABORT_EX(EX_EOF_FROM_PEER);
+    if(lenbufLength_ == 0) {
+      // The previous message has been processed.
+      releaseBuffer();
     }
-    lenbufLength_ += remaining;
-    if(4 > lenbufLength_) {
-      // still 4-lenbufLength_ bytes to go
+    // read payload size, 32bit unsigned integer
+    if(!readUntil(lenbuf_, lenbufLength_, 4)) {
       return false;
     }
     uint32_t payloadLength;
@@ -113,26 +145,28 @@ bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength) {
   if(!socket_->isReadable(0)) {
     return false;
   }
-  // we have currentPayloadLen-resbufLen bytes to read
-  size_t remaining = currentPayloadLength_-resbufLength_;
-  size_t temp = remaining;
-  if(remaining > 0) {
-    readData(resbuf_+resbufLength_, remaining, encryptionEnabled_);
-    if(remaining == 0) {
-      if(socket_->wantRead() || socket_->wantWrite()) {
-        return false;
-      }
-      // we got EOF
-      A2_LOG_DEBUG(fmt("CUID#%lld - In PeerConnection::receiveMessage(),"
-                       " payloadlen=%lu, remaining=%lu",
-                       cuid_,
-                       static_cast<unsigned long>(currentPayloadLength_),
-                       static_cast<unsigned long>(temp)));
-      peer_->setDisconnectedGracefully(true);
-      throw DL_ABORT_EX(EX_EOF_FROM_PEER);
+  if(blockFreeList_ && !block_ && resbufLength_ < PIECE_HEADER_LENGTH &&
+     currentPayloadLength_ >= PIECE_HEADER_LENGTH+MIN_BLOCK_RECEIVE_LENGTH) {
+    // Read the header first to see whether this is PIECE message.
+    reserveBuffer(PIECE_HEADER_LENGTH);
+    if(!readUntil(resbuf_, resbufLength_, PIECE_HEADER_LENGTH)) {
+      return false;
     }
-    resbufLength_ += remaining;
-    if(currentPayloadLength_ > resbufLength_) {
+    if(resbuf_[0] == BtPieceMessage::ID &&
+       currentPayloadLength_-PIECE_HEADER_LENGTH <=
+       blockFreeList_->getChunkSize()) {
+      block_ = static_cast<unsigned char*>(blockFreeList_->allocate());
+      blockLength_ = 0;
+    }
+  }
+  if(block_) {
+    if(!readUntil(block_, blockLength_,
+                  currentPayloadLength_-PIECE_HEADER_LENGTH)) {
+      return false;
+    }
+  } else {
+    reserveBuffer(currentPayloadLength_);
+    if(!readUntil(resbuf_, resbufLength_, currentPayloadLength_)) {
       return false;
     }
   }
@@ -140,12 +174,67 @@ bool PeerConnection::receiveMessage(unsigned char* data, size_t& dataLength) {
   resbufLength_ = 0;
   lenbufLength_ = 0;
   if(data) {
-    memcpy(data, resbuf_, currentPayloadLength_);
+    if(block_) {
+      memcpy(data, resbuf_, PIECE_HEADER_LENGTH);
+      memcpy(data+PIECE_HEADER_LENGTH, block_, blockLength_);
+    } else {
+      memcpy(data, resbuf_, currentPayloadLength_);
+    }
   }
   dataLength = currentPayloadLength_;
   return true;
 }
 
+bool PeerConnection::readUntil
+(unsigned char* buf, size_t& bufLength, size_t length)
+{
+  if(bufLength >= length) {
+    return true;
+  }
+  size_t remaining = length-bufLength;
+  size_t temp = remaining;
+  readData(buf+bufLength, remaining, encryptionEnabled_);
+  if(remaining == 0) {
+    if(socket_->wantRead() || socket_->wantWrite()) {
+      return false;
+    }
+    // we got EOF
+    A2_LOG_DEBUG(fmt("CUID#%lld - In PeerConnection::receiveMessage(),"
+                     " payloadlen=%lu, remaining=%lu",
+                     cuid_,
+                     static_cast<unsigned long>(currentPayloadLength_),
+                     static_cast<unsigned long>(temp)));
+    peer_->setDisconnectedGracefully(true);
+    throw DL_ABORT_EX(EX_EOF_FROM_PEER);
+  }
+  bufLength += remaining;
+  return bufLength == length;
+}
+
+void PeerConnection::reserveBuffer(size_t length)
+{
+  if(resbufCapacity_ < length) {
+    unsigned char* buf = new unsigned char[length];
+    memcpy(buf, resbuf_, resbufLength_);
+    delete [] resbuf_;
+    resbuf_ = buf;
+    resbufCapacity_ = length;
+  }
+}
+
+void PeerConnection::releaseBuffer()
+{
+  if(block_) {
+    blockFreeList_->deallocate(block_);
+    block_ = 0;
+  }
+  if(resbufCapacity_ > DEFAULT_RESBUF_LEN) {
+    delete [] resbuf_;
+    resbuf_ = new unsigned char[DEFAULT_RESBUF_LEN];
+    resbufCapacity_ = DEFAULT_RESBUF_LEN;
+  }
+}
+
 bool PeerConnection::receiveHandshake(unsigned char* data, size_t& dataLength,
                                       bool peek) {
   if(BtHandshakeMessage::MESSAGE_LENGTH < resbufLength_) {
@@ -202,6 +291,8 @@ void PeerConnection::enableEncryption
 void PeerConnection::presetBuffer(const unsigned char* data, size_t length)
 {
   size_t nwrite = std::min((size_t)MAX_PAYLOAD_LEN, length);
+  resbufLength_ = 0;
+  reserveBuffer(nwrite);
   memcpy(resbuf_, data, nwrite);
   resbufLength_ = length;
 }
@@ -221,8 +312,21 @@ ssize_t PeerConnection::sendPendingData()
 unsigned char* PeerConnection::detachBuffer()
 {
   unsigned char* detachbuf = resbuf_;
-  resbuf_ = new unsigned char[MAX_PAYLOAD_LEN];
+  resbuf_ = new unsigned char[DEFAULT_RESBUF_LEN];
+  resbufCapacity_ = DEFAULT_RESBUF_LEN;
   return detachbuf;
 }
 
+void PeerConnection::enableBlockReceive(FreeList* freeList)
+{
+  blockFreeList_ = freeList;
+}
+
+unsigned char* PeerConnection::detachBlock()
+{
+  unsigned char* block = block_;
+  block_ = 0;
+  return block;
+}
+
 } // namespace aria2
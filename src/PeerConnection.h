@@ -48,11 +48,16 @@ namespace aria2 {
 class Peer;
 class SocketCore;
 class ARC4Encryptor;
+class DiskAdaptor;
 
 // The maximum length of payload. Messages beyond that length are
 // dropped.
 #define MAX_PAYLOAD_LEN (16*1024+128)
 
+// The size of the receive buffer while no long message is being
+// received. It must hold a handshake message.
+#define DEFAULT_RESBUF_LEN 128
+
 class PeerConnection {
 private:
   cuid_t cuid_;
@@ -60,11 +65,18 @@ private:
   SharedHandle<SocketCore> socket_;
 
   unsigned char* resbuf_;
+  size_t resbufCapacity_;
   size_t resbufLength_;
   size_t currentPayloadLength_;
   unsigned char lenbuf_[4];
   size_t lenbufLength_;
 
+  // If not null, the block of PIECE message is read into block_,
+  // which is allocated by blockFreeList_, instead of resbuf_.
+  FreeList* blockFreeList_;
+  unsigned char* block_;
+  size_t blockLength_;
+
   SocketBuffer socketBuffer_;
 
   bool encryptionEnabled_;
@@ -75,6 +87,17 @@ private:
 
   void readData(unsigned char* data, size_t& length, bool encryption);
 
+  // Reads data into buf until bufLength reaches length. Returns true
+  // if it does. Throws DlAbortEx on EOF.
+  bool readUntil(unsigned char* buf, size_t& bufLength, size_t length);
+
+  // Makes resbuf_ hold at least length bytes.
+  void reserveBuffer(size_t length);
+
+  // Frees block_ and shrinks resbuf_ to DEFAULT_RESBUF_LEN bytes.
+  // Called when no message is being received.
+  void releaseBuffer();
+
   ssize_t sendData(const unsigned char* data, size_t length, bool encryption);
 
 public:
@@ -89,8 +112,27 @@ public:
   // ownership of data, so caller must not delete or alter it.
   void pushBytes(unsigned char* data, size_t len);
 
+  // Same as pushBytes(data, len), but data was allocated by
+  // freeList->allocate() and is returned to freeList after it is
+  // sent.
+  void pushBytes(unsigned char* data, size_t len, FreeList* freeList);
+
   void pushStr(const std::string& data);
 
+  // Pushes len bytes of data at offset in diskAdaptor into send
+  // buffer.  The data are sent by sendfile(2) without reading them
+  // into memory.  Returns false and pushes nothing if the data cannot
+  // be sent that way, for example, when encryption is enabled.
+  bool pushFileData(const SharedHandle<DiskAdaptor>& diskAdaptor,
+                    off_t offset, size_t len);
+
+  // Receives one message. Returns true if a whole message is
+  // received, and stores its payload length in dataLength. If data is
+  // not null, the payload is copied to it. Otherwise, the payload is
+  // available from getBuffer() until the next call. If the block of
+  // PIECE message was received into a separate buffer,
+  // getBuffer() has only the first 9 bytes of the payload and the
+  // block is taken by detachBlock().
   bool receiveMessage(unsigned char* data, size_t& dataLength);
 
   /**
@@ -122,6 +164,24 @@ public:
   }
 
   unsigned char* detachBuffer();
+
+  // Makes receiveMessage() read the block of PIECE messages longer
+  // than 1KiB into a buffer allocated by freeList, so that it can be
+  // handed to the disk cache without copying it. PIECE messages
+  // whose block does not fit in the chunk of freeList are received
+  // into the receive buffer.
+  void enableBlockReceive(FreeList* freeList);
+
+  // Returns the block received into a buffer of the free list given
+  // to enableBlockReceive(), or 0 if the last message was not
+  // received that way. The caller takes ownership of the buffer and
+  // must return it to the free list.
+  unsigned char* detachBlock();
+
+  FreeList* getBlockFreeList() const
+  {
+    return blockFreeList_;
+  }
 };
 
 typedef SharedHandle<PeerConnection> PeerConnectionHandle;
@@ -183,6 +183,9 @@ PeerInteractionCommand::PeerInteractionCommand
   dispatcher->setRequestGroupMan
     (getDownloadEngine()->getRequestGroupMan().get());
 
+  // Received blocks are handed to the disk cache without copying.
+  peerConnection->enableBlockReceive(&bittorrent::getBlockBufferList());
+
   DefaultBtMessageReceiverHandle receiver(new DefaultBtMessageReceiver());
   receiver->setDownloadContext(requestGroup_->getDownloadContext());
   receiver->setPeerConnection(peerConnection.get());
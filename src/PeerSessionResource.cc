@@ -44,6 +44,10 @@
 
 namespace aria2 {
 
+namespace {
+const size_t MAX_CANDIDATE_PIECES_HAVES = 256;
+} // namespace
+
 PeerSessionResource::PeerSessionResource(size_t pieceLength, uint64_t totalLength):
   amChoking_(true),
   amInterested_(false),
@@ -56,6 +60,11 @@ PeerSessionResource::PeerSessionResource(size_t pieceLength, uint64_t totalLengt
   fastExtensionEnabled_(false),
   extendedMessagingEnabled_(false),
   dhtEnabled_(false),
+  reqq_(0),
+  requestQueueSize_(0),
+  minRtt_(-1),
+  prevMinRtt_(-1),
+  rttWindowTimer_(global::wallclock()),
   lastDownloadUpdate_(0),
   lastAmUnchoking_(0),
   dispatcher_(0)
@@ -125,14 +134,24 @@ void PeerSessionResource::updateBitfield(size_t index, int operation)
 {
   if(operation == 1) {
     bitfieldMan_->setBit(index);
+    if(candidatePieces_.seq) {
+      // Rebuilding is cheaper than applying many HAVEs one by one.
+      if(candidatePieces_.haves.size() >= MAX_CANDIDATE_PIECES_HAVES) {
+        candidatePieces_.invalidate();
+      } else {
+        candidatePieces_.haves.push_back(index);
+      }
+    }
   } else if(operation == 0) {
     bitfieldMan_->unsetBit(index);
+    candidatePieces_.invalidate();
   }
 }
 
 void PeerSessionResource::setBitfield(const unsigned char* bitfield, size_t bitfieldLength)
 {
   bitfieldMan_->setBitfield(bitfield, bitfieldLength);
+  candidatePieces_.invalidate();
 }
 
 const unsigned char* PeerSessionResource::getBitfield() const
@@ -153,6 +172,7 @@ bool PeerSessionResource::hasPiece(size_t index) const
 void PeerSessionResource::markSeeder()
 {
   bitfieldMan_->setAllBit();
+  candidatePieces_.invalidate();
 }
 
 void PeerSessionResource::fastExtensionEnabled(bool b)
@@ -245,6 +265,7 @@ uint64_t PeerSessionResource::uploadLength() const
 void PeerSessionResource::updateUploadLength(size_t bytes)
 {
   peerStat_.updateUploadLength(bytes);
+  uploadRate_.update(bytes);
 }
 
 uint64_t PeerSessionResource::downloadLength() const
@@ -255,6 +276,7 @@ uint64_t PeerSessionResource::downloadLength() const
 void PeerSessionResource::updateDownloadLength(size_t bytes)
 {
   peerStat_.updateDownloadLength(bytes);
+  downloadRate_.update(bytes);
 
   lastDownloadUpdate_ = global::wallclock();
 }
@@ -275,10 +297,56 @@ size_t PeerSessionResource::countOutstandingUpload() const
   return dispatcher_->countOutstandingUpload();
 }
 
+size_t PeerSessionResource::countOutstandingRequest() const
+{
+  assert(dispatcher_);
+  return dispatcher_->countOutstandingRequest();
+}
+
+namespace {
+// The minimum RTT is taken over this many seconds, so that a route
+// change is noticed eventually.
+const time_t RTT_WINDOW = 10;
+} // namespace
+
+void PeerSessionResource::updateRtt(int64_t latency, uint64_t aheadLength)
+{
+  if(aheadLength > 0) {
+    unsigned int speed = peerStat_.calculateDownloadSpeed();
+    if(speed == 0) {
+      return;
+    }
+    latency -= aheadLength*1000/speed;
+    if(latency < 0) {
+      return;
+    }
+  }
+  if(rttWindowTimer_.difference(global::wallclock()) >= RTT_WINDOW) {
+    prevMinRtt_ = minRtt_;
+    minRtt_ = -1;
+    rttWindowTimer_ = global::wallclock();
+  }
+  if(minRtt_ < 0 || latency < minRtt_) {
+    minRtt_ = latency;
+  }
+}
+
+int64_t PeerSessionResource::getRtt() const
+{
+  if(minRtt_ < 0) {
+    return prevMinRtt_;
+  } else if(prevMinRtt_ < 0) {
+    return minRtt_;
+  } else {
+    return std::min(minRtt_, prevMinRtt_);
+  }
+}
+
 void PeerSessionResource::reconfigure(size_t pieceLength, uint64_t totalLenth)
 {
   delete bitfieldMan_;
   bitfieldMan_ = new BitfieldMan(pieceLength, totalLenth);
+  candidatePieces_.invalidate();
 }
 
 } // namespace aria2
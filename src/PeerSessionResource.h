@@ -42,6 +42,7 @@
 
 #include "BtConstants.h"
 #include "PeerStat.h"
+#include "RateEstimator.h"
 #include "TimerA2.h"
 
 namespace aria2 {
@@ -49,6 +50,26 @@ namespace aria2 {
 class BitfieldMan;
 class BtMessageDispatcher;
 
+// Pieces which a peer has and localhost has neither downloaded nor
+// checked out yet. DefaultPieceStorage keeps it up to date from its
+// piece change log and the HAVE messages recorded here.
+struct CandidatePieces {
+  std::vector<unsigned char> bitfield;
+  // Position in the piece change log which bitfield reflects. 0 means
+  // bitfield must be rebuilt.
+  uint64_t seq;
+  // Pieces the peer announced after bitfield was updated.
+  std::vector<size_t> haves;
+
+  CandidatePieces():seq(0) {}
+
+  void invalidate()
+  {
+    seq = 0;
+    haves.clear();
+  }
+};
+
 class PeerSessionResource {
 private:
   // localhost is choking this peer
@@ -67,6 +88,7 @@ private:
   bool snubbing_;
 
   BitfieldMan* bitfieldMan_;
+  CandidatePieces candidatePieces_;
   bool fastExtensionEnabled_;
   // fast index set which a peer has sent to localhost.
   std::vector<size_t> peerAllowedIndexSet_;
@@ -75,7 +97,20 @@ private:
   bool extendedMessagingEnabled_;
   Extensions extensions_;
   bool dhtEnabled_;
+  // The number of outstanding requests this peer accepts. 0 means
+  // the peer did not tell it.
+  size_t reqq_;
+  // The number of outstanding requests localhost keeps to this peer.
+  size_t requestQueueSize_;
+  // The minimum request round trip time in milliseconds seen in the
+  // current and the previous RTT window. -1 means no sample.
+  int64_t minRtt_;
+  int64_t prevMinRtt_;
+  Timer rttWindowTimer_;
   PeerStat peerStat_;
+  // Smoothed transfer rates used to rank peers.
+  RateEstimator downloadRate_;
+  RateEstimator uploadRate_;
 
   Timer lastDownloadUpdate_;
 
@@ -155,6 +190,11 @@ public:
 
   size_t getBitfieldLength() const;
 
+  CandidatePieces& getCandidatePieces()
+  {
+    return candidatePieces_;
+  }
+
   void reconfigure(size_t index, uint64_t totalLength);
 
   bool hasPiece(size_t index) const;
@@ -205,6 +245,36 @@ public:
 
   void dhtEnabled(bool b);
 
+  size_t reqq() const
+  {
+    return reqq_;
+  }
+
+  void reqq(size_t n)
+  {
+    reqq_ = n;
+  }
+
+  size_t requestQueueSize() const
+  {
+    return requestQueueSize_;
+  }
+
+  void requestQueueSize(size_t n)
+  {
+    requestQueueSize_ = n;
+  }
+
+  // Records the time in milliseconds between sending a request and
+  // receiving its block. aheadLength is the number of bytes received
+  // from this peer in the meantime. Their transfer time is not part
+  // of the round trip time.
+  void updateRtt(int64_t latency, uint64_t aheadLength);
+
+  // Returns the request round trip time in milliseconds, or -1 if it
+  // is not measured yet.
+  int64_t getRtt() const;
+
   PeerStat& getPeerStat()
   {
     return peerStat_;
@@ -218,6 +288,16 @@ public:
 
   void updateDownloadLength(size_t bytes);
 
+  unsigned int calculateDownloadRate()
+  {
+    return downloadRate_.calculateRate();
+  }
+
+  unsigned int calculateUploadRate()
+  {
+    return uploadRate_.calculateRate();
+  }
+
   const Timer& getLastDownloadUpdate() const
   {
     return lastDownloadUpdate_;
@@ -233,6 +313,8 @@ public:
   void setBtMessageDispatcher(BtMessageDispatcher* dpt);
 
   size_t countOutstandingUpload() const;
+
+  size_t countOutstandingRequest() const;
 };
 
 } // namespace aria2
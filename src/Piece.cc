@@ -33,11 +33,25 @@
  */
 /* copyright --> */
 #include "Piece.h"
+
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+
 #include "util.h"
 #include "BitfieldMan.h"
 #include "A2STR.h"
 #include "util.h"
 #include "a2functional.h"
+#include "WrDiskCache.h"
+#include "WrDiskCacheEntry.h"
+#include "DiskWriteJob.h"
+#include "PieceStorage.h"
+#include "DiskAdaptor.h"
+#include "DlAbortEx.h"
+#include "message.h"
+#include "fmt.h"
+#include "LogFactory.h"
 #ifdef ENABLE_MESSAGE_DIGEST
 # include "MessageDigest.h"
 #endif // ENABLE_MESSAGE_DIGEST
@@ -45,7 +59,7 @@
 namespace aria2 {
 
 Piece::Piece():index_(0), length_(0), blockLength_(BLOCK_LENGTH), bitfield_(0),
-               usedBySegment_(false)
+               usedBySegment_(false), wrCache_(0)
 #ifdef ENABLE_MESSAGE_DIGEST
               , nextBegin_(0)
 #endif // ENABLE_MESSAGE_DIGEST
@@ -54,7 +68,8 @@ Piece::Piece():index_(0), length_(0), blockLength_(BLOCK_LENGTH), bitfield_(0),
 Piece::Piece(size_t index, size_t length, size_t blockLength):
   index_(index), length_(length), blockLength_(blockLength),
   bitfield_(new BitfieldMan(blockLength_, length)),
-  usedBySegment_(false)
+  usedBySegment_(false),
+  wrCache_(0)
 #ifdef ENABLE_MESSAGE_DIGEST
   , nextBegin_(0)
 #endif // ENABLE_MESSAGE_DIGEST
@@ -62,6 +77,7 @@ Piece::Piece(size_t index, size_t length, size_t blockLength):
 
 Piece::~Piece()
 {
+  releaseWrCache();
   delete bitfield_;
 }
 
@@ -73,6 +89,7 @@ void Piece::completeBlock(size_t blockIndex) {
 void Piece::clearAllBlock() {
   bitfield_->clearAllBit();
   bitfield_->clearAllUseBit();
+  clearWrCache();
 }
 
 void Piece::setAllBlock() {
@@ -235,6 +252,62 @@ void Piece::destroyHashContext()
   nextBegin_ = 0;
 }
 
+namespace {
+void updateHashWithRead(const SharedHandle<MessageDigest>& mdctx,
+                        const SharedHandle<DiskAdaptor>& adaptor,
+                        off_t offset, size_t len)
+{
+  const size_t BUFSIZE = 4096;
+  unsigned char buf[BUFSIZE];
+  while(len > 0) {
+    size_t rlen = std::min(len, BUFSIZE);
+    ssize_t nread = adaptor->readData(buf, rlen, offset);
+    if(nread != static_cast<ssize_t>(rlen)) {
+      throw DL_ABORT_EX(fmt(EX_FILE_READ, "n/a", "data is too short"));
+    }
+    mdctx->update(buf, rlen);
+    offset += rlen;
+    len -= rlen;
+  }
+}
+} // namespace
+
+std::string Piece::getDigestWithWrCache
+(size_t pieceLength, const SharedHandle<DiskAdaptor>& adaptor)
+{
+  if(hashType_.empty()) {
+    return A2STR::NIL;
+  }
+  if(wrCache_ && wrCache_->getPendingWrite() > 0) {
+    // The data being written by worker threads are read from the disk
+    // below.
+    wrCache_->getCache()->waitAsyncWrite(wrCache_);
+  }
+  SharedHandle<MessageDigest> mdctx(MessageDigest::create(hashType_));
+  off_t goff = static_cast<off_t>(index_)*pieceLength;
+  off_t end = goff+length_;
+  if(wrCache_) {
+    const WrDiskCacheEntry::DataCellSet& dataSet = wrCache_->getDataSet();
+    for(WrDiskCacheEntry::DataCellSet::const_iterator i = dataSet.begin(),
+          eoi = dataSet.end(); i != eoi && goff < end; ++i) {
+      off_t cellEnd = std::min(end, static_cast<off_t>((*i)->goff+(*i)->len));
+      if(cellEnd <= goff) {
+        continue;
+      }
+      if(goff < (*i)->goff) {
+        updateHashWithRead(mdctx, adaptor, goff, (*i)->goff-goff);
+        goff = (*i)->goff;
+      }
+      mdctx->update((*i)->data+(goff-(*i)->goff), cellEnd-goff);
+      goff = cellEnd;
+    }
+  }
+  if(goff < end) {
+    updateHashWithRead(mdctx, adaptor, goff, end-goff);
+  }
+  return mdctx->digest();
+}
+
 #endif // ENABLE_MESSAGE_DIGEST
 
 bool Piece::usedBy(cuid_t cuid) const
@@ -254,4 +327,103 @@ void Piece::removeUser(cuid_t cuid)
   users_.erase(std::remove(users_.begin(), users_.end(), cuid), users_.end());
 }
 
+void Piece::initWrCache(WrDiskCache* diskCache,
+                        const SharedHandle<DiskAdaptor>& diskAdaptor)
+{
+  assert(!wrCache_);
+  wrCache_ = new WrDiskCacheEntry(diskCache, diskAdaptor);
+  diskCache->add(wrCache_);
+}
+
+void Piece::updateWrCache(const unsigned char* data, size_t dataLen,
+                          off_t goff)
+{
+  assert(wrCache_);
+  A2_LOG_DEBUG(fmt("updateWrCache entry=%p goff=%lld len=%lu",
+                   wrCache_, static_cast<long long int>(goff),
+                   static_cast<unsigned long>(dataLen)));
+  WrDiskCacheEntry::DataCell* cell = new WrDiskCacheEntry::DataCell();
+  cell->goff = goff;
+  cell->data = new unsigned char[dataLen];
+  cell->len = dataLen;
+  cell->freeList = 0;
+  memcpy(cell->data, data, dataLen);
+  ssize_t delta = wrCache_->cacheData(cell);
+  wrCache_->getCache()->update(wrCache_, delta);
+}
+
+void Piece::updateWrCache(unsigned char* data, size_t dataLen, off_t goff,
+                          FreeList* freeList)
+{
+  assert(wrCache_);
+  A2_LOG_DEBUG(fmt("updateWrCache entry=%p goff=%lld len=%lu",
+                   wrCache_, static_cast<long long int>(goff),
+                   static_cast<unsigned long>(dataLen)));
+  WrDiskCacheEntry::DataCell* cell = new WrDiskCacheEntry::DataCell();
+  cell->goff = goff;
+  cell->data = data;
+  cell->len = dataLen;
+  cell->freeList = freeList;
+  ssize_t delta = wrCache_->cacheData(cell);
+  wrCache_->getCache()->update(wrCache_, delta);
+}
+
+void Piece::flushWrCache()
+{
+  if(!wrCache_) {
+    return;
+  }
+  if(wrCache_->getPendingWrite() > 0) {
+    wrCache_->getCache()->waitAsyncWrite(wrCache_);
+    if(!wrCache_) {
+      return;
+    }
+  }
+  size_t size = wrCache_->getSize();
+  wrCache_->writeToDisk();
+  wrCache_->getCache()->update(wrCache_, -static_cast<ssize_t>(size));
+}
+
+void Piece::clearWrCache()
+{
+  if(!wrCache_) {
+    return;
+  }
+  size_t size = wrCache_->getSize();
+  wrCache_->deleteDataCells();
+  wrCache_->setWriteError(false);
+  wrCache_->getCache()->update(wrCache_, -static_cast<ssize_t>(size));
+}
+
+SharedHandle<DiskWriteJob> Piece::flushWrCacheAsync
+(Command* command,
+ const SharedHandle<PieceStorage>& pieceStorage,
+ const SharedHandle<Piece>& self,
+ cuid_t cuid)
+{
+  SharedHandle<DiskWriteJob> job;
+  if(wrCache_ && wrCache_->getCache()->isAsyncWriteEnabled(wrCache_) &&
+     (wrCache_->getSize() > 0 || wrCache_->getPendingWrite() > 0)) {
+    job = wrCache_->getCache()->writeAsync
+      (wrCache_, command, pieceStorage, self, cuid);
+  }
+  return job;
+}
+
+void Piece::releaseWrCache()
+{
+  if(!wrCache_) {
+    return;
+  }
+  if(wrCache_->getPendingWrite() > 0) {
+    wrCache_->getCache()->waitAsyncWrite(wrCache_);
+    if(!wrCache_) {
+      return;
+    }
+  }
+  wrCache_->getCache()->remove(wrCache_);
+  delete wrCache_;
+  wrCache_ = 0;
+}
+
 } // namespace aria2
@@ -47,6 +47,12 @@
 namespace aria2 {
 
 class BitfieldMan;
+class WrDiskCache;
+class WrDiskCacheEntry;
+class DiskAdaptor;
+class DiskWriteJob;
+class PieceStorage;
+class FreeList;
 
 #ifdef ENABLE_MESSAGE_DIGEST
 
@@ -62,6 +68,7 @@ private:
   BitfieldMan* bitfield_;
   std::vector<cuid_t> users_;
   bool usedBySegment_;
+  WrDiskCacheEntry* wrCache_;
 #ifdef ENABLE_MESSAGE_DIGEST
 
   size_t nextBegin_;
@@ -172,6 +179,12 @@ public:
 
   void destroyHashContext();
 
+  // Calculates the hash value of this piece. The data held in the
+  // write cache are used as they are and the rest of the piece is
+  // read from adaptor. Returns raw hash value.
+  std::string getDigestWithWrCache
+  (size_t pieceLength, const SharedHandle<DiskAdaptor>& adaptor);
+
 #endif // ENABLE_MESSAGE_DIGEST
 
   /**
@@ -186,6 +199,10 @@ public:
     return !users_.empty();
   }
   bool usedBy(cuid_t cuid) const;
+  size_t countUser() const
+  {
+    return users_.size();
+  }
   bool getUsedBySegment() const
   {
     return usedBySegment_;
@@ -194,6 +211,41 @@ public:
   {
     usedBySegment_ = f;
   }
+
+  // Creates write cache entry for this piece and registers it to
+  // diskCache. The cached data are written to diskAdaptor.
+  void initWrCache(WrDiskCache* diskCache,
+                   const SharedHandle<DiskAdaptor>& diskAdaptor);
+  // Copies data and stores it in the write cache. goff is the global
+  // offset of data. initWrCache() must be called beforehand.
+  void updateWrCache(const unsigned char* data, size_t dataLen, off_t goff);
+  // Stores data in the write cache without copying it. data must be
+  // allocated by freeList, and this object takes ownership of it.
+  // The data may be written and freed before this function returns.
+  void updateWrCache(unsigned char* data, size_t dataLen, off_t goff,
+                     FreeList* freeList);
+  // Writes the cached data to the disk. The cache entry is kept.
+  void flushWrCache();
+  // Writes the cached data in a worker thread if the cache supports
+  // it. self must point to this object. If pieceStorage is not null,
+  // this piece is completed in it by cuid after the write. command,
+  // if not 0, is woken up when the write is done. Returns null if
+  // nothing is submitted; then the caller must flush and complete
+  // the piece by itself.
+  SharedHandle<DiskWriteJob> flushWrCacheAsync
+  (Command* command,
+   const SharedHandle<PieceStorage>& pieceStorage,
+   const SharedHandle<Piece>& self,
+   cuid_t cuid);
+  // Discards the cached data. The cache entry is kept.
+  void clearWrCache();
+  // Discards the cached data and deletes the cache entry. Call
+  // flushWrCache() beforehand to keep the data.
+  void releaseWrCache();
+  WrDiskCacheEntry* getWrDiskCacheEntry() const
+  {
+    return wrCache_;
+  }
 };
 
 } // namespace aria2
@@ -0,0 +1,141 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "PieceHashJob.h"
+
+#include <algorithm>
+
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "DefaultDiskWriter.h"
+#include "MessageDigest.h"
+#include "DlAbortEx.h"
+#include "message.h"
+#include "fmt.h"
+#include "array_fun.h"
+
+namespace aria2 {
+
+PieceHashJob::PieceHashJob
+(const SharedHandle<DownloadContext>& dctx,
+ const std::vector<SharedHandle<FileEntry> >& fileEntries,
+ size_t index, size_t numPieces)
+  : hashType_(dctx->getPieceHashType()),
+    pieceLength_(dctx->getPieceLength()),
+    totalLength_(dctx->getTotalLength()),
+    index_(index),
+    numPieces_(numPieces),
+    digests_(numPieces),
+    errors_(numPieces)
+{
+  off_t first = static_cast<off_t>(index)*pieceLength_;
+  off_t last = std::min(static_cast<off_t>(index+numPieces)*
+                        static_cast<off_t>(pieceLength_),
+                        static_cast<off_t>(totalLength_));
+  for(std::vector<SharedHandle<FileEntry> >::const_iterator i =
+        fileEntries.begin(), eoi = fileEntries.end(); i != eoi; ++i) {
+    if((*i)->getLength() == 0 || (*i)->getLastOffset() <= first) {
+      continue;
+    }
+    if(last <= (*i)->getOffset()) {
+      break;
+    }
+    FileSpan span;
+    span.path = (*i)->getPath();
+    span.offset = (*i)->getOffset();
+    span.length = (*i)->getLength();
+    files_.push_back(span);
+  }
+}
+
+PieceHashJob::~PieceHashJob() {}
+
+void PieceHashJob::execute()
+{
+  array_ptr<unsigned char> buf(new unsigned char[BUFSIZE]);
+  // Files are opened when they are read first and kept open until all
+  // pieces are hashed.
+  std::vector<SharedHandle<DiskWriter> > writers(files_.size());
+  for(size_t i = index_; i < index_+numPieces_; ++i) {
+    try {
+      hashPiece(i, buf, BUFSIZE, writers);
+    } catch(Exception& e) {
+      digests_[i-index_].clear();
+      errors_[i-index_] = e.what();
+    }
+  }
+}
+
+void PieceHashJob::hashPiece
+(size_t index, unsigned char* buf, size_t bufSize,
+ std::vector<SharedHandle<DiskWriter> >& writers)
+{
+  SharedHandle<MessageDigest> ctx = MessageDigest::create(hashType_);
+  off_t offset = static_cast<off_t>(index)*pieceLength_;
+  off_t max = std::min(offset+static_cast<off_t>(pieceLength_),
+                       static_cast<off_t>(totalLength_));
+  size_t fi = 0;
+  while(offset < max) {
+    for(; fi < files_.size() &&
+          files_[fi].offset+static_cast<off_t>(files_[fi].length) <= offset;
+        ++fi);
+    if(fi == files_.size() || offset < files_[fi].offset) {
+      throw DL_ABORT_EX(fmt("No file contains offset %lld",
+                            static_cast<long long int>(offset)));
+    }
+    const FileSpan& file = files_[fi];
+    if(!writers[fi]) {
+      SharedHandle<DiskWriter> dw(new DefaultDiskWriter(file.path));
+      dw->enableReadOnly();
+      dw->openExistingFile();
+      writers[fi] = dw;
+    }
+    off_t fileMax = std::min(max, file.offset+
+                             static_cast<off_t>(file.length));
+    while(offset < fileMax) {
+      size_t r = writers[fi]->readData
+        (buf, std::min(static_cast<off_t>(bufSize), fileMax-offset),
+         offset-file.offset);
+      if(r == 0) {
+        throw DL_ABORT_EX(fmt(EX_FILE_READ, file.path.c_str(),
+                              "data is too short"));
+      }
+      ctx->update(buf, r);
+      offset += r;
+    }
+  }
+  digests_[index-index_] = ctx->digest();
+}
+
+} // namespace aria2
@@ -0,0 +1,113 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_PIECE_HASH_JOB_H
+#define D_PIECE_HASH_JOB_H
+
+#include "ThreadJob.h"
+
+#include <string>
+#include <vector>
+
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+class DownloadContext;
+class FileEntry;
+class DiskWriter;
+
+// Calculates the hashes of the consecutive pieces in a worker thread.
+// The files are read through the file descriptors opened by this job
+// because DiskAdaptor is not thread-safe.
+class PieceHashJob:public ThreadJob {
+public:
+  struct FileSpan {
+    std::string path;
+    off_t offset;
+    uint64_t length;
+  };
+private:
+  std::vector<FileSpan> files_;
+  std::string hashType_;
+  size_t pieceLength_;
+  uint64_t totalLength_;
+  size_t index_;
+  size_t numPieces_;
+  // Written in the worker thread. The hash of the piece which cannot
+  // be read is left empty.
+  std::vector<std::string> digests_;
+  std::vector<std::string> errors_;
+
+  void hashPiece(size_t index, unsigned char* buf, size_t bufSize,
+                 std::vector<SharedHandle<DiskWriter> >& writers);
+public:
+  // Hashes numPieces pieces from index-th piece of dctx.
+  PieceHashJob(const SharedHandle<DownloadContext>& dctx,
+               const std::vector<SharedHandle<FileEntry> >& fileEntries,
+               size_t index, size_t numPieces);
+
+  virtual ~PieceHashJob();
+
+  virtual void execute();
+
+  size_t getIndex() const
+  {
+    return index_;
+  }
+
+  size_t getNumPieces() const
+  {
+    return numPieces_;
+  }
+
+  // Returns the hash of index-th piece. Empty string means the piece
+  // could not be read and getError() tells why.
+  const std::string& getDigest(size_t index) const
+  {
+    return digests_[index-index_];
+  }
+
+  const std::string& getError(size_t index) const
+  {
+    return errors_[index-index_];
+  }
+
+  // The size of the buffer used to read files.
+  static const size_t BUFSIZE = 256*1024;
+};
+
+} // namespace aria2
+
+#endif // D_PIECE_HASH_JOB_H
@@ -38,13 +38,15 @@
 #include <algorithm>
 
 #include "SimpleRandomizer.h"
-#include "bitfield.h"
 
 namespace aria2 {
 
 PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle):
   order_(pieceNum),
-  counts_(pieceNum)
+  pos_(pieceNum),
+  counts_(pieceNum),
+  bucketStart_(1, 0),
+  randomShuffle_(randomShuffle)
 {
   for(size_t i = 0; i < pieceNum; ++i) {
     order_[i] = i;
@@ -54,34 +56,84 @@ PieceStatMan::PieceStatMan(size_t pieceNum, bool randomShuffle):
     std::random_shuffle(order_.begin(), order_.end(),
                         *(SimpleRandomizer::getInstance().get()));
   }
+  for(size_t i = 0; i < pieceNum; ++i) {
+    pos_[order_[i]] = i;
+  }
 }
 
 PieceStatMan::~PieceStatMan() {}
 
 namespace {
-void inc(int& x)
+void swapPieces
+(std::vector<size_t>& order, std::vector<size_t>& pos, size_t a, size_t b)
 {
-  if(x < std::numeric_limits<int>::max()) {
-    ++x;
-  }
+  size_t x = order[a];
+  size_t y = order[b];
+  order[a] = y;
+  order[b] = x;
+  pos[y] = a;
+  pos[x] = b;
 }
 } // namespace
 
-namespace {
-void sub(int& x)
+void PieceStatMan::shuffleIntoBucket(size_t pos, size_t first, size_t last)
 {
-  if(x > 0) {
-    --x;
+  // Moving a piece always to the bucket boundary would sort the pieces
+  // with the same count by the order of their count changes. Swap it
+  // with a random piece of the bucket to keep the ties random.
+  if(randomShuffle_ && last-first > 1) {
+    swapPieces(order_, pos_, pos,
+               first+SimpleRandomizer::getInstance()->getRandomNumber
+               (last-first));
   }
 }
-} // namespace
+
+void PieceStatMan::inc(size_t index)
+{
+  int c = counts_[index];
+  if(c == std::numeric_limits<int>::max()) {
+    return;
+  }
+  if(bucketStart_.size() < static_cast<size_t>(c)+2) {
+    bucketStart_.resize(c+2, order_.size());
+  }
+  // Move the piece to the back of its bucket, which then becomes the
+  // front of the next bucket.
+  swapPieces(order_, pos_, pos_[index], bucketStart_[c+1]-1);
+  --bucketStart_[c+1];
+  ++counts_[index];
+  size_t last = bucketStart_.size() > static_cast<size_t>(c)+2 ?
+    bucketStart_[c+2] : order_.size();
+  shuffleIntoBucket(bucketStart_[c+1], bucketStart_[c+1], last);
+}
+
+void PieceStatMan::dec(size_t index)
+{
+  int c = counts_[index];
+  if(c == 0) {
+    return;
+  }
+  // Move the piece to the front of its bucket, which then becomes the
+  // back of the previous bucket.
+  swapPieces(order_, pos_, pos_[index], bucketStart_[c]);
+  ++bucketStart_[c];
+  --counts_[index];
+  shuffleIntoBucket(bucketStart_[c]-1, bucketStart_[c-1], bucketStart_[c]);
+}
 
 void PieceStatMan::addPieceStats(const unsigned char* bitfield,
                                  size_t bitfieldLength)
 {
-  for(size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    if(bitfield::test(bitfield, nbits, i)) {
-      inc(counts_[i]);
+  size_t nbits = counts_.size();
+  bitfieldLength = std::min(bitfieldLength, (nbits+7)/8);
+  for(size_t i = 0; i < bitfieldLength; ++i) {
+    if(bitfield[i] == 0) {
+      continue;
+    }
+    for(size_t j = 0, index = i*8; j < 8 && index < nbits; ++j, ++index) {
+      if(bitfield[i]&(0x80u >> j)) {
+        inc(index);
+      }
     }
   }
 }
@@ -89,9 +141,16 @@ void PieceStatMan::addPieceStats(const unsigned char* bitfield,
 void PieceStatMan::subtractPieceStats(const unsigned char* bitfield,
                                       size_t bitfieldLength)
 {
-  for(size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    if(bitfield::test(bitfield, nbits, i)) {
-      sub(counts_[i]);
+  size_t nbits = counts_.size();
+  bitfieldLength = std::min(bitfieldLength, (nbits+7)/8);
+  for(size_t i = 0; i < bitfieldLength; ++i) {
+    if(bitfield[i] == 0) {
+      continue;
+    }
+    for(size_t j = 0, index = i*8; j < 8 && index < nbits; ++j, ++index) {
+      if(bitfield[i]&(0x80u >> j)) {
+        dec(index);
+      }
     }
   }
 }
@@ -100,22 +159,29 @@ void PieceStatMan::updatePieceStats(const unsigned char* newBitfield,
                                     size_t newBitfieldLength,
                                     const unsigned char* oldBitfield)
 {
-  for(size_t i = 0, nbits = counts_.size(); i < nbits; ++i) {
-    bool inNew = bitfield::test(newBitfield, nbits, i);
-    bool inOld = bitfield::test(oldBitfield, nbits, i);
-    if(inNew) {
-      if(!inOld) {
-        inc(counts_[i]);
+  size_t nbits = counts_.size();
+  size_t bitfieldLength = std::min(newBitfieldLength, (nbits+7)/8);
+  for(size_t i = 0; i < bitfieldLength; ++i) {
+    unsigned char diff = newBitfield[i]^oldBitfield[i];
+    if(diff == 0) {
+      continue;
+    }
+    for(size_t j = 0, index = i*8; j < 8 && index < nbits; ++j, ++index) {
+      unsigned char mask = 0x80u >> j;
+      if(diff&mask) {
+        if(newBitfield[i]&mask) {
+          inc(index);
+        } else {
+          dec(index);
+        }
       }
-    } else if(inOld) {
-      sub(counts_[i]);
     }
   }
 }
 
 void PieceStatMan::addPieceStats(size_t index)
 {
-  inc(counts_[index]);
+  inc(index);
 }
 
 } // namespace aria2
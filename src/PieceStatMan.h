@@ -43,10 +43,31 @@
 
 namespace aria2 {
 
+// Keeps the number of peers which have each piece. The piece indexes
+// are kept sorted in ascending order of the count, and the pieces
+// with the same count are grouped in a bucket, so that a change of
+// a count is done by one swap at a bucket boundary.
 class PieceStatMan {
 private:
+  // Piece indexes sorted in ascending order of counts_.
   std::vector<size_t> order_;
+  // The position of each piece in order_.
+  std::vector<size_t> pos_;
   std::vector<int> counts_;
+  // bucketStart_[c] is the position in order_ of the first piece
+  // whose count is c or more. The positions beyond the back are equal
+  // to order_.size().
+  std::vector<size_t> bucketStart_;
+  // If true, the pieces with the same count are kept in random order.
+  bool randomShuffle_;
+
+  // Swaps the piece at pos, which was just moved into the bucket
+  // [first, last), with a random piece of the bucket.
+  void shuffleIntoBucket(size_t pos, size_t first, size_t last);
+
+  void inc(size_t index);
+
+  void dec(size_t index);
 public:
   PieceStatMan(size_t pieceNum, bool randomShuffle);
 
@@ -64,11 +85,20 @@ public:
                         size_t newBitfieldLength,
                         const unsigned char* oldBitfield);
 
+  // Returns piece indexes sorted in ascending order of count. The
+  // order among the pieces with the same count is random if
+  // randomShuffle is true in the constructor.
   const std::vector<size_t>& getOrder() const
   {
     return order_;
   }
 
+  // Returns the position of each piece in getOrder().
+  const std::vector<size_t>& getPositions() const
+  {
+    return pos_;
+  }
+
   const std::vector<int>& getCounts() const
   {
     return counts_;
@@ -49,8 +49,10 @@ namespace aria2 {
 class Piece;
 #ifdef ENABLE_BITTORRENT
 class Peer;
+class SuperSeeder;
 #endif // ENABLE_BITTORRENT
 class DiskAdaptor;
+class DeadlinePieceSelector;
 
 class PieceStorage {
 public:
@@ -127,6 +129,10 @@ public:
   (const SharedHandle<Peer>& peer,
    const std::vector<size_t>& excludedIndexes,
    cuid_t cuid) = 0;
+
+  // Returns the super-seeding state, or null if super-seeding is
+  // disabled.
+  virtual SharedHandle<SuperSeeder> getSuperSeeder() = 0;
 #endif // ENABLE_BITTORRENT
 
   // Returns true if there is at least one missing and unused piece.
@@ -142,6 +148,17 @@ public:
    size_t length,
    cuid_t cuid) = 0;
 
+  // Same as getMissingPiece(minSplitSize, ignoreBitfield, length,
+  // cuid), but speed is the download speed of the connection in bytes
+  // per second. It is used to select pieces by deadline when the
+  // playback position is set by setPlayback().
+  virtual SharedHandle<Piece> getMissingPiece
+  (size_t minSplitSize,
+   const unsigned char* ignoreBitfield,
+   size_t length,
+   cuid_t cuid,
+   unsigned int speed) = 0;
+
   /**
    * Returns a missing piece whose index is index.
    * If a piece whose index is index is already acquired or currently used,
@@ -237,18 +254,21 @@ public:
   virtual void advertisePiece(cuid_t cuid, size_t index) = 0;
 
   /**
-   * indexes is filled with piece index which is not advertised by the caller
-   * command and newer than lastCheckTime.
+   * Each advertised piece is given a sequence number. indexes is
+   * filled with piece index advertised at or after the sequence
+   * number cursor, except the ones advertised by the caller command,
+   * and cursor is moved past them. Returns false if some of them are
+   * no longer kept. Then indexes is not filled, and the caller should
+   * send the whole bitfield instead.
    */
-  virtual void getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
+  virtual bool getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
                                          cuid_t myCuid,
-                                         const Timer& lastCheckTime) = 0;
+                                         uint64_t& cursor) = 0;
 
   /**
-   * Removes have entry if specified seconds have elapsed since its
-   * registration.
+   * Returns the sequence number the next advertised piece gets.
    */
-  virtual void removeAdvertisedPiece(time_t elapsed) = 0;
+  virtual uint64_t getAdvertisedPieceCursor() = 0;
 
   /**
    * Sets all bits in bitfield to 1.
@@ -286,6 +306,23 @@ public:
 
   // Called when system detects download is not finished
   virtual void onDownloadIncomplete() = 0;
+
+  // Writes the data held in the write disk cache for in-flight pieces
+  // to the disk.
+  virtual void flushWrDiskCacheEntry() = 0;
+
+  // Same as flushWrDiskCacheEntry() but also deletes the cache
+  // entries. Call this before the files are closed.
+  virtual void releaseWrDiskCacheEntry() = 0;
+
+  // Tells that a media player plays the download from position at
+  // bitrate bytes per second. After this call, pieces are selected by
+  // the time the player needs them.
+  virtual void setPlayback(uint64_t position, unsigned int bitrate) = 0;
+
+  // Returns the selector set up by setPlayback(), or null if
+  // setPlayback() has not been called.
+  virtual SharedHandle<DeadlinePieceSelector> getDeadlinePieceSelector() = 0;
 };
 
 typedef SharedHandle<PieceStorage> PieceStorageHandle;
@@ -105,7 +105,7 @@ void PollEventPoll::poll(const struct timeval& tv)
           std::lower_bound(socketEntries_.begin(), socketEntries_.end(), se,
                            DerefLess<SharedHandle<KSocketEntry> >());
         if(itr != socketEntries_.end() && *(*itr) == *se) {
-          (*itr)->processEvents(first->revents);
+          (*itr)->processEvents(first->revents, getReadyCommands());
         } else {
           A2_LOG_DEBUG(fmt("Socket %d is not found in SocketEntries.",
                            first->fd));
@@ -120,7 +120,7 @@ void PortEventPoll::poll(const struct timeval& tv)
     for(uint_t i = 0; i < nget; ++i) {
       const port_event_t& pev = portEvents_[i];
       KSocketEntry* p = reinterpret_cast<KSocketEntry*>(pev.portev_user);
-      p->processEvents(pev.portev_events);
+      p->processEvents(pev.portev_events, getReadyCommands());
       int r = port_associate(port_, PORT_SOURCE_FD, pev.portev_object,
                              p->getEvents().events, p);
       int errNum = errno;
@@ -34,11 +34,7 @@
 /* copyright --> */
 #include "RarestPieceSelector.h"
 
-#include <limits>
-#include <algorithm>
-
 #include "PieceStatMan.h"
-#include "bitfield.h"
 
 namespace aria2 {
 
@@ -48,23 +44,27 @@ RarestPieceSelector::RarestPieceSelector
 bool RarestPieceSelector::select
 (size_t& index, const unsigned char* bitfield, size_t nbits) const
 {
-  const std::vector<size_t>& order = pieceStatMan_->getOrder();
-  const std::vector<int>& counts = pieceStatMan_->getCounts();
-  int min = std::numeric_limits<int>::max();
-  size_t bestIdx = nbits;
-  for(size_t i = 0; i < nbits; ++i) {
-    size_t idx = order[i];
-    if(bitfield::test(bitfield, nbits, idx) && counts[idx] < min) {
-      min = counts[idx];
-      bestIdx = idx;
+  // The order is sorted by the number of peers which have the piece
+  // and the ties are in random order, so the candidate at the lowest
+  // position is the rarest one. Only the set bits of bitfield are
+  // examined, so that the pieces which are not candidates, for
+  // example, the pieces already downloaded, cost nothing but a zero
+  // byte check.
+  const std::vector<size_t>& pos = pieceStatMan_->getPositions();
+  size_t bestPos = pos.size();
+  size_t bitfieldLength = (nbits+7)/8;
+  for(size_t i = 0; i < bitfieldLength; ++i) {
+    if(bitfield[i] == 0) {
+      continue;
+    }
+    for(size_t j = 0, idx = i*8; j < 8 && idx < nbits; ++j, ++idx) {
+      if((bitfield[i]&(0x80u >> j)) && pos[idx] < bestPos) {
+        bestPos = pos[idx];
+        index = idx;
+      }
     }
   }
-  if(bestIdx == nbits) {
-    return false;
-  } else {
-    index = bestIdx;
-    return true;
-  }
+  return bestPos != pos.size();
 }
 
 } // namespace aria2
@@ -214,6 +214,7 @@ error_code::Value RequestGroup::downloadResult() const
 void RequestGroup::closeFile()
 {
   if(pieceStorage_) {
+    pieceStorage_->releaseWrDiskCacheEntry();
     pieceStorage_->getDiskAdaptor()->closeFile();
   }
 }
@@ -634,6 +635,10 @@ void RequestGroup::initPieceStorage()
     if(diskWriterFactory_) {
       ps->setDiskWriterFactory(diskWriterFactory_);
     }
+    if(requestGroupMan_) {
+      ps->setWrDiskCache(requestGroupMan_->getWrDiskCache());
+      ps->setOpenedFileCache(requestGroupMan_->getOpenedFileCache());
+    }
     tempPieceStorage.swap(psHolder);
   } else {
     UnknownLengthPieceStorage* ps =
@@ -1025,9 +1030,6 @@ void RequestGroup::releaseRuntimeResource(DownloadEngine* e)
   btRuntime_ = 0;
   peerStorage_ = 0;
 #endif // ENABLE_BITTORRENT
-  if(pieceStorage_) {
-    pieceStorage_->removeAdvertisedPiece(0);
-  }
   // Don't reset segmentMan_ and pieceStorage_ here to provide
   // progress information via RPC
   progressInfoFile_.reset();
@@ -1298,6 +1300,11 @@ bool RequestGroup::doesUploadSpeedExceed()
 void RequestGroup::saveControlFile() const
 {
   if(saveControlFile_) {
+    if(pieceStorage_) {
+      // The control file must not claim the data which are still in
+      // the write disk cache.
+      pieceStorage_->flushWrDiskCacheEntry();
+    }
     progressInfoFile_->save();
   }
 }
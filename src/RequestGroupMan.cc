@@ -74,14 +74,41 @@
 #include "Triplet.h"
 #include "Signature.h"
 #include "OutputFile.h"
+#include "WrDiskCache.h"
+#include "OpenedFileCache.h"
 
 namespace aria2 {
 
+namespace {
+SharedHandle<WrDiskCache> createWrDiskCache(const Option* option)
+{
+  SharedHandle<WrDiskCache> wrDiskCache;
+  int64_t limit = option->getAsLLInt(PREF_DISK_CACHE);
+  if(limit > 0) {
+    wrDiskCache.reset(new WrDiskCache(limit));
+  }
+  return wrDiskCache;
+}
+} // namespace
+
+namespace {
+SharedHandle<OpenedFileCache> createOpenedFileCache(const Option* option)
+{
+  size_t maxOpenFiles = OpenedFileCache::DEFAULT_MAX_OPEN_FILES;
+  if(option->defined(PREF_BT_MAX_OPEN_FILES)) {
+    maxOpenFiles = option->getAsInt(PREF_BT_MAX_OPEN_FILES);
+  }
+  return SharedHandle<OpenedFileCache>(new OpenedFileCache(maxOpenFiles));
+}
+} // namespace
+
 RequestGroupMan::RequestGroupMan
 (const std::vector<SharedHandle<RequestGroup> >& requestGroups,
  unsigned int maxSimultaneousDownloads,
  const Option* option)
-  : reservedGroups_(requestGroups.begin(), requestGroups.end()),
+  : wrDiskCache_(createWrDiskCache(option)),
+    openedFileCache_(createOpenedFileCache(option)),
+    reservedGroups_(requestGroups.begin(), requestGroups.end()),
     maxSimultaneousDownloads_(maxSimultaneousDownloads),
     option_(option),
     serverStatMan_(new ServerStatMan()),
@@ -98,6 +125,11 @@ RequestGroupMan::RequestGroupMan
 
 RequestGroupMan::~RequestGroupMan() {}
 
+void RequestGroupMan::setMaxOpenFiles(size_t maxOpenFiles)
+{
+  openedFileCache_->setMaxOpenFiles(maxOpenFiles);
+}
+
 bool RequestGroupMan::downloadFinished()
 {
   if(rpc_) {
@@ -325,7 +357,13 @@ public:
           group->applyLastModifiedTimeToLocalFiles();
           group->reportDownloadFinished();
           if(group->allDownloadFinished()) {
-            group->removeControlFile();
+            if(group->getOption()->getAsBool(PREF_FAST_RESUME)) {
+              // Keep the control file so that the next hash check can
+              // skip unchanged files.
+              group->saveControlFile();
+            } else {
+              group->removeControlFile();
+            }
             saveSignature(group);
           } else {
             group->saveControlFile();
@@ -539,8 +577,9 @@ void RequestGroupMan::save()
 {
   for(std::deque<SharedHandle<RequestGroup> >::const_iterator itr =
         requestGroups_.begin(), eoi = requestGroups_.end(); itr != eoi; ++itr) {
-    if((*itr)->allDownloadFinished() && 
-       !(*itr)->getDownloadContext()->isChecksumVerificationNeeded()) {
+    if((*itr)->allDownloadFinished() &&
+       !(*itr)->getDownloadContext()->isChecksumVerificationNeeded() &&
+       !(*itr)->getOption()->getAsBool(PREF_FAST_RESUME)) {
       (*itr)->removeControlFile();
     } else {
       try {
@@ -55,9 +55,15 @@ class ServerStatMan;
 class ServerStat;
 class Option;
 class OutputFile;
+class WrDiskCache;
+class OpenedFileCache;
 
 class RequestGroupMan {
 private:
+  // Declared before requestGroups_ so that it outlives the pieces
+  // which hold entries in it.
+  SharedHandle<WrDiskCache> wrDiskCache_;
+  SharedHandle<OpenedFileCache> openedFileCache_;
   std::deque<SharedHandle<RequestGroup> > requestGroups_;
   std::deque<SharedHandle<RequestGroup> > reservedGroups_;
   std::deque<SharedHandle<DownloadResult> > downloadResults_;
@@ -300,6 +306,21 @@ public:
   // Returns currently used hosts and its use count.
   void getUsedHosts(std::vector<std::pair<size_t, std::string> >& usedHosts);
 
+  // Returns 0 if write disk cache is disabled.
+  WrDiskCache* getWrDiskCache() const
+  {
+    return wrDiskCache_.get();
+  }
+
+  // Cache of files opened by multi-file downloads, shared by all
+  // downloads.
+  const SharedHandle<OpenedFileCache>& getOpenedFileCache() const
+  {
+    return openedFileCache_;
+  }
+
+  void setMaxOpenFiles(size_t maxOpenFiles);
+
   const SharedHandle<ServerStatMan>& getServerStatMan() const
   {
     return serverStatMan_;
@@ -49,6 +49,9 @@ private:
   uint32_t begin_;
   size_t length_;
   size_t blockIndex_;
+  // The number of bytes received from the peer when this request was
+  // dispatched. Used to measure the round trip time.
+  uint64_t sessionDownloadLength_;
 
   // This is the piece whose index is index of this RequestSlot has.
   // To detect duplicate RequestSlot, we have to find the piece using
@@ -65,6 +68,7 @@ private:
     begin_ = requestSlot.begin_;
     length_ = requestSlot.length_;
     blockIndex_ = requestSlot.blockIndex_;
+    sessionDownloadLength_ = requestSlot.sessionDownloadLength_;
     piece_ = requestSlot.piece_;
   }
 public:
@@ -73,6 +77,7 @@ public:
               const SharedHandle<Piece>& piece = SharedHandle<Piece>()):
     dispatchedTime_(global::wallclock()),
     index_(index), begin_(begin), length_(length), blockIndex_(blockIndex),
+    sessionDownloadLength_(0),
     piece_(piece) {}
 
   RequestSlot(const RequestSlot& requestSlot):
@@ -81,10 +86,11 @@ public:
     begin_(requestSlot.begin_),
     length_(requestSlot.length_),
     blockIndex_(requestSlot.blockIndex_),
+    sessionDownloadLength_(requestSlot.sessionDownloadLength_),
     piece_(requestSlot.piece_) {}
 
   RequestSlot():dispatchedTime_(0), index_(0), begin_(0), length_(0),
-                blockIndex_(0)
+                blockIndex_(0), sessionDownloadLength_(0)
   {}
 
   ~RequestSlot() {}
@@ -121,6 +127,21 @@ public:
 
   bool isTimeout(time_t timeoutSec) const;
 
+  const Timer& getDispatchedTime() const
+  {
+    return dispatchedTime_;
+  }
+
+  uint64_t getSessionDownloadLength() const
+  {
+    return sessionDownloadLength_;
+  }
+
+  void setSessionDownloadLength(uint64_t length)
+  {
+    sessionDownloadLength_ = length;
+  }
+
   size_t getIndex() const { return index_; }
   void setIndex(size_t index) { index_ = index; }
 
@@ -83,6 +83,8 @@ createMethod(const std::string& methodName)
     return SharedHandle<RpcMethod>(new ForceRemoveRpcMethod());
   } else if(methodName == ChangePositionRpcMethod::getMethodName()) {
     return SharedHandle<RpcMethod>(new ChangePositionRpcMethod());
+  } else if(methodName == ChangePlaybackRpcMethod::getMethodName()) {
+    return SharedHandle<RpcMethod>(new ChangePlaybackRpcMethod());
   } else if(methodName == TellStatusRpcMethod::getMethodName()) {
     return SharedHandle<RpcMethod>(new TellStatusRpcMethod());
   } else if(methodName == GetUrisRpcMethod::getMethodName()) {
@@ -126,6 +128,8 @@ createMethod(const std::string& methodName)
     return SharedHandle<RpcMethod>(new ForceShutdownRpcMethod());
   } else if(methodName == GetGlobalStatRpcMethod::getMethodName()) {
     return SharedHandle<RpcMethod>(new GetGlobalStatRpcMethod());
+  } else if(methodName == GetEngineStatsRpcMethod::getMethodName()) {
+    return SharedHandle<RpcMethod>(new GetEngineStatsRpcMethod());
   } else if(methodName == SystemMulticallRpcMethod::getMethodName()) {
     return SharedHandle<RpcMethod>(new SystemMulticallRpcMethod());
   } else {
@@ -37,6 +37,7 @@
 #include <cassert>
 #include <algorithm>
 #include <sstream>
+#include <limits>
 
 #include "Logger.h"
 #include "LogFactory.h"
@@ -66,6 +67,9 @@
 #include "PeerStat.h"
 #include "base64.h"
 #include "BitfieldMan.h"
+#include "CommandStatMan.h"
+#include "OpenedFileCache.h"
+#include "DeadlinePieceSelector.h"
 #ifdef ENABLE_MESSAGE_DIGEST
 # include "MessageDigest.h"
 # include "message_digest_helper.h"
@@ -143,6 +147,22 @@ const std::string KEY_SERVERS = "servers";
 const std::string KEY_NUM_WAITING = "numWaiting";
 const std::string KEY_NUM_STOPPED = "numStopped";
 const std::string KEY_NUM_ACTIVE = "numActive";
+const std::string KEY_COMMANDS = "commands";
+const std::string KEY_COUNT = "count";
+const std::string KEY_TOTAL_TIME = "totalTime";
+const std::string KEY_MAX_TIME = "maxTime";
+const std::string KEY_HISTOGRAM = "histogram";
+const std::string KEY_FILE_CACHE = "fileCache";
+const std::string KEY_NUM_OPEN = "numOpen";
+const std::string KEY_MAX_OPEN = "maxOpen";
+const std::string KEY_HITS = "hits";
+const std::string KEY_MISSES = "misses";
+const std::string KEY_PLAYBACK_POSITION = "playbackPosition";
+const std::string KEY_BUFFERED_AHEAD = "bufferedAhead";
+const std::string KEY_REQUEST_QUEUE_SIZE = "requestQueueSize";
+const std::string KEY_OUTSTANDING_REQUESTS = "outstandingRequests";
+const std::string KEY_REQQ = "reqq";
+const std::string KEY_RTT = "rtt";
 } // namespace
 
 namespace {
@@ -693,6 +713,20 @@ void gatherProgressCommon
   if(requested_key(keys, KEY_NUM_PIECES)) {
     entryDict->put(KEY_NUM_PIECES, util::uitos(dctx->getNumPieces()));
   }
+  if(ps) {
+    SharedHandle<DeadlinePieceSelector> selector =
+      ps->getDeadlinePieceSelector();
+    if(selector) {
+      if(requested_key(keys, KEY_PLAYBACK_POSITION)) {
+        entryDict->put(KEY_PLAYBACK_POSITION,
+                       util::uitos(selector->getPlaybackPosition()));
+      }
+      if(requested_key(keys, KEY_BUFFERED_AHEAD)) {
+        entryDict->put(KEY_BUFFERED_AHEAD,
+                       util::uitos(selector->getBufferedAhead()));
+      }
+    }
+  }
   if(requested_key(keys, KEY_FOLLOWED_BY)) {
     if(!group->followedBy().empty()) {
       SharedHandle<List> list = List::g();
@@ -805,10 +839,20 @@ void gatherPeer
                    util::toHex((*i)->getBitfield(), (*i)->getBitfieldLength()));
     peerEntry->put(KEY_AM_CHOKING, (*i)->amChoking()?VLB_TRUE:VLB_FALSE);
     peerEntry->put(KEY_PEER_CHOKING, (*i)->peerChoking()?VLB_TRUE:VLB_FALSE);
-    TransferStat stat = ps->getTransferStatFor(*i);
-    peerEntry->put(KEY_DOWNLOAD_SPEED, util::uitos(stat.getDownloadSpeed()));
-    peerEntry->put(KEY_UPLOAD_SPEED, util::uitos(stat.getUploadSpeed()));
+    peerEntry->put(KEY_DOWNLOAD_SPEED,
+                   util::uitos((*i)->calculateDownloadRate()));
+    peerEntry->put(KEY_UPLOAD_SPEED, util::uitos((*i)->calculateUploadRate()));
     peerEntry->put(KEY_SEEDER, (*i)->isSeeder()?VLB_TRUE:VLB_FALSE);
+    peerEntry->put(KEY_REQUEST_QUEUE_SIZE,
+                   util::uitos((*i)->getRequestQueueSize()));
+    peerEntry->put(KEY_OUTSTANDING_REQUESTS,
+                   util::uitos((*i)->countOutstandingRequest()));
+    if((*i)->getReqq()) {
+      peerEntry->put(KEY_REQQ, util::uitos((*i)->getReqq()));
+    }
+    if((*i)->getRtt() >= 0) {
+      peerEntry->put(KEY_RTT, util::itos((*i)->getRtt()));
+    }
     peers->append(peerEntry);
   }
 }
@@ -1246,6 +1290,10 @@ SharedHandle<ValueBase> ChangeGlobalOptionRpcMethod::process
     e->getRequestGroupMan()->setMaxDownloadResult
       (option.getAsInt(PREF_MAX_DOWNLOAD_RESULT));
   }
+  if(option.defined(PREF_BT_MAX_OPEN_FILES)) {
+    e->getRequestGroupMan()->setMaxOpenFiles
+      (option.getAsInt(PREF_BT_MAX_OPEN_FILES));
+  }
   if(option.defined(PREF_LOG_LEVEL)) {
     LogFactory::setLogLevel(option.get(PREF_LOG_LEVEL));
   }
@@ -1356,6 +1404,28 @@ SharedHandle<ValueBase> ChangePositionRpcMethod::process
   return result;
 }
 
+SharedHandle<ValueBase> ChangePlaybackRpcMethod::process
+(const RpcRequest& req, DownloadEngine* e)
+{
+  const String* gidParam = checkRequiredParam<String>(req, 0);
+  const Integer* posParam = checkRequiredParam<Integer>(req, 1);
+  const Integer* bitrateParam = checkRequiredParam<Integer>(req, 2);
+
+  a2_gid_t gid = str2Gid(gidParam);
+  if(posParam->i() < 0 || bitrateParam->i() <= 0 ||
+     bitrateParam->i() > std::numeric_limits<int32_t>::max()) {
+    throw DL_ABORT_EX("Illegal argument.");
+  }
+  SharedHandle<RequestGroup> group =
+    e->getRequestGroupMan()->findRequestGroup(gid);
+  if(!group || !group->getPieceStorage()) {
+    throw DL_ABORT_EX(fmt("No active download for GID#%s",
+                          util::itos(gid).c_str()));
+  }
+  group->getPieceStorage()->setPlayback(posParam->i(), bitrateParam->i());
+  return VLB_OK;
+}
+
 SharedHandle<ValueBase> GetSessionInfoRpcMethod::process
 (const RpcRequest& req, DownloadEngine* e)
 {
@@ -1508,6 +1578,46 @@ SharedHandle<ValueBase> GetGlobalStatRpcMethod::process
   return res;
 }
 
+SharedHandle<ValueBase> GetEngineStatsRpcMethod::process
+(const RpcRequest& req, DownloadEngine* e)
+{
+  SharedHandle<Dict> res = Dict::g();
+  // Command statistics are recorded only if --enable-engine-stats is
+  // given. The other statistics are always available.
+  const SharedHandle<CommandStatMan>& statMan = e->getCommandStatMan();
+  if(statMan) {
+    std::vector<std::pair<std::string, CommandStat> > stats;
+    statMan->getStats(stats);
+    SharedHandle<List> commands = List::g();
+    for(std::vector<std::pair<std::string, CommandStat> >::const_iterator i =
+          stats.begin(), eoi = stats.end(); i != eoi; ++i) {
+      const CommandStat& stat = (*i).second;
+      SharedHandle<Dict> entry = Dict::g();
+      entry->put(KEY_NAME, (*i).first);
+      entry->put(KEY_COUNT, util::uitos(stat.getCount()));
+      entry->put(KEY_TOTAL_TIME, util::uitos(stat.getTotalTime()));
+      entry->put(KEY_MAX_TIME, util::uitos(stat.getMaxTime()));
+      SharedHandle<List> histogram = List::g();
+      for(size_t j = 0; j < CommandStat::NUM_BUCKETS; ++j) {
+        histogram->append(util::uitos(stat.getBucket(j)));
+      }
+      entry->put(KEY_HISTOGRAM, histogram);
+      commands->append(entry);
+    }
+    res->put(KEY_COMMANDS, commands);
+  }
+  const SharedHandle<OpenedFileCache>& openedFileCache =
+    e->getRequestGroupMan()->getOpenedFileCache();
+  SharedHandle<Dict> fileCache = Dict::g();
+  fileCache->put(KEY_NUM_OPEN, util::uitos(openedFileCache->countOpenFile()));
+  fileCache->put(KEY_MAX_OPEN,
+                 util::uitos(openedFileCache->getMaxOpenFiles()));
+  fileCache->put(KEY_HITS, util::uitos(openedFileCache->getHits()));
+  fileCache->put(KEY_MISSES, util::uitos(openedFileCache->getMisses()));
+  res->put(KEY_FILE_CACHE, fileCache);
+  return res;
+}
+
 SharedHandle<ValueBase> SystemMulticallRpcMethod::process
 (const RpcRequest& req, DownloadEngine* e)
 {
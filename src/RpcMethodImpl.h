@@ -509,6 +509,18 @@ public:
   }
 };
 
+class ChangePlaybackRpcMethod:public RpcMethod {
+protected:
+  virtual SharedHandle<ValueBase> process
+  (const RpcRequest& req, DownloadEngine* e);
+public:
+  static const std::string& getMethodName()
+  {
+    static std::string methodName = "aria2.changePlayback";
+    return methodName;
+  }
+};
+
 class ChangeUriRpcMethod:public RpcMethod {
 protected:
   virtual SharedHandle<ValueBase> process
@@ -557,6 +569,18 @@ public:
   }
 };
 
+class GetEngineStatsRpcMethod:public RpcMethod {
+protected:
+  virtual SharedHandle<ValueBase> process
+  (const RpcRequest& req, DownloadEngine* e);
+public:
+  static const std::string& getMethodName()
+  {
+    static std::string methodName = "aria2.getEngineStats";
+    return methodName;
+  }
+};
+
 class ForceShutdownRpcMethod:public RpcMethod {
 protected:
   virtual SharedHandle<ValueBase> process
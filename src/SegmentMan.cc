@@ -177,7 +177,7 @@ SharedHandle<Segment> SegmentMan::getSegment(cuid_t cuid, size_t minSplitSize)
     pieceStorage_->getMissingPiece
     (minSplitSize,
      ignoreBitfield_.getFilterBitfield(), ignoreBitfield_.getBitfieldLength(),
-     cuid);
+     cuid, getDownloadSpeed(cuid));
   return checkoutSegment(cuid, piece);
 }
 
@@ -198,7 +198,7 @@ void SegmentMan::getSegment
                       pieceStorage_->getMissingPiece
                       (minSplitSize,
                        filter.getFilterBitfield(), filter.getBitfieldLength(),
-                       cuid));
+                       cuid, getDownloadSpeed(cuid)));
     if(!segment) {
       break;
     }
@@ -373,6 +373,16 @@ SharedHandle<PeerStat> SegmentMan::getPeerStat(cuid_t cuid) const
   return SharedHandle<PeerStat>();
 }
 
+unsigned int SegmentMan::getDownloadSpeed(cuid_t cuid) const
+{
+  SharedHandle<PeerStat> peerStat = getPeerStat(cuid);
+  if(peerStat) {
+    return peerStat->calculateDownloadSpeed();
+  } else {
+    return 0;
+  }
+}
+
 namespace {
 class PeerStatHostProtoEqual {
 private:
@@ -107,6 +107,10 @@ private:
                                         const SharedHandle<Piece>& piece);
 
   void cancelSegmentInternal(cuid_t cuid, const SharedHandle<Segment>& segment);
+
+  // Returns the current download speed of the connection identified
+  // by cuid, or 0 if it is unknown.
+  unsigned int getDownloadSpeed(cuid_t cuid) const;
 public:
   SegmentMan(const Option* option,
              const SharedHandle<DownloadContext>& downloadContext,
@@ -53,11 +53,15 @@ namespace aria2 {
 SelectEventPoll::CommandEvent::CommandEvent(Command* command, int events):
   command_(command), events_(events) {}
 
-void SelectEventPoll::CommandEvent::processEvents(int events)
+void SelectEventPoll::CommandEvent::processEvents
+(int events, std::deque<Command*>* readyCommands)
 {
   if((events_&events) ||
      ((EventPoll::EVENT_ERROR|EventPoll::EVENT_HUP)&events)) {
     command_->setStatusActive();
+    if(readyCommands) {
+      readyCommands->push_back(command_);
+    }
   }
   if(EventPoll::EVENT_READ&events) {
     command_->readEventReceived();
@@ -104,11 +108,13 @@ void SelectEventPoll::SocketEntry::removeCommandEvent
     }
   }
 }
-void SelectEventPoll::SocketEntry::processEvents(int events)
+void SelectEventPoll::SocketEntry::processEvents
+(int events, std::deque<Command*>* readyCommands)
 {
-  std::for_each(commandEvents_.begin(), commandEvents_.end(),
-                std::bind2nd(std::mem_fun_ref(&CommandEvent::processEvents),
-                             events));
+  for(std::deque<CommandEvent>::iterator i = commandEvents_.begin(),
+        eoi = commandEvents_.end(); i != eoi; ++i) {
+    (*i).processEvents(events, readyCommands);
+  }
 }
 
 int accumulateEvent(int events, const SelectEventPoll::CommandEvent& event)
@@ -136,13 +142,16 @@ int SelectEventPoll::AsyncNameResolverEntry::getFds
 }
 
 void SelectEventPoll::AsyncNameResolverEntry::process
-(fd_set* rfdsPtr, fd_set* wfdsPtr)
+(fd_set* rfdsPtr, fd_set* wfdsPtr, std::deque<Command*>* readyCommands)
 {
   nameResolver_->process(rfdsPtr, wfdsPtr);
   switch(nameResolver_->getStatus()) {
   case AsyncNameResolver::STATUS_SUCCESS:
   case AsyncNameResolver::STATUS_ERROR:
     command_->setStatusActive();
+    if(readyCommands) {
+      readyCommands->push_back(command_);
+    }
     break;
   default:
     break;
@@ -212,7 +221,7 @@ void SelectEventPoll::poll(const struct timeval& tv)
       if(FD_ISSET((*i)->getSocket(), &wfds)) {
         events |= EventPoll::EVENT_WRITE;
       }
-      (*i)->processEvents(events);
+      (*i)->processEvents(events, getReadyCommands());
     }
   } else if(retval == -1) {
     int errNum = errno;
@@ -223,7 +232,7 @@ void SelectEventPoll::poll(const struct timeval& tv)
   for(std::deque<SharedHandle<AsyncNameResolverEntry> >::const_iterator i =
         nameResolverEntries_.begin(), eoi = nameResolverEntries_.end();
       i != eoi; ++i) {
-    (*i)->process(&rfds, &wfds);
+    (*i)->process(&rfds, &wfds, getReadyCommands());
   }
 
 #endif // ENABLE_ASYNC_DNS
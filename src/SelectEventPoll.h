@@ -84,7 +84,7 @@ private:
       return events_;
     }
     
-    void processEvents(int events);
+    void processEvents(int events, std::deque<Command*>* readyCommands);
   };
 
   friend int accumulateEvent
@@ -124,7 +124,7 @@ private:
       return commandEvents_.empty();
     }
     
-    void processEvents(int events);
+    void processEvents(int events, std::deque<Command*>* readyCommands);
   };
 
 #ifdef ENABLE_ASYNC_DNS
@@ -147,7 +147,8 @@ private:
 
     int getFds(fd_set* rfdsPtr, fd_set* wfdsPtr);
 
-    void process(fd_set* rfdsPtr, fd_set* wfdsPtr);
+    void process(fd_set* rfdsPtr, fd_set* wfdsPtr,
+                 std::deque<Command*>* readyCommands);
   };
 #endif // ENABLE_ASYNC_DNS
 
@@ -70,7 +70,7 @@ public:
     if(e_->getRequestGroupMan()->downloadFinished() || e_->isHaltRequested()) {
       return true;
     }
-    if(picker_->hasNext() && !picker_->isPicked()) {
+    if(picker_->canPickNext()) {
       e_->addCommand(createCommand(picker_->pickNext()));
 
       e_->setNoWait(true);
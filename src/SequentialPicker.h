@@ -47,21 +47,47 @@ template<typename T>
 class SequentialPicker {
 private:
   std::deque<SharedHandle<T> > entries_;
-  SharedHandle<T> pickedEntry_;
+  // Picked entries, in the order they were picked.
+  std::deque<SharedHandle<T> > pickedEntries_;
+  size_t maxPickedEntries_;
 public:
+  SequentialPicker():maxPickedEntries_(1) {}
+
   bool isPicked() const
   {
-    return pickedEntry_;
+    return !pickedEntries_.empty();
   }
 
+  // Returns the entry picked first among the picked entries.
   SharedHandle<T> getPickedEntry() const
   {
-    return pickedEntry_;
+    if(pickedEntries_.empty()) {
+      return SharedHandle<T>();
+    } else {
+      return pickedEntries_.front();
+    }
+  }
+
+  const std::deque<SharedHandle<T> >& getPickedEntries() const
+  {
+    return pickedEntries_;
   }
 
+  // Drops all picked entries.
   void dropPickedEntry()
   {
-    pickedEntry_.reset();
+    pickedEntries_.clear();
+  }
+
+  void dropPickedEntry(const SharedHandle<T>& entry)
+  {
+    for(typename std::deque<SharedHandle<T> >::iterator i =
+          pickedEntries_.begin(), eoi = pickedEntries_.end(); i != eoi; ++i) {
+      if((*i).get() == entry.get()) {
+        pickedEntries_.erase(i);
+        break;
+      }
+    }
   }
 
   bool hasNext() const
@@ -69,13 +95,20 @@ public:
     return !entries_.empty();
   }
 
+  // Returns true if there is a queued entry and the number of picked
+  // entries is less than the limit.
+  bool canPickNext() const
+  {
+    return hasNext() && pickedEntries_.size() < maxPickedEntries_;
+  }
+
   SharedHandle<T> pickNext()
   {
     SharedHandle<T> r;
     if(hasNext()) {
       r = entries_.front();
       entries_.pop_front();
-      pickedEntry_ = r;
+      pickedEntries_.push_back(r);
     }
     return r;
   }
@@ -89,6 +122,18 @@ public:
   {
     return entries_.size();
   }
+
+  // Sets the number of entries which can be picked at the same
+  // time. The default value is 1.
+  void setMaxPickedEntries(size_t n)
+  {
+    maxPickedEntries_ = n;
+  }
+
+  size_t getMaxPickedEntries() const
+  {
+    return maxPickedEntries_;
+  }
 };
 
 } // namespace aria2
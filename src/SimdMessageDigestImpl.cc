@@ -0,0 +1,390 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SimdMessageDigestImpl.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef HAVE_X86_SHA_INTRINSICS
+# include <cpuid.h>
+# include <immintrin.h>
+#endif // HAVE_X86_SHA_INTRINSICS
+
+namespace aria2 {
+
+namespace {
+const uint32_t SHA1_INIT_STATE[] = {
+  0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0
+};
+
+const uint32_t SHA256_INIT_STATE[] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+} // namespace
+
+#ifdef HAVE_X86_SHA_INTRINSICS
+
+namespace {
+const uint32_t SHA256_K[] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+  0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+  0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+  0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+  0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+  0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+} // namespace
+
+// Rounds 4*g to 4*g+3 of SHA-1 for g >= 1. M0 is the message
+// schedule for these rounds. M1, M2 and M3 are advanced for the
+// following rounds. Computing schedules which are not used in the
+// last rounds is harmless.
+#define SHA1_ROUNDS4(EA, EB, M0, M1, M2, M3, F) \
+  EA = _mm_sha1nexte_epu32(EA, M0);             \
+  EB = abcd;                                    \
+  M1 = _mm_sha1msg2_epu32(M1, M0);              \
+  abcd = _mm_sha1rnds4_epu32(abcd, EA, F);      \
+  M3 = _mm_sha1msg1_epu32(M3, M0);              \
+  M2 = _mm_xor_si128(M2, M0)
+
+namespace {
+__attribute__((target("sha,sse4.1")))
+void sha1CompressShaNi
+(uint32_t* state, const unsigned char* data, size_t numBlocks)
+{
+  const __m128i mask =
+    _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+  __m128i abcd = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  for(; numBlocks > 0; --numBlocks, data += 64) {
+    __m128i abcdSave = abcd;
+    __m128i e0Save = e0;
+    __m128i e1;
+    __m128i msg0 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), mask);
+    __m128i msg1 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+16)), mask);
+    __m128i msg2 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+32)), mask);
+    __m128i msg3 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+48)), mask);
+    // Rounds 0-3
+    e0 = _mm_add_epi32(e0, msg0);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    // Rounds 4-7
+    e1 = _mm_sha1nexte_epu32(e1, msg1);
+    e0 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+    msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+    // Rounds 8-11
+    e0 = _mm_sha1nexte_epu32(e0, msg2);
+    e1 = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+    msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+    msg0 = _mm_xor_si128(msg0, msg2);
+    // Rounds 12-79
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 0);
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 0);
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 1);
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 1);
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 1);
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 1);
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 1);
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 2);
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 2);
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 2);
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 2);
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 2);
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 3);
+    SHA1_ROUNDS4(e0, e1, msg0, msg1, msg2, msg3, 3);
+    SHA1_ROUNDS4(e1, e0, msg1, msg2, msg3, msg0, 3);
+    SHA1_ROUNDS4(e0, e1, msg2, msg3, msg0, msg1, 3);
+    SHA1_ROUNDS4(e1, e0, msg3, msg0, msg1, msg2, 3);
+
+    e0 = _mm_sha1nexte_epu32(e0, e0Save);
+    abcd = _mm_add_epi32(abcd, abcdSave);
+  }
+  abcd = _mm_shuffle_epi32(abcd, 0x1b);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), abcd);
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+} // namespace
+
+#undef SHA1_ROUNDS4
+
+// Rounds 4*g to 4*g+3 of SHA-256 for g >= 3. M0 is the message
+// schedule for these rounds and M3 is the one for the previous
+// rounds.
+#define SHA256_ROUNDS4(G, M0, M1, M2, M3)                               \
+  msg = _mm_add_epi32                                                   \
+    (M0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&SHA256_K[4*G]))); \
+  state1 = _mm_sha256rnds2_epu32(state1, state0, msg);                  \
+  M1 = _mm_sha256msg2_epu32                                             \
+    (_mm_add_epi32(M1, _mm_alignr_epi8(M0, M3, 4)), M0);                \
+  msg = _mm_shuffle_epi32(msg, 0x0e);                                   \
+  state0 = _mm_sha256rnds2_epu32(state0, state1, msg);                  \
+  M3 = _mm_sha256msg1_epu32(M3, M0)
+
+namespace {
+__attribute__((target("sha,sse4.1")))
+void sha256CompressShaNi
+(uint32_t* state, const unsigned char* data, size_t numBlocks)
+{
+  const __m128i mask =
+    _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+  __m128i state1 =
+    _mm_loadu_si128(reinterpret_cast<const __m128i*>(state+4));
+  tmp = _mm_shuffle_epi32(tmp, 0xb1); // CDAB
+  state1 = _mm_shuffle_epi32(state1, 0x1b); // EFGH
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8); // ABEF
+  state1 = _mm_blend_epi16(state1, tmp, 0xf0); // CDGH
+  for(; numBlocks > 0; --numBlocks, data += 64) {
+    __m128i abefSave = state0;
+    __m128i cdghSave = state1;
+    __m128i msg;
+    __m128i msg0 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), mask);
+    __m128i msg1 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+16)), mask);
+    __m128i msg2 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+32)), mask);
+    __m128i msg3 = _mm_shuffle_epi8
+      (_mm_loadu_si128(reinterpret_cast<const __m128i*>(data+48)), mask);
+    // Rounds 0-3
+    msg = _mm_add_epi32
+      (msg0, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&SHA256_K[0])));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    // Rounds 4-7
+    msg = _mm_add_epi32
+      (msg1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&SHA256_K[4])));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+    // Rounds 8-11
+    msg = _mm_add_epi32
+      (msg2, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&SHA256_K[8])));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+    msg = _mm_shuffle_epi32(msg, 0x0e);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+    msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+    // Rounds 12-63
+    SHA256_ROUNDS4(3, msg3, msg0, msg1, msg2);
+    SHA256_ROUNDS4(4, msg0, msg1, msg2, msg3);
+    SHA256_ROUNDS4(5, msg1, msg2, msg3, msg0);
+    SHA256_ROUNDS4(6, msg2, msg3, msg0, msg1);
+    SHA256_ROUNDS4(7, msg3, msg0, msg1, msg2);
+    SHA256_ROUNDS4(8, msg0, msg1, msg2, msg3);
+    SHA256_ROUNDS4(9, msg1, msg2, msg3, msg0);
+    SHA256_ROUNDS4(10, msg2, msg3, msg0, msg1);
+    SHA256_ROUNDS4(11, msg3, msg0, msg1, msg2);
+    SHA256_ROUNDS4(12, msg0, msg1, msg2, msg3);
+    SHA256_ROUNDS4(13, msg1, msg2, msg3, msg0);
+    SHA256_ROUNDS4(14, msg2, msg3, msg0, msg1);
+    SHA256_ROUNDS4(15, msg3, msg0, msg1, msg2);
+
+    state0 = _mm_add_epi32(state0, abefSave);
+    state1 = _mm_add_epi32(state1, cdghSave);
+  }
+  tmp = _mm_shuffle_epi32(state0, 0x1b); // FEBA
+  state1 = _mm_shuffle_epi32(state1, 0xb1); // DCHG
+  state0 = _mm_blend_epi16(tmp, state1, 0xf0); // DCBA
+  state1 = _mm_alignr_epi8(state1, tmp, 8); // HGFE
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(state+4), state1);
+}
+} // namespace
+
+#undef SHA256_ROUNDS4
+
+namespace {
+bool cpuSupportsShaNi()
+{
+  unsigned int eax, ebx, ecx, edx;
+  if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  // SSSE3 and SSE4.1
+  if(!(ecx & (1 << 9)) || !(ecx & (1 << 19))) {
+    return false;
+  }
+  if(__get_cpuid_max(0, 0) < 7) {
+    return false;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  // SHA extensions
+  return ebx & (1 << 29);
+}
+} // namespace
+
+#endif // HAVE_X86_SHA_INTRINSICS
+
+namespace {
+struct Kernel {
+  const char* name;
+  SimdMessageDigestImpl::CompressFunc sha1;
+  SimdMessageDigestImpl::CompressFunc sha256;
+};
+} // namespace
+
+namespace {
+// Returns the fastest kernel the CPU supports. Kernel.name is 0 if
+// none is available.
+Kernel detectKernel()
+{
+  Kernel kernel = { 0, 0, 0 };
+#ifdef HAVE_X86_SHA_INTRINSICS
+  if(cpuSupportsShaNi()) {
+    kernel.name = "sha-ni";
+    kernel.sha1 = sha1CompressShaNi;
+    kernel.sha256 = sha256CompressShaNi;
+  }
+#endif // HAVE_X86_SHA_INTRINSICS
+  return kernel;
+}
+} // namespace
+
+namespace {
+const Kernel& getKernel()
+{
+  static Kernel kernel = detectKernel();
+  return kernel;
+}
+} // namespace
+
+SimdMessageDigestImpl::SimdMessageDigestImpl
+(CompressFunc compress, const uint32_t* initState, size_t digestLength)
+  : compress_(compress),
+    initState_(initState),
+    digestLength_(digestLength)
+{
+  reset();
+}
+
+SimdMessageDigestImpl::~SimdMessageDigestImpl() {}
+
+SharedHandle<SimdMessageDigestImpl> SimdMessageDigestImpl::create
+(const std::string& hashType)
+{
+  SharedHandle<SimdMessageDigestImpl> impl;
+  const Kernel& kernel = getKernel();
+  if(hashType == "sha-1" && kernel.sha1) {
+    impl.reset(new SimdMessageDigestImpl(kernel.sha1, SHA1_INIT_STATE, 20));
+  } else if(hashType == "sha-256" && kernel.sha256) {
+    impl.reset(new SimdMessageDigestImpl(kernel.sha256, SHA256_INIT_STATE,
+                                         32));
+  }
+  return impl;
+}
+
+std::string SimdMessageDigestImpl::getKernelName()
+{
+  const Kernel& kernel = getKernel();
+  return kernel.name ? kernel.name : "";
+}
+
+void SimdMessageDigestImpl::reset()
+{
+  memcpy(state_, initState_, digestLength_);
+  blockLength_ = 0;
+  length_ = 0;
+}
+
+void SimdMessageDigestImpl::update(const void* data, size_t length)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  length_ += length;
+  if(blockLength_ > 0) {
+    size_t n = std::min(length, sizeof(block_)-blockLength_);
+    memcpy(block_+blockLength_, p, n);
+    blockLength_ += n;
+    p += n;
+    length -= n;
+    if(blockLength_ < sizeof(block_)) {
+      return;
+    }
+    compress_(state_, block_, 1);
+    blockLength_ = 0;
+  }
+  if(length >= sizeof(block_)) {
+    size_t numBlocks = length/sizeof(block_);
+    compress_(state_, p, numBlocks);
+    p += numBlocks*sizeof(block_);
+    length -= numBlocks*sizeof(block_);
+  }
+  memcpy(block_, p, length);
+  blockLength_ = length;
+}
+
+void SimdMessageDigestImpl::digest(unsigned char* md)
+{
+  uint64_t bits = length_*8;
+  block_[blockLength_++] = 0x80;
+  if(blockLength_ > sizeof(block_)-8) {
+    memset(block_+blockLength_, 0, sizeof(block_)-blockLength_);
+    compress_(state_, block_, 1);
+    blockLength_ = 0;
+  }
+  memset(block_+blockLength_, 0, sizeof(block_)-8-blockLength_);
+  for(int i = 0; i < 8; ++i) {
+    block_[sizeof(block_)-1-i] = (bits >> (8*i)) & 0xff;
+  }
+  compress_(state_, block_, 1);
+  for(size_t i = 0; i < digestLength_/4; ++i) {
+    md[4*i] = state_[i] >> 24;
+    md[4*i+1] = (state_[i] >> 16) & 0xff;
+    md[4*i+2] = (state_[i] >> 8) & 0xff;
+    md[4*i+3] = state_[i] & 0xff;
+  }
+  reset();
+}
+
+} // namespace aria2
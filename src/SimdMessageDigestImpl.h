@@ -0,0 +1,95 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SIMD_MESSAGE_DIGEST_IMPL_H
+#define D_SIMD_MESSAGE_DIGEST_IMPL_H
+
+#include "common.h"
+
+#include <stdint.h>
+
+#include <string>
+
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+// Built-in SHA-1 and SHA-256 implementation using CPU instructions
+// which are detected at runtime. MessageDigest uses it in preference
+// to the crypto library if create() succeeds.
+class SimdMessageDigestImpl {
+public:
+  typedef void (*CompressFunc)
+  (uint32_t* state, const unsigned char* data, size_t numBlocks);
+private:
+  CompressFunc compress_;
+  const uint32_t* initState_;
+  size_t digestLength_;
+  uint32_t state_[8];
+  unsigned char block_[64];
+  size_t blockLength_;
+  uint64_t length_;
+
+  SimdMessageDigestImpl(CompressFunc compress, const uint32_t* initState,
+                        size_t digestLength);
+  // We don't implement copy ctor.
+  SimdMessageDigestImpl(const SimdMessageDigestImpl&);
+  // We don't implement assignment operator.
+  SimdMessageDigestImpl& operator=(const SimdMessageDigestImpl&);
+public:
+  ~SimdMessageDigestImpl();
+
+  // Returns null if hashType is not supported or the CPU lacks the
+  // required instructions.
+  static SharedHandle<SimdMessageDigestImpl> create
+  (const std::string& hashType);
+
+  // Returns the name of the instruction set used, or empty string if
+  // no accelerated implementation is available.
+  static std::string getKernelName();
+
+  size_t getDigestLength() const
+  {
+    return digestLength_;
+  }
+
+  void reset();
+  void update(const void* data, size_t length);
+  // Stores digest to md and resets this object.
+  void digest(unsigned char* md);
+};
+
+} // namespace aria2
+
+#endif // D_SIMD_MESSAGE_DIGEST_IMPL_H
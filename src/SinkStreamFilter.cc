@@ -35,6 +35,7 @@
 #include "SinkStreamFilter.h"
 #include "BinaryStream.h"
 #include "Segment.h"
+#include "Piece.h"
 
 namespace aria2 {
 
@@ -50,7 +51,12 @@ ssize_t SinkStreamFilter::transform
  const unsigned char* inbuf, size_t inlen)
 {
   if(inlen > 0) {
-    out->writeData(inbuf, inlen, segment->getPositionToWrite());
+    SharedHandle<Piece> piece = segment->getPiece();
+    if(piece && piece->getWrDiskCacheEntry()) {
+      piece->updateWrCache(inbuf, inlen, segment->getPositionToWrite());
+    } else {
+      out->writeData(inbuf, inlen, segment->getPositionToWrite());
+    }
 #ifdef ENABLE_MESSAGE_DIGEST
     if(hashUpdate_) {
       segment->updateHash(segment->getWrittenLength(), inbuf, inlen);
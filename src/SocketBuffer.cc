@@ -38,20 +38,26 @@
 #include <algorithm>
 
 #include "SocketCore.h"
+#include "DiskAdaptor.h"
 #include "DlAbortEx.h"
 #include "message.h"
 #include "fmt.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
 SocketBuffer::ByteArrayBufEntry::ByteArrayBufEntry
-(unsigned char* bytes, size_t length)
-  : bytes_(bytes), length_(length)
+(unsigned char* bytes, size_t length, FreeList* freeList)
+  : bytes_(bytes), length_(length), freeList_(freeList)
 {}
 
 SocketBuffer::ByteArrayBufEntry::~ByteArrayBufEntry()
 {
-  delete [] bytes_;
+  if(freeList_) {
+    freeList_->deallocate(bytes_);
+  } else {
+    delete [] bytes_;
+  }
 }
 
 ssize_t SocketBuffer::ByteArrayBufEntry::send
@@ -87,30 +93,96 @@ void SocketBuffer::StringBufEntry::swap(std::string& s)
   str_.swap(s);
 }
 
+#ifdef HAVE_SENDFILE
+SocketBuffer::FileBufEntry::FileBufEntry
+(const SharedHandle<DiskAdaptor>& diskAdaptor, off_t offset, size_t length)
+  : diskAdaptor_(diskAdaptor), offset_(offset), length_(length)
+{}
+
+ssize_t SocketBuffer::FileBufEntry::send
+(const SharedHandle<SocketCore>& socket, size_t offset)
+{
+  // The data may span several files.  Since the file descriptor is
+  // only valid until the next call to diskAdaptor_, it is obtained
+  // for each sendfile(2) call.
+  size_t totalslen = 0;
+  while(offset < length_) {
+    off_t fileOffset;
+    size_t fileLength;
+    int fd = diskAdaptor_->getFd(offset_+offset, length_-offset,
+                                 fileOffset, fileLength);
+    if(fd == -1) {
+      throw DL_ABORT_EX(EX_DATA_READ);
+    }
+    ssize_t slen = socket->sendFile(fd, fileOffset, fileLength);
+    if(slen == 0 && !socket->wantWrite()) {
+      // The file is shorter than expected.
+      throw DL_ABORT_EX(EX_DATA_READ);
+    }
+    totalslen += slen;
+    offset += slen;
+    if(static_cast<size_t>(slen) < fileLength) {
+      break;
+    }
+  }
+  return totalslen;
+}
+
+bool SocketBuffer::FileBufEntry::final(size_t offset) const
+{
+  return length_ <= offset;
+}
+#endif // HAVE_SENDFILE
+
 SocketBuffer::SocketBuffer(const SharedHandle<SocketCore>& socket):
   socket_(socket), offset_(0) {}
 
-SocketBuffer::~SocketBuffer() {}
+SocketBuffer::~SocketBuffer()
+{
+  std::for_each(bufq_.begin(), bufq_.end(), Deleter());
+}
 
 void SocketBuffer::pushBytes(unsigned char* bytes, size_t len)
 {
   if(len > 0) {
-    bufq_.push_back(SharedHandle<BufEntry>(new ByteArrayBufEntry(bytes, len)));
+    bufq_.push_back(new ByteArrayBufEntry(bytes, len, 0));
+  } else {
+    delete [] bytes;
+  }
+}
+
+void SocketBuffer::pushBytes
+(unsigned char* bytes, size_t len, FreeList* freeList)
+{
+  if(len > 0) {
+    bufq_.push_back(new ByteArrayBufEntry(bytes, len, freeList));
+  } else {
+    freeList->deallocate(bytes);
   }
 }
 
 void SocketBuffer::pushStr(const std::string& data)
 {
   if(data.size() > 0) {
-    bufq_.push_back(SharedHandle<BufEntry>(new StringBufEntry(data)));
+    bufq_.push_back(new StringBufEntry(data));
+  }
+}
+
+#ifdef HAVE_SENDFILE
+void SocketBuffer::pushFile
+(const SharedHandle<DiskAdaptor>& diskAdaptor, off_t offset, size_t len)
+{
+  if(len > 0) {
+    bufq_.push_back(new FileBufEntry(diskAdaptor, offset, len));
   }
 }
+#endif // HAVE_SENDFILE
 
 ssize_t SocketBuffer::send()
 {
   size_t totalslen = 0;
   while(!bufq_.empty()) {
-    const SharedHandle<BufEntry>& buf = bufq_[0];
+    BufEntry* buf = bufq_[0];
     ssize_t slen = buf->send(socket_, offset_);
     if(slen == 0 && !socket_->wantRead() && !socket_->wantWrite()) {
       throw DL_ABORT_EX(fmt(EX_SOCKET_SEND, "Connection closed."));
@@ -118,6 +190,7 @@ ssize_t SocketBuffer::send()
     totalslen += slen;
     offset_ += slen;
     if(buf->final(offset_)) {
+      delete buf;
       bufq_.pop_front();
       offset_ = 0;
     } else {
@@ -41,10 +41,12 @@
 #include <deque>
 
 #include "SharedHandle.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
 class SocketCore;
+class DiskAdaptor;
 
 class SocketBuffer {
 private:
@@ -56,9 +58,13 @@ private:
     virtual bool final(size_t offset) const = 0;
   };
 
-  class ByteArrayBufEntry:public BufEntry {
+  // Most of the data are pushed as byte arrays, so entries of this
+  // type are recycled.
+  class ByteArrayBufEntry:public BufEntry,
+                          public PooledObject<ByteArrayBufEntry> {
   public:
-    ByteArrayBufEntry(unsigned char* bytes, size_t length);
+    ByteArrayBufEntry(unsigned char* bytes, size_t length,
+                      FreeList* freeList);
     virtual ~ByteArrayBufEntry();
     virtual ssize_t send
     (const SharedHandle<SocketCore>& socket, size_t offset);
@@ -66,6 +72,8 @@ private:
   private:
     unsigned char* bytes_;
     size_t length_;
+    // If not null, bytes_ was allocated from this free list.
+    FreeList* freeList_;
   };
 
   class StringBufEntry:public BufEntry {
@@ -79,10 +87,28 @@ private:
   private:
     std::string str_;
   };
+
+#ifdef HAVE_SENDFILE
+  // Data in files, which are sent by sendfile(2) without copying them
+  // to user space.
+  class FileBufEntry:public BufEntry {
+  public:
+    FileBufEntry(const SharedHandle<DiskAdaptor>& diskAdaptor,
+                 off_t offset, size_t length);
+    virtual ssize_t send
+    (const SharedHandle<SocketCore>& socket, size_t offset);
+    virtual bool final(size_t offset) const;
+  private:
+    SharedHandle<DiskAdaptor> diskAdaptor_;
+    off_t offset_;
+    size_t length_;
+  };
+#endif // HAVE_SENDFILE
     
   SharedHandle<SocketCore> socket_;
 
-  std::deque<SharedHandle<BufEntry> > bufq_;
+  // BufEntry objects are owned by this object.
+  std::deque<BufEntry*> bufq_;
 
   // Offset of data in bufq_[0]. SocketBuffer tries to send bufq_[0],
   // but it cannot always send whole data. In this case, offset points
@@ -102,9 +128,24 @@ public:
   // later bytes after this call. This function doesn't send data.
   void pushBytes(unsigned char* bytes, size_t len);
 
+  // Same as pushBytes(bytes, len), but bytes was allocated by
+  // freeList->allocate() and is returned to freeList after it is
+  // sent.
+  void pushBytes(unsigned char* bytes, size_t len, FreeList* freeList);
+
   // Feeds data into queue. This function doesn't send data.
   void pushStr(const std::string& data);
 
+#ifdef HAVE_SENDFILE
+  // Feeds len bytes of data at offset in diskAdaptor into queue.  The
+  // data are read from the files when they are sent, using
+  // sendfile(2).  diskAdaptor must provide file descriptors by
+  // DiskAdaptor::getFd() and the socket must not use TLS.  This
+  // function doesn't send data.
+  void pushFile(const SharedHandle<DiskAdaptor>& diskAdaptor,
+                off_t offset, size_t len);
+#endif // HAVE_SENDFILE
+
   // Sends data in queue.  Returns the number of bytes sent.
   ssize_t send();
 
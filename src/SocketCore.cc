@@ -38,8 +38,15 @@
 #ifdef HAVE_IFADDRS_H
 # include <ifaddrs.h>
 #endif // HAVE_IFADDRS_H
+#ifdef HAVE_SENDFILE
+# include <sys/sendfile.h>
+#endif // HAVE_SENDFILE
+#ifdef HAVE_SPLICE
+# include <fcntl.h>
+#endif // HAVE_SPLICE
 
 #include <cerrno>
+#include <cassert>
 #include <cstring>
 
 #ifdef HAVE_LIBGNUTLS
@@ -742,6 +749,53 @@ ssize_t SocketCore::writeData(const char* data, size_t len)
   return ret;
 }
 
+#ifdef HAVE_SENDFILE
+ssize_t SocketCore::sendFile(int fd, off_t offset, size_t len)
+{
+  assert(!secure_);
+  ssize_t ret = 0;
+  wantRead_ = false;
+  wantWrite_ = false;
+
+  while((ret = sendfile(sockfd_, fd, &offset, len)) == -1 &&
+        errno == EINTR);
+  int errNum = errno;
+  if(ret == -1) {
+    if(A2_WOULDBLOCK(errNum)) {
+      wantWrite_ = true;
+      ret = 0;
+    } else {
+      throw DL_RETRY_EX(fmt(EX_SOCKET_SEND, errorMsg(errNum).c_str()));
+    }
+  }
+  return ret;
+}
+#endif // HAVE_SENDFILE
+
+#ifdef HAVE_SPLICE
+ssize_t SocketCore::spliceData(int pipefd, size_t len)
+{
+  assert(!secure_);
+  ssize_t ret = 0;
+  wantRead_ = false;
+  wantWrite_ = false;
+
+  while((ret = splice(sockfd_, 0, pipefd, 0, len,
+                      SPLICE_F_MOVE|SPLICE_F_NONBLOCK)) == -1 &&
+        errno == EINTR);
+  int errNum = errno;
+  if(ret == -1) {
+    if(A2_WOULDBLOCK(errNum)) {
+      wantRead_ = true;
+      ret = 0;
+    } else {
+      throw DL_RETRY_EX(fmt(EX_SOCKET_RECV, errorMsg(errNum).c_str()));
+    }
+  }
+  return ret;
+}
+#endif // HAVE_SPLICE
+
 void SocketCore::readData(char* data, size_t& len)
 {
   ssize_t ret = 0;
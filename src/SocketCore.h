@@ -245,6 +245,27 @@ public:
   ssize_t writeData(const char* data, size_t len,
                     const std::string& host, uint16_t port);
 
+#ifdef HAVE_SENDFILE
+  // Sends len bytes of the file fd starting at offset using
+  // sendfile(2), so that the data are not copied to user space.  The
+  // return value and wantWrite_ are set as writeData() does.  Must not
+  // be called if TLS is enabled.
+  ssize_t sendFile(int fd, off_t offset, size_t len);
+#endif // HAVE_SENDFILE
+
+#ifdef HAVE_SPLICE
+  // Moves at most len bytes received from this socket into the write
+  // end of the pipe pipefd using splice(2).  The return value and
+  // wantRead_ are set as readData() does.  Must not be used with
+  // secure connection.
+  ssize_t spliceData(int pipefd, size_t len);
+#endif // HAVE_SPLICE
+
+  bool isSecure() const
+  {
+    return secure_;
+  }
+
   ssize_t writeData(const unsigned char* data, size_t len,
                     const std::string& host,
                     uint16_t port)
@@ -0,0 +1,112 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SplicePipe.h"
+
+#include <fcntl.h>
+
+#include <cerrno>
+#include <cassert>
+
+#include "SocketCore.h"
+#include "DlAbortEx.h"
+#include "DownloadFailureException.h"
+#include "message.h"
+#include "fmt.h"
+#include "util.h"
+#include "error_code.h"
+
+namespace aria2 {
+
+SplicePipe::SplicePipe()
+  : length_(0)
+{
+  if(pipe(fds_) == -1) {
+    fds_[0] = fds_[1] = -1;
+  }
+}
+
+SplicePipe::~SplicePipe()
+{
+  if(good()) {
+    close(fds_[0]);
+    close(fds_[1]);
+  }
+}
+
+ssize_t SplicePipe::recv(const SharedHandle<SocketCore>& socket, size_t len)
+{
+  assert(good());
+  ssize_t ret = socket->spliceData(fds_[1], len);
+  length_ += ret;
+  return ret;
+}
+
+void SplicePipe::writeTo(int fd, off_t offset, const std::string& filename)
+{
+  assert(good());
+  while(length_ > 0) {
+    ssize_t ret;
+    while((ret = splice(fds_[0], 0, fd, &offset, length_, SPLICE_F_MOVE)) == -1
+          && errno == EINTR);
+    int errNum = errno;
+    if(ret <= 0) {
+      // The data left in the pipe are stale now. Drop the pipe so that
+      // they are not written to the file later.
+      close(fds_[0]);
+      close(fds_[1]);
+      fds_[0] = fds_[1] = -1;
+      length_ = 0;
+      if(ret == 0) {
+        errNum = EIO;
+      }
+      if(errNum == ENOSPC) {
+        throw DOWNLOAD_FAILURE_EXCEPTION3
+          (errNum,
+           fmt(EX_FILE_WRITE, filename.c_str(),
+               util::safeStrerror(errNum).c_str()),
+           error_code::NOT_ENOUGH_DISK_SPACE);
+      } else {
+        throw DL_ABORT_EX3
+          (errNum,
+           fmt(EX_FILE_WRITE, filename.c_str(),
+               util::safeStrerror(errNum).c_str()),
+           error_code::FILE_IO_ERROR);
+      }
+    }
+    length_ -= ret;
+  }
+}
+
+} // namespace aria2
@@ -0,0 +1,92 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SPLICE_PIPE_H
+#define D_SPLICE_PIPE_H
+
+#include "common.h"
+
+#include <unistd.h>
+
+#include <string>
+
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+class SocketCore;
+
+// Pipe used to move data received from a socket to a file with
+// splice(2) without copying them to user space.
+class SplicePipe {
+private:
+  int fds_[2];
+  // The number of bytes in the pipe
+  size_t length_;
+public:
+  // Creates pipe. If it fails, good() returns false.
+  SplicePipe();
+
+  ~SplicePipe();
+
+  bool good() const
+  {
+    return fds_[0] != -1;
+  }
+
+  // Moves at most len bytes received from socket into the pipe.
+  // Returns the number of bytes moved. 0 means EOF unless
+  // socket->wantRead() is true.
+  ssize_t recv(const SharedHandle<SocketCore>& socket, size_t len);
+
+  // Writes all data in the pipe to fd at offset. filename is used in
+  // the error message. Throws DlAbortEx on error.
+  void writeTo(int fd, off_t offset, const std::string& filename);
+
+  size_t getLength() const
+  {
+    return length_;
+  }
+
+  // The maximum number of bytes recv() should move at once so that
+  // the pipe does not become full.
+  static const size_t CAPACITY = 64*1024;
+private:
+  SplicePipe(const SplicePipe&);
+  SplicePipe& operator=(const SplicePipe&);
+};
+
+} // namespace aria2
+
+#endif // D_SPLICE_PIPE_H
@@ -0,0 +1,145 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "SuperSeeder.h"
+
+#include <algorithm>
+
+#include "PieceStatMan.h"
+#include "bitfield.h"
+
+namespace aria2 {
+
+SuperSeeder::SuperSeeder(const SharedHandle<PieceStatMan>& pieceStatMan)
+  : pieceStatMan_(pieceStatMan),
+    offers_(pieceStatMan->getCounts().size())
+{}
+
+SuperSeeder::~SuperSeeder() {}
+
+void SuperSeeder::addPeer(cuid_t cuid)
+{
+  peers_[cuid];
+}
+
+void SuperSeeder::removePeer(cuid_t cuid)
+{
+  PeerMap::iterator i = peers_.find(cuid);
+  if(i == peers_.end()) {
+    return;
+  }
+  for(std::vector<size_t>::const_iterator j = (*i).second.pending.begin(),
+        eoj = (*i).second.pending.end(); j != eoj; ++j) {
+    --offers_[*j];
+  }
+  peers_.erase(i);
+}
+
+bool SuperSeeder::canUpload(cuid_t cuid, size_t index) const
+{
+  PeerMap::const_iterator i = peers_.find(cuid);
+  return i == peers_.end() || (*i).second.shown.count(index);
+}
+
+void SuperSeeder::updatePeerHave(cuid_t cuid, size_t index)
+{
+  if(offers_[index] == 0) {
+    return;
+  }
+  for(PeerMap::iterator i = peers_.begin(), eoi = peers_.end(); i != eoi;
+      ++i) {
+    if((*i).first == cuid) {
+      continue;
+    }
+    std::vector<size_t>& pending = (*i).second.pending;
+    std::vector<size_t>::iterator j =
+      std::find(pending.begin(), pending.end(), index);
+    if(j != pending.end()) {
+      pending.erase(j);
+      --offers_[index];
+    }
+  }
+}
+
+bool SuperSeeder::getNextPiece
+(size_t& index, cuid_t cuid, const unsigned char* bitfield, size_t nbits)
+{
+  PeerMap::iterator i = peers_.find(cuid);
+  if(i == peers_.end()) {
+    return false;
+  }
+  const std::vector<int>& counts = pieceStatMan_->getCounts();
+  int numPeers = peers_.size();
+  std::vector<size_t>& pending = (*i).second.pending;
+  for(std::vector<size_t>::iterator j = pending.begin(); j != pending.end();) {
+    if(bitfield::test(bitfield, nbits, *j) && counts[*j] >= numPeers) {
+      --offers_[*j];
+      j = pending.erase(j);
+    } else {
+      ++j;
+    }
+  }
+  if(!pending.empty()) {
+    return false;
+  }
+  // getOrder() is sorted by counts, so the search stops once the
+  // count alone is not less than the best score found.
+  const std::vector<size_t>& order = pieceStatMan_->getOrder();
+  bool found = false;
+  int best = 0;
+  for(std::vector<size_t>::const_iterator j = order.begin(),
+        eoj = order.end(); j != eoj; ++j) {
+    if(found && counts[*j] >= best) {
+      break;
+    }
+    if(bitfield::test(bitfield, nbits, *j)) {
+      continue;
+    }
+    int score = counts[*j]+offers_[*j];
+    if(!found || score < best) {
+      index = *j;
+      best = score;
+      found = true;
+    }
+  }
+  if(!found) {
+    return false;
+  }
+  ++offers_[index];
+  pending.push_back(index);
+  (*i).second.shown.insert(index);
+  return true;
+}
+
+} // namespace aria2
@@ -0,0 +1,105 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_SUPER_SEEDER_H
+#define D_SUPER_SEEDER_H
+
+#include "common.h"
+
+#include <vector>
+#include <set>
+#include <map>
+
+#include "SharedHandle.h"
+#include "Command.h"
+
+namespace aria2 {
+
+class PieceStatMan;
+
+// Implements super-seeding (BEP 16). Instead of the bitfield, each
+// peer is shown one piece at a time, picking the piece the fewest
+// peers have or have been shown. A peer is shown the next piece when
+// another peer announces the piece it was shown, that is, when the
+// peer has uploaded it to the swarm.
+class SuperSeeder {
+private:
+  struct PeerEntry {
+    // Pieces shown to the peer which have not propagated yet.
+    std::vector<size_t> pending;
+    // All pieces shown to the peer. The peer may request only these.
+    std::set<size_t> shown;
+  };
+  typedef std::map<cuid_t, PeerEntry> PeerMap;
+  PeerMap peers_;
+
+  SharedHandle<PieceStatMan> pieceStatMan_;
+  // The number of peers each piece is pending for.
+  std::vector<int> offers_;
+public:
+  SuperSeeder(const SharedHandle<PieceStatMan>& pieceStatMan);
+
+  ~SuperSeeder();
+
+  // Starts super-seeding to the peer cuid.
+  void addPeer(cuid_t cuid);
+
+  void removePeer(cuid_t cuid);
+
+  // Returns false if the peer cuid is super-seeded and has not been
+  // shown the piece index.
+  bool canUpload(cuid_t cuid, size_t index) const;
+
+  // Called when the peer cuid announced that it has the piece
+  // index. The peers which were shown the piece get the next piece.
+  // The caller must add the piece stats before calling this function.
+  void updatePeerHave(cuid_t cuid, size_t index);
+
+  // If the peer cuid is due for the next piece, stores the piece to
+  // show in index and returns true. bitfield is the peer's bitfield
+  // and nbits is the number of pieces. A peer which has got its
+  // pending piece is also due if every super-seeded peer has that
+  // piece, because no one can get it from the peer.
+  bool getNextPiece(size_t& index, cuid_t cuid,
+                    const unsigned char* bitfield, size_t nbits);
+
+  size_t countPeer() const
+  {
+    return peers_.size();
+  }
+};
+
+} // namespace aria2
+
+#endif // D_SUPER_SEEDER_H
@@ -0,0 +1,90 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_THREAD_JOB_H
+#define D_THREAD_JOB_H
+
+#include "common.h"
+
+namespace aria2 {
+
+class Command;
+
+// Job executed by ThreadPool. execute() is called in a worker thread,
+// so it must not touch any object shared with the event loop and must
+// not throw exception. The other member functions are only called in
+// the event loop thread.
+class ThreadJob {
+private:
+  // Command woken up when this job is done.
+  Command* command_;
+
+  bool done_;
+public:
+  ThreadJob():command_(0), done_(false) {}
+
+  virtual ~ThreadJob() {}
+
+  virtual void execute() = 0;
+
+  // Called in the event loop thread when this job is done, before
+  // the command is woken up.
+  virtual void onDone() {}
+
+  Command* getCommand() const
+  {
+    return command_;
+  }
+
+  // Setting 0 detaches this job from Command, for example, when
+  // Command is deleted before this job is done.
+  void setCommand(Command* command)
+  {
+    command_ = command;
+  }
+
+  bool isDone() const
+  {
+    return done_;
+  }
+
+  void setDone(bool done)
+  {
+    done_ = done;
+  }
+};
+
+} // namespace aria2
+
+#endif // D_THREAD_JOB_H
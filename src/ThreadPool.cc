@@ -0,0 +1,199 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "ThreadPool.h"
+
+#include <fcntl.h>
+
+#include <cerrno>
+#include <algorithm>
+
+#include "ThreadJob.h"
+#include "LogFactory.h"
+#include "Logger.h"
+#include "util.h"
+#include "fmt.h"
+#include "a2io.h"
+
+namespace aria2 {
+
+ThreadPool::ThreadPool(size_t numThreads)
+  : good_(false),
+    notified_(false),
+    stop_(false)
+{
+  wakeFds_[0] = wakeFds_[1] = -1;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_init(&mutex_, 0);
+  pthread_cond_init(&cond_, 0);
+  pthread_cond_init(&doneCond_, 0);
+  if(pipe(wakeFds_) == -1) {
+    int errNum = errno;
+    A2_LOG_ERROR(fmt("Creating pipe for ThreadPool failed: %s",
+                     util::safeStrerror(errNum).c_str()));
+    wakeFds_[0] = wakeFds_[1] = -1;
+    return;
+  }
+  for(int i = 0; i < 2; ++i) {
+    fcntl(wakeFds_[i], F_SETFD, FD_CLOEXEC);
+    fcntl(wakeFds_[i], F_SETFL, fcntl(wakeFds_[i], F_GETFL, 0)|O_NONBLOCK);
+  }
+  for(size_t i = 0; i < numThreads; ++i) {
+    pthread_t thread;
+    int rv = pthread_create(&thread, 0, &ThreadPool::run, this);
+    if(rv != 0) {
+      A2_LOG_ERROR(fmt("Starting worker thread failed: %s",
+                       util::safeStrerror(rv).c_str()));
+      break;
+    }
+    threads_.push_back(thread);
+  }
+  good_ = !threads_.empty();
+#endif // HAVE_PTHREAD
+}
+
+ThreadPool::~ThreadPool()
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&mutex_);
+  stop_ = true;
+  pthread_cond_broadcast(&cond_);
+  pthread_mutex_unlock(&mutex_);
+  for(std::vector<pthread_t>::const_iterator i = threads_.begin(),
+        eoi = threads_.end(); i != eoi; ++i) {
+    pthread_join(*i, 0);
+  }
+  pthread_cond_destroy(&cond_);
+  pthread_cond_destroy(&doneCond_);
+  pthread_mutex_destroy(&mutex_);
+#endif // HAVE_PTHREAD
+  for(int i = 0; i < 2; ++i) {
+    if(wakeFds_[i] != -1) {
+      close(wakeFds_[i]);
+    }
+  }
+}
+
+size_t ThreadPool::getNumThreads() const
+{
+#ifdef HAVE_PTHREAD
+  return threads_.size();
+#else // !HAVE_PTHREAD
+  return 0;
+#endif // !HAVE_PTHREAD
+}
+
+#ifdef HAVE_PTHREAD
+void* ThreadPool::run(void* arg)
+{
+  reinterpret_cast<ThreadPool*>(arg)->runJobs();
+  return 0;
+}
+#endif // HAVE_PTHREAD
+
+void ThreadPool::runJobs()
+{
+#ifdef HAVE_PTHREAD
+  while(1) {
+    pthread_mutex_lock(&mutex_);
+    while(!stop_ && jobs_.empty()) {
+      pthread_cond_wait(&cond_, &mutex_);
+    }
+    if(stop_) {
+      pthread_mutex_unlock(&mutex_);
+      break;
+    }
+    ThreadJob* job = jobs_.front();
+    jobs_.pop_front();
+    pthread_mutex_unlock(&mutex_);
+
+    job->execute();
+
+    pthread_mutex_lock(&mutex_);
+    doneJobs_.push_back(job);
+    bool notify = !notified_;
+    notified_ = true;
+    pthread_cond_broadcast(&doneCond_);
+    pthread_mutex_unlock(&mutex_);
+    if(notify) {
+      char c = 0;
+      while(write(wakeFds_[1], &c, 1) == -1 && errno == EINTR);
+    }
+  }
+#endif // HAVE_PTHREAD
+}
+
+void ThreadPool::submit(ThreadJob* job)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&mutex_);
+  jobs_.push_back(job);
+  pthread_cond_signal(&cond_);
+  pthread_mutex_unlock(&mutex_);
+#else // !HAVE_PTHREAD
+  job->execute();
+  doneJobs_.push_back(job);
+#endif // !HAVE_PTHREAD
+}
+
+void ThreadPool::getDoneJobs(std::vector<ThreadJob*>& jobs)
+{
+#ifdef HAVE_PTHREAD
+  if(wakeFds_[0] != -1) {
+    char buf[64];
+    while(read(wakeFds_[0], buf, sizeof(buf)) > 0);
+  }
+  pthread_mutex_lock(&mutex_);
+#endif // HAVE_PTHREAD
+  jobs.insert(jobs.end(), doneJobs_.begin(), doneJobs_.end());
+  doneJobs_.clear();
+  notified_ = false;
+#ifdef HAVE_PTHREAD
+  pthread_mutex_unlock(&mutex_);
+#endif // HAVE_PTHREAD
+}
+
+void ThreadPool::wait(ThreadJob* job)
+{
+#ifdef HAVE_PTHREAD
+  pthread_mutex_lock(&mutex_);
+  while(std::find(doneJobs_.begin(), doneJobs_.end(), job) ==
+        doneJobs_.end()) {
+    pthread_cond_wait(&doneCond_, &mutex_);
+  }
+  pthread_mutex_unlock(&mutex_);
+#endif // HAVE_PTHREAD
+}
+
+} // namespace aria2
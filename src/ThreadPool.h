@@ -0,0 +1,122 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_THREAD_POOL_H
+#define D_THREAD_POOL_H
+
+#include "common.h"
+
+#include <deque>
+#include <vector>
+
+#ifdef HAVE_PTHREAD
+# include <pthread.h>
+#endif // HAVE_PTHREAD
+
+namespace aria2 {
+
+class ThreadJob;
+
+// Fixed number of worker threads executing ThreadJob. Done jobs are
+// queued and the read end of wake up pipe, returned by getWakeFd(),
+// becomes readable so that the event loop can pick them up by
+// getDoneJobs().  ThreadPool never deletes ThreadJob: the caller must
+// keep submitted jobs alive until they are returned by getDoneJobs()
+// or ThreadPool is destroyed.
+class ThreadPool {
+private:
+  bool good_;
+#ifdef HAVE_PTHREAD
+  std::vector<pthread_t> threads_;
+
+  pthread_mutex_t mutex_;
+
+  pthread_cond_t cond_;
+
+  // Signaled when a job is done.
+  pthread_cond_t doneCond_;
+#endif // HAVE_PTHREAD
+
+  // Guarded by mutex_.
+  std::deque<ThreadJob*> jobs_;
+
+  // Guarded by mutex_.
+  std::vector<ThreadJob*> doneJobs_;
+
+  // True if a byte was written to wake up pipe and it is not drained
+  // yet. Guarded by mutex_.
+  bool notified_;
+
+  // Guarded by mutex_.
+  bool stop_;
+
+  int wakeFds_[2];
+
+#ifdef HAVE_PTHREAD
+  static void* run(void* arg);
+#endif // HAVE_PTHREAD
+
+  void runJobs();
+public:
+  ThreadPool(size_t numThreads);
+
+  ~ThreadPool();
+
+  // Returns true if wake up pipe is created and at least one worker
+  // thread is started.
+  bool good() const
+  {
+    return good_;
+  }
+
+  size_t getNumThreads() const;
+
+  void submit(ThreadJob* job);
+
+  // Appends done jobs to jobs and drains wake up pipe.
+  void getDoneJobs(std::vector<ThreadJob*>& jobs);
+
+  // Blocks until job is done. job must be submitted and must not be
+  // returned by getDoneJobs() yet.
+  void wait(ThreadJob* job);
+
+  int getWakeFd() const
+  {
+    return wakeFds_[0];
+  }
+};
+
+} // namespace aria2
+
+#endif // D_THREAD_POOL_H
@@ -65,6 +65,13 @@ bool TimeBasedCommand::execute()
   }
   if(routineCommand_) {
     e_->addRoutineCommand(this);
+  } else if(interval_ > 0) {
+    // Sleep until next process() is due. DownloadEngine wakes this
+    // command up earlier if all downloads finished or halt is
+    // requested.
+    Timer deadline(checkPoint_);
+    deadline.advance(interval_);
+    e_->addTimerCommand(this, deadline);
   } else {
     e_->addCommand(this);
   }
@@ -43,6 +43,10 @@
 #include "DownloadContext.h"
 #include "Piece.h"
 #include "FileEntry.h"
+#include "DeadlinePieceSelector.h"
+#ifdef ENABLE_BITTORRENT
+# include "SuperSeeder.h"
+#endif // ENABLE_BITTORRENT
 
 namespace aria2 {
 
@@ -130,6 +134,11 @@ SharedHandle<Piece> UnknownLengthPieceStorage::getMissingPiece
 {
   abort();
 }
+
+SharedHandle<SuperSeeder> UnknownLengthPieceStorage::getSuperSeeder()
+{
+  return SharedHandle<SuperSeeder>();
+}
 #endif // ENABLE_BITTORRENT
 
 bool UnknownLengthPieceStorage::hasMissingUnusedPiece()
@@ -154,6 +163,16 @@ SharedHandle<Piece> UnknownLengthPieceStorage::getMissingPiece
   }
 }
 
+SharedHandle<Piece> UnknownLengthPieceStorage::getMissingPiece
+(size_t minSplitSize,
+ const unsigned char* ignoreBitfield,
+ size_t length,
+ cuid_t cuid,
+ unsigned int speed)
+{
+  return getMissingPiece(minSplitSize, ignoreBitfield, length, cuid);
+}
+
 SharedHandle<Piece> UnknownLengthPieceStorage::getMissingPiece
 (size_t index,
  cuid_t cuid)
@@ -254,6 +273,12 @@ void UnknownLengthPieceStorage::getInFlightPieces
 (std::vector<SharedHandle<Piece> >& pieces)
 {}
 
+SharedHandle<DeadlinePieceSelector>
+UnknownLengthPieceStorage::getDeadlinePieceSelector()
+{
+  return SharedHandle<DeadlinePieceSelector>();
+}
+
 void UnknownLengthPieceStorage::setDiskWriterFactory
 (const DiskWriterFactoryHandle& diskWriterFactory)
 {
@@ -107,6 +107,8 @@ public:
   (const SharedHandle<Peer>& peer,
    const std::vector<size_t>& excludedIndexes,
    cuid_t cuid);
+
+  virtual SharedHandle<SuperSeeder> getSuperSeeder();
 #endif // ENABLE_BITTORRENT
 
   virtual bool hasMissingUnusedPiece();
@@ -120,6 +122,13 @@ public:
    size_t length,
    cuid_t cuid);
 
+  virtual SharedHandle<Piece> getMissingPiece
+  (size_t minSplitSize,
+   const unsigned char* ignoreBitfield,
+   size_t length,
+   cuid_t cuid,
+   unsigned int speed);
+
   /**
    * Returns a missing piece whose index is index.
    * If a piece whose index is index is already acquired or currently used,
@@ -239,20 +248,17 @@ public:
    */
   virtual void advertisePiece(cuid_t cuid, size_t index) {}
 
-  /**
-   * Returns piece index which is not advertised by the caller command and
-   * newer than lastCheckTime.
-   */
-  virtual void
+  virtual bool
   getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
-                            cuid_t myCuid, const Timer& lastCheckTime)
-  {}
+                            cuid_t myCuid, uint64_t& cursor)
+  {
+    return true;
+  }
 
-  /**
-   * Removes have entry if specified seconds have elapsed since its
-   * registration.
-   */
-  virtual void removeAdvertisedPiece(time_t elapsed) {}
+  virtual uint64_t getAdvertisedPieceCursor()
+  {
+    return 0;
+  }
 
   /**
    * Sets all bits in bitfield to 1.
@@ -294,6 +300,14 @@ public:
   void setDiskWriterFactory(const SharedHandle<DiskWriterFactory>& diskWriterFactory);
 
   virtual void onDownloadIncomplete() {}
+
+  virtual void flushWrDiskCacheEntry() {}
+
+  virtual void releaseWrDiskCacheEntry() {}
+
+  virtual void setPlayback(uint64_t position, unsigned int bitrate) {}
+
+  virtual SharedHandle<DeadlinePieceSelector> getDeadlinePieceSelector();
 };
 
 typedef SharedHandle<UnknownLengthPieceStorage> UnknownLengthPieceStorageHandle;
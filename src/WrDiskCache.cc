@@ -0,0 +1,240 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "WrDiskCache.h"
+
+#include <algorithm>
+
+#include "WrDiskCacheEntry.h"
+#include "DiskWriteJob.h"
+#include "DiskAdaptor.h"
+#include "DownloadEngine.h"
+#include "ThreadPool.h"
+#include "Piece.h"
+#include "PieceStorage.h"
+#include "LogFactory.h"
+#include "RecoverableException.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+bool WrDiskCache::EntryLess::operator()
+  (const WrDiskCacheEntry* lhs, const WrDiskCacheEntry* rhs) const
+{
+  return lhs->getLastUpdate() < rhs->getLastUpdate() ||
+    (lhs->getLastUpdate() == rhs->getLastUpdate() && lhs < rhs);
+}
+
+WrDiskCache::WrDiskCache(size_t limit)
+  : limit_(limit),
+    total_(0),
+    clock_(0),
+    e_(0)
+{}
+
+WrDiskCache::~WrDiskCache()
+{
+  if(!set_.empty()) {
+    A2_LOG_WARN(fmt("WrDiskCache: %lu entries are still registered",
+                    static_cast<unsigned long>(set_.size())));
+  }
+}
+
+bool WrDiskCache::add(WrDiskCacheEntry* ent)
+{
+  ent->setLastUpdate(++clock_);
+  if(!set_.insert(ent).second) {
+    return false;
+  }
+  total_ += ent->getSize();
+  ensureLimit(ent);
+  return true;
+}
+
+bool WrDiskCache::remove(WrDiskCacheEntry* ent)
+{
+  if(set_.erase(ent)) {
+    total_ -= ent->getSize();
+    return true;
+  } else {
+    return false;
+  }
+}
+
+bool WrDiskCache::update(WrDiskCacheEntry* ent, ssize_t delta)
+{
+  if(delta <= 0) {
+    if(set_.count(ent) == 0) {
+      return false;
+    }
+    total_ += delta;
+    return true;
+  }
+  if(set_.erase(ent) == 0) {
+    return false;
+  }
+  ent->setLastUpdate(++clock_);
+  set_.insert(ent);
+  total_ += delta;
+  ensureLimit(ent);
+  return true;
+}
+
+void WrDiskCache::ensureLimit(WrDiskCacheEntry* caller)
+{
+  if(total_ <= limit_) {
+    return;
+  }
+  A2_LOG_DEBUG(fmt("WrDiskCache: cache is full (%lu/%lu), flushing entries",
+                   static_cast<unsigned long>(total_),
+                   static_cast<unsigned long>(limit_)));
+  for(EntrySet::iterator i = set_.begin(), eoi = set_.end();
+      total_ > limit_ && i != eoi; ++i) {
+    size_t size = (*i)->getSize();
+    if(size == 0) {
+      continue;
+    }
+    if(isAsyncWriteEnabled(*i)) {
+      writeAsync(*i, 0, SharedHandle<PieceStorage>(), SharedHandle<Piece>(),
+                 0);
+    } else if((*i)->getDiskAdaptor().get() ==
+              caller->getDiskAdaptor().get()) {
+      // The error belongs to the download of caller, so let it
+      // propagate.
+      (*i)->writeToDisk();
+      total_ -= size;
+    } else {
+      // The entry belongs to another download. Its error must not
+      // abort the caller, so drop the data and let the owner find
+      // out through the write error flag.
+      try {
+        (*i)->writeToDisk();
+      } catch(RecoverableException& e) {
+        A2_LOG_ERROR_EX("WrDiskCache: failed to write cached data of"
+                        " another download", e);
+        (*i)->deleteDataCells();
+        (*i)->setWriteError(true);
+      }
+      total_ -= size;
+    }
+  }
+}
+
+bool WrDiskCache::isAsyncWriteEnabled(const WrDiskCacheEntry* ent) const
+{
+  return e_ && e_->getThreadPool() &&
+    ent->getDiskAdaptor()->isThreadSafe();
+}
+
+SharedHandle<DiskWriteJob> WrDiskCache::writeAsync
+(WrDiskCacheEntry* ent,
+ Command* command,
+ const SharedHandle<PieceStorage>& pieceStorage,
+ const SharedHandle<Piece>& piece,
+ cuid_t cuid)
+{
+  SharedHandle<DiskWriteJob> job(new DiskWriteJob(ent));
+  total_ -= job->getSize();
+  if(pieceStorage) {
+    job->setPieceCompletion(pieceStorage, piece, cuid);
+  }
+  ent->incPendingWrite();
+  pendingJobs_.insert(job.get());
+  e_->submitJob(job, command);
+  return job;
+}
+
+void WrDiskCache::onWriteDone(DiskWriteJob* job)
+{
+  if(pendingJobs_.erase(job)) {
+    job->getEntry()->decPendingWrite();
+  }
+}
+
+namespace {
+struct EntryMatch {
+  const WrDiskCacheEntry* ent;
+  EntryMatch(const WrDiskCacheEntry* ent) : ent(ent) {}
+  bool operator()(const DiskWriteJob* job) const
+  {
+    return job->getEntry() == ent;
+  }
+};
+
+struct DiskAdaptorMatch {
+  const DiskAdaptor* diskAdaptor;
+  DiskAdaptorMatch(const DiskAdaptor* diskAdaptor)
+    : diskAdaptor(diskAdaptor)
+  {}
+  bool operator()(const DiskWriteJob* job) const
+  {
+    return job->getEntry()->getDiskAdaptor().get() == diskAdaptor;
+  }
+};
+} // namespace
+
+template<typename Pred>
+void WrDiskCache::waitAsyncWriteIf(Pred pred)
+{
+  while(1) {
+    // Handling a job may remove other jobs from pendingJobs_, so
+    // search from the beginning each time.
+    std::set<DiskWriteJob*>::iterator i =
+      std::find_if(pendingJobs_.begin(), pendingJobs_.end(), pred);
+    if(i == pendingJobs_.end()) {
+      break;
+    }
+    DiskWriteJob* job = *i;
+    if(job->isDone()) {
+      // DownloadEngine has marked job done but has not called
+      // onDone() yet.
+      job->onDone();
+    } else {
+      e_->waitJob(job);
+    }
+  }
+}
+
+void WrDiskCache::waitAsyncWrite(const WrDiskCacheEntry* ent)
+{
+  waitAsyncWriteIf(EntryMatch(ent));
+}
+
+void WrDiskCache::waitAsyncWrite
+(const SharedHandle<DiskAdaptor>& diskAdaptor)
+{
+  waitAsyncWriteIf(DiskAdaptorMatch(diskAdaptor.get()));
+}
+
+} // namespace aria2
@@ -0,0 +1,158 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_WR_DISK_CACHE_H
+#define D_WR_DISK_CACHE_H
+
+#include "common.h"
+
+#include <set>
+
+#include "SharedHandle.h"
+#include "Command.h"
+
+namespace aria2 {
+
+class WrDiskCacheEntry;
+class PieceStorage;
+class Piece;
+class DownloadEngine;
+class DiskWriteJob;
+class DiskAdaptor;
+
+// Write-back cache of received data shared by all downloads. The
+// total amount of cached data is capped by the limit given in the
+// constructor. When the limit is exceeded, the entry updated least
+// recently is written to the disk. If DownloadEngine with ThreadPool
+// is set, the data are written by worker threads where possible.
+class WrDiskCache {
+public:
+  WrDiskCache(size_t limit);
+  ~WrDiskCache();
+
+  // Registers ent. Returns false if ent is already registered.
+  bool add(WrDiskCacheEntry* ent);
+
+  // Unregisters ent. The cached data in ent are not written. Returns
+  // false if ent is not registered.
+  bool remove(WrDiskCacheEntry* ent);
+
+  // Must be called after the cached data in ent are changed by
+  // delta bytes. If delta is positive, ent is treated as the most
+  // recently updated entry and then entries are written to the disk
+  // until the total size does not exceed the limit. Returns false if
+  // ent is not registered.
+  bool update(WrDiskCacheEntry* ent, ssize_t delta);
+
+  size_t getSize() const
+  {
+    return total_;
+  }
+
+  size_t getLimit() const
+  {
+    return limit_;
+  }
+
+  size_t countEntry() const
+  {
+    return set_.size();
+  }
+
+  void setDownloadEngine(DownloadEngine* e)
+  {
+    e_ = e;
+  }
+
+  // Returns true if the data of ent can be written by a worker
+  // thread.
+  bool isAsyncWriteEnabled(const WrDiskCacheEntry* ent) const;
+
+  // Takes the cached data of ent and writes them in a worker thread.
+  // If pieceStorage is not null, piece is completed in it after the
+  // write. When the write is done, command is woken up if it is not
+  // 0. isAsyncWriteEnabled(ent) must be true.
+  SharedHandle<DiskWriteJob> writeAsync
+  (WrDiskCacheEntry* ent,
+   Command* command,
+   const SharedHandle<PieceStorage>& pieceStorage,
+   const SharedHandle<Piece>& piece,
+   cuid_t cuid);
+
+  // Called by DiskWriteJob::onDone().
+  void onWriteDone(DiskWriteJob* job);
+
+  // Blocks until all asynchronous writes of ent are done.
+  void waitAsyncWrite(const WrDiskCacheEntry* ent);
+
+  // Blocks until all asynchronous writes to diskAdaptor, that is, the
+  // writes of one download, are done.
+  void waitAsyncWrite(const SharedHandle<DiskAdaptor>& diskAdaptor);
+
+  size_t countPendingWrite() const
+  {
+    return pendingJobs_.size();
+  }
+private:
+  struct EntryLess {
+    bool operator()(const WrDiskCacheEntry* lhs,
+                    const WrDiskCacheEntry* rhs) const;
+  };
+
+  typedef std::set<WrDiskCacheEntry*, EntryLess> EntrySet;
+
+  size_t limit_;
+  size_t total_;
+  // Incremented on each update to order the entries.
+  int64_t clock_;
+  EntrySet set_;
+  DownloadEngine* e_;
+  // Submitted jobs which are not handled by onWriteDone() yet.
+  std::set<DiskWriteJob*> pendingJobs_;
+
+  // Writes entries to the disk until the total size does not exceed
+  // the limit. caller is the entry whose update triggered this call.
+  // Only an error from the download of caller is thrown.
+  void ensureLimit(WrDiskCacheEntry* caller);
+
+  template<typename Pred>
+  void waitAsyncWriteIf(Pred pred);
+
+  WrDiskCache(const WrDiskCache&);
+  WrDiskCache& operator=(const WrDiskCache&);
+};
+
+} // namespace aria2
+
+#endif // D_WR_DISK_CACHE_H
@@ -0,0 +1,182 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#include "WrDiskCacheEntry.h"
+
+#include <cstring>
+#include <vector>
+
+#include "DiskAdaptor.h"
+#include "FreeList.h"
+#include "LogFactory.h"
+#include "fmt.h"
+
+namespace aria2 {
+
+WrDiskCacheEntry::WrDiskCacheEntry
+(WrDiskCache* cache,
+ const SharedHandle<DiskAdaptor>& diskAdaptor)
+  : cache_(cache),
+    diskAdaptor_(diskAdaptor),
+    size_(0),
+    lastUpdate_(0),
+    pendingWrite_(0),
+    writeError_(false)
+{}
+
+WrDiskCacheEntry::~WrDiskCacheEntry()
+{
+  deleteDataCells();
+}
+
+void WrDiskCacheEntry::deleteDataCells()
+{
+  deleteDataCells(set_);
+  size_ = 0;
+}
+
+void WrDiskCacheEntry::deleteDataCell(DataCell* dataCell)
+{
+  if(dataCell->freeList) {
+    dataCell->freeList->deallocate(dataCell->data);
+  } else {
+    delete [] dataCell->data;
+  }
+  delete dataCell;
+}
+
+void WrDiskCacheEntry::deleteDataCells(DataCellSet& dataSet)
+{
+  for(DataCellSet::iterator i = dataSet.begin(), eoi = dataSet.end();
+      i != eoi; ++i) {
+    deleteDataCell(*i);
+  }
+  dataSet.clear();
+}
+
+void WrDiskCacheEntry::swapDataSet(DataCellSet& dataSet)
+{
+  set_.swap(dataSet);
+  size_ = 0;
+}
+
+ssize_t WrDiskCacheEntry::cacheData(DataCell* dataCell)
+{
+  // The same region may be received twice, e.g., in end game mode,
+  // and not always at the same offset. Resolve overlaps with the
+  // cells already cached so that no byte is written twice and the
+  // newest data win.
+  size_t oldSize = size_;
+  off_t start = dataCell->goff;
+  off_t end = dataCell->goff+dataCell->len;
+  DataCell key;
+  key.goff = start;
+  DataCellSet::iterator i = set_.upper_bound(&key);
+  if(i != set_.begin()) {
+    --i;
+  }
+  while(i != set_.end() && (*i)->goff < end) {
+    DataCell* old = *i;
+    off_t oldEnd = old->goff+old->len;
+    if(oldEnd <= start) {
+      ++i;
+    } else if(start <= old->goff && oldEnd <= end) {
+      // old is covered by dataCell.
+      set_.erase(i++);
+      size_ -= old->len;
+      deleteDataCell(old);
+    } else if(old->goff < start) {
+      // dataCell overlaps the tail of old, or is inside old.
+      if(end < oldEnd) {
+        memcpy(old->data+(start-old->goff), dataCell->data, dataCell->len);
+        deleteDataCell(dataCell);
+        return 0;
+      }
+      size_ -= oldEnd-start;
+      old->len = start-old->goff;
+      ++i;
+    } else {
+      // dataCell overlaps the head of old. old is the last cell which
+      // overlaps dataCell.
+      memcpy(old->data, dataCell->data+(old->goff-start), end-old->goff);
+      dataCell->len = old->goff-start;
+      break;
+    }
+  }
+  if(dataCell->len == 0) {
+    deleteDataCell(dataCell);
+  } else {
+    set_.insert(dataCell);
+    size_ += dataCell->len;
+  }
+  return static_cast<ssize_t>(size_)-static_cast<ssize_t>(oldSize);
+}
+
+void WrDiskCacheEntry::writeToDisk()
+{
+  if(set_.empty()) {
+    return;
+  }
+  A2_LOG_DEBUG(fmt("WrDiskCache: writing %lu bytes in %lu cells",
+                   static_cast<unsigned long>(size_),
+                   static_cast<unsigned long>(set_.size())));
+  writeDataCells(diskAdaptor_, set_);
+  deleteDataCells();
+}
+
+void WrDiskCacheEntry::writeDataCells
+(const SharedHandle<DiskAdaptor>& diskAdaptor, const DataCellSet& dataSet)
+{
+  if(dataSet.empty()) {
+    return;
+  }
+  std::vector<DataBuffer> bufs;
+  off_t start = 0;
+  off_t end = 0;
+  for(DataCellSet::const_iterator i = dataSet.begin(), eoi = dataSet.end();
+      i != eoi; ++i) {
+    if(bufs.empty() || (*i)->goff != end) {
+      if(!bufs.empty()) {
+        diskAdaptor->writeDataVector(bufs, start);
+        bufs.clear();
+      }
+      start = (*i)->goff;
+    }
+    bufs.push_back(DataBuffer((*i)->data, (*i)->len));
+    end = (*i)->goff+(*i)->len;
+  }
+  diskAdaptor->writeDataVector(bufs, start);
+}
+
+} // namespace aria2
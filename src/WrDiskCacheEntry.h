@@ -0,0 +1,187 @@
+/* <!-- copyright */
+/*
+ * aria2 - The high speed download utility
+ *
+ * Copyright (C) 2011 Tatsuhiro Tsujikawa
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * In addition, as a special exception, the copyright holders give
+ * permission to link the code of portions of this program with the
+ * OpenSSL library under certain conditions as described in each
+ * individual source file, and distribute linked combinations
+ * including the two.
+ * You must obey the GNU General Public License in all respects
+ * for all of the code used other than OpenSSL.  If you modify
+ * file(s) with this exception, you may extend this exception to your
+ * version of the file(s), but you are not obligated to do so.  If you
+ * do not wish to do so, delete this exception statement from your
+ * version.  If you delete this exception statement from all source
+ * files in the program, then also delete it here.
+ */
+/* copyright --> */
+#ifndef D_WR_DISK_CACHE_ENTRY_H
+#define D_WR_DISK_CACHE_ENTRY_H
+
+#include "common.h"
+
+#include <set>
+
+#include "SharedHandle.h"
+
+namespace aria2 {
+
+class DiskAdaptor;
+class WrDiskCache;
+class FreeList;
+
+// Holds the data of one Piece which is received but not yet written
+// to the disk. The data are written to diskAdaptor when writeToDisk()
+// is called. This object does not update WrDiskCache by itself; the
+// owner must report the change of size to the cache.
+class WrDiskCacheEntry {
+public:
+  struct DataCell {
+    // Global offset in diskAdaptor
+    off_t goff;
+    unsigned char* data;
+    size_t len;
+    // If not null, data was allocated by freeList and is returned to
+    // it. Otherwise data is deleted by delete [].
+    FreeList* freeList;
+  };
+
+  struct DataCellLess {
+    bool operator()(const DataCell* lhs, const DataCell* rhs) const
+    {
+      return lhs->goff < rhs->goff;
+    }
+  };
+
+  typedef std::set<DataCell*, DataCellLess> DataCellSet;
+
+  WrDiskCacheEntry(WrDiskCache* cache,
+                   const SharedHandle<DiskAdaptor>& diskAdaptor);
+
+  // Discards cached data without writing them.
+  ~WrDiskCacheEntry();
+
+  // Stores dataCell in this entry. This object takes ownership of
+  // dataCell and dataCell->data, which must be allocated by new
+  // unsigned char[] or by dataCell->freeList. Where dataCell overlaps
+  // the cells already cached, the data of dataCell replace theirs and
+  // the cells are trimmed or removed, so that no two cells overlap.
+  // Returns the increase of cached bytes, which may be negative.
+  ssize_t cacheData(DataCell* dataCell);
+
+  // Writes all cached data to diskAdaptor and discards them.
+  // Contiguous cells are written with one vectored write.
+  void writeToDisk();
+
+  // Moves all cached data to dataSet, which must be empty. The caller
+  // takes ownership of them.
+  void swapDataSet(DataCellSet& dataSet);
+
+  // Writes dataSet to diskAdaptor. Contiguous cells are written with
+  // one vectored write. This function does not touch any other object
+  // and may be called in a worker thread if diskAdaptor is thread
+  // safe.
+  static void writeDataCells(const SharedHandle<DiskAdaptor>& diskAdaptor,
+                             const DataCellSet& dataSet);
+
+  // Deletes dataCell and its data.
+  static void deleteDataCell(DataCell* dataCell);
+
+  // Deletes all cells in dataSet and clears it.
+  static void deleteDataCells(DataCellSet& dataSet);
+
+  // Discards all cached data without writing them.
+  void deleteDataCells();
+
+  size_t getSize() const
+  {
+    return size_;
+  }
+
+  const DataCellSet& getDataSet() const
+  {
+    return set_;
+  }
+
+  WrDiskCache* getCache() const
+  {
+    return cache_;
+  }
+
+  const SharedHandle<DiskAdaptor>& getDiskAdaptor() const
+  {
+    return diskAdaptor_;
+  }
+
+  // The number of asynchronous writes of this entry which are not
+  // finished yet.
+  size_t getPendingWrite() const
+  {
+    return pendingWrite_;
+  }
+
+  void incPendingWrite()
+  {
+    ++pendingWrite_;
+  }
+
+  void decPendingWrite()
+  {
+    --pendingWrite_;
+  }
+
+  // True if an asynchronous write of this entry failed and the data
+  // were lost.
+  bool getWriteError() const
+  {
+    return writeError_;
+  }
+
+  void setWriteError(bool f)
+  {
+    writeError_ = f;
+  }
+
+  // Used by WrDiskCache to decide the order of eviction.
+  int64_t getLastUpdate() const
+  {
+    return lastUpdate_;
+  }
+
+  void setLastUpdate(int64_t lastUpdate)
+  {
+    lastUpdate_ = lastUpdate;
+  }
+private:
+  WrDiskCache* cache_;
+  SharedHandle<DiskAdaptor> diskAdaptor_;
+  DataCellSet set_;
+  size_t size_;
+  int64_t lastUpdate_;
+  size_t pendingWrite_;
+  bool writeError_;
+
+  WrDiskCacheEntry(const WrDiskCacheEntry&);
+  WrDiskCacheEntry& operator=(const WrDiskCacheEntry&);
+};
+
+} // namespace aria2
+
+#endif // D_WR_DISK_CACHE_ENTRY_H
@@ -34,10 +34,318 @@
 /* copyright --> */
 #include "bitfield.h"
 
+#ifdef HAVE_X86_AVX2_INTRINSICS
+# include <cpuid.h>
+# include <immintrin.h>
+#endif // HAVE_X86_AVX2_INTRINSICS
+
 namespace aria2 {
 
 namespace bitfield {
 
+// The kernels below process whole bytes. The callers take care of the
+// bits after nbits in the last byte.
+
+namespace {
+inline uint64_t load64(const unsigned char* p)
+{
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+} // namespace
+
+namespace {
+inline size_t countBytesGeneric(const unsigned char* p, size_t len)
+{
+  size_t count = 0;
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    count += countBit64(load64(p+i));
+  }
+  for(; i < len; ++i) {
+    count += countBit64(p[i]);
+  }
+  return count;
+}
+} // namespace
+
+namespace {
+inline size_t countAndBytesGeneric
+(const unsigned char* p, const unsigned char* q, size_t len)
+{
+  size_t count = 0;
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    count += countBit64(load64(p+i)&load64(q+i));
+  }
+  for(; i < len; ++i) {
+    count += countBit64(p[i]&q[i]);
+  }
+  return count;
+}
+} // namespace
+
+namespace {
+bool andNotBytesGeneric
+(unsigned char* dst,
+ const unsigned char* a, const unsigned char* b,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  uint64_t bits = 0;
+  size_t i = 0;
+  if(dst) {
+    for(; i+8 <= len; i += 8) {
+      uint64_t v = load64(a+i)&load64(b+i)&~(load64(n1+i)|load64(n2+i));
+      memcpy(dst+i, &v, sizeof(v));
+      bits |= v;
+    }
+    for(; i < len; ++i) {
+      dst[i] = a[i]&b[i]&~(n1[i]|n2[i]);
+      bits |= dst[i];
+    }
+  } else {
+    for(; i+8 <= len; i += 8) {
+      if(load64(a+i)&load64(b+i)&~(load64(n1+i)|load64(n2+i))) {
+        return true;
+      }
+    }
+    for(; i < len; ++i) {
+      bits |= a[i]&b[i]&~(n1[i]|n2[i]);
+    }
+  }
+  return bits != 0;
+}
+} // namespace
+
+#ifdef HAVE_X86_AVX2_INTRINSICS
+
+namespace {
+// Same as countBytesGeneric, but __builtin_popcountll becomes the
+// POPCNT instruction.
+__attribute__((target("popcnt")))
+size_t countBytesPopcnt(const unsigned char* p, size_t len)
+{
+  size_t count = 0;
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    count += __builtin_popcountll(load64(p+i));
+  }
+  for(; i < len; ++i) {
+    count += __builtin_popcountll(p[i]);
+  }
+  return count;
+}
+} // namespace
+
+namespace {
+__attribute__((target("popcnt")))
+size_t countAndBytesPopcnt
+(const unsigned char* p, const unsigned char* q, size_t len)
+{
+  size_t count = 0;
+  size_t i = 0;
+  for(; i+8 <= len; i += 8) {
+    count += __builtin_popcountll(load64(p+i)&load64(q+i));
+  }
+  for(; i < len; ++i) {
+    count += __builtin_popcountll(p[i]&q[i]);
+  }
+  return count;
+}
+} // namespace
+
+namespace {
+__attribute__((target("avx2")))
+bool andNotBytesAvx2
+(unsigned char* dst,
+ const unsigned char* a, const unsigned char* b,
+ const unsigned char* n1, const unsigned char* n2,
+ size_t len)
+{
+  __m256i bits = _mm256_setzero_si256();
+  size_t i = 0;
+  for(; i+32 <= len; i += 32) {
+    __m256i v = _mm256_and_si256
+      (_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i)),
+       _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i)));
+    v = _mm256_andnot_si256
+      (_mm256_or_si256
+       (_mm256_loadu_si256(reinterpret_cast<const __m256i*>(n1+i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(n2+i))),
+       v);
+    if(dst) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst+i), v);
+      bits = _mm256_or_si256(bits, v);
+    } else if(!_mm256_testz_si256(v, v)) {
+      return true;
+    }
+  }
+  bool found = !_mm256_testz_si256(bits, bits);
+  return andNotBytesGeneric(dst ? dst+i : 0, a+i, b+i, n1+i, n2+i, len-i) ||
+    found;
+}
+} // namespace
+
+namespace {
+bool cpuSupports(bool& popcnt, bool& avx2)
+{
+  unsigned int eax, ebx, ecx, edx;
+  popcnt = avx2 = false;
+  if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+    return false;
+  }
+  popcnt = ecx & (1 << 23);
+  // The OS must save the YMM registers.
+  if(!(ecx & (1 << 27))) {
+    return true;
+  }
+  unsigned int xcr0, xcr0hi;
+  __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0hi) : "c"(0));
+  if((xcr0 & 0x6) != 0x6 || __get_cpuid_max(0, 0) < 7) {
+    return true;
+  }
+  __cpuid_count(7, 0, eax, ebx, ecx, edx);
+  avx2 = ebx & (1 << 5);
+  return true;
+}
+} // namespace
+
+#endif // HAVE_X86_AVX2_INTRINSICS
+
+namespace {
+struct Kernel {
+  const char* name;
+  size_t (*countBytes)(const unsigned char* p, size_t len);
+  size_t (*countAndBytes)
+  (const unsigned char* p, const unsigned char* q, size_t len);
+  bool (*andNotBytes)
+  (unsigned char* dst,
+   const unsigned char* a, const unsigned char* b,
+   const unsigned char* n1, const unsigned char* n2,
+   size_t len);
+};
+} // namespace
+
+namespace {
+size_t countBytesGenericFun(const unsigned char* p, size_t len)
+{
+  return countBytesGeneric(p, len);
+}
+} // namespace
+
+namespace {
+size_t countAndBytesGenericFun
+(const unsigned char* p, const unsigned char* q, size_t len)
+{
+  return countAndBytesGeneric(p, q, len);
+}
+} // namespace
+
+namespace {
+Kernel selectKernel()
+{
+  Kernel kernel = { "generic", countBytesGenericFun, countAndBytesGenericFun,
+                    andNotBytesGeneric };
+#ifdef HAVE_X86_AVX2_INTRINSICS
+  bool popcnt, avx2;
+  cpuSupports(popcnt, avx2);
+  if(popcnt) {
+    kernel.name = "popcnt";
+    kernel.countBytes = countBytesPopcnt;
+    kernel.countAndBytes = countAndBytesPopcnt;
+  }
+  if(avx2) {
+    kernel.name = popcnt ? "avx2,popcnt" : "avx2";
+    kernel.andNotBytes = andNotBytesAvx2;
+  }
+#endif // HAVE_X86_AVX2_INTRINSICS
+  return kernel;
+}
+} // namespace
+
+namespace {
+const Kernel& getKernel()
+{
+  static Kernel kernel = selectKernel();
+  return kernel;
+}
+} // namespace
+
+const char* getKernelName()
+{
+  return getKernel().name;
+}
+
+size_t countSetBit(const unsigned char* bitfield, size_t nbits)
+{
+  if(nbits == 0) {
+    return 0;
+  }
+  size_t len = (nbits+7)/8;
+  return getKernel().countBytes(bitfield, len-1)+
+    countBit64(bitfield[len-1]&lastByteMask(nbits));
+}
+
+size_t countSetBitAnd
+(const unsigned char* bitfield1, const unsigned char* bitfield2, size_t nbits)
+{
+  if(nbits == 0) {
+    return 0;
+  }
+  size_t len = (nbits+7)/8;
+  return getKernel().countAndBytes(bitfield1, bitfield2, len-1)+
+    countBit64(bitfield1[len-1]&bitfield2[len-1]&lastByteMask(nbits));
+}
+
+bool andNot(unsigned char* dst,
+            const unsigned char* a, const unsigned char* b,
+            const unsigned char* n1, const unsigned char* n2,
+            size_t nbits)
+{
+  if(nbits == 0) {
+    return false;
+  }
+  size_t len = (nbits+7)/8;
+  if(!a) {
+    std::swap(a, b);
+  }
+  if(!n1) {
+    std::swap(n1, n2);
+  }
+  bool found = false;
+  if(a && n1) {
+    // The kernels take all 4 operands. x&x == x and ~x&~x == ~x.
+    found = getKernel().andNotBytes(dst, a, b ? b : a, n1, n2 ? n2 : n1,
+                                    len-1);
+    if(found && !dst) {
+      return true;
+    }
+  } else {
+    for(size_t i = 0; i < len-1; ++i) {
+      unsigned char v = 0xffu;
+      if(a) v &= a[i];
+      if(b) v &= b[i];
+      if(n1) v &= ~n1[i];
+      if(n2) v &= ~n2[i];
+      if(dst) {
+        dst[i] = v;
+      }
+      found |= v != 0;
+    }
+  }
+  unsigned char v = lastByteMask(nbits);
+  if(a) v &= a[len-1];
+  if(b) v &= b[len-1];
+  if(n1) v &= ~n1[len-1];
+  if(n2) v &= ~n2[len-1];
+  if(dst) {
+    dst[len-1] = v;
+  }
+  return found || v != 0;
+}
+
 void flipBit(unsigned char* data, size_t length, size_t bitIndex)
 {
   size_t byteIndex = bitIndex/8;
@@ -40,6 +40,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 
 #include "util.h"
 
@@ -99,34 +100,121 @@ inline size_t countBit32(uint32_t n)
     nbits[(n >> 24)&0xffu];
 }
 
+inline size_t countBit64(uint64_t n)
+{
+  n = n-((n >> 1)&0x5555555555555555ULL);
+  n = (n&0x3333333333333333ULL)+((n >> 2)&0x3333333333333333ULL);
+  n = (n+(n >> 4))&0x0f0f0f0f0f0f0f0fULL;
+  return (n*0x0101010101010101ULL) >> 56;
+}
+
+// Returns the number of leading 0 bits in n. n must not be 0.
+inline size_t countLeadingZero64(uint64_t n)
+{
+  assert(n);
+#ifdef HAVE_BUILTIN_CLZLL
+  return __builtin_clzll(n);
+#else // !HAVE_BUILTIN_CLZLL
+  size_t count = 0;
+  for(size_t shift = 32; shift > 0; shift /= 2) {
+    if((n >> (64-shift)) == 0) {
+      count += shift;
+      n <<= shift;
+    }
+  }
+  return count;
+#endif // !HAVE_BUILTIN_CLZLL
+}
+
+// Returns 8 bytes of bitfield starting at offset as an integer, so
+// that the first bit becomes the most significant bit. The bytes at
+// len or later are read as 0.
+template<typename Array>
+inline uint64_t loadWord(const Array& bitfield, size_t offset, size_t len)
+{
+  uint64_t word = 0;
+  if(offset+8 <= len) {
+    for(size_t i = offset; i < offset+8; ++i) {
+      word = (word << 8)|static_cast<unsigned char>(bitfield[i]);
+    }
+  } else {
+    for(size_t i = offset; i < offset+8; ++i) {
+      word <<= 8;
+      if(i < len) {
+        word |= static_cast<unsigned char>(bitfield[i]);
+      }
+    }
+  }
+  return word;
+}
+
 // Counts set bit in bitfield.
-inline size_t countSetBit(const unsigned char* bitfield, size_t nbits)
+size_t countSetBit(const unsigned char* bitfield, size_t nbits);
+
+// Counts set bit in bitfield1 & bitfield2.
+size_t countSetBitAnd
+(const unsigned char* bitfield1, const unsigned char* bitfield2, size_t nbits);
+
+// Stores a & b & ~n1 & ~n2 to dst. Any of a, b, n1 and n2 can be 0,
+// which means it is not used. All bitfields contain nbits bits. The
+// bits after nbits in the last byte of dst are cleared. If dst is 0,
+// the result is not stored. Returns true if the result has any set
+// bit.
+bool andNot(unsigned char* dst,
+            const unsigned char* a, const unsigned char* b,
+            const unsigned char* n1, const unsigned char* n2,
+            size_t nbits);
+
+// Returns the name of the instruction set used by countSetBit() and
+// andNot().
+const char* getKernelName();
+
+void flipBit(unsigned char* data, size_t length, size_t bitIndex);
+
+// Returns the index of the first set bit at from or later in
+// bitfield, which contains nbits bits. If there is no such bit,
+// returns nbits.
+template<typename Array>
+size_t getNextSetBitIndex(const Array& bitfield, size_t nbits, size_t from)
 {
-  if(nbits == 0) {
-    return 0;
+  if(from >= nbits) {
+    return nbits;
   }
-  size_t count = 0;
-  size_t size = sizeof(uint32_t);
   size_t len = (nbits+7)/8;
-  if(nbits%32 != 0) {
-    --len;
-    count +=
-      countBit32(static_cast<uint32_t>(bitfield[len]&lastByteMask(nbits)));
+  size_t offset = from/8;
+  uint64_t word = loadWord(bitfield, offset, len)&(~0ULL >> (from%8));
+  while(word == 0) {
+    offset += 8;
+    if(offset >= len) {
+      return nbits;
+    }
+    word = loadWord(bitfield, offset, len);
   }
-  size_t to = len/size;
-  for(size_t i = 0; i < to; ++i) {
-    uint32_t v;
-    memcpy(&v, &bitfield[i*size], sizeof(v));
-    count += countBit32(v);
+  return std::min(nbits, offset*8+countLeadingZero64(word));
+}
+
+// Returns the index of the first unset bit at from or later in
+// bitfield, which contains nbits bits. If there is no such bit,
+// returns nbits.
+template<typename Array>
+size_t getNextUnsetBitIndex(const Array& bitfield, size_t nbits, size_t from)
+{
+  if(from >= nbits) {
+    return nbits;
   }
-  for(size_t i = len-len%size; i < len; ++i) {
-    count += countBit32(static_cast<uint32_t>(bitfield[i]));
+  size_t len = (nbits+7)/8;
+  size_t offset = from/8;
+  uint64_t word = ~loadWord(bitfield, offset, len)&(~0ULL >> (from%8));
+  while(word == 0) {
+    offset += 8;
+    if(offset >= len) {
+      return nbits;
+    }
+    word = ~loadWord(bitfield, offset, len);
   }
-  return count;
+  return std::min(nbits, offset*8+countLeadingZero64(word));
 }
 
-void flipBit(unsigned char* data, size_t length, size_t bitIndex);
-
 // Stores first set bit index of bitfield to index.  bitfield contains
 // nbits. Returns true if missing bit index is found. Otherwise
 // returns false.
@@ -134,13 +222,13 @@ template<typename Array>
 bool getFirstSetBitIndex
 (size_t& index, const Array& bitfield, size_t nbits)
 {
-  for(size_t i = 0; i < nbits; ++i) {
-    if(bitfield::test(bitfield, nbits, i)) {
-      index = i;
-      return true;
-    }
+  size_t i = getNextSetBitIndex(bitfield, nbits, 0);
+  if(i == nbits) {
+    return false;
+  } else {
+    index = i;
+    return true;
   }
-  return false;
 }
 
 // Appends first at most n set bit index in bitfield to out.  bitfield
@@ -153,12 +241,20 @@ size_t getFirstNSetBitIndex
     return 0;
   }
   const size_t origN = n;
-  for(size_t i = 0; i < nbits; ++i) {
-    if(bitfield::test(bitfield, nbits, i)) {
+  size_t len = (nbits+7)/8;
+  for(size_t offset = 0; offset < len; offset += 8) {
+    uint64_t word = loadWord(bitfield, offset, len);
+    while(word) {
+      size_t bit = countLeadingZero64(word);
+      size_t i = offset*8+bit;
+      if(i >= nbits) {
+        return origN-n;
+      }
       *out++ = i;
       if(--n == 0) {
-        break;
+        return origN;
       }
+      word &= ~(0x8000000000000000ULL >> bit);
     }
   }
   return origN-n;
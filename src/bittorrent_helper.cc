@@ -60,6 +60,7 @@
 #include "FileEntry.h"
 #include "error_code.h"
 #include "array_fun.h"
+#include "FreeList.h"
 
 namespace aria2 {
 
@@ -701,6 +702,13 @@ const unsigned char* getStaticPeerId()
   }
 }
 
+FreeList& getBlockBufferList()
+{
+  // 256 buffers are 4MiB.
+  static FreeList* freeList = new FreeList(MAX_BLOCK_LENGTH, 256);
+  return *freeList;
+}
+
 uint8_t getId(const unsigned char* msg)
 {
   return msg[0];
@@ -56,6 +56,7 @@ namespace aria2 {
 class DownloadContext;
 class Randomizer;
 class Option;
+class FreeList;
 
 namespace bittorrent {
 
@@ -140,6 +141,12 @@ const unsigned char* getStaticPeerId();
 // length.
 void setStaticPeerId(const std::string& newPeerId);
 
+// Returns the free list of MAX_BLOCK_LENGTH bytes buffers shared by
+// all peers. The buffers hold blocks being uploaded and blocks
+// received until they are written to the disk. It must be used only
+// in the main thread.
+FreeList& getBlockBufferList();
+
 // Computes fast set index and stores them in fastset.
 void computeFastSet
 (std::vector<size_t>& fastSet, const std::string& ipaddr,
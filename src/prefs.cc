@@ -132,6 +132,7 @@ const std::string A2_V_FULL("full");
 const std::string A2_V_GEOM("geom");
 const std::string V_PREALLOC("prealloc");
 const std::string V_FALLOC("falloc");
+const std::string V_MMAP("mmap");
 const std::string V_DEBUG("debug");
 const std::string V_INFO("info");
 const std::string V_NOTICE("notice");
@@ -141,6 +142,7 @@ const std::string V_INORDER("inorder");
 const std::string V_FEEDBACK("feedback");
 const std::string V_ADAPTIVE("adaptive");
 const std::string V_EPOLL("epoll");
+const std::string V_IO_URING("io_uring");
 const std::string V_KQUEUE("kqueue");
 const std::string V_PORT("port");
 const std::string V_POLL("poll");
@@ -197,6 +199,9 @@ const Pref* PREF_STARTUP_IDLE_TIME = makePref("startup-idle-time");
 const Pref* PREF_FILE_ALLOCATION = makePref("file-allocation");
 // value: 1*digit
 const Pref* PREF_NO_FILE_ALLOCATION_LIMIT = makePref("no-file-allocation-limit");
+const Pref* PREF_DISK_CACHE = makePref("disk-cache");
+// value: default | mmap
+const Pref* PREF_FILE_IO = makePref("file-io");
 // value: true | false
 const Pref* PREF_ALLOW_OVERWRITE = makePref("allow-overwrite");
 // value: true | false
@@ -251,7 +256,7 @@ const Pref* PREF_SERVER_STAT_OF = makePref("server-stat-of");
 const Pref* PREF_REMOTE_TIME = makePref("remote-time");
 // value: 1*digit
 const Pref* PREF_MAX_FILE_NOT_FOUND = makePref("max-file-not-found");
-// value: epoll | select
+// value: epoll | io_uring | kqueue | port | poll | select
 const Pref* PREF_EVENT_POLL = makePref("event-poll");
 // value: true | false
 const Pref* PREF_ENABLE_RPC = makePref("enable-rpc");
@@ -319,8 +324,18 @@ const Pref* PREF_PAUSE = makePref("pause");
 const Pref* PREF_DOWNLOAD_RESULT = makePref("download-result");
 // value: true | false
 const Pref* PREF_HASH_CHECK_ONLY = makePref("hash-check-only");
+// value: true | false
+const Pref* PREF_FAST_RESUME = makePref("fast-resume");
 // values: hashType=digest
 const Pref* PREF_CHECKSUM = makePref("checksum");
+// value: true | false
+const Pref* PREF_ENABLE_READY_QUEUE = makePref("enable-ready-queue");
+// value: 1*digit
+const Pref* PREF_WORKER_THREADS = makePref("worker-threads");
+// value: true | false
+const Pref* PREF_ENABLE_ENGINE_STATS = makePref("enable-engine-stats");
+// value: true | false
+const Pref* PREF_ENABLE_SPLICE = makePref("enable-splice");
 
 /**
  * FTP related preferences
@@ -493,6 +508,8 @@ const Pref* PREF_ON_BT_DOWNLOAD_COMPLETE = makePref("on-bt-download-complete");
 const Pref* PREF_BT_TRACKER = makePref("bt-tracker");
 // values: string
 const Pref* PREF_BT_EXCLUDE_TRACKER = makePref("bt-exclude-tracker");
+// values: true | false
+const Pref* PREF_BT_SUPER_SEEDING = makePref("bt-super-seeding");
 
 /**
  * Metalink related preferences
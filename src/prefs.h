@@ -75,6 +75,7 @@ extern const std::string A2_V_FULL;
 extern const std::string A2_V_GEOM;
 extern const std::string V_PREALLOC;
 extern const std::string V_FALLOC;
+extern const std::string V_MMAP;
 extern const std::string V_DEBUG;
 extern const std::string V_INFO;
 extern const std::string V_NOTICE;
@@ -84,6 +85,7 @@ extern const std::string V_INORDER;
 extern const std::string V_FEEDBACK;
 extern const std::string V_ADAPTIVE;
 extern const std::string V_EPOLL;
+extern const std::string V_IO_URING;
 extern const std::string V_KQUEUE;
 extern const std::string V_PORT;
 extern const std::string V_POLL;
@@ -138,6 +140,10 @@ extern const Pref* PREF_STARTUP_IDLE_TIME;
 extern const Pref* PREF_FILE_ALLOCATION;
 // value: 1*digit
 extern const Pref* PREF_NO_FILE_ALLOCATION_LIMIT;
+// value: 1*digit
+extern const Pref* PREF_DISK_CACHE;
+// value: default | mmap
+extern const Pref* PREF_FILE_IO;
 // value: true | false
 extern const Pref* PREF_ALLOW_OVERWRITE;
 // value: true | false
@@ -194,7 +200,7 @@ extern const Pref* PREF_SERVER_STAT_OF;
 extern const Pref* PREF_REMOTE_TIME;
 // value: 1*digit
 extern const Pref* PREF_MAX_FILE_NOT_FOUND;
-// value: epoll | select
+// value: epoll | io_uring | kqueue | port | poll | select
 extern const Pref* PREF_EVENT_POLL;
 // value: true | false
 extern const Pref* PREF_ENABLE_RPC;
@@ -262,6 +268,8 @@ extern const Pref* PREF_PAUSE;
 extern const Pref* PREF_DOWNLOAD_RESULT;
 // value: true | false
 extern const Pref* PREF_HASH_CHECK_ONLY;
+// value: true | false
+extern const Pref* PREF_FAST_RESUME;
 
 /**
  * FTP related preferences
@@ -276,6 +284,14 @@ extern const Pref* PREF_FTP_PASV;
 extern const Pref* PREF_FTP_REUSE_CONNECTION;
 // values: hashType=digest
 extern const Pref* PREF_CHECKSUM;
+// value: true | false
+extern const Pref* PREF_ENABLE_READY_QUEUE;
+// value: 1*digit
+extern const Pref* PREF_WORKER_THREADS;
+// value: true | false
+extern const Pref* PREF_ENABLE_ENGINE_STATS;
+// value: true | false
+extern const Pref* PREF_ENABLE_SPLICE;
 
 /**
  * HTTP related preferences
@@ -436,6 +452,8 @@ extern const Pref* PREF_ON_BT_DOWNLOAD_COMPLETE;
 extern const Pref* PREF_BT_TRACKER;
 // values: string
 extern const Pref* PREF_BT_EXCLUDE_TRACKER;
+// values: true | false
+extern const Pref* PREF_BT_SUPER_SEEDING;
 
 /**
  * Metalink related preferences
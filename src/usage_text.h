@@ -138,6 +138,28 @@
     "                              blocks aria2 entirely until allocation finishes.\n" \
     "                              'falloc' may not be available if your system\n" \
     "                              doesn't have posix_fallocate() function.")
+#define TEXT_DISK_CACHE                                                 \
+  _(" --disk-cache=SIZE            Enable disk cache. If SIZE is 0, the disk cache\n" \
+    "                              is disabled. Received data are held in memory\n" \
+    "                              and written to the disk in larger chunks, for\n" \
+    "                              example, when a piece is completed. SIZE is the\n" \
+    "                              total amount of memory used by the cache for all\n" \
+    "                              downloads. You can append K or M\n" \
+    "                              (1K = 1024, 1M = 1024K).")
+#define TEXT_FILE_IO                                                    \
+  _(" --file-io=METHOD             Specify the method used to access a downloaded\n" \
+    "                              file. 'default' uses read and write system\n" \
+    "                              calls. 'mmap' maps the file into memory and\n" \
+    "                              copies data from and to the mapped region. 'mmap'\n" \
+    "                              is only used for downloads which consist of a\n" \
+    "                              single file preallocated by\n" \
+    "                              --file-allocation=prealloc or falloc, because a\n" \
+    "                              write to a mapped sparse file kills aria2 with\n" \
+    "                              SIGBUS when the disk is full. Files with holes\n" \
+    "                              and files on copy-on-write file systems are not\n" \
+    "                              mapped either. Otherwise, 'default' is used.\n" \
+    "                              'mmap' may not be available if your system\n" \
+    "                              doesn't have mmap() function.")
 #define TEXT_NO_FILE_ALLOCATION_LIMIT                                   \
   _(" --no-file-allocation-limit=SIZE No file allocation is made for files whose\n" \
     "                              size is smaller than SIZE.\n"        \
@@ -335,8 +357,9 @@
     "                              download speed in some cases.\n"     \
     "                              You can append K or M(1K = 1024, 1M = 1024K).")
 #define TEXT_BT_MAX_OPEN_FILES                                          \
-  _(" --bt-max-open-files=NUM      Specify maximum number of files to open in each\n" \
-    "                              BitTorrent download.")
+  _(" --bt-max-open-files=NUM      Specify maximum number of files to open in\n" \
+    "                              multi-file BitTorrent and Metalink downloads.\n" \
+    "                              The limit is shared by all downloads.")
 #define TEXT_BT_SEED_UNVERIFIED                                         \
   _(" --bt-seed-unverified[=true|false] Seed previously downloaded files without\n" \
     "                              verifying piece hashes.")
@@ -734,6 +757,13 @@
     "                              announce URIs. When specifying '*' in shell\n" \
     "                              command-line, don't forget to escape or quote it.\n" \
     "                              See also --bt-tracker option.")
+#define TEXT_BT_SUPER_SEEDING                                           \
+  _(" --bt-super-seeding[=true|false] Enable super-seeding (BEP 16). When seeding,\n" \
+    "                              peers are shown one piece at a time and get the\n" \
+    "                              next piece after the previous one is seen on\n" \
+    "                              another peer. This reduces the amount of data the\n" \
+    "                              initial seeder uploads. Use this only when this\n" \
+    "                              is the only seeder.")
 #define TEXT_MAX_DOWNLOAD_RESULT                \
   _(" --max-download-result=NUM    Set maximum number of download result kept in\n" \
     "                              memory. The download results are completed/error/\n" \
@@ -836,6 +866,14 @@
   _(" --hash-check-only[=true|false] If true is given, after hash check using\n" \
     "                              --check-integrity option, abort download whether\n" \
     "                              or not download is complete.")
+#define TEXT_FAST_RESUME                        \
+  _(" --fast-resume[=true|false]   When checking piece hashes with\n" \
+    "                              --check-integrity option, trust the progress\n" \
+    "                              saved in the control file for the files whose\n" \
+    "                              size and modification time have not changed\n" \
+    "                              since the control file was saved, and only hash\n" \
+    "                              the pieces in the other files. The control file\n" \
+    "                              is kept after the download completes.")
 #define TEXT_CHECKSUM                                                   \
   _(" --checksum=TYPE=DIGEST       Set checksum. TYPE is hash type. The supported\n" \
     "                              hash type is listed in \"Hash Algorithms\" in\n" \
@@ -852,3 +890,30 @@
     "                              option will be ignored in BitTorrent downloads.\n" \
     "                              It will be also ignored if Metalink file\n" \
     "                              contains piece hashes.")
+#define TEXT_ENABLE_READY_QUEUE                 \
+  _(" --enable-ready-queue[=true|false] Execute only commands whose sockets are\n" \
+    "                              reported ready by event poll, instead of\n" \
+    "                              checking all commands in every loop. Idle\n" \
+    "                              commands are still checked once per second for\n" \
+    "                              timeout. This reduces CPU usage when many\n" \
+    "                              connections are open.")
+#define TEXT_ENABLE_ENGINE_STATS                \
+  _(" --enable-engine-stats[=true|false] Record call count and execution time of\n" \
+    "                              each kind of command run by the download\n" \
+    "                              engine. The statistics can be retrieved by\n" \
+    "                              aria2.getEngineStats RPC method.")
+#define TEXT_ENABLE_SPLICE                      \
+  _(" --enable-splice[=true|false] Move data received by plain HTTP and FTP\n" \
+    "                              connections to files with splice(2), without\n" \
+    "                              copying them to user space. It is only used\n" \
+    "                              when the response is neither compressed nor\n" \
+    "                              chunked, --realtime-chunk-checksum is not in\n" \
+    "                              effect and the file is on disk. This option is\n" \
+    "                              ignored on platforms without splice(2).")
+#define TEXT_WORKER_THREADS                     \
+  _(" --worker-threads=N           Start N worker threads and hand blocking work,\n" \
+    "                              such as synchronous name resolution, writing\n" \
+    "                              the disk cache and hash checking of pieces, to\n" \
+    "                              them instead of doing it in the main event loop.\n" \
+    "                              If 0 is given, all work is done in the main\n" \
+    "                              thread.")
@@ -0,0 +1,238 @@
+// Microbenchmarks for bitfield.h and BitfieldMan against the byte at
+// a time implementations they replaced. Build with "make
+// BitfieldBench" and run without arguments.
+#include "common.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "bitfield.h"
+#include "BitfieldMan.h"
+#include "array_fun.h"
+
+using namespace aria2;
+using namespace aria2::expr;
+
+namespace {
+
+const size_t NUM_BLOCKS = 1024*1024;
+const size_t BLOCK_LENGTH = 16*1024;
+const int REPEAT = 50;
+
+// The previous implementations.
+namespace old {
+
+size_t countSetBit(const unsigned char* bitfield, size_t nbits)
+{
+  if(nbits == 0) {
+    return 0;
+  }
+  size_t count = 0;
+  size_t size = sizeof(uint32_t);
+  size_t len = (nbits+7)/8;
+  if(nbits%32 != 0) {
+    --len;
+    count += bitfield::countBit32
+      (static_cast<uint32_t>(bitfield[len]&bitfield::lastByteMask(nbits)));
+  }
+  size_t to = len/size;
+  for(size_t i = 0; i < to; ++i) {
+    uint32_t v;
+    memcpy(&v, &bitfield[i*size], sizeof(v));
+    count += bitfield::countBit32(v);
+  }
+  for(size_t i = len-len%size; i < len; ++i) {
+    count += bitfield::countBit32(static_cast<uint32_t>(bitfield[i]));
+  }
+  return count;
+}
+
+template<typename Array>
+bool getFirstSetBitIndex(size_t& index, const Array& bitfield, size_t nbits)
+{
+  for(size_t i = 0; i < nbits; ++i) {
+    if(bitfield::test(bitfield, nbits, i)) {
+      index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename Array>
+bool copyBitfield(unsigned char* dst, const Array& src, size_t blocks)
+{
+  unsigned char bits = 0;
+  size_t len = (blocks+7)/8;
+  for(size_t i = 0; i < len-1; ++i) {
+    dst[i] = src[i];
+    bits |= dst[i];
+  }
+  dst[len-1] = src[len-1]&bitfield::lastByteMask(blocks);
+  bits |= dst[len-1];
+  return bits != 0;
+}
+
+bool hasMissingPiece(const unsigned char* peer, const unsigned char* bf,
+                     size_t len)
+{
+  for(size_t i = 0; i < len; ++i) {
+    if(peer[i]&~bf[i]) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace old
+
+class Timer {
+private:
+  clock_t start_;
+public:
+  Timer():start_(clock()) {}
+
+  // Returns elapsed time per iteration in microseconds.
+  double perIteration() const
+  {
+    return static_cast<double>(clock()-start_)*1000000/CLOCKS_PER_SEC/REPEAT;
+  }
+};
+
+void report(const char* name, double oldUs, double newUs, bool same)
+{
+  std::cout << name << ": old " << oldUs << " us, new " << newUs
+            << " us, speedup " << (newUs > 0 ? oldUs/newUs : 0)
+            << (same ? "" : " RESULT MISMATCH") << std::endl;
+}
+
+void fillRandom(unsigned char* p, size_t len, int density)
+{
+  // Each bit is set with probability density/8.
+  for(size_t i = 0; i < len; ++i) {
+    unsigned char v = 0;
+    for(int j = 0; j < 8; ++j) {
+      v = (v << 1)|(rand()%8 < density ? 1 : 0);
+    }
+    p[i] = v;
+  }
+}
+
+} // namespace
+
+int main()
+{
+  srand(0);
+  const size_t len = (NUM_BLOCKS+7)/8;
+  std::vector<unsigned char> have(len), use(len), peer(len), dst1(len),
+    dst2(len);
+  fillRandom(&have[0], len, 7);
+  fillRandom(&use[0], len, 1);
+  fillRandom(&peer[0], len, 4);
+
+  std::cout << "blocks: " << NUM_BLOCKS << ", kernel: "
+            << bitfield::getKernelName() << std::endl;
+
+  volatile size_t sink = 0;
+  {
+    size_t r1 = 0, r2 = 0;
+    Timer t1;
+    for(int i = 0; i < REPEAT; ++i) {
+      r1 = old::countSetBit(&have[0], NUM_BLOCKS-3);
+    }
+    double o = t1.perIteration();
+    Timer t2;
+    for(int i = 0; i < REPEAT; ++i) {
+      r2 = bitfield::countSetBit(&have[0], NUM_BLOCKS-3);
+    }
+    report("countSetBit", o, t2.perIteration(), r1 == r2);
+    sink += r1;
+  }
+  {
+    // Worst case: the only missing block is the last one.
+    std::vector<unsigned char> full(len, 0xffu);
+    full[len-1] = 0xfeu;
+    size_t r1 = 0, r2 = 0;
+    Timer t1;
+    for(int i = 0; i < REPEAT; ++i) {
+      old::getFirstSetBitIndex(r1, ~array(&full[0])&~array(&use[0]),
+                               NUM_BLOCKS);
+    }
+    double o = t1.perIteration();
+    Timer t2;
+    for(int i = 0; i < REPEAT; ++i) {
+      bitfield::getFirstSetBitIndex(r2, ~array(&full[0])&~array(&use[0]),
+                                    NUM_BLOCKS);
+    }
+    report("getFirstSetBitIndex", o, t2.perIteration(), r1 == r2);
+  }
+  {
+    bool r1 = false, r2 = false;
+    Timer t1;
+    for(int i = 0; i < REPEAT; ++i) {
+      r1 = old::copyBitfield
+        (&dst1[0], ~array(&have[0])&~array(&use[0])&array(&peer[0]),
+         NUM_BLOCKS);
+    }
+    double o = t1.perIteration();
+    Timer t2;
+    for(int i = 0; i < REPEAT; ++i) {
+      r2 = bitfield::andNot(&dst2[0], &peer[0], 0, &have[0], &use[0],
+                            NUM_BLOCKS);
+    }
+    report("getAllMissingUnusedIndexes", o, t2.perIteration(),
+           r1 == r2 && dst1 == dst2);
+  }
+  {
+    // The peer has nothing we miss, so the whole bitfield is scanned.
+    std::vector<unsigned char> seeder(have);
+    bool r1 = false, r2 = false;
+    Timer t1;
+    for(int i = 0; i < REPEAT; ++i) {
+      // Keeps the compiler from hoisting the loop-invariant call.
+      *static_cast<volatile unsigned char*>(&seeder[0]) = seeder[0];
+      r1 = old::hasMissingPiece(&seeder[0], &have[0], len);
+    }
+    double o = t1.perIteration();
+    Timer t2;
+    for(int i = 0; i < REPEAT; ++i) {
+      r2 = bitfield::andNot(0, &seeder[0], 0, &have[0], 0, NUM_BLOCKS);
+    }
+    report("hasMissingPiece", o, t2.perIteration(), r1 == r2);
+  }
+  {
+    // setBit() calls updateCache(), so this mostly measures
+    // countSetBit and friends.
+    BitfieldMan bm(BLOCK_LENGTH, (uint64_t)BLOCK_LENGTH*NUM_BLOCKS);
+    bm.setBitfield(&have[0], len);
+    bm.addFilter(0, (uint64_t)BLOCK_LENGTH*NUM_BLOCKS/2);
+    bm.enableFilter();
+    Timer t;
+    for(int i = 0; i < REPEAT; ++i) {
+      bm.setBit(i);
+    }
+    std::cout << "BitfieldMan::setBit: " << t.perIteration() << " us"
+              << std::endl;
+    sink += bm.countMissingBlock();
+  }
+  {
+    BitfieldMan bm(BLOCK_LENGTH, (uint64_t)BLOCK_LENGTH*NUM_BLOCKS);
+    std::vector<unsigned char> full(len, 0xffu);
+    full[len-1] = 0xfeu;
+    bm.setBitfield(&full[0], len);
+    std::vector<unsigned char> ignore(len);
+    size_t index = 0;
+    Timer t;
+    for(int i = 0; i < REPEAT; ++i) {
+      bm.getInorderMissingUnusedIndex(index, 1024*1024, &ignore[0], len);
+    }
+    std::cout << "BitfieldMan::getInorderMissingUnusedIndex: "
+              << t.perIteration() << " us" << std::endl;
+    sink += index;
+  }
+  return 0;
+}
@@ -0,0 +1,46 @@
+#include "BtHaveBatchMessage.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "bittorrent_helper.h"
+#include "array_fun.h"
+
+namespace aria2 {
+
+class BtHaveBatchMessageTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(BtHaveBatchMessageTest);
+  CPPUNIT_TEST(testCreateMessage);
+  CPPUNIT_TEST(testToString);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testCreateMessage();
+  void testToString();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BtHaveBatchMessageTest);
+
+void BtHaveBatchMessageTest::testCreateMessage() {
+  size_t indexes[] = { 12345, 1 };
+  BtHaveBatchMessage msg(std::vector<size_t>(vbegin(indexes), vend(indexes)));
+  CPPUNIT_ASSERT_EQUAL((size_t)18, msg.getMessageLength());
+  unsigned char data[18];
+  bittorrent::createPeerMessageString(data, 9, 5, 4);
+  bittorrent::setIntParam(&data[5], 12345);
+  bittorrent::createPeerMessageString(&data[9], 9, 5, 4);
+  bittorrent::setIntParam(&data[14], 1);
+  unsigned char* rawmsg = msg.createMessage();
+  CPPUNIT_ASSERT(memcmp(rawmsg, data, 18) == 0);
+  delete [] rawmsg;
+}
+
+void BtHaveBatchMessageTest::testToString() {
+  std::vector<size_t> indexes(3);
+  BtHaveBatchMessage msg(indexes);
+  CPPUNIT_ASSERT_EQUAL(std::string("have batch count=3"), msg.toString());
+}
+
+} // namespace aria2
@@ -28,6 +28,7 @@ class BtRequestMessageTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testDoReceivedAction_hasPieceAndAmChokingAndFastExtensionDisabled);
   CPPUNIT_TEST(testDoReceivedAction_doesntHavePieceAndFastExtensionEnabled);
   CPPUNIT_TEST(testDoReceivedAction_doesntHavePieceAndFastExtensionDisabled);
+  CPPUNIT_TEST(testDoReceivedAction_tooManyRequests);
   CPPUNIT_TEST(testHandleAbortRequestEvent);
   CPPUNIT_TEST(testHandleAbortRequestEvent_indexNoMatch);
   CPPUNIT_TEST(testHandleAbortRequestEvent_alreadyInvalidated);
@@ -46,6 +47,7 @@ public:
   void testDoReceivedAction_hasPieceAndAmChokingAndFastExtensionDisabled();
   void testDoReceivedAction_doesntHavePieceAndFastExtensionEnabled();
   void testDoReceivedAction_doesntHavePieceAndFastExtensionDisabled();
+  void testDoReceivedAction_tooManyRequests();
   void testHandleAbortRequestEvent();
   void testHandleAbortRequestEvent_indexNoMatch();
   void testHandleAbortRequestEvent_alreadyInvalidated();
@@ -228,6 +230,23 @@ void BtRequestMessageTest::testDoReceivedAction_doesntHavePieceAndFastExtensionD
   CPPUNIT_ASSERT_EQUAL((size_t)0, dispatcher_->messageQueue.size());
 }
 
+void BtRequestMessageTest::testDoReceivedAction_tooManyRequests() {
+  peer_->amChoking(false);
+  peer_->setFastExtensionEnabled(true);
+  for(size_t i = 0; i < MAX_INCOMING_REQUEST; ++i) {
+    SharedHandle<MockBtMessage> piece(new MockBtMessage());
+    piece->setUploading(true);
+    dispatcher_->addMessageToQueue(piece);
+  }
+  msg->doReceivedAction();
+
+  CPPUNIT_ASSERT_EQUAL((size_t)MAX_INCOMING_REQUEST+1,
+                       dispatcher_->messageQueue.size());
+  SharedHandle<MockBtMessage2> rejectMsg =
+    dynamic_pointer_cast<MockBtMessage2>(dispatcher_->messageQueue.back());
+  CPPUNIT_ASSERT_EQUAL(std::string("reject"), rejectMsg->type);
+}
+
 void BtRequestMessageTest::testHandleAbortRequestEvent() {
   SharedHandle<Piece> piece(new Piece(1, 16*1024));
   CPPUNIT_ASSERT(!msg->isInvalidate());
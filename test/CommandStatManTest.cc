@@ -0,0 +1,83 @@
+#include "CommandStatMan.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "Command.h"
+
+namespace aria2 {
+
+class CommandStatManTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(CommandStatManTest);
+  CPPUNIT_TEST(testGetBucketIndex);
+  CPPUNIT_TEST(testUpdate);
+  CPPUNIT_TEST(testGetStats);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testGetBucketIndex();
+  void testUpdate();
+  void testGetStats();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CommandStatManTest);
+
+namespace {
+class AlphaCommand:public Command {
+public:
+  AlphaCommand():Command(1) {}
+  virtual bool execute() { return true; }
+};
+
+class BetaCommand:public Command {
+public:
+  BetaCommand():Command(2) {}
+  virtual bool execute() { return true; }
+};
+} // namespace
+
+void CommandStatManTest::testGetBucketIndex()
+{
+  CPPUNIT_ASSERT_EQUAL((size_t)0, CommandStat::getBucketIndex(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, CommandStat::getBucketIndex(1));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, CommandStat::getBucketIndex(2));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, CommandStat::getBucketIndex(3));
+  CPPUNIT_ASSERT_EQUAL((size_t)2, CommandStat::getBucketIndex(4));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, CommandStat::getBucketIndex(1024));
+  CPPUNIT_ASSERT_EQUAL(CommandStat::NUM_BUCKETS-1,
+                       CommandStat::getBucketIndex(1LL << 40));
+}
+
+void CommandStatManTest::testUpdate()
+{
+  CommandStat stat;
+  stat.update(1);
+  stat.update(5);
+  stat.update(100);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, stat.getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)106, stat.getTotalTime());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)100, stat.getMaxTime());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stat.getBucket(0));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stat.getBucket(2));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stat.getBucket(6));
+}
+
+void CommandStatManTest::testGetStats()
+{
+  CommandStatMan statMan;
+  AlphaCommand alpha;
+  BetaCommand beta;
+  statMan.update(&beta, 10);
+  statMan.update(&alpha, 20);
+  statMan.update(&beta, 30);
+  std::vector<std::pair<std::string, CommandStat> > stats;
+  statMan.getStats(stats);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, stats.size());
+  CPPUNIT_ASSERT_EQUAL(std::string("AlphaCommand"), stats[0].first);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, stats[0].second.getCount());
+  CPPUNIT_ASSERT_EQUAL(std::string("BetaCommand"), stats[1].first);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)2, stats[1].second.getCount());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)40, stats[1].second.getTotalTime());
+}
+
+} // namespace aria2
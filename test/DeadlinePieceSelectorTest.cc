@@ -0,0 +1,150 @@
+#include "DeadlinePieceSelector.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "BitfieldMan.h"
+#include "bitfield.h"
+
+namespace aria2 {
+
+class DeadlinePieceSelectorTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(DeadlinePieceSelectorTest);
+  CPPUNIT_TEST(testSelect);
+  CPPUNIT_TEST(testSelect_slowConnection);
+  CPPUNIT_TEST(testSelectDuplicate);
+  CPPUNIT_TEST(testGetDeadline);
+  CPPUNIT_TEST(testHasEarlierPiece);
+  CPPUNIT_TEST(testGetBufferedAhead);
+  CPPUNIT_TEST(testSetPlayback);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  SharedHandle<BitfieldMan> bitfieldMan_;
+  SharedHandle<DeadlinePieceSelector> selector_;
+  unsigned char bitfield_[13];
+public:
+  void setUp()
+  {
+    // 100 pieces of 1KiB. Played at 1KiB/s, a piece lasts 1 second
+    // and the lookahead window spans 30 pieces.
+    bitfieldMan_.reset(new BitfieldMan(1024, 1024*100));
+    selector_.reset(new DeadlinePieceSelector(bitfieldMan_.get()));
+    selector_->setPlayback(10*1024+512, 1024);
+    memset(bitfield_, 0, sizeof(bitfield_));
+  }
+
+  void testSelect();
+  void testSelect_slowConnection();
+  void testSelectDuplicate();
+  void testGetDeadline();
+  void testHasEarlierPiece();
+  void testGetBufferedAhead();
+  void testSetPlayback();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeadlinePieceSelectorTest);
+
+void DeadlinePieceSelectorTest::testSelect()
+{
+  size_t index;
+  bitfield::flipBit(bitfield_, 100, 5);
+  bitfield::flipBit(bitfield_, 100, 20);
+  bitfield::flipBit(bitfield_, 100, 50);
+  CPPUNIT_ASSERT(selector_->select(index, bitfield_, 100, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)20, index);
+
+  bitfield::flipBit(bitfield_, 100, 10);
+  CPPUNIT_ASSERT(selector_->select(index, bitfield_, 100, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, index);
+
+  // Pieces after the lookahead window are left to other selectors.
+  memset(bitfield_, 0, sizeof(bitfield_));
+  bitfield::flipBit(bitfield_, 100, 50);
+  CPPUNIT_ASSERT(!selector_->select(index, bitfield_, 100, 0));
+}
+
+void DeadlinePieceSelectorTest::testSelect_slowConnection()
+{
+  memset(bitfield_, 0xff, sizeof(bitfield_));
+  size_t index;
+  CPPUNIT_ASSERT(selector_->select(index, bitfield_, 100, 10000));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, index);
+  // Half as fast as the fastest one is still fast.
+  CPPUNIT_ASSERT(selector_->select(index, bitfield_, 100, 5000));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, index);
+  // Downloading a piece takes 10 seconds, so the piece must be due in
+  // 20 seconds or later.
+  CPPUNIT_ASSERT(selector_->select(index, bitfield_, 100, 100));
+  CPPUNIT_ASSERT_EQUAL((size_t)31, index);
+  // A connection of unknown speed gets a piece due in 15 seconds or
+  // later.
+  CPPUNIT_ASSERT(selector_->select(index, bitfield_, 100, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)26, index);
+  // Too slow for any piece in the window.
+  CPPUNIT_ASSERT(!selector_->select(index, bitfield_, 100, 10));
+}
+
+void DeadlinePieceSelectorTest::testSelectDuplicate()
+{
+  size_t index;
+  bitfield::flipBit(bitfield_, 100, 11);
+  CPPUNIT_ASSERT(selector_->selectDuplicate(index, bitfield_, 100, 10000));
+  CPPUNIT_ASSERT_EQUAL((size_t)11, index);
+  CPPUNIT_ASSERT(!selector_->selectDuplicate(index, bitfield_, 100, 100));
+  CPPUNIT_ASSERT(!selector_->selectDuplicate(index, bitfield_, 100, 0));
+
+  // Due in 3.5 seconds.
+  memset(bitfield_, 0, sizeof(bitfield_));
+  bitfield::flipBit(bitfield_, 100, 14);
+  CPPUNIT_ASSERT(!selector_->selectDuplicate(index, bitfield_, 100, 10000));
+}
+
+void DeadlinePieceSelectorTest::testGetDeadline()
+{
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, selector_->getDeadline(9));
+  CPPUNIT_ASSERT_EQUAL((int64_t)0, selector_->getDeadline(10));
+  CPPUNIT_ASSERT_EQUAL((int64_t)500, selector_->getDeadline(11));
+  CPPUNIT_ASSERT_EQUAL((int64_t)1500, selector_->getDeadline(12));
+}
+
+void DeadlinePieceSelectorTest::testHasEarlierPiece()
+{
+  CPPUNIT_ASSERT(!selector_->hasEarlierPiece(10));
+  CPPUNIT_ASSERT(selector_->hasEarlierPiece(11));
+  CPPUNIT_ASSERT(selector_->hasEarlierPiece(60));
+  bitfieldMan_->setBitRange(10, 14);
+  bitfieldMan_->setUseBit(15);
+  CPPUNIT_ASSERT(!selector_->hasEarlierPiece(16));
+  CPPUNIT_ASSERT(selector_->hasEarlierPiece(17));
+  // Pieces after the lookahead window do not count.
+  bitfieldMan_->setBitRange(16, 40);
+  CPPUNIT_ASSERT(!selector_->hasEarlierPiece(60));
+}
+
+void DeadlinePieceSelectorTest::testGetBufferedAhead()
+{
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, selector_->getBufferedAhead());
+  bitfieldMan_->setBitRange(10, 14);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)4608, selector_->getBufferedAhead());
+  bitfieldMan_->setBitRange(15, 99);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1024*100-(10*1024+512),
+                       selector_->getBufferedAhead());
+}
+
+void DeadlinePieceSelectorTest::testSetPlayback()
+{
+  CPPUNIT_ASSERT_EQUAL((uint64_t)10*1024+512,
+                       selector_->getPlaybackPosition());
+  CPPUNIT_ASSERT_EQUAL(1024U, selector_->getBitrate());
+  selector_->setPlayback(1024*1024, 2048);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1024*100, selector_->getPlaybackPosition());
+  CPPUNIT_ASSERT_EQUAL(2048U, selector_->getBitrate());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, selector_->getBufferedAhead());
+  size_t index;
+  memset(bitfield_, 0xff, sizeof(bitfield_));
+  CPPUNIT_ASSERT(!selector_->select(index, bitfield_, 100, 0));
+}
+
+} // namespace aria2
@@ -13,6 +13,9 @@
 #include "Piece.h"
 #include "FileEntry.h"
 #include "array_fun.h"
+#include "File.h"
+#include "TimeA2.h"
+#include "TestUtil.h"
 #ifdef ENABLE_BITTORRENT
 # include "MockPeerStorage.h"
 # include "BtRuntime.h"
@@ -37,6 +40,7 @@ class DefaultBtProgressInfoFileTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testLoad_nonBt_compat);
 #endif // !WORDS_BIGENDIAN
   CPPUNIT_TEST(testLoad_nonBt_pieceLengthShorter);
+  CPPUNIT_TEST(testLoad_fileStats);
   CPPUNIT_TEST(testUpdateFilename);
   CPPUNIT_TEST_SUITE_END();
 private:
@@ -96,6 +100,7 @@ public:
   void testLoad_nonBt_compat();
 #endif // !WORDS_BIGENDIAN
   void testLoad_nonBt_pieceLengthShorter();
+  void testLoad_fileStats();
   void testUpdateFilename();
 };
 
@@ -246,7 +251,7 @@ void DefaultBtProgressInfoFileTest::testSave()
 
   unsigned char extension[4];
   in.read((char*)extension, sizeof(extension));
-  CPPUNIT_ASSERT_EQUAL(std::string("00000001"),
+  CPPUNIT_ASSERT_EQUAL(std::string("00000003"),
                        util::toHex(extension, sizeof(extension)));
 
   uint32_t infoHashLength;
@@ -479,7 +484,7 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
 
   unsigned char extension[4];
   in.read((char*)extension, sizeof(extension));
-  CPPUNIT_ASSERT_EQUAL(std::string("00000000"),
+  CPPUNIT_ASSERT_EQUAL(std::string("00000002"),
                        util::toHex(extension, sizeof(extension)));
 
   uint32_t infoHashLength;
@@ -549,6 +554,65 @@ void DefaultBtProgressInfoFileTest::testSave_nonBt()
   pieceLength2 = ntohl(pieceLength2);
   CPPUNIT_ASSERT_EQUAL((uint32_t)512, pieceLength2);
 
+  uint32_t pieceBitfieldLength2;
+  in.read((char*)&pieceBitfieldLength2, sizeof(pieceBitfieldLength2));
+  pieceBitfieldLength2 = ntohl(pieceBitfieldLength2);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)1, pieceBitfieldLength2);
+
+  unsigned char pieceBitfield2[1];
+  in.read((char*)pieceBitfield2, sizeof(pieceBitfield2));
+
+  // file stats
+  uint32_t numFiles;
+  in.read((char*)&numFiles, sizeof(numFiles));
+  numFiles = ntohl(numFiles);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)1, numFiles);
+
+  // save-temp does not exist.
+  uint64_t fileSize;
+  in.read((char*)&fileSize, sizeof(fileSize));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, ntoh64(fileSize));
+
+  uint64_t mtime;
+  in.read((char*)&mtime, sizeof(mtime));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, ntoh64(mtime));
+}
+
+void DefaultBtProgressInfoFileTest::testLoad_fileStats()
+{
+  initializeMembers(1024, 81920);
+  option_->put(PREF_FAST_RESUME, A2_V_TRUE);
+
+  std::string path = A2_TEST_OUT_DIR"/aria2_DefaultBtProgressInfoFileTest_fs";
+  createFile(path, 1024);
+  File f(path);
+  Time mtime(Time().getTime()-3600);
+  f.utime(mtime, mtime);
+
+  SharedHandle<DownloadContext> dctx(new DownloadContext(1024, 81920, path));
+  bitfield_->setAllBit();
+  DefaultBtProgressInfoFile infoFile(dctx, pieceStorage_, option_.get());
+  infoFile.save();
+
+  infoFile.load();
+  CPPUNIT_ASSERT(dctx->getFirstFileEntry()->isUnchanged());
+
+  option_->put(PREF_FAST_RESUME, A2_V_FALSE);
+  infoFile.load();
+  CPPUNIT_ASSERT(!dctx->getFirstFileEntry()->isUnchanged());
+
+  option_->put(PREF_FAST_RESUME, A2_V_TRUE);
+  Time newMtime(mtime.getTime()+1);
+  f.utime(newMtime, newMtime);
+  infoFile.load();
+  CPPUNIT_ASSERT(!dctx->getFirstFileEntry()->isUnchanged());
+
+  // The file is modified in the same second as the control file is
+  // saved, so it is not trusted.
+  f.utime(Time(), Time());
+  infoFile.save();
+  infoFile.load();
+  CPPUNIT_ASSERT(!dctx->getFirstFileEntry()->isUnchanged());
 }
 
 void DefaultBtProgressInfoFileTest::testUpdateFilename()
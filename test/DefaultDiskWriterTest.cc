@@ -1,12 +1,19 @@
 #include "DefaultDiskWriter.h"
+
+#include <cstring>
+
 #include <cppunit/extensions/HelperMacros.h>
 
+#include "File.h"
+
 namespace aria2 {
 
 class DefaultDiskWriterTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(DefaultDiskWriterTest);
   CPPUNIT_TEST(testSize);
+  CPPUNIT_TEST(testWriteAndReadData);
+  CPPUNIT_TEST(testWriteDataVector);
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -15,6 +22,8 @@ public:
   }
 
   void testSize();
+  void testWriteAndReadData();
+  void testWriteDataVector();
 };
 
 
@@ -28,4 +37,50 @@ void DefaultDiskWriterTest::testSize()
   CPPUNIT_ASSERT_EQUAL((uint64_t)4096ULL, dw.size());
 }
 
+void DefaultDiskWriterTest::testWriteAndReadData()
+{
+  std::string filename = A2_TEST_OUT_DIR"/aria2_DefaultDiskWriterTest_rw";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("world"), 5, 6);
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello "), 6, 0);
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, dw.readData(buf, 5, 6));
+  CPPUNIT_ASSERT_EQUAL(std::string("world"),
+                       std::string(&buf[0], &buf[5]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)11, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"),
+                       std::string(&buf[0], &buf[11]));
+  dw.closeFile();
+}
+
+void DefaultDiskWriterTest::testWriteDataVector()
+{
+  std::string filename = A2_TEST_OUT_DIR"/aria2_DefaultDiskWriterTest_vec";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("0123456789"), 10, 0);
+  std::vector<DataBuffer> bufs;
+  bufs.push_back(DataBuffer(reinterpret_cast<const unsigned char*>("ab"), 2));
+  bufs.push_back(DataBuffer(reinterpret_cast<const unsigned char*>(""), 0));
+  bufs.push_back(DataBuffer(reinterpret_cast<const unsigned char*>("cde"), 3));
+  dw.writeDataVector(bufs, 3);
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)10, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("012abcde89"),
+                       std::string(&buf[0], &buf[10]));
+
+  // More buffers than IOV_MAX
+  std::vector<DataBuffer> many(5000,
+                               DataBuffer(reinterpret_cast<const unsigned char*>
+                                          ("x"), 1));
+  dw.writeDataVector(many, 10);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)5010, dw.size());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, dw.readData(buf, 1, 5009));
+  CPPUNIT_ASSERT_EQUAL('x', (char)buf[0]);
+  dw.closeFile();
+}
+
 } // namespace aria2
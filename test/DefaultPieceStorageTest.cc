@@ -6,6 +6,7 @@
 #include "Exception.h"
 #include "Piece.h"
 #include "Peer.h"
+#include "PeerSessionResource.h"
 #include "Option.h"
 #include "FileEntry.h"
 #include "RarestPieceSelector.h"
@@ -27,6 +28,8 @@ class DefaultPieceStorageTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testGetMissingPiece_many);
   CPPUNIT_TEST(testGetMissingPiece_excludedIndexes);
   CPPUNIT_TEST(testGetMissingPiece_manyWithExcludedIndexes);
+  CPPUNIT_TEST(testGetMissingPiece_candidatePieces);
+  CPPUNIT_TEST(testGetMissingPiece_playback);
   CPPUNIT_TEST(testGetMissingFastPiece);
   CPPUNIT_TEST(testGetMissingFastPiece_excludedIndexes);
   CPPUNIT_TEST(testHasMissingPiece);
@@ -38,6 +41,7 @@ class DefaultPieceStorageTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testMarkPiecesDone);
   CPPUNIT_TEST(testGetCompletedLength);
   CPPUNIT_TEST(testGetNextUsedIndex);
+  CPPUNIT_TEST(testGetAdvertisedPieceIndexes);
   CPPUNIT_TEST_SUITE_END();
 private:
   SharedHandle<DownloadContext> dctx_;
@@ -61,6 +65,8 @@ public:
   void testGetMissingPiece_many();
   void testGetMissingPiece_excludedIndexes();
   void testGetMissingPiece_manyWithExcludedIndexes();
+  void testGetMissingPiece_candidatePieces();
+  void testGetMissingPiece_playback();
   void testGetMissingFastPiece();
   void testGetMissingFastPiece_excludedIndexes();
   void testHasMissingPiece();
@@ -72,6 +78,7 @@ public:
   void testMarkPiecesDone();
   void testGetCompletedLength();
   void testGetNextUsedIndex();
+  void testGetAdvertisedPieceIndexes();
 };
 
 
@@ -162,6 +169,71 @@ void DefaultPieceStorageTest::testGetMissingPiece_manyWithExcludedIndexes() {
   CPPUNIT_ASSERT(pieces.empty());
 }
 
+void DefaultPieceStorageTest::testGetMissingPiece_candidatePieces()
+{
+  DefaultPieceStorage pss(dctx_, option_.get());
+  pss.setPieceSelector(pieceSelector_);
+  peer->updateBitfield(0, 1);
+
+  SharedHandle<Piece> piece0 = pss.getMissingPiece(peer, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, piece0->getIndex());
+  CPPUNIT_ASSERT(peer->getCandidatePieces().seq > 0);
+  CPPUNIT_ASSERT(!pss.getMissingPiece(peer, 1));
+
+  // HAVE is applied without rebuilding.
+  peer->updateBitfield(2, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, peer->getCandidatePieces().haves.size());
+  SharedHandle<Piece> piece2 = pss.getMissingPiece(peer, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, piece2->getIndex());
+  CPPUNIT_ASSERT(peer->getCandidatePieces().haves.empty());
+
+  // Canceled piece becomes a candidate again.
+  pss.cancelPiece(piece0, 1);
+  piece0 = pss.getMissingPiece(peer, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, piece0->getIndex());
+
+  pss.completePiece(piece0);
+  pss.completePiece(piece2);
+  peer->updateBitfield(1, 1);
+  SharedHandle<Piece> piece1 = pss.getMissingPiece(peer, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, piece1->getIndex());
+  CPPUNIT_ASSERT(!pss.getMissingPiece(peer, 1));
+
+  // Missing piece found by hash check is requested again.
+  pss.markPieceMissing(2);
+  piece2 = pss.getMissingPiece(peer, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, piece2->getIndex());
+
+  // BITFIELD rebuilds the candidates.
+  peer->setAllBitfield();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, peer->getCandidatePieces().seq);
+  CPPUNIT_ASSERT(!pss.getMissingPiece(peer, 1));
+}
+
+void DefaultPieceStorageTest::testGetMissingPiece_playback()
+{
+  DefaultPieceStorage pss(dctx_, option_.get());
+  pss.setPieceSelector(pieceSelector_);
+  CPPUNIT_ASSERT(!pss.getDeadlinePieceSelector());
+  peer->setAllBitfield();
+  pss.setPlayback(128, 128);
+  CPPUNIT_ASSERT(pss.getDeadlinePieceSelector());
+
+  // Pieces after the playback position come first.
+  std::vector<SharedHandle<Piece> > pieces;
+  pss.getMissingPiece(pieces, 3, peer, 1);
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pieces.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, pieces[0]->getIndex());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, pieces[1]->getIndex());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pieces[2]->getIndex());
+  pss.cancelPiece(pieces[0], 1);
+  pss.cancelPiece(pieces[1], 1);
+  pss.cancelPiece(pieces[2], 1);
+
+  SharedHandle<Piece> piece = pss.getMissingPiece(0, 0, 0, 2, 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, piece->getIndex());
+}
+
 void DefaultPieceStorageTest::testGetMissingFastPiece() {
   DefaultPieceStorage pss(dctx_, option_.get());
   pss.setPieceSelector(pieceSelector_);
@@ -357,4 +429,36 @@ void DefaultPieceStorageTest::testGetNextUsedIndex()
   CPPUNIT_ASSERT_EQUAL((size_t)2, pss.getNextUsedIndex(0));
 }
 
+void DefaultPieceStorageTest::testGetAdvertisedPieceIndexes()
+{
+  DefaultPieceStorage pss(dctx_, option_.get());
+  uint64_t cursor = pss.getAdvertisedPieceCursor();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)0, cursor);
+  pss.advertisePiece(1, 0);
+  pss.advertisePiece(2, 1);
+  pss.advertisePiece(1, 2);
+  std::vector<size_t> indexes;
+  CPPUNIT_ASSERT(pss.getAdvertisedPieceIndexes(indexes, 2, cursor));
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, cursor);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, indexes.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, indexes[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, indexes[1]);
+  indexes.clear();
+  CPPUNIT_ASSERT(pss.getAdvertisedPieceIndexes(indexes, 2, cursor));
+  CPPUNIT_ASSERT(indexes.empty());
+
+  // The ring holds 64 entries for this torrent. Older entries are
+  // overwritten.
+  for(size_t i = 0; i < 65; ++i) {
+    pss.advertisePiece(1, 0);
+  }
+  CPPUNIT_ASSERT(!pss.getAdvertisedPieceIndexes(indexes, 2, cursor));
+  CPPUNIT_ASSERT(indexes.empty());
+  CPPUNIT_ASSERT_EQUAL(pss.getAdvertisedPieceCursor(), cursor);
+  pss.advertisePiece(1, 1);
+  CPPUNIT_ASSERT(pss.getAdvertisedPieceIndexes(indexes, 2, cursor));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, indexes.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, indexes[0]);
+}
+
 } // namespace aria2
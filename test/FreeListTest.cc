@@ -0,0 +1,71 @@
+#include "FreeList.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace aria2 {
+
+class FreeListTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(FreeListTest);
+  CPPUNIT_TEST(testAllocate);
+  CPPUNIT_TEST(testPooledObject);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testAllocate();
+  void testPooledObject();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FreeListTest);
+
+void FreeListTest::testAllocate()
+{
+  FreeList freeList(16, 2);
+  CPPUNIT_ASSERT_EQUAL((size_t)16, freeList.getChunkSize());
+  void* a = freeList.allocate();
+  void* b = freeList.allocate();
+  void* c = freeList.allocate();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, freeList.countFree());
+  freeList.deallocate(a);
+  freeList.deallocate(b);
+  // At most 2 chunks are kept.
+  freeList.deallocate(c);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, freeList.countFree());
+  freeList.deallocate(0);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, freeList.countFree());
+  // The last freed chunk is reused first.
+  CPPUNIT_ASSERT(b == freeList.allocate());
+  CPPUNIT_ASSERT(a == freeList.allocate());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, freeList.countFree());
+  freeList.deallocate(a);
+  freeList.deallocate(b);
+}
+
+namespace {
+class Pooled:public PooledObject<Pooled> {
+public:
+  virtual ~Pooled() {}
+  int n;
+};
+
+class DerivedPooled:public Pooled {
+public:
+  char buf[64];
+};
+} // namespace
+
+void FreeListTest::testPooledObject()
+{
+  Pooled* p = new Pooled();
+  delete p;
+  Pooled* q = new Pooled();
+  CPPUNIT_ASSERT(p == q);
+  delete q;
+  // Derived classes of different size do not use the free list.
+  Pooled* d = new DerivedPooled();
+  CPPUNIT_ASSERT(d != p);
+  delete d;
+  CPPUNIT_ASSERT(p == new Pooled());
+  delete p;
+}
+
+} // namespace aria2
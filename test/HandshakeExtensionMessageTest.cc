@@ -62,17 +62,21 @@ void HandshakeExtensionMessageTest::testGetBencodedData()
   msg.setExtension("ut_pex", 1);
   msg.setExtension("a2_dht", 2);
   msg.setMetadataSize(1024);
+  msg.setReqq(500);
   CPPUNIT_ASSERT_EQUAL
     (std::string("d"
                  "1:md6:a2_dhti2e6:ut_pexi1ee"
                  "13:metadata_sizei1024e"
                  "1:pi6889e"
+                 "4:reqqi500e"
                  "1:v5:aria2"
                  "e"), msg.getPayload());
 
   msg.setMetadataSize(0);
   CPPUNIT_ASSERT
     (msg.getPayload().find("metadata_size") == std::string::npos);
+  msg.setReqq(0);
+  CPPUNIT_ASSERT(msg.getPayload().find("reqq") == std::string::npos);
 }
 
 void HandshakeExtensionMessageTest::testToString()
@@ -109,6 +113,7 @@ void HandshakeExtensionMessageTest::testDoReceivedAction()
   msg.setExtension("a2_dht", 2);
   msg.setExtension("ut_metadata", 3);
   msg.setMetadataSize(1024);
+  msg.setReqq(500);
   msg.setPeer(peer);
   msg.setDownloadContext(dctx);
 
@@ -118,6 +123,7 @@ void HandshakeExtensionMessageTest::testDoReceivedAction()
   CPPUNIT_ASSERT_EQUAL((uint8_t)1, peer->getExtensionMessageID("ut_pex"));
   CPPUNIT_ASSERT_EQUAL((uint8_t)2, peer->getExtensionMessageID("a2_dht"));
   CPPUNIT_ASSERT(peer->isSeeder());
+  CPPUNIT_ASSERT_EQUAL((size_t)500, peer->getReqq());
   CPPUNIT_ASSERT_EQUAL((size_t)1024, attrs->metadataSize);
   CPPUNIT_ASSERT_EQUAL((uint64_t)1024, dctx->getTotalLength());
   CPPUNIT_ASSERT(dctx->knowsTotalLength());
@@ -133,7 +139,8 @@ void HandshakeExtensionMessageTest::testDoReceivedAction()
 void HandshakeExtensionMessageTest::testCreate()
 {
   std::string in = 
-    "0d1:pi6881e1:v5:aria21:md6:ut_pexi1ee13:metadata_sizei1024ee";
+    "0d1:pi6881e1:v5:aria21:md6:ut_pexi1ee13:metadata_sizei1024e"
+    "4:reqqi500ee";
   SharedHandle<HandshakeExtensionMessage> m =
     HandshakeExtensionMessage::create(reinterpret_cast<const unsigned char*>(in.c_str()),
                                       in.size());
@@ -141,6 +148,12 @@ void HandshakeExtensionMessageTest::testCreate()
   CPPUNIT_ASSERT_EQUAL((uint16_t)6881, m->getTCPPort());
   CPPUNIT_ASSERT_EQUAL((uint8_t)1, m->getExtensionMessageID("ut_pex"));
   CPPUNIT_ASSERT_EQUAL((size_t)1024, m->getMetadataSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)500, m->getReqq());
+  // reqq larger than we ever use is capped.
+  in = "0d4:reqqi100000ee";
+  m = HandshakeExtensionMessage::create
+    (reinterpret_cast<const unsigned char*>(in.c_str()), in.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)UB_MAX_OUTSTANDING_REQUEST, m->getReqq());
   try {
     // bad payload format
     std::string in = "011:hello world";
@@ -17,6 +17,7 @@ class IteratableChunkChecksumValidatorTest:public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(IteratableChunkChecksumValidatorTest);
   CPPUNIT_TEST(testValidate);
   CPPUNIT_TEST(testValidate_readError);
+  CPPUNIT_TEST(testValidate_unchangedFile);
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -27,6 +28,7 @@ public:
 
   void testValidate();
   void testValidate_readError();
+  void testValidate_unchangedFile();
 };
 
 
@@ -104,4 +106,43 @@ void IteratableChunkChecksumValidatorTest::testValidate_readError() {
   CPPUNIT_ASSERT(!ps->hasPiece(4));
 }
 
+void IteratableChunkChecksumValidatorTest::testValidate_unchangedFile() {
+  Option option;
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(100, 250, A2_TEST_DIR"/chunkChecksumTestFile250.txt"));
+  // None of the pieces matches these hashes.
+  std::deque<std::string> badHashes
+    (3, fromHex("ffffffffffffffffffffffffffffffffffffffff"));
+  dctx->setPieceHashes("sha-1", badHashes.begin(), badHashes.end());
+  SharedHandle<DefaultPieceStorage> ps
+    (new DefaultPieceStorage(dctx, &option));
+  ps->initStorage();
+  ps->getDiskAdaptor()->enableReadOnly();
+  ps->getDiskAdaptor()->openFile();
+  // The state loaded from the control file
+  unsigned char bitfield[] = { 0xa0 };
+  ps->setBitfield(bitfield, sizeof(bitfield));
+  dctx->getFirstFileEntry()->setUnchanged(true);
+
+  IteratableChunkChecksumValidator validator(dctx, ps);
+  validator.init();
+  CPPUNIT_ASSERT(!dctx->getFirstFileEntry()->isUnchanged());
+
+  validator.validateChunk();
+  CPPUNIT_ASSERT(validator.finished());
+  CPPUNIT_ASSERT_EQUAL((off_t)300, validator.getCurrentOffset());
+  CPPUNIT_ASSERT(ps->hasPiece(0));
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(ps->hasPiece(2));
+
+  // Without the mark, all pieces are hashed again.
+  validator.init();
+  while(!validator.finished()) {
+    validator.validateChunk();
+  }
+  CPPUNIT_ASSERT(!ps->hasPiece(0));
+  CPPUNIT_ASSERT(!ps->hasPiece(1));
+  CPPUNIT_ASSERT(!ps->hasPiece(2));
+}
+
 } // namespace aria2
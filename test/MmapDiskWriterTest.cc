@@ -0,0 +1,100 @@
+#include "MmapDiskWriter.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "File.h"
+
+namespace aria2 {
+
+class MmapDiskWriterTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(MmapDiskWriterTest);
+  CPPUNIT_TEST(testWriteAndReadData);
+  CPPUNIT_TEST(testWriteDataVector);
+  CPPUNIT_TEST(testWriteBeyondEnd);
+  CPPUNIT_TEST(testReadOnly);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testWriteAndReadData();
+  void testWriteDataVector();
+  void testWriteBeyondEnd();
+  void testReadOnly();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( MmapDiskWriterTest );
+
+void MmapDiskWriterTest::testWriteAndReadData()
+{
+  std::string filename = A2_TEST_OUT_DIR"/aria2_MmapDiskWriterTest_rw";
+  File(filename).remove();
+  MmapDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.truncate(11);
+  dw.writeData(reinterpret_cast<const unsigned char*>("world"), 5, 6);
+  dw.writeData(reinterpret_cast<const unsigned char*>("hello "), 6, 0);
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, dw.readData(buf, 5, 6));
+  CPPUNIT_ASSERT_EQUAL(std::string("world"),
+                       std::string(&buf[0], &buf[5]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)11, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"),
+                       std::string(&buf[0], &buf[11]));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, sizeof(buf), 11));
+  dw.closeFile();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)11, File(filename).size());
+}
+
+void MmapDiskWriterTest::testWriteDataVector()
+{
+  std::string filename = A2_TEST_OUT_DIR"/aria2_MmapDiskWriterTest_vec";
+  File(filename).remove();
+  MmapDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("0123456789"), 10, 0);
+  std::vector<DataBuffer> bufs;
+  bufs.push_back(DataBuffer(reinterpret_cast<const unsigned char*>("ab"), 2));
+  bufs.push_back(DataBuffer(reinterpret_cast<const unsigned char*>(""), 0));
+  bufs.push_back(DataBuffer(reinterpret_cast<const unsigned char*>("cde"), 3));
+  dw.writeDataVector(bufs, 3);
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)10, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("012abcde89"),
+                       std::string(&buf[0], &buf[10]));
+  dw.closeFile();
+}
+
+void MmapDiskWriterTest::testWriteBeyondEnd()
+{
+  std::string filename = A2_TEST_OUT_DIR"/aria2_MmapDiskWriterTest_grow";
+  File(filename).remove();
+  MmapDiskWriter dw(filename);
+  dw.initAndOpenFile();
+  dw.writeData(reinterpret_cast<const unsigned char*>("0123"), 4, 0);
+  // Mapped here
+  dw.writeData(reinterpret_cast<const unsigned char*>("ab"), 2, 1);
+  // Grows the file
+  dw.writeData(reinterpret_cast<const unsigned char*>("xyz"), 3, 3);
+  CPPUNIT_ASSERT_EQUAL((uint64_t)6, dw.size());
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, dw.readData(buf, sizeof(buf), 0));
+  CPPUNIT_ASSERT_EQUAL(std::string("0abxyz"),
+                       std::string(&buf[0], &buf[6]));
+  dw.closeFile();
+}
+
+void MmapDiskWriterTest::testReadOnly()
+{
+  MmapDiskWriter dw(A2_TEST_DIR"/4096chunk.txt");
+  dw.enableReadOnly();
+  dw.openExistingFile();
+  CPPUNIT_ASSERT_EQUAL((uint64_t)4096ULL, dw.size());
+  unsigned char buf[16];
+  CPPUNIT_ASSERT_EQUAL((ssize_t)10, dw.readData(buf, 10, 4086));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, dw.readData(buf, 10, 4096));
+  dw.closeFile();
+}
+
+} // namespace aria2
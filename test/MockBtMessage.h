@@ -45,9 +45,19 @@ private:
   bool invalidate;
   bool uploading;
 public:
-  MockBtMessage():BtMessage(0) {}
-
-  MockBtMessage(uint8_t id):BtMessage(id) {}
+  MockBtMessage()
+    : BtMessage(0),
+      sendingInProgress(false),
+      invalidate(false),
+      uploading(false)
+  {}
+
+  MockBtMessage(uint8_t id)
+    : BtMessage(id),
+      sendingInProgress(false),
+      invalidate(false),
+      uploading(false)
+  {}
 
   virtual ~MockBtMessage() {}
 
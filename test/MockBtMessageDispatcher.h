@@ -7,6 +7,7 @@
 
 #include "BtMessage.h"
 #include "Piece.h"
+#include "a2functional.h"
 
 namespace aria2 {
 
@@ -66,7 +67,8 @@ public:
 
   virtual size_t countOutstandingUpload()
   {
-    return 0;
+    return std::count_if(messageQueue.begin(), messageQueue.end(),
+                         mem_fun_sh(&BtMessage::isUploading));
   }
 };
 
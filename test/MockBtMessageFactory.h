@@ -48,6 +48,11 @@ public:
     return SharedHandle<BtMessage>();
   }
 
+  virtual SharedHandle<BtMessage> createHaveBatchMessage
+  (const std::vector<size_t>& indexes) {
+    return SharedHandle<BtMessage>();
+  }
+
   virtual SharedHandle<BtMessage> createChokeMessage() {
     return SharedHandle<BtMessage>();
   }
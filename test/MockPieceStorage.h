@@ -8,6 +8,8 @@
 #include "BitfieldMan.h"
 #include "Piece.h"
 #include "DiskAdaptor.h"
+#include "DeadlinePieceSelector.h"
+#include "SuperSeeder.h"
 
 namespace aria2 {
 
@@ -89,6 +91,11 @@ public:
     return SharedHandle<Piece>(new Piece());
   }
 
+  virtual SharedHandle<SuperSeeder> getSuperSeeder()
+  {
+    return SharedHandle<SuperSeeder>();
+  }
+
 #endif // ENABLE_BITTORRENT
 
   virtual bool hasMissingUnusedPiece()
@@ -105,6 +112,16 @@ public:
     return SharedHandle<Piece>(new Piece());
   }
 
+  virtual SharedHandle<Piece> getMissingPiece
+  (size_t minSplitSize,
+   const unsigned char* ignoreBitfield,
+   size_t length,
+   cuid_t cuid,
+   unsigned int speed)
+  {
+    return SharedHandle<Piece>(new Piece());
+  }
+
   virtual SharedHandle<Piece> getMissingPiece(size_t index, cuid_t cuid)
   {
     return SharedHandle<Piece>(new Piece());
@@ -240,12 +257,17 @@ public:
 
   virtual void advertisePiece(cuid_t cuid, size_t index) {}
 
-  virtual void getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
+  virtual bool getAdvertisedPieceIndexes(std::vector<size_t>& indexes,
                                          cuid_t myCuid,
-                                         const Timer& lastCheckTime)
-  {}
+                                         uint64_t& cursor)
+  {
+    return true;
+  }
 
-  virtual void removeAdvertisedPiece(time_t elapsed) {}
+  virtual uint64_t getAdvertisedPieceCursor()
+  {
+    return 0;
+  }
 
   virtual void markAllPiecesDone() {}
 
@@ -282,6 +304,17 @@ public:
   }
 
   virtual void onDownloadIncomplete() {}
+
+  virtual void flushWrDiskCacheEntry() {}
+
+  virtual void releaseWrDiskCacheEntry() {}
+
+  virtual void setPlayback(uint64_t position, unsigned int bitrate) {}
+
+  virtual SharedHandle<DeadlinePieceSelector> getDeadlinePieceSelector()
+  {
+    return SharedHandle<DeadlinePieceSelector>();
+  }
 };
 
 } // namespace aria2
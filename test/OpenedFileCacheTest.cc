@@ -0,0 +1,112 @@
+#include "OpenedFileCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "MultiDiskAdaptor.h"
+#include "FileEntry.h"
+#include "ByteArrayDiskWriter.h"
+
+namespace aria2 {
+
+class OpenedFileCacheTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(OpenedFileCacheTest);
+  CPPUNIT_TEST(testAdd);
+  CPPUNIT_TEST(testSetMaxOpenFiles);
+  CPPUNIT_TEST(testSharedByAdaptors);
+  CPPUNIT_TEST_SUITE_END();
+
+  std::vector<SharedHandle<DiskWriterEntry> > entries_;
+public:
+  void setUp()
+  {
+    entries_.clear();
+    for(int i = 0; i < 3; ++i) {
+      SharedHandle<DiskWriterEntry> entry
+        (new DiskWriterEntry(SharedHandle<FileEntry>
+                             (new FileEntry("file", 10, i*10))));
+      entry->setDiskWriter
+        (SharedHandle<DiskWriter>(new ByteArrayDiskWriter()));
+      entries_.push_back(entry);
+    }
+  }
+
+  void testAdd();
+  void testSetMaxOpenFiles();
+  void testSharedByAdaptors();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(OpenedFileCacheTest);
+
+void OpenedFileCacheTest::testAdd()
+{
+  OpenedFileCache cache(2);
+  for(int i = 0; i < 2; ++i) {
+    entries_[i]->openFile();
+    cache.add(entries_[i].get());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countOpenFile());
+  // entries_[1] becomes the least recently used one.
+  cache.hit(entries_[0].get());
+  entries_[2]->openFile();
+  cache.add(entries_[2].get());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, cache.countOpenFile());
+  CPPUNIT_ASSERT(entries_[0]->isOpen());
+  CPPUNIT_ASSERT(!entries_[1]->isOpen());
+  CPPUNIT_ASSERT(!cache.contains(entries_[1].get()));
+  CPPUNIT_ASSERT(entries_[2]->isOpen());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache.getHits());
+  CPPUNIT_ASSERT_EQUAL((uint64_t)3, cache.getMisses());
+
+  cache.remove(entries_[0].get());
+  cache.remove(entries_[2].get());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countOpenFile());
+}
+
+void OpenedFileCacheTest::testSetMaxOpenFiles()
+{
+  OpenedFileCache cache(3);
+  for(int i = 0; i < 3; ++i) {
+    entries_[i]->openFile();
+    cache.add(entries_[i].get());
+  }
+  cache.setMaxOpenFiles(1);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countOpenFile());
+  CPPUNIT_ASSERT(!entries_[0]->isOpen());
+  CPPUNIT_ASSERT(!entries_[1]->isOpen());
+  CPPUNIT_ASSERT(entries_[2]->isOpen());
+  cache.remove(entries_[2].get());
+}
+
+void OpenedFileCacheTest::testSharedByAdaptors()
+{
+  SharedHandle<OpenedFileCache> cache(new OpenedFileCache(2));
+  {
+    std::string dir = A2_TEST_OUT_DIR"/aria2_OpenedFileCacheTest";
+    SharedHandle<FileEntry> fileEntries[] = {
+      SharedHandle<FileEntry>(new FileEntry(dir+"/file1", 10, 0)),
+      SharedHandle<FileEntry>(new FileEntry(dir+"/file2", 10, 10)),
+    };
+    MultiDiskAdaptor adaptor1;
+    adaptor1.setFileEntries(&fileEntries[0], &fileEntries[1]);
+    adaptor1.setOpenedFileCache(cache);
+    adaptor1.initAndOpenFile();
+    CPPUNIT_ASSERT_EQUAL((size_t)1, cache->countOpenFile());
+
+    MultiDiskAdaptor adaptor2;
+    adaptor2.setFileEntries(&fileEntries[1], &fileEntries[2]);
+    adaptor2.setOpenedFileCache(cache);
+    adaptor2.initAndOpenFile();
+    CPPUNIT_ASSERT_EQUAL((size_t)2, cache->countOpenFile());
+
+    unsigned char buf[10];
+    adaptor1.readData(buf, sizeof(buf), 0);
+    CPPUNIT_ASSERT_EQUAL((uint64_t)1, cache->getHits());
+
+    adaptor2.closeFile();
+    CPPUNIT_ASSERT_EQUAL((size_t)1, cache->countOpenFile());
+  }
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache->countOpenFile());
+}
+
+} // namespace aria2
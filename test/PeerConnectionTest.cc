@@ -0,0 +1,130 @@
+#include "PeerConnection.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "Peer.h"
+#include "FreeList.h"
+#include "bittorrent_helper.h"
+
+namespace aria2 {
+
+class PeerConnectionTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PeerConnectionTest);
+  CPPUNIT_TEST(testReceiveMessage);
+  CPPUNIT_TEST(testReceiveMessage_block);
+  CPPUNIT_TEST_SUITE_END();
+
+  SharedHandle<SocketCore> clientSock_;
+  SharedHandle<SocketCore> acceptedSock_;
+  SharedHandle<Peer> peer_;
+public:
+  void setUp()
+  {
+    clientSock_.reset(new SocketCore());
+    SocketCore serverSock;
+    serverSock.bind(0);
+    serverSock.beginListen();
+    std::pair<std::string, uint16_t> addrinfo;
+    serverSock.getAddrInfo(addrinfo);
+    clientSock_->establishConnection("localhost", addrinfo.second);
+    clientSock_->setBlockingMode();
+    acceptedSock_.reset(serverSock.acceptConnection());
+    acceptedSock_->setBlockingMode();
+    peer_.reset(new Peer("localhost", 6881));
+  }
+
+  void testReceiveMessage();
+  void testReceiveMessage_block();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PeerConnectionTest);
+
+namespace {
+// Writes PIECE message with index 1, begin 0 and blockLength bytes of
+// block filled with 'a'.
+void writePieceMessage(const SharedHandle<SocketCore>& socket,
+                       size_t blockLength)
+{
+  std::string msg(4+9+blockLength, 'a');
+  bittorrent::createPeerMessageString
+    (reinterpret_cast<unsigned char*>(&msg[0]), 13, 9+blockLength, 7);
+  bittorrent::setIntParam(reinterpret_cast<unsigned char*>(&msg[5]), 1);
+  bittorrent::setIntParam(reinterpret_cast<unsigned char*>(&msg[9]), 0);
+  socket->writeData(msg);
+}
+} // namespace
+
+namespace {
+bool receiveMessage(PeerConnection& conn, size_t& dataLength)
+{
+  for(int i = 0; i < 100; ++i) {
+    if(conn.receiveMessage(0, dataLength)) {
+      return true;
+    }
+  }
+  return false;
+}
+} // namespace
+
+void PeerConnectionTest::testReceiveMessage()
+{
+  PeerConnection conn(1, peer_, acceptedSock_);
+  writePieceMessage(clientSock_, 2048);
+  size_t dataLength;
+  CPPUNIT_ASSERT(receiveMessage(conn, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)9+2048, dataLength);
+  // Block receive is not enabled.
+  CPPUNIT_ASSERT(!conn.detachBlock());
+  CPPUNIT_ASSERT_EQUAL((unsigned char)7, conn.getBuffer()[0]);
+  CPPUNIT_ASSERT_EQUAL((unsigned char)'a', conn.getBuffer()[9+2047]);
+}
+
+void PeerConnectionTest::testReceiveMessage_block()
+{
+  FreeList freeList(4096, 4);
+  PeerConnection conn(1, peer_, acceptedSock_);
+  conn.enableBlockReceive(&freeList);
+  CPPUNIT_ASSERT(&freeList == conn.getBlockFreeList());
+
+  writePieceMessage(clientSock_, 2048);
+  size_t dataLength;
+  CPPUNIT_ASSERT(receiveMessage(conn, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)9+2048, dataLength);
+  CPPUNIT_ASSERT_EQUAL((unsigned char)7, conn.getBuffer()[0]);
+  CPPUNIT_ASSERT_EQUAL((uint32_t)1, bittorrent::getIntParam
+                       (conn.getBuffer(), 1));
+  unsigned char* block = conn.detachBlock();
+  CPPUNIT_ASSERT(block);
+  CPPUNIT_ASSERT_EQUAL(std::string(2048, 'a'),
+                       std::string(&block[0], &block[2048]));
+  CPPUNIT_ASSERT(!conn.detachBlock());
+  freeList.deallocate(block);
+
+  // The block does not fit in the chunk of the free list.
+  writePieceMessage(clientSock_, 8192);
+  CPPUNIT_ASSERT(receiveMessage(conn, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)9+8192, dataLength);
+  CPPUNIT_ASSERT(!conn.detachBlock());
+  CPPUNIT_ASSERT_EQUAL((unsigned char)'a', conn.getBuffer()[9+8191]);
+
+  // A block which is not taken is returned to the free list when the
+  // next message is received.
+  writePieceMessage(clientSock_, 2048);
+  CPPUNIT_ASSERT(receiveMessage(conn, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, freeList.countFree());
+  // HAVE message
+  unsigned char have[9];
+  bittorrent::createPeerMessageString(have, sizeof(have), 5, 4);
+  bittorrent::setIntParam(&have[5], 3);
+  clientSock_->writeData(reinterpret_cast<const char*>(have), sizeof(have));
+  CPPUNIT_ASSERT(receiveMessage(conn, dataLength));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, dataLength);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, freeList.countFree());
+  CPPUNIT_ASSERT_EQUAL((unsigned char)4, conn.getBuffer()[0]);
+}
+
+} // namespace aria2
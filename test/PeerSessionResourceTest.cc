@@ -5,6 +5,7 @@
 #include "MockBtMessageDispatcher.h"
 #include "Exception.h"
 #include "util.h"
+#include "wallclock.h"
 
 namespace aria2 {
 
@@ -29,6 +30,7 @@ class PeerSessionResourceTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testOptUnchoking);
   CPPUNIT_TEST(testShouldBeChoking);
   CPPUNIT_TEST(testCountOutstandingRequest);
+  CPPUNIT_TEST(testUpdateRtt);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -53,6 +55,7 @@ public:
   void testOptUnchoking();
   void testShouldBeChoking();
   void testCountOutstandingRequest();
+  void testUpdateRtt();
 };
 
 
@@ -255,4 +258,29 @@ void PeerSessionResourceTest::testCountOutstandingRequest()
   CPPUNIT_ASSERT_EQUAL((size_t)0, res.countOutstandingUpload());
 }
 
+void PeerSessionResourceTest::testUpdateRtt()
+{
+  global::wallclock().reset();
+  PeerSessionResource res(1024, 1024*1024);
+  CPPUNIT_ASSERT_EQUAL((int64_t)-1, res.getRtt());
+  res.updateRtt(100, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, res.getRtt());
+  res.updateRtt(150, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)100, res.getRtt());
+  res.updateRtt(80, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)80, res.getRtt());
+  // The time spent on the preceding blocks cannot be subtracted
+  // without the download speed.
+  res.updateRtt(50, 16*1024);
+  CPPUNIT_ASSERT_EQUAL((int64_t)80, res.getRtt());
+
+  // The minimum of the previous window still counts.
+  global::wallclock().advance(10);
+  res.updateRtt(120, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)80, res.getRtt());
+  global::wallclock().advance(10);
+  res.updateRtt(130, 0);
+  CPPUNIT_ASSERT_EQUAL((int64_t)120, res.getRtt());
+}
+
 } // namespace aria2
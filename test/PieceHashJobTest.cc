@@ -0,0 +1,104 @@
+#include "PieceHashJob.h"
+
+#include <fstream>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "TestUtil.h"
+#include "DownloadContext.h"
+#include "FileEntry.h"
+#include "MessageDigest.h"
+#include "File.h"
+#include "util.h"
+
+namespace aria2 {
+
+class PieceHashJobTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(PieceHashJobTest);
+  CPPUNIT_TEST(testExecute);
+  CPPUNIT_TEST(testExecute_multiFile);
+  CPPUNIT_TEST(testExecute_readError);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testExecute();
+  void testExecute_multiFile();
+  void testExecute_readError();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PieceHashJobTest );
+
+namespace {
+std::string sha1(const std::string& data)
+{
+  SharedHandle<MessageDigest> ctx = MessageDigest::sha1();
+  ctx->update(data.data(), data.size());
+  return ctx->digest();
+}
+} // namespace
+
+namespace {
+void writeFile(const std::string& path, const std::string& data)
+{
+  File(path).remove();
+  std::ofstream out(path.c_str(), std::ios::binary);
+  out << data;
+}
+} // namespace
+
+void PieceHashJobTest::testExecute()
+{
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(100, 250, A2_TEST_DIR"/chunkChecksumTestFile250.txt"));
+  std::vector<std::string> hashes;
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  PieceHashJob job(dctx, dctx->getFileEntries(), 1, 2);
+  job.execute();
+  CPPUNIT_ASSERT_EQUAL(std::string("4df75a661cb7eb2733d9cdaa7f772eae3a4e2976"),
+                       util::toHex(job.getDigest(1)));
+  CPPUNIT_ASSERT_EQUAL(std::string("0a4ea2f7dd7c52ddf2099a444ab2184b4d341bdb"),
+                       util::toHex(job.getDigest(2)));
+}
+
+void PieceHashJobTest::testExecute_multiFile()
+{
+  std::string dir = A2_TEST_OUT_DIR"/aria2_PieceHashJobTest";
+  File(dir).mkdirs();
+  writeFile(dir+"/file1", "hello ");
+  writeFile(dir+"/file2", "world");
+  SharedHandle<FileEntry> entries[] = {
+    SharedHandle<FileEntry>(new FileEntry(dir+"/file1", 6, 0)),
+    SharedHandle<FileEntry>(new FileEntry(dir+"/empty", 0, 6)),
+    SharedHandle<FileEntry>(new FileEntry(dir+"/file2", 5, 6))
+  };
+  SharedHandle<DownloadContext> dctx(new DownloadContext());
+  dctx->setPieceLength(4);
+  dctx->setFileEntries(&entries[0], &entries[3]);
+  std::vector<std::string> hashes;
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+
+  PieceHashJob job(dctx, dctx->getFileEntries(), 0, 3);
+  job.execute();
+  CPPUNIT_ASSERT(sha1("hell") == job.getDigest(0));
+  CPPUNIT_ASSERT(sha1("o wo") == job.getDigest(1));
+  CPPUNIT_ASSERT(sha1("rld") == job.getDigest(2));
+}
+
+void PieceHashJobTest::testExecute_readError()
+{
+  SharedHandle<DownloadContext> dctx
+    (new DownloadContext(100, 500, A2_TEST_DIR"/chunkChecksumTestFile250.txt"));
+  std::vector<std::string> hashes;
+  dctx->setPieceHashes("sha-1", hashes.begin(), hashes.end());
+  PieceHashJob job(dctx, dctx->getFileEntries(), 1, 3);
+  job.execute();
+  CPPUNIT_ASSERT_EQUAL(std::string("4df75a661cb7eb2733d9cdaa7f772eae3a4e2976"),
+                       util::toHex(job.getDigest(1)));
+  // The file is shorter than 300 bytes.
+  CPPUNIT_ASSERT(job.getDigest(2).empty());
+  CPPUNIT_ASSERT(!job.getError(2).empty());
+  CPPUNIT_ASSERT(job.getDigest(3).empty());
+}
+
+} // namespace aria2
@@ -1,9 +1,30 @@
 #include "PieceStatMan.h"
 
+#include <algorithm>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 namespace aria2 {
 
+namespace {
+// Checks that the order is a permutation of piece indexes sorted by
+// count.
+void checkOrder(const PieceStatMan& pieceStatMan)
+{
+  const std::vector<size_t>& order(pieceStatMan.getOrder());
+  const std::vector<int>& counts(pieceStatMan.getCounts());
+  CPPUNIT_ASSERT_EQUAL(counts.size(), order.size());
+  std::vector<size_t> indexes(order);
+  std::sort(indexes.begin(), indexes.end());
+  for(size_t i = 0; i < indexes.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL(i, indexes[i]);
+  }
+  for(size_t i = 1; i < order.size(); ++i) {
+    CPPUNIT_ASSERT(counts[order[i-1]] <= counts[order[i]]);
+  }
+}
+} // namespace
+
 class PieceStatManTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(PieceStatManTest);
@@ -11,6 +32,8 @@ class PieceStatManTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testAddPieceStats_bitfield);
   CPPUNIT_TEST(testUpdatePieceStats);
   CPPUNIT_TEST(testSubtractPieceStats);
+  CPPUNIT_TEST(testOrder);
+  CPPUNIT_TEST(testOrder_tieIsRandom);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -21,6 +44,8 @@ public:
   void testAddPieceStats_bitfield();
   void testUpdatePieceStats();
   void testSubtractPieceStats();
+  void testOrder();
+  void testOrder_tieIsRandom();
 };
 
 
@@ -32,12 +57,12 @@ void PieceStatManTest::testAddPieceStats_index()
   pieceStatMan.addPieceStats(1);
   {
     int ans[] = { 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
-    const std::vector<size_t>& order(pieceStatMan.getOrder());
     const std::vector<int>& counts(pieceStatMan.getCounts());
     for(size_t i = 0; i < 10; ++i) {
-      CPPUNIT_ASSERT_EQUAL(i, order[i]);
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    CPPUNIT_ASSERT_EQUAL((size_t)1, pieceStatMan.getOrder()[9]);
+    checkOrder(pieceStatMan);
   }
   pieceStatMan.addPieceStats(1);
   {
@@ -57,6 +82,7 @@ void PieceStatManTest::testAddPieceStats_index()
     for(size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
   }
 }
 
@@ -79,6 +105,7 @@ void PieceStatManTest::testAddPieceStats_bitfield()
     for(size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
   }
 }
 
@@ -102,6 +129,7 @@ void PieceStatManTest::testUpdatePieceStats()
     for(size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
   }
 }
 
@@ -123,6 +151,70 @@ void PieceStatManTest::testSubtractPieceStats()
     for(size_t i = 0; i < 10; ++i) {
       CPPUNIT_ASSERT_EQUAL(ans[i], counts[i]);
     }
+    checkOrder(pieceStatMan);
+  }
+}
+
+void PieceStatManTest::testOrder()
+{
+  PieceStatMan pieceStatMan(20, true);
+  const unsigned char full[] = { 0xff, 0xff, 0xf0 };
+  const unsigned char half[] = { 0xaa, 0xaa, 0xa0 };
+  const unsigned char quarter[] = { 0x88, 0x88, 0x80 };
+  pieceStatMan.addPieceStats(full, sizeof(full));
+  pieceStatMan.addPieceStats(half, sizeof(half));
+  pieceStatMan.addPieceStats(quarter, sizeof(quarter));
+  pieceStatMan.addPieceStats(3);
+  checkOrder(pieceStatMan);
+  const std::vector<int>& counts(pieceStatMan.getCounts());
+  CPPUNIT_ASSERT_EQUAL(3, counts[0]);
+  CPPUNIT_ASSERT_EQUAL(2, counts[2]);
+  CPPUNIT_ASSERT_EQUAL(2, counts[3]);
+  CPPUNIT_ASSERT_EQUAL(1, counts[19]);
+  // The rarest pieces come first.
+  CPPUNIT_ASSERT_EQUAL(1, counts[pieceStatMan.getOrder()[0]]);
+  CPPUNIT_ASSERT_EQUAL(3, counts[pieceStatMan.getOrder()[19]]);
+
+  pieceStatMan.subtractPieceStats(full, sizeof(full));
+  checkOrder(pieceStatMan);
+  CPPUNIT_ASSERT_EQUAL(0, counts[pieceStatMan.getOrder()[0]]);
+  CPPUNIT_ASSERT_EQUAL(2, counts[0]);
+
+  pieceStatMan.updatePieceStats(full, sizeof(full), half);
+  checkOrder(pieceStatMan);
+  CPPUNIT_ASSERT_EQUAL(2, counts[0]);
+  CPPUNIT_ASSERT_EQUAL(1, counts[1]);
+  CPPUNIT_ASSERT_EQUAL(2, counts[3]);
+
+  pieceStatMan.subtractPieceStats(full, sizeof(full));
+  pieceStatMan.subtractPieceStats(full, sizeof(full));
+  pieceStatMan.subtractPieceStats(full, sizeof(full));
+  checkOrder(pieceStatMan);
+  for(size_t i = 0; i < 20; ++i) {
+    CPPUNIT_ASSERT_EQUAL(0, counts[i]);
+  }
+}
+
+void PieceStatManTest::testOrder_tieIsRandom()
+{
+  PieceStatMan pieceStatMan(1024, true);
+  std::vector<unsigned char> full(128, 0xff);
+  // A seeder connects. All pieces have the same count, so their order
+  // must stay random instead of following the order of increments.
+  pieceStatMan.addPieceStats(&full[0], full.size());
+  checkOrder(pieceStatMan);
+  const std::vector<size_t>& order(pieceStatMan.getOrder());
+  size_t descents = 0;
+  for(size_t i = 1; i < order.size(); ++i) {
+    if(order[i-1] > order[i]) {
+      ++descents;
+    }
+  }
+  // About a half of the pairs in a random permutation are descents.
+  CPPUNIT_ASSERT(descents > 384);
+  CPPUNIT_ASSERT(descents < 640);
+  for(size_t i = 0; i < order.size(); ++i) {
+    CPPUNIT_ASSERT_EQUAL(i, pieceStatMan.getPositions()[order[i]]);
   }
 }
 
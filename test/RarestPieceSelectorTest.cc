@@ -11,6 +11,7 @@ class RarestPieceSelectorTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(RarestPieceSelectorTest);
   CPPUNIT_TEST(testSelect);
+  CPPUNIT_TEST(testSelect_subtract);
   CPPUNIT_TEST_SUITE_END();
 public:
   void setUp() {}
@@ -22,6 +23,7 @@ public:
   void testUpdatePieceStats();
   void testSubtractPieceStats();
   void testSelect();
+  void testSelect_subtract();
 };
 
 
@@ -48,4 +50,35 @@ void RarestPieceSelectorTest::testSelect()
   CPPUNIT_ASSERT_EQUAL((size_t)2, index);
 }
 
+void RarestPieceSelectorTest::testSelect_subtract()
+{
+  SharedHandle<PieceStatMan> pieceStatMan(new PieceStatMan(16, true));
+  RarestPieceSelector selector(pieceStatMan);
+  BitfieldMan bf(1024, 16*1024);
+  bf.setBitRange(4, 7);
+  size_t index;
+  const unsigned char seeder[] = { 0xff, 0xff };
+  const unsigned char peer[] = { 0x0c, 0x00 };
+  pieceStatMan->addPieceStats(seeder, sizeof(seeder));
+  pieceStatMan->addPieceStats(seeder, sizeof(seeder));
+  pieceStatMan->addPieceStats(peer, sizeof(peer));
+  pieceStatMan->addPieceStats(7);
+
+  // counts: 4:3, 5:3, 6:2, 7:3
+  CPPUNIT_ASSERT(selector.select(index, bf.getBitfield(), bf.countBlock()));
+  CPPUNIT_ASSERT_EQUAL((size_t)6, index);
+
+  pieceStatMan->subtractPieceStats(seeder, sizeof(seeder));
+  pieceStatMan->subtractPieceStats(seeder, sizeof(seeder));
+  pieceStatMan->addPieceStats(6);
+  pieceStatMan->addPieceStats(6);
+
+  // counts: 4:1, 5:1, 6:2, 7:1
+  CPPUNIT_ASSERT(selector.select(index, bf.getBitfield(), bf.countBlock()));
+  CPPUNIT_ASSERT(index == 4 || index == 5 || index == 7);
+
+  bf.clearAllBit();
+  CPPUNIT_ASSERT(!selector.select(index, bf.getBitfield(), bf.countBlock()));
+}
+
 } // namespace aria2
@@ -0,0 +1,57 @@
+#include "RateEstimator.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "wallclock.h"
+
+namespace aria2 {
+
+class RateEstimatorTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(RateEstimatorTest);
+  CPPUNIT_TEST(testCalculateRate);
+  CPPUNIT_TEST(testCalculateRate_steady);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void setUp()
+  {
+    global::wallclock().reset();
+  }
+
+  void testCalculateRate();
+  void testCalculateRate_steady();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RateEstimatorTest);
+
+void RateEstimatorTest::testCalculateRate()
+{
+  RateEstimator rate(5000);
+  rate.update(10000);
+  // Not sampled until 1 second passes.
+  CPPUNIT_ASSERT_EQUAL(0U, rate.calculateRate());
+  global::wallclock().advance(1);
+  // 10000*(1-exp(-1/5))
+  CPPUNIT_ASSERT_EQUAL(1813U, rate.calculateRate());
+  // Repeated calls in the same second do not change the rate.
+  CPPUNIT_ASSERT_EQUAL(1813U, rate.calculateRate());
+  global::wallclock().advance(1);
+  // 1812.69*exp(-1/5)
+  CPPUNIT_ASSERT_EQUAL(1484U, rate.calculateRate());
+}
+
+void RateEstimatorTest::testCalculateRate_steady()
+{
+  RateEstimator rate(5000);
+  for(int i = 0; i < 60; ++i) {
+    rate.update(10000);
+    global::wallclock().advance(1);
+  }
+  CPPUNIT_ASSERT_EQUAL(10000U, rate.calculateRate());
+  // A single idle second does not drop the rate to 0.
+  global::wallclock().advance(1);
+  CPPUNIT_ASSERT(rate.calculateRate() > 8000);
+}
+
+} // namespace aria2
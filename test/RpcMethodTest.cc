@@ -62,6 +62,7 @@ class RpcMethodTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testTellWaiting);
   CPPUNIT_TEST(testTellWaiting_fail);
   CPPUNIT_TEST(testGetVersion);
+  CPPUNIT_TEST(testGetEngineStats);
   CPPUNIT_TEST(testNoSuchMethod);
   CPPUNIT_TEST(testGatherStoppedDownload);
   CPPUNIT_TEST(testGatherProgressCommon);
@@ -126,6 +127,7 @@ public:
   void testTellWaiting();
   void testTellWaiting_fail();
   void testGetVersion();
+  void testGetEngineStats();
   void testNoSuchMethod();
   void testGatherStoppedDownload();
   void testGatherProgressCommon();
@@ -714,6 +716,21 @@ void RpcMethodTest::testGetVersion()
                        features);
 }
 
+void RpcMethodTest::testGetEngineStats()
+{
+  GetEngineStatsRpcMethod m;
+  RpcRequest req(GetEngineStatsRpcMethod::getMethodName(), List::g());
+  RpcResponse res = m.execute(req, e_.get());
+  CPPUNIT_ASSERT_EQUAL(0, res.code);
+  const Dict* resParams = downcast<Dict>(res.param);
+  // Command statistics are disabled.
+  CPPUNIT_ASSERT(!resParams->containsKey("commands"));
+  const Dict* fileCache = downcast<Dict>(resParams->get("fileCache"));
+  CPPUNIT_ASSERT(fileCache);
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(fileCache, "hits"));
+  CPPUNIT_ASSERT_EQUAL(std::string("0"), getString(fileCache, "misses"));
+}
+
 void RpcMethodTest::testGatherStoppedDownload()
 {
   std::vector<SharedHandle<FileEntry> > fileEntries;
@@ -10,9 +10,11 @@ class SequentialPickerTest:public CppUnit::TestFixture {
 
   CPPUNIT_TEST_SUITE(SequentialPickerTest);
   CPPUNIT_TEST(testPick);
+  CPPUNIT_TEST(testPick_multiple);
   CPPUNIT_TEST_SUITE_END();
 public:
   void testPick();
+  void testPick_multiple();
 };
 
 
@@ -48,4 +50,34 @@ void SequentialPickerTest::testPick()
   CPPUNIT_ASSERT(!picker.hasNext());
 }
 
+void SequentialPickerTest::testPick_multiple()
+{
+  SequentialPicker<int> picker;
+  picker.setMaxPickedEntries(2);
+  Integer one(new int(1));
+  Integer two(new int(2));
+  Integer three(new int(3));
+  picker.pushEntry(one);
+  picker.pushEntry(two);
+  picker.pushEntry(three);
+
+  CPPUNIT_ASSERT(picker.canPickNext());
+  picker.pickNext();
+  CPPUNIT_ASSERT(picker.canPickNext());
+  picker.pickNext();
+  CPPUNIT_ASSERT(!picker.canPickNext());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, picker.getPickedEntries().size());
+  CPPUNIT_ASSERT(one.get() == picker.getPickedEntry().get());
+
+  picker.dropPickedEntry(one);
+  CPPUNIT_ASSERT(two.get() == picker.getPickedEntry().get());
+  CPPUNIT_ASSERT(picker.canPickNext());
+  picker.pickNext();
+  CPPUNIT_ASSERT(!picker.hasNext());
+  CPPUNIT_ASSERT(!picker.canPickNext());
+
+  picker.dropPickedEntry();
+  CPPUNIT_ASSERT(!picker.isPicked());
+}
+
 } // namespace aria2
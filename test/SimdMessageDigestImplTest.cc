@@ -0,0 +1,130 @@
+#include "SimdMessageDigestImpl.h"
+
+#include <cstdlib>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "MessageDigestImpl.h"
+#include "util.h"
+#include "array_fun.h"
+
+namespace aria2 {
+
+class SimdMessageDigestImplTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SimdMessageDigestImplTest);
+  CPPUNIT_TEST(testDigest);
+  CPPUNIT_TEST(testDigest_compareWithLibrary);
+  CPPUNIT_TEST(testCreate_unsupported);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testDigest();
+  void testDigest_compareWithLibrary();
+  void testCreate_unsupported();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SimdMessageDigestImplTest );
+
+namespace {
+template<typename T>
+std::string digest(const SharedHandle<T>& impl)
+{
+  array_ptr<unsigned char> md(new unsigned char[impl->getDigestLength()]);
+  impl->digest(md);
+  return util::toHex(&md[0], impl->getDigestLength());
+}
+} // namespace
+
+void SimdMessageDigestImplTest::testDigest()
+{
+  SharedHandle<SimdMessageDigestImpl> sha1 =
+    SimdMessageDigestImpl::create("sha-1");
+  if(!sha1) {
+    // No accelerated implementation on this CPU.
+    return;
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("da39a3ee5e6b4b0d3255bfef95601890afd80709"),
+                       digest(sha1));
+  sha1->update("abc", 3);
+  CPPUNIT_ASSERT_EQUAL(std::string("a9993e364706816aba3e25717850c26c9cd0d89d"),
+                       digest(sha1));
+  for(int i = 0; i < 1000; ++i) {
+    sha1->update("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+                 "aaaaaaaa", 1000);
+  }
+  CPPUNIT_ASSERT_EQUAL(std::string("34aa973cd4c4daa4f61eeb2bdbad27316534016f"),
+                       digest(sha1));
+
+  SharedHandle<SimdMessageDigestImpl> sha256 =
+    SimdMessageDigestImpl::create("sha-256");
+  CPPUNIT_ASSERT(sha256);
+  sha256->update("abc", 3);
+  CPPUNIT_ASSERT_EQUAL
+    (std::string("ba7816bf8f01cfea414140de5dae2223"
+                 "b00361a396177a9cb410ff61f20015ad"),
+     digest(sha256));
+  const char msg[] =
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+  sha256->update(msg, sizeof(msg)-1);
+  CPPUNIT_ASSERT_EQUAL
+    (std::string("248d6a61d20638b8e5c026930c3e6039"
+                 "a33ce45964ff2167f6ecedd419db06c1"),
+     digest(sha256));
+}
+
+void SimdMessageDigestImplTest::testDigest_compareWithLibrary()
+{
+  const char* hashTypes[] = { "sha-1", "sha-256" };
+  unsigned char data[1024];
+  for(size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = rand();
+  }
+  for(size_t t = 0; t < A2_ARRAY_LEN(hashTypes); ++t) {
+    SharedHandle<SimdMessageDigestImpl> simd =
+      SimdMessageDigestImpl::create(hashTypes[t]);
+    if(!simd) {
+      return;
+    }
+    SharedHandle<MessageDigestImpl> lib =
+      MessageDigestImpl::create(hashTypes[t]);
+    for(size_t len = 0; len <= 300; ++len) {
+      // Feed data in uneven pieces to exercise buffering.
+      for(size_t off = 0; off < len;) {
+        size_t n = std::min(len-off, off%7+1);
+        simd->update(data+off, n);
+        off += n;
+      }
+      lib->reset();
+      lib->update(data, len);
+      CPPUNIT_ASSERT_EQUAL(digest(lib), digest(simd));
+    }
+    simd->update(data, sizeof(data));
+    lib->reset();
+    lib->update(data, sizeof(data));
+    CPPUNIT_ASSERT_EQUAL(digest(lib), digest(simd));
+  }
+}
+
+void SimdMessageDigestImplTest::testCreate_unsupported()
+{
+  CPPUNIT_ASSERT(!SimdMessageDigestImpl::create("md5"));
+  CPPUNIT_ASSERT(!SimdMessageDigestImpl::create("sha-512"));
+}
+
+} // namespace aria2
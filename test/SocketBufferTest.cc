@@ -0,0 +1,124 @@
+#include "SocketBuffer.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "MultiDiskAdaptor.h"
+#include "FileEntry.h"
+#include "array_fun.h"
+
+namespace aria2 {
+
+class SocketBufferTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SocketBufferTest);
+  CPPUNIT_TEST(testSend);
+#ifdef HAVE_SENDFILE
+  CPPUNIT_TEST(testPushFile);
+#endif // HAVE_SENDFILE
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testSend();
+#ifdef HAVE_SENDFILE
+  void testPushFile();
+#endif // HAVE_SENDFILE
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SocketBufferTest);
+
+namespace {
+std::pair<SharedHandle<SocketCore>, SharedHandle<SocketCore> >
+createSocketPair()
+{
+  SharedHandle<SocketCore> clientSock(new SocketCore());
+
+  SocketCore serverSock;
+  serverSock.bind(0);
+  serverSock.beginListen();
+
+  std::pair<std::string, uint16_t> addrinfo;
+  serverSock.getAddrInfo(addrinfo);
+  clientSock->establishConnection("localhost", addrinfo.second);
+  clientSock->setBlockingMode();
+
+  SharedHandle<SocketCore> acceptedSock(serverSock.acceptConnection());
+  acceptedSock->setBlockingMode();
+
+  return std::make_pair(clientSock, acceptedSock);
+}
+} // namespace
+
+namespace {
+std::string readAll(const SharedHandle<SocketCore>& socket, size_t len)
+{
+  std::string res;
+  while(res.size() < len) {
+    char buf[256];
+    size_t n = std::min(sizeof(buf), len-res.size());
+    socket->readData(buf, n);
+    if(n == 0) {
+      break;
+    }
+    res.append(&buf[0], &buf[n]);
+  }
+  return res;
+}
+} // namespace
+
+void SocketBufferTest::testSend()
+{
+  std::pair<SharedHandle<SocketCore>, SharedHandle<SocketCore> > sockPair =
+    createSocketPair();
+  SocketBuffer sb(sockPair.first);
+  CPPUNIT_ASSERT(sb.sendBufferIsEmpty());
+  unsigned char* bytes = new unsigned char[5];
+  memcpy(bytes, "hello", 5);
+  sb.pushBytes(bytes, 5);
+  sb.pushStr(" world");
+  CPPUNIT_ASSERT(!sb.sendBufferIsEmpty());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)11, sb.send());
+  CPPUNIT_ASSERT(sb.sendBufferIsEmpty());
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"),
+                       readAll(sockPair.second, 11));
+
+  // Sent buffers are returned to the free list.
+  FreeList freeList(16, 4);
+  bytes = static_cast<unsigned char*>(freeList.allocate());
+  memcpy(bytes, "pooled", 6);
+  sb.pushBytes(bytes, 6, &freeList);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, freeList.countFree());
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, sb.send());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, freeList.countFree());
+  CPPUNIT_ASSERT_EQUAL(std::string("pooled"), readAll(sockPair.second, 6));
+}
+
+#ifdef HAVE_SENDFILE
+void SocketBufferTest::testPushFile()
+{
+  std::string dir = A2_TEST_OUT_DIR"/aria2_SocketBufferTest_testPushFile";
+  SharedHandle<FileEntry> entries[] = {
+    SharedHandle<FileEntry>(new FileEntry(dir+"/file1", 3, 0)),
+    SharedHandle<FileEntry>(new FileEntry(dir+"/file2", 4, 3)),
+  };
+  SharedHandle<MultiDiskAdaptor> adaptor(new MultiDiskAdaptor());
+  adaptor->setFileEntries(vbegin(entries), vend(entries));
+  adaptor->initAndOpenFile();
+  adaptor->writeData(reinterpret_cast<const unsigned char*>("abcdefg"), 7, 0);
+
+  std::pair<SharedHandle<SocketCore>, SharedHandle<SocketCore> > sockPair =
+    createSocketPair();
+  SocketBuffer sb(sockPair.first);
+  sb.pushStr("[");
+  // Spans file1 and file2
+  sb.pushFile(adaptor, 1, 5);
+  sb.pushStr("]");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)7, sb.send());
+  CPPUNIT_ASSERT(sb.sendBufferIsEmpty());
+  CPPUNIT_ASSERT_EQUAL(std::string("[bcdef]"), readAll(sockPair.second, 7));
+}
+#endif // HAVE_SENDFILE
+
+} // namespace aria2
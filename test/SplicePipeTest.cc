@@ -0,0 +1,84 @@
+#include "SplicePipe.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "SocketCore.h"
+#include "DefaultDiskWriter.h"
+#include "File.h"
+#include "TestUtil.h"
+
+namespace aria2 {
+
+class SplicePipeTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SplicePipeTest);
+  CPPUNIT_TEST(testRecvAndWriteTo);
+  CPPUNIT_TEST(testRecv_eof);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testRecvAndWriteTo();
+  void testRecv_eof();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SplicePipeTest);
+
+namespace {
+std::pair<SharedHandle<SocketCore>, SharedHandle<SocketCore> >
+createSocketPair()
+{
+  SharedHandle<SocketCore> clientSock(new SocketCore());
+
+  SocketCore serverSock;
+  serverSock.bind(0);
+  serverSock.beginListen();
+
+  std::pair<std::string, uint16_t> addrinfo;
+  serverSock.getAddrInfo(addrinfo);
+  clientSock->establishConnection("localhost", addrinfo.second);
+  clientSock->setBlockingMode();
+
+  SharedHandle<SocketCore> acceptedSock(serverSock.acceptConnection());
+  acceptedSock->setBlockingMode();
+
+  return std::make_pair(clientSock, acceptedSock);
+}
+} // namespace
+
+void SplicePipeTest::testRecvAndWriteTo()
+{
+  std::string filename = A2_TEST_OUT_DIR"/aria2_SplicePipeTest_recv";
+  File(filename).remove();
+  DefaultDiskWriter dw(filename);
+  dw.initAndOpenFile();
+
+  std::pair<SharedHandle<SocketCore>, SharedHandle<SocketCore> > sockPair =
+    createSocketPair();
+  SplicePipe pipe;
+  CPPUNIT_ASSERT(pipe.good());
+
+  sockPair.first->writeData("world");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, pipe.recv(sockPair.second, 5));
+  CPPUNIT_ASSERT_EQUAL((size_t)5, pipe.getLength());
+  pipe.writeTo(dw.getFd(), 6, filename);
+  CPPUNIT_ASSERT_EQUAL((size_t)0, pipe.getLength());
+
+  sockPair.first->writeData("hello ");
+  CPPUNIT_ASSERT_EQUAL((ssize_t)6, pipe.recv(sockPair.second, 6));
+  pipe.writeTo(dw.getFd(), 0, filename);
+  dw.closeFile();
+
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world"), readFile(filename));
+}
+
+void SplicePipeTest::testRecv_eof()
+{
+  std::pair<SharedHandle<SocketCore>, SharedHandle<SocketCore> > sockPair =
+    createSocketPair();
+  SplicePipe pipe;
+  sockPair.first->closeConnection();
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, pipe.recv(sockPair.second, 16));
+  CPPUNIT_ASSERT(!sockPair.second->wantRead());
+}
+
+} // namespace aria2
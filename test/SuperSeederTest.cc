@@ -0,0 +1,99 @@
+#include "SuperSeeder.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "PieceStatMan.h"
+
+namespace aria2 {
+
+class SuperSeederTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(SuperSeederTest);
+  CPPUNIT_TEST(testGetNextPiece);
+  CPPUNIT_TEST(testCanUpload);
+  CPPUNIT_TEST(testRemovePeer);
+  CPPUNIT_TEST_SUITE_END();
+private:
+  SharedHandle<PieceStatMan> pieceStatMan_;
+  SharedHandle<SuperSeeder> superSeeder_;
+public:
+  void setUp()
+  {
+    pieceStatMan_.reset(new PieceStatMan(4, false));
+    superSeeder_.reset(new SuperSeeder(pieceStatMan_));
+    superSeeder_->addPeer(1);
+    superSeeder_->addPeer(2);
+  }
+
+  void testGetNextPiece();
+  void testCanUpload();
+  void testRemovePeer();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SuperSeederTest);
+
+void SuperSeederTest::testGetNextPiece()
+{
+  unsigned char bitfield1[] = { 0x00 };
+  unsigned char bitfield2[] = { 0x00 };
+  size_t index;
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 1, bitfield1, 4));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index);
+  // Peer 1 waits until piece 0 propagates.
+  CPPUNIT_ASSERT(!superSeeder_->getNextPiece(index, 1, bitfield1, 4));
+  // Peer 2 is shown another piece.
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 2, bitfield2, 4));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index);
+  // Peer 1 downloaded piece 0, but peer 2 does not have it yet.
+  bitfield1[0] = 0x80;
+  pieceStatMan_->addPieceStats(0);
+  superSeeder_->updatePeerHave(1, 0);
+  CPPUNIT_ASSERT(!superSeeder_->getNextPiece(index, 1, bitfield1, 4));
+  // Peer 2 got piece 0 from peer 1.
+  bitfield2[0] = 0x80;
+  pieceStatMan_->addPieceStats(0);
+  superSeeder_->updatePeerHave(2, 0);
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 1, bitfield1, 4));
+  // Piece 1 is already shown to peer 2, so peer 1 gets one of the
+  // pieces nobody has seen yet.
+  CPPUNIT_ASSERT(index == 2 || index == 3);
+  // Peer 2 has not downloaded piece 1 yet.
+  CPPUNIT_ASSERT(!superSeeder_->getNextPiece(index, 2, bitfield2, 4));
+  // Unknown peer
+  CPPUNIT_ASSERT(!superSeeder_->getNextPiece(index, 3, bitfield2, 4));
+}
+
+void SuperSeederTest::testCanUpload()
+{
+  unsigned char bitfield[] = { 0x00 };
+  size_t index;
+  CPPUNIT_ASSERT(!superSeeder_->canUpload(1, 0));
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 1, bitfield, 4));
+  CPPUNIT_ASSERT(superSeeder_->canUpload(1, index));
+  CPPUNIT_ASSERT(!superSeeder_->canUpload(2, index));
+  // Peers which are not super-seeded are not restricted.
+  CPPUNIT_ASSERT(superSeeder_->canUpload(3, index));
+}
+
+void SuperSeederTest::testRemovePeer()
+{
+  unsigned char bitfield[] = { 0x00 };
+  size_t index;
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 2, bitfield, 4));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index);
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 1, bitfield, 4));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, index);
+  superSeeder_->removePeer(2);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, superSeeder_->countPeer());
+  // Peer 1 downloaded piece 1. No one else is left to get it from
+  // peer 1, so peer 1 gets piece 0 which is no longer shown to
+  // anyone.
+  bitfield[0] = 0x40;
+  pieceStatMan_->addPieceStats(1);
+  superSeeder_->updatePeerHave(1, 1);
+  CPPUNIT_ASSERT(superSeeder_->getNextPiece(index, 1, bitfield, 4));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, index);
+}
+
+} // namespace aria2
@@ -0,0 +1,107 @@
+#include "ThreadPool.h"
+
+#include <poll.h>
+
+#include <algorithm>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "ThreadJob.h"
+
+namespace aria2 {
+
+class ThreadPoolTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(ThreadPoolTest);
+  CPPUNIT_TEST(testSubmit);
+  CPPUNIT_TEST(testDestroyWithPendingJobs);
+  CPPUNIT_TEST(testWait);
+  CPPUNIT_TEST_SUITE_END();
+public:
+  void testSubmit();
+  void testDestroyWithPendingJobs();
+  void testWait();
+};
+
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ThreadPoolTest);
+
+namespace {
+class SumJob:public ThreadJob {
+public:
+  int n;
+  int sum;
+  SumJob(int n):n(n), sum(0) {}
+  virtual void execute()
+  {
+    for(int i = 1; i <= n; ++i) {
+      sum += i;
+    }
+  }
+};
+} // namespace
+
+void ThreadPoolTest::testSubmit()
+{
+  ThreadPool pool(3);
+  CPPUNIT_ASSERT(pool.good());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, pool.getNumThreads());
+  std::vector<SumJob*> jobs;
+  for(int i = 0; i < 100; ++i) {
+    jobs.push_back(new SumJob(i));
+    pool.submit(jobs.back());
+  }
+  std::vector<ThreadJob*> doneJobs;
+  while(doneJobs.size() < jobs.size()) {
+    struct pollfd pfd;
+    pfd.fd = pool.getWakeFd();
+    pfd.events = POLLIN;
+    CPPUNIT_ASSERT(poll(&pfd, 1, 5000) == 1);
+    pool.getDoneJobs(doneJobs);
+  }
+  CPPUNIT_ASSERT_EQUAL(jobs.size(), doneJobs.size());
+  for(size_t i = 0; i < jobs.size(); ++i) {
+    CPPUNIT_ASSERT(std::find(doneJobs.begin(), doneJobs.end(), jobs[i]) !=
+                   doneJobs.end());
+    CPPUNIT_ASSERT_EQUAL(jobs[i]->n*(jobs[i]->n+1)/2, jobs[i]->sum);
+    delete jobs[i];
+  }
+  // Wake up pipe is drained.
+  struct pollfd pfd;
+  pfd.fd = pool.getWakeFd();
+  pfd.events = POLLIN;
+  CPPUNIT_ASSERT_EQUAL(0, poll(&pfd, 1, 0));
+}
+
+void ThreadPoolTest::testDestroyWithPendingJobs()
+{
+  std::vector<SumJob*> jobs;
+  {
+    ThreadPool pool(1);
+    for(int i = 0; i < 1000; ++i) {
+      jobs.push_back(new SumJob(10000));
+      pool.submit(jobs.back());
+    }
+  }
+  for(size_t i = 0; i < jobs.size(); ++i) {
+    CPPUNIT_ASSERT(jobs[i]->sum == 0 || jobs[i]->sum == 50005000);
+    delete jobs[i];
+  }
+}
+
+void ThreadPoolTest::testWait()
+{
+  ThreadPool pool(2);
+  SumJob job1(10000), job2(100);
+  pool.submit(&job1);
+  pool.submit(&job2);
+  pool.wait(&job2);
+  CPPUNIT_ASSERT_EQUAL(5050, job2.sum);
+  pool.wait(&job1);
+  CPPUNIT_ASSERT_EQUAL(50005000, job1.sum);
+  std::vector<ThreadJob*> doneJobs;
+  pool.getDoneJobs(doneJobs);
+  CPPUNIT_ASSERT_EQUAL((size_t)2, doneJobs.size());
+}
+
+} // namespace aria2
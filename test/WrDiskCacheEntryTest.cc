@@ -0,0 +1,102 @@
+#include "WrDiskCacheEntry.h"
+
+#include <cstring>
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+
+namespace aria2 {
+
+class WrDiskCacheEntryTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(WrDiskCacheEntryTest);
+  CPPUNIT_TEST(testCacheData);
+  CPPUNIT_TEST(testWriteToDisk);
+  CPPUNIT_TEST(testWriteToDisk_overlap);
+  CPPUNIT_TEST_SUITE_END();
+
+  SharedHandle<DirectDiskAdaptor> adaptor_;
+  SharedHandle<ByteArrayDiskWriter> writer_;
+public:
+  void setUp()
+  {
+    adaptor_.reset(new DirectDiskAdaptor());
+    writer_.reset(new ByteArrayDiskWriter());
+    adaptor_->setDiskWriter(writer_);
+    adaptor_->setTotalLength(16);
+  }
+
+  void testCacheData();
+  void testWriteToDisk();
+  void testWriteToDisk_overlap();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WrDiskCacheEntryTest);
+
+namespace {
+WrDiskCacheEntry::DataCell* createDataCell(off_t goff, const char* data)
+{
+  WrDiskCacheEntry::DataCell* cell = new WrDiskCacheEntry::DataCell();
+  cell->goff = goff;
+  cell->len = strlen(data);
+  cell->data = new unsigned char[cell->len];
+  memcpy(cell->data, data, cell->len);
+  return cell;
+}
+} // namespace
+
+void WrDiskCacheEntryTest::testCacheData()
+{
+  WrDiskCacheEntry e(0, adaptor_);
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, e.cacheData(createDataCell(0, "hello")));
+  CPPUNIT_ASSERT_EQUAL((ssize_t)5, e.cacheData(createDataCell(6, "world")));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, e.getSize());
+  // Same offset overwrites the head of the old cell.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, e.cacheData(createDataCell(6, "WO")));
+  CPPUNIT_ASSERT_EQUAL((size_t)10, e.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, e.getDataSet().size());
+  // Covering the old cell replaces it.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, e.cacheData(createDataCell(6, "WORLD!")));
+  CPPUNIT_ASSERT_EQUAL((size_t)11, e.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)2, e.getDataSet().size());
+  e.deleteDataCells();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, e.getSize());
+  CPPUNIT_ASSERT(e.getDataSet().empty());
+}
+
+void WrDiskCacheEntryTest::testWriteToDisk()
+{
+  adaptor_->openFile();
+  WrDiskCacheEntry e(0, adaptor_);
+  e.cacheData(createDataCell(6, "world"));
+  e.cacheData(createDataCell(0, "hello"));
+  e.cacheData(createDataCell(5, " "));
+  e.cacheData(createDataCell(12, "!!"));
+  e.writeToDisk();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, e.getSize());
+  CPPUNIT_ASSERT(e.getDataSet().empty());
+  CPPUNIT_ASSERT_EQUAL(std::string("hello world\0!!", 14),
+                       writer_->getString());
+}
+
+void WrDiskCacheEntryTest::testWriteToDisk_overlap()
+{
+  adaptor_->openFile();
+  WrDiskCacheEntry e(0, adaptor_);
+  e.cacheData(createDataCell(0, "hello"));
+  e.cacheData(createDataCell(6, "world"));
+  // Overlaps the tail of "hello" and the head of "world". The newer
+  // data win.
+  CPPUNIT_ASSERT_EQUAL((ssize_t)1, e.cacheData(createDataCell(3, "LO WO")));
+  CPPUNIT_ASSERT_EQUAL((size_t)11, e.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)3, e.getDataSet().size());
+  // Inside a cell
+  CPPUNIT_ASSERT_EQUAL((ssize_t)0, e.cacheData(createDataCell(8, "R")));
+  CPPUNIT_ASSERT_EQUAL((size_t)3, e.getDataSet().size());
+  e.writeToDisk();
+  CPPUNIT_ASSERT_EQUAL(std::string("helLO WORld"), writer_->getString());
+}
+
+} // namespace aria2
@@ -0,0 +1,212 @@
+#include "WrDiskCache.h"
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "WrDiskCacheEntry.h"
+#include "Piece.h"
+#include "DirectDiskAdaptor.h"
+#include "ByteArrayDiskWriter.h"
+#include "util.h"
+#include "DlAbortEx.h"
+#include "DownloadEngine.h"
+#include "SelectEventPoll.h"
+#include "ThreadPool.h"
+
+namespace aria2 {
+
+namespace {
+class FailingDiskWriter:public ByteArrayDiskWriter {
+public:
+  virtual void writeData(const unsigned char* data, size_t len, off_t position)
+  {
+    throw DL_ABORT_EX("disk is full");
+  }
+  virtual bool isThreadSafe() const
+  {
+    return true;
+  }
+};
+} // namespace
+
+class WrDiskCacheTest:public CppUnit::TestFixture {
+
+  CPPUNIT_TEST_SUITE(WrDiskCacheTest);
+  CPPUNIT_TEST(testAdd);
+  CPPUNIT_TEST(testEnsureLimit);
+  CPPUNIT_TEST(testEnsureLimit_otherDownloadError);
+  CPPUNIT_TEST(testAsyncWriteError);
+  CPPUNIT_TEST(testPiece);
+  CPPUNIT_TEST_SUITE_END();
+
+  SharedHandle<DirectDiskAdaptor> adaptor_;
+  SharedHandle<ByteArrayDiskWriter> writer_;
+public:
+  void setUp()
+  {
+    adaptor_.reset(new DirectDiskAdaptor());
+    writer_.reset(new ByteArrayDiskWriter());
+    adaptor_->setDiskWriter(writer_);
+    adaptor_->setTotalLength(Piece::BLOCK_LENGTH*4);
+    adaptor_->openFile();
+  }
+
+  void testAdd();
+  void testEnsureLimit();
+  void testEnsureLimit_otherDownloadError();
+  void testAsyncWriteError();
+  void testPiece();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WrDiskCacheTest);
+
+void WrDiskCacheTest::testAdd()
+{
+  WrDiskCache cache(1024);
+  WrDiskCacheEntry e(&cache, adaptor_);
+  CPPUNIT_ASSERT(cache.add(&e));
+  CPPUNIT_ASSERT(!cache.add(&e));
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countEntry());
+  CPPUNIT_ASSERT(cache.update(&e, 100));
+  CPPUNIT_ASSERT_EQUAL((size_t)100, cache.getSize());
+  CPPUNIT_ASSERT(cache.update(&e, -100));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+  CPPUNIT_ASSERT(cache.remove(&e));
+  CPPUNIT_ASSERT(!cache.remove(&e));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countEntry());
+  CPPUNIT_ASSERT(!cache.update(&e, 1));
+}
+
+void WrDiskCacheTest::testEnsureLimit()
+{
+  std::string block(Piece::BLOCK_LENGTH, 'a');
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(block.data());
+  WrDiskCache cache(Piece::BLOCK_LENGTH*2);
+  Piece p1(0, Piece::BLOCK_LENGTH*2);
+  Piece p2(1, Piece::BLOCK_LENGTH*2);
+  p1.initWrCache(&cache, adaptor_);
+  p2.initWrCache(&cache, adaptor_);
+  p1.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  p2.updateWrCache(data, Piece::BLOCK_LENGTH, Piece::BLOCK_LENGTH*2);
+  CPPUNIT_ASSERT_EQUAL((size_t)Piece::BLOCK_LENGTH*2, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, writer_->getString().size());
+  // p1 is the least recently updated entry, so it is written.
+  p2.updateWrCache(data, Piece::BLOCK_LENGTH, Piece::BLOCK_LENGTH*3);
+  CPPUNIT_ASSERT_EQUAL((size_t)Piece::BLOCK_LENGTH*2, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, p1.getWrDiskCacheEntry()->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)Piece::BLOCK_LENGTH*2,
+                       p2.getWrDiskCacheEntry()->getSize());
+  CPPUNIT_ASSERT_EQUAL(block, writer_->getString());
+  p2.flushWrCache();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)Piece::BLOCK_LENGTH*4,
+                       writer_->getString().size());
+  p1.releaseWrCache();
+  CPPUNIT_ASSERT(!p1.getWrDiskCacheEntry());
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countEntry());
+}
+
+void WrDiskCacheTest::testEnsureLimit_otherDownloadError()
+{
+  std::string block(Piece::BLOCK_LENGTH, 'a');
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(block.data());
+  SharedHandle<DirectDiskAdaptor> failingAdaptor(new DirectDiskAdaptor());
+  failingAdaptor->setDiskWriter(SharedHandle<DiskWriter>
+                                (new FailingDiskWriter()));
+  failingAdaptor->setTotalLength(Piece::BLOCK_LENGTH*4);
+  failingAdaptor->openFile();
+  WrDiskCache cache(Piece::BLOCK_LENGTH);
+  Piece p1(0, Piece::BLOCK_LENGTH*2);
+  Piece p2(0, Piece::BLOCK_LENGTH*2);
+  p1.initWrCache(&cache, failingAdaptor);
+  p2.initWrCache(&cache, adaptor_);
+  p1.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  // Writing p1 fails, but the error is not thrown to the download of
+  // p2. The data of p1 are dropped and the error is recorded.
+  p2.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  CPPUNIT_ASSERT(p1.getWrDiskCacheEntry()->getWriteError());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, p1.getWrDiskCacheEntry()->getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)Piece::BLOCK_LENGTH, cache.getSize());
+  p2.flushWrCache();
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+  // The error of the own download is thrown.
+  p1.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  try {
+    p1.updateWrCache(data, Piece::BLOCK_LENGTH, Piece::BLOCK_LENGTH);
+    CPPUNIT_FAIL("exception must be thrown");
+  } catch(RecoverableException& e) {
+    // success
+  }
+  p1.releaseWrCache();
+  p2.releaseWrCache();
+}
+
+void WrDiskCacheTest::testAsyncWriteError()
+{
+  std::string block(Piece::BLOCK_LENGTH, 'a');
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(block.data());
+  SharedHandle<DirectDiskAdaptor> failingAdaptor(new DirectDiskAdaptor());
+  failingAdaptor->setDiskWriter(SharedHandle<DiskWriter>
+                                (new FailingDiskWriter()));
+  failingAdaptor->setTotalLength(Piece::BLOCK_LENGTH*4);
+  failingAdaptor->openFile();
+  DownloadEngine e(SharedHandle<EventPoll>(new SelectEventPoll()));
+  e.setThreadPool(SharedHandle<ThreadPool>(new ThreadPool(1)));
+  WrDiskCache cache(Piece::BLOCK_LENGTH);
+  cache.setDownloadEngine(&e);
+  Piece p1(0, Piece::BLOCK_LENGTH*2);
+  Piece p2(0, Piece::BLOCK_LENGTH*2);
+  p1.initWrCache(&cache, failingAdaptor);
+  p2.initWrCache(&cache, adaptor_);
+  p1.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  // p1 is evicted and written by the worker thread, which fails.
+  p2.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  CPPUNIT_ASSERT_EQUAL((size_t)1, cache.countPendingWrite());
+  cache.waitAsyncWrite(p1.getWrDiskCacheEntry());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countPendingWrite());
+  // Nothing is left to write, so the caller must check the write
+  // error flag before completing the piece.
+  CPPUNIT_ASSERT(!p1.flushWrCacheAsync(0, SharedHandle<PieceStorage>(),
+                                       SharedHandle<Piece>(), 0));
+  CPPUNIT_ASSERT(p1.getWrDiskCacheEntry()->getWriteError());
+  p1.clearAllBlock();
+  CPPUNIT_ASSERT(!p1.getWrDiskCacheEntry()->getWriteError());
+  p1.releaseWrCache();
+  p2.releaseWrCache();
+}
+
+void WrDiskCacheTest::testPiece()
+{
+  std::string block(Piece::BLOCK_LENGTH, 'a');
+  const unsigned char* data =
+    reinterpret_cast<const unsigned char*>(block.data());
+  WrDiskCache cache(Piece::BLOCK_LENGTH*4);
+  {
+    Piece p(0, Piece::BLOCK_LENGTH*2);
+    p.initWrCache(&cache, adaptor_);
+    p.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+    CPPUNIT_ASSERT_EQUAL((size_t)Piece::BLOCK_LENGTH, cache.getSize());
+    p.clearAllBlock();
+    CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+    p.updateWrCache(data, Piece::BLOCK_LENGTH, 0);
+  }
+  // Piece's destructor discards the cached data.
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.getSize());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, cache.countEntry());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, writer_->getString().size());
+#ifdef ENABLE_MESSAGE_DIGEST
+  Piece p(0, Piece::BLOCK_LENGTH*2);
+  p.setHashType("sha-1");
+  p.initWrCache(&cache, adaptor_);
+  adaptor_->writeData(data, Piece::BLOCK_LENGTH, 0);
+  p.updateWrCache(data, Piece::BLOCK_LENGTH, Piece::BLOCK_LENGTH);
+  // 32KiB of 'a'
+  CPPUNIT_ASSERT_EQUAL(std::string("94b0a80707ea5daee9093efe9d9433533c4ce482"),
+                       util::toHex(p.getDigestWithWrCache
+                                   (Piece::BLOCK_LENGTH*2, adaptor_)));
+#endif // ENABLE_MESSAGE_DIGEST
+}
+
+} // namespace aria2
@@ -1,5 +1,8 @@
 #include "bitfield.h"
 
+#include <vector>
+#include <iterator>
+
 #include <cppunit/extensions/HelperMacros.h>
 
 namespace aria2 {
@@ -11,6 +14,12 @@ class bitfieldTest:public CppUnit::TestFixture {
   CPPUNIT_TEST(testCountBit32);
   CPPUNIT_TEST(testCountSetBit);
   CPPUNIT_TEST(testLastByteMask);
+  CPPUNIT_TEST(testCountBit64);
+  CPPUNIT_TEST(testCountSetBitAnd);
+  CPPUNIT_TEST(testAndNot);
+  CPPUNIT_TEST(testGetNextSetBitIndex);
+  CPPUNIT_TEST(testGetNextUnsetBitIndex);
+  CPPUNIT_TEST(testGetFirstNSetBitIndex);
   CPPUNIT_TEST_SUITE_END();
 private:
 
@@ -19,6 +28,12 @@ public:
   void testCountBit32();
   void testCountSetBit();
   void testLastByteMask();
+  void testCountBit64();
+  void testCountSetBitAnd();
+  void testAndNot();
+  void testGetNextSetBitIndex();
+  void testGetNextUnsetBitIndex();
+  void testGetFirstNSetBitIndex();
 };
 
 
@@ -66,4 +81,139 @@ void bitfieldTest::testLastByteMask()
                        (unsigned int)bitfield::lastByteMask(16));
 }
 
+void bitfieldTest::testCountBit64()
+{
+  CPPUNIT_ASSERT_EQUAL((size_t)64, bitfield::countBit64(UINT64_MAX));
+  CPPUNIT_ASSERT_EQUAL((size_t)0, bitfield::countBit64(0));
+  CPPUNIT_ASSERT_EQUAL((size_t)33,
+                       bitfield::countBit64(0x80000000ffffffffULL));
+}
+
+void bitfieldTest::testCountSetBitAnd()
+{
+  // Longer than 32 bytes so that the word-wide kernels are used.
+  unsigned char bitfield1[40];
+  unsigned char bitfield2[40];
+  memset(bitfield1, 0xff, sizeof(bitfield1));
+  memset(bitfield2, 0x0f, sizeof(bitfield2));
+  bitfield2[39] = 0xff;
+  CPPUNIT_ASSERT_EQUAL((size_t)4*39+8,
+                       bitfield::countSetBitAnd(bitfield1, bitfield2, 320));
+  CPPUNIT_ASSERT_EQUAL((size_t)4*39+3,
+                       bitfield::countSetBitAnd(bitfield1, bitfield2, 315));
+  CPPUNIT_ASSERT_EQUAL((size_t)0,
+                       bitfield::countSetBitAnd(bitfield1, bitfield2, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)315, bitfield::countSetBit(bitfield1, 315));
+}
+
+void bitfieldTest::testAndNot()
+{
+  unsigned char a[40];
+  unsigned char b[40];
+  unsigned char n1[40];
+  unsigned char n2[40];
+  unsigned char dst[40];
+  memset(a, 0xff, sizeof(a));
+  memset(b, 0xf0, sizeof(b));
+  memset(n1, 0xc0, sizeof(n1));
+  memset(n2, 0, sizeof(n2));
+  n2[39] = 0x20;
+
+  CPPUNIT_ASSERT(bitfield::andNot(dst, a, b, n1, n2, 316));
+  for(size_t i = 0; i < 39; ++i) {
+    CPPUNIT_ASSERT_EQUAL((unsigned int)0x30u, (unsigned int)dst[i]);
+  }
+  // 0x30&~0x20, and the bits after 316 are cleared.
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0x10u, (unsigned int)dst[39]);
+  CPPUNIT_ASSERT(bitfield::andNot(dst, a, b, n1, n2, 315));
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0, (unsigned int)dst[39]);
+
+  // 0 means the operand is not used.
+  CPPUNIT_ASSERT(bitfield::andNot(dst, 0, 0, n1, 0, 315));
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0x3fu, (unsigned int)dst[0]);
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0x20u, (unsigned int)dst[39]);
+  CPPUNIT_ASSERT(bitfield::andNot(dst, 0, b, 0, 0, 315));
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0xf0u, (unsigned int)dst[0]);
+  CPPUNIT_ASSERT(bitfield::andNot(dst, 0, b, 0, n1, 315));
+  CPPUNIT_ASSERT_EQUAL((unsigned int)0x30u, (unsigned int)dst[0]);
+
+  // Only the last bit survives.
+  memset(n1, 0xff, sizeof(n1));
+  n1[39] = 0xfe;
+  CPPUNIT_ASSERT(bitfield::andNot(0, a, 0, n1, 0, 320));
+  CPPUNIT_ASSERT(!bitfield::andNot(0, a, 0, n1, 0, 319));
+  CPPUNIT_ASSERT(!bitfield::andNot(dst, a, 0, n1, 0, 319));
+  for(size_t i = 0; i < 40; ++i) {
+    CPPUNIT_ASSERT_EQUAL((unsigned int)0, (unsigned int)dst[i]);
+  }
+  // A set bit in the middle is found without dst.
+  n1[5] = 0xef;
+  CPPUNIT_ASSERT(bitfield::andNot(0, a, 0, n1, 0, 319));
+
+  CPPUNIT_ASSERT(!bitfield::andNot(dst, a, b, n1, n2, 0));
+}
+
+void bitfieldTest::testGetNextSetBitIndex()
+{
+  unsigned char bitfield[20];
+  memset(bitfield, 0, sizeof(bitfield));
+  bitfield[0] = 0x40;
+  bitfield[12] = 0x01;
+  // Beyond nbits
+  bitfield[19] = 0x01;
+  CPPUNIT_ASSERT_EQUAL((size_t)1,
+                       bitfield::getNextSetBitIndex(bitfield, 159, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)1,
+                       bitfield::getNextSetBitIndex(bitfield, 159, 1));
+  CPPUNIT_ASSERT_EQUAL((size_t)103,
+                       bitfield::getNextSetBitIndex(bitfield, 159, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)159,
+                       bitfield::getNextSetBitIndex(bitfield, 159, 104));
+  CPPUNIT_ASSERT_EQUAL((size_t)159,
+                       bitfield::getNextSetBitIndex(bitfield, 159, 200));
+  CPPUNIT_ASSERT_EQUAL((size_t)159,
+                       bitfield::getNextSetBitIndex(bitfield, 160, 104));
+}
+
+void bitfieldTest::testGetNextUnsetBitIndex()
+{
+  unsigned char bitfield[20];
+  memset(bitfield, 0xff, sizeof(bitfield));
+  bitfield[0] = 0xbf;
+  bitfield[12] = 0xfe;
+  CPPUNIT_ASSERT_EQUAL((size_t)1,
+                       bitfield::getNextUnsetBitIndex(bitfield, 159, 0));
+  CPPUNIT_ASSERT_EQUAL((size_t)103,
+                       bitfield::getNextUnsetBitIndex(bitfield, 159, 2));
+  CPPUNIT_ASSERT_EQUAL((size_t)159,
+                       bitfield::getNextUnsetBitIndex(bitfield, 159, 104));
+  CPPUNIT_ASSERT_EQUAL((size_t)160,
+                       bitfield::getNextUnsetBitIndex(bitfield, 160, 104));
+}
+
+void bitfieldTest::testGetFirstNSetBitIndex()
+{
+  unsigned char bitfield[20];
+  memset(bitfield, 0, sizeof(bitfield));
+  bitfield[0] = 0x81;
+  bitfield[9] = 0x10;
+  bitfield[19] = 0x03;
+  std::vector<size_t> out;
+  CPPUNIT_ASSERT_EQUAL
+    ((size_t)4,
+     bitfield::getFirstNSetBitIndex(std::back_inserter(out), 10,
+                                    bitfield, 159));
+  CPPUNIT_ASSERT_EQUAL((size_t)4, out.size());
+  CPPUNIT_ASSERT_EQUAL((size_t)0, out[0]);
+  CPPUNIT_ASSERT_EQUAL((size_t)7, out[1]);
+  CPPUNIT_ASSERT_EQUAL((size_t)75, out[2]);
+  CPPUNIT_ASSERT_EQUAL((size_t)158, out[3]);
+  out.clear();
+  CPPUNIT_ASSERT_EQUAL
+    ((size_t)2,
+     bitfield::getFirstNSetBitIndex(std::back_inserter(out), 2,
+                                    bitfield, 159));
+  CPPUNIT_ASSERT_EQUAL((size_t)7, out[1]);
+}
+
 } // namespace aria2